@@ -18,10 +18,12 @@ setup(
                   define_macros=[("HAVE_PYBIND11", "1")],
                   sources=[
                       "src/control/actuators.cpp",
+                      "src/util/prop_handle.cpp",
                       "src/util/timing.cpp"
                   ],
                   depends=[
                       "src/control/actuators.h",
+                      "src/util/prop_handle.h",
                       "src/util/timing.h"
                   ],
                   include_dirs=["src"],
@@ -38,26 +40,53 @@ setup(
                       "src/control/pid.cpp",
                       "src/control/pid_vel.cpp",
                       "src/control/predictor.cpp",
+                      "src/control/schedule.cpp",
+                      "src/control/signals.cpp",
                       "src/control/summer.cpp",
                       "src/control/tecs.cpp",
+                      "src/util/prop_handle.cpp",
                       "src/util/timing.cpp"
                   ],
                   depends=[
                       "src/control/ap.h",
                       "src/control/cas.h",
+                      "src/control/component.h",
                       "src/control/control.h",
                       "src/control/dig_filter.h",
                       "src/control/dtss.h",
+                      "src/control/dtss_kernel.h",
                       "src/control/pid.h",
                       "src/control/pid_vel.h",
                       "src/control/predictor.h",
+                      "src/control/schedule.h",
+                      "src/control/signals.h",
                       "src/control/summer.h",
                       "src/control/tecs.h",
+                      "src/util/prop_handle.h",
                       "src/util/timing.h"
                   ],
                   include_dirs=["src"],
                   extra_objects=["/usr/local/lib/libpyprops.a"]
                   ),
+        Extension("rcUAS.nav_mgr",
+                  define_macros=[("HAVE_PYBIND11", "1")],
+                  sources=[
+                      "src/control/nav_mgr.cpp",
+                      "src/control/nav_route.cpp",
+                      "src/util/prop_handle.cpp",
+                      "src/util/wgs84.cpp",
+                      "src/util/windtri.cpp"
+                  ],
+                  depends=[
+                      "src/control/nav_mgr.h",
+                      "src/control/nav_route.h",
+                      "src/util/prop_handle.h",
+                      "src/util/wgs84.h",
+                      "src/util/windtri.h"
+                  ],
+                  include_dirs=["src"],
+                  extra_objects=["/usr/local/lib/libpyprops.a"]
+                  ),
         Extension("rcUAS.driver_mgr",
                   define_macros=[("HAVE_PYBIND11", "1")],
                   sources=[
@@ -74,12 +103,14 @@ setup(
                       "src/drivers/ublox8.cpp",
                       "src/drivers/ublox9.cpp",
                       "src/filters/nav_common/coremag.c",
+                      "src/filters/nav_common/magcache.cpp",
                       "src/filters/nav_common/nav_functions.cpp",
                       "src/util/butter.cpp",
                       "src/util/geodesy.cpp",
                       "src/util/linearfit.cpp",
                       "src/util/lowpass.cpp",
                       "src/util/netSocket.cpp",
+                      "src/util/prop_handle.cpp",
                       "src/util/props_helper.cpp",
                       "src/util/serial_link.cpp",
                       "src/util/sg_path.cpp",
@@ -103,12 +134,14 @@ setup(
                       "src/drivers/ublox8.h",
                       "src/drivers/ublox9.h",
                       "src/filters/nav_common/coremag.h",
+                      "src/filters/nav_common/magcache.h",
                       "src/filters/nav_common/nav_functions.h",
                       "src/util/butter.h",
                       "src/util/geodesy.h",
                       "src/util/linearfit.h",
                       "src/util/lowpass.h",
                       "src/util/netSocket.h",
+                      "src/util/prop_handle.h",
                       "src/util/props_helper.h",
                       "src/util/serial_link.h",
                       "src/util/sg_path.h",
@@ -153,26 +186,80 @@ setup(
                       "src/filters/ground.cpp",
                       "src/filters/wind.cpp",
                       "src/filters/nav_ekf15/aura_interface.cpp",
+                      "src/filters/nav_ekf15/covariance.cpp",
                       "src/filters/nav_ekf15/EKF_15state.cpp",
                       "src/filters/nav_ekf15_mag/aura_interface.cpp",
-                      "src/filters/nav_ekf15_mag/EKF_15state.cpp",
                       "src/filters/nav_common/coremag.c",
+                      "src/filters/nav_common/magcache.cpp",
                       "src/filters/nav_common/nav_functions.cpp",
                       "src/util/lowpass.cpp",
-                      "src/util/props_helper.cpp"
+                      "src/util/prop_handle.cpp",
+                      "src/util/props_helper.cpp",
+                      "src/util/timing.cpp"
                   ],
                   depends=[
                       "src/filters/filter_mgr.h",
                       "src/filters/ground.h",
                       "src/filters/wind.h",
                       "src/filters/nav_ekf15/aura_interface.h",
+                      "src/filters/nav_ekf15/config.h",
+                      "src/filters/nav_ekf15/covariance.h",
                       "src/filters/nav_ekf15/EKF_15state.h",
                       "src/filters/nav_ekf15_mag/aura_interface.h",
-                      "src/filters/nav_ekf15_mag/EKF_15state.h",
                       "src/filters/nav_common/coremag.h",
+                      "src/filters/nav_common/magcache.h",
                       "src/filters/nav_common/nav_functions.h",
                       "src/util/lowpass.h",
-                      "src/util/props_helper.h"
+                      "src/util/prop_handle.h",
+                      "src/util/props_helper.h",
+                      "src/util/timing.h"
+                  ],
+                  include_dirs=["src"],
+                  extra_objects=["/usr/local/lib/libpyprops.a"]
+                  ),
+        Extension("rcUAS.replay",
+                  define_macros=[("HAVE_PYBIND11", "1")],
+                  sources=[
+                      "src/filters/replay/log_reader.cpp",
+                      "src/filters/replay/nav_writer.cpp",
+                      "src/filters/replay/replay.cpp",
+                      "src/filters/replay/smoother.cpp",
+                      "src/filters/replay/sweep.cpp",
+                      "src/filters/nav_ekf15/covariance.cpp",
+                      "src/filters/nav_ekf15/EKF_15state.cpp",
+                      "src/filters/nav_ekf15/EKF_15state_batch.cpp",
+                      "src/filters/nav_common/coremag.c",
+                      "src/filters/nav_common/magcache.cpp",
+                      "src/filters/nav_common/nav_functions.cpp",
+                      "src/util/timing.cpp"
+                  ],
+                  depends=[
+                      "src/filters/replay/log_messages.h",
+                      "src/filters/replay/log_reader.h",
+                      "src/filters/replay/nav_writer.h",
+                      "src/filters/replay/replay.h",
+                      "src/filters/replay/smoother.h",
+                      "src/filters/replay/sweep.h",
+                      "src/filters/nav_ekf15/covariance.h",
+                      "src/filters/nav_ekf15/EKF_15state.h",
+                      "src/filters/nav_ekf15/EKF_15state_batch.h",
+                      "src/filters/nav_common/coremag.h",
+                      "src/filters/nav_common/magcache.h",
+                      "src/filters/nav_common/nav_functions.h",
+                      "src/util/timing.h"
+                  ],
+                  include_dirs=["src"],
+                  libraries=["z"]
+                  ),
+        Extension("rcUAS.frame_snapshot",
+                  define_macros=[("HAVE_PYBIND11", "1")],
+                  sources=[
+                      "src/util/frame_snapshot.cpp",
+                      "src/util/timing.cpp"
+                  ],
+                  depends=[
+                      "src/util/frame_snapshot.h",
+                      "src/util/timing.h"
                   ],
                   include_dirs=["src"],
                   extra_objects=["/usr/local/lib/libpyprops.a"]
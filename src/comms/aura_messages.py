@@ -22,6 +22,7 @@ ap_status_v4_id = 30
 ap_status_v5_id = 32
 ap_status_v6_id = 33
 ap_status_v7_id = 39
+ap_stats_v1_id = 49
 system_health_v4_id = 19
 system_health_v5_id = 41
 system_health_v6_id = 46
@@ -1490,6 +1491,63 @@ class ap_status_v7():
         self.airspeed_kt /= 10
         self.flight_timer /= 1
 
+# Message: ap_stats_v1
+# Id: 49
+class ap_stats_v1():
+    id = 49
+    _pack_string = "<BfBHHHHHHB"
+    _struct = struct.Struct(_pack_string)
+
+    def __init__(self, msg=None):
+        # public fields
+        self.index = 0
+        self.timestamp_sec = 0.0
+        self.size = 0
+        self.avg_ms = 0.0
+        self.min_ms = 0.0
+        self.max_ms = 0.0
+        self.clamps = 0
+        self.windups = 0
+        self.resets = 0
+        self.name = ""
+        # unpack if requested
+        if msg: self.unpack(msg)
+
+    def pack(self):
+        msg = self._struct.pack(
+                  self.index,
+                  self.timestamp_sec,
+                  self.size,
+                  int(round(self.avg_ms * 10000)),
+                  int(round(self.min_ms * 10000)),
+                  int(round(self.max_ms * 10000)),
+                  self.clamps,
+                  self.windups,
+                  self.resets,
+                  len(self.name))
+        msg += str.encode(self.name)
+        return msg
+
+    def unpack(self, msg):
+        base_len = struct.calcsize(self._pack_string)
+        extra = msg[base_len:]
+        msg = msg[:base_len]
+        (self.index,
+         self.timestamp_sec,
+         self.size,
+         self.avg_ms,
+         self.min_ms,
+         self.max_ms,
+         self.clamps,
+         self.windups,
+         self.resets,
+         self.name_len) = self._struct.unpack(msg)
+        self.avg_ms /= 10000
+        self.min_ms /= 10000
+        self.max_ms /= 10000
+        self.name = extra[:self.name_len].decode()
+        extra = extra[self.name_len:]
+
 # Message: system_health_v4
 # Id: 19
 class system_health_v4():
@@ -16,6 +16,7 @@ import comms.serial_parser
 log_buffer = []
 fdata = None
 logging_node = None
+stats_node = getNode('/autopilot/stats', True)
 
 enable_file = False             # log to file enabled/disabled
 enable_udp = False              # log to a udp port enabled/disabled
@@ -120,6 +121,9 @@ def init():
     global airdata_count
     global ap_skip
     global ap_count
+    global ap_stats_skip
+    global ap_stats_count
+    global ap_stats_index
     global filter_skip
     global filter_count
     global gps_skip
@@ -136,6 +140,10 @@ def init():
     airdata_count = random.randint(0, airdata_skip)
     ap_skip = logging_node.getInt("autopilot_skip")
     ap_count = random.randint(0, ap_skip)
+    # (one autopilot component per message, 0 = off)
+    ap_stats_skip = logging_node.getInt("ap_stats_skip")
+    ap_stats_count = random.randint(0, ap_stats_skip)
+    ap_stats_index = 0
     filter_skip = logging_node.getInt("filter_skip")
     filter_count = random.randint(0, filter_skip)
     gps_skip = logging_node.getInt("gps_skip")
@@ -181,6 +189,8 @@ def process_messages():
     global act_count
     global airdata_count
     global ap_count
+    global ap_stats_count
+    global ap_stats_index
     global filter_count
     global gps_count
     global health_count
@@ -189,6 +199,7 @@ def process_messages():
     act_count -= 1
     airdata_count -= 1
     ap_count -= 1
+    ap_stats_count -= 1
     filter_count -= 1
     gps_count -= 1
     health_count -= 1
@@ -221,6 +232,19 @@ def process_messages():
             print("pack_ap_status_bin() error:", str(e))
         if not buf is None and len(buf):
             log_message(packer.ap.id, buf)
+    if ap_stats_skip > 0 and ap_stats_count < 0:
+        ap_stats_count = ap_stats_skip
+        if ap_stats_index >= stats_node.getInt("size"):
+            ap_stats_index = 0
+        buf = None
+        try:
+            if stats_node.getInt("size") > 0:
+                buf = packer.pack_ap_stats_bin(ap_stats_index)
+                ap_stats_index += 1
+        except Exception as e:
+            print("pack_ap_stats_bin() error:", str(e))
+        if not buf is None and len(buf):
+            log_message(packer.ap_stats.id, buf)
     if filter_count < 0:
         filter_count = filter_skip
         buf = None
@@ -38,6 +38,7 @@ status_node = getNode("/status", True)
 ap_node = getNode("/autopilot", True)
 targets_node = getNode("/autopilot/targets", True)
 tecs_node = getNode("/autopilot/tecs", True)
+stats_node = getNode("/autopilot/stats", True)
 task_node = getNode("/task", True)
 route_node = getNode("/task/route", True)
 active_node = getNode("/task/route/active", True)
@@ -81,6 +82,7 @@ def wrap_packet( self, packet_id, payload ):
 
 class Packer():
     ap = aura_messages.ap_status_v7()
+    ap_stats = aura_messages.ap_stats_v1()
     act = aura_messages.actuator_v3()
     airdata = aura_messages.airdata_v7()
     filter = aura_messages.filter_v5()
@@ -1276,6 +1278,36 @@ class Packer():
 
         return index
 
+    # one autopilot component per message (the senders cycle the
+    # index through /autopilot/stats/size)
+    def pack_ap_stats_bin(self, index):
+        node = stats_node.getChild("component[%d]" % index, True)
+        self.ap_stats.index = index
+        self.ap_stats.timestamp_sec = status_node.getFloat("frame_time")
+        self.ap_stats.size = stats_node.getInt("size")
+        # times saturate at the 6.5 ms the packed fields hold, counts wrap
+        self.ap_stats.avg_ms = min(node.getFloat("avg_ms"), 6.5)
+        self.ap_stats.min_ms = min(node.getFloat("min_ms"), 6.5)
+        self.ap_stats.max_ms = min(node.getFloat("max_ms"), 6.5)
+        self.ap_stats.clamps = node.getInt("clamps") % 65536
+        self.ap_stats.windups = node.getInt("windups") % 65536
+        self.ap_stats.resets = node.getInt("resets") % 65536
+        self.ap_stats.name = node.getString("name")
+        return self.ap_stats.pack()
+
+    def unpack_ap_stats_v1(self, buf):
+        stats = aura_messages.ap_stats_v1(buf)
+        stats_node.setInt("size", stats.size)
+        node = stats_node.getChild("component[%d]" % stats.index, True)
+        node.setString("name", stats.name)
+        node.setFloat("avg_ms", stats.avg_ms)
+        node.setFloat("min_ms", stats.min_ms)
+        node.setFloat("max_ms", stats.max_ms)
+        node.setInt("clamps", stats.clamps)
+        node.setInt("windups", stats.windups)
+        node.setInt("resets", stats.resets)
+        return stats.index
+
     def pack_system_health_bin(self, use_cached=False):
         health_time = status_node.getFloat('frame_time')
         if not use_cached and health_time > self.last_health_time:
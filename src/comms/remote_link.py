@@ -19,6 +19,7 @@ task_node = getNode( '/task', True )
 home_node = getNode( '/task/home', True )
 active_node = getNode("/task/route/active", True)
 targets_node = getNode( '/autopilot/targets', True )
+stats_node = getNode( '/autopilot/stats', True )
 comms_node = getNode( '/comms', True)
 
 remote_link_config = getNode('/config/remote_link', True)
@@ -43,6 +44,9 @@ def init():
     global airdata_count
     global ap_skip
     global ap_count
+    global ap_stats_skip
+    global ap_stats_count
+    global ap_stats_index
     global filter_skip
     global filter_count
     global gps_skip
@@ -59,6 +63,10 @@ def init():
     airdata_count = random.randint(0, airdata_skip)
     ap_skip = remote_link_config.getInt("autopilot_skip")
     ap_count = random.randint(0, ap_skip)
+    # (one autopilot component per message, 0 = off)
+    ap_stats_skip = remote_link_config.getInt("ap_stats_skip")
+    ap_stats_count = random.randint(0, ap_stats_skip)
+    ap_stats_index = 0
     filter_skip = remote_link_config.getInt("filter_skip")
     filter_count = random.randint(0, filter_skip)
     gps_skip = remote_link_config.getInt("gps_skip")
@@ -142,6 +150,8 @@ def process_messages():
     global act_count
     global airdata_count
     global ap_count
+    global ap_stats_count
+    global ap_stats_index
     global filter_count
     global gps_count
     global health_count
@@ -150,6 +160,7 @@ def process_messages():
     act_count -= 1
     airdata_count -= 1
     ap_count -= 1
+    ap_stats_count -= 1
     filter_count -= 1
     gps_count -= 1
     health_count -= 1
@@ -177,6 +188,14 @@ def process_messages():
             if counter >= route_size + 2:
                 counter = 0
             remote_link_node.setInt("wp_counter", counter) 
+    if ap_stats_skip > 0 and ap_stats_count < 0:
+        ap_stats_count = ap_stats_skip
+        if ap_stats_index >= stats_node.getInt("size"):
+            ap_stats_index = 0
+        if stats_node.getInt("size") > 0:
+            buf = packer.pack_ap_stats_bin(ap_stats_index)
+            if send_message(packer.ap_stats.id, buf):
+                ap_stats_index += 1
     if filter_count < 0:
         filter_count = filter_skip
         buf = packer.pack_filter_bin(use_cached=True)
@@ -8,6 +8,8 @@ import re
 
 from props import getNode
 
+from util import propprof
+
 #import commands
 
 class ChatHandler(asynchat.async_chat):
@@ -204,6 +206,21 @@ class ChatHandler(asynchat.async_chat):
                     self.my_push(tokens[1] + ' = "' + value + '"\n')
             else:
                 self.my_push('usage: set [[/]path/]attr value\n')
+        elif tokens[0] == 'propprof':
+            if len(tokens) >= 2 and tokens[1] == 'on':
+                propprof.reset()
+                propprof.enable()
+            elif len(tokens) >= 2 and tokens[1] == 'off':
+                propprof.disable()
+            elif len(tokens) >= 2 and tokens[1] == 'reset':
+                propprof.reset()
+            elif len(tokens) >= 2 and tokens[1] == 'report':
+                count = 25
+                if len(tokens) == 3:
+                    count = int(tokens[2])
+                self.my_push(propprof.report(count))
+            else:
+                self.my_push('usage: propprof on|off|reset|report [<n>]\n')
         elif tokens[0] == 'quit':
             self.close()
             return
@@ -232,6 +249,7 @@ pwd                display your current path
 get <var>          show the value of a parameter
 set <var> <val>    set <var> to a new <val>
 dump [<dir>]       dump the current state (in xml)
+propprof on|off|reset|report [<n>]  property access profiler
 quit               exit the client telnet session
 shutdown-application xyzzy      terminate the host application
 """
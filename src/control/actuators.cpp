@@ -17,6 +17,17 @@ using std::string;
 #include "util/timing.h"
 #include "actuators.h"
 
+// surface commands are read and written as blocks (in this order)
+static const char *flight_names[] = {
+    "aileron", "elevator", "rudder", "flaps", "gear"
+};
+static const char *act_names[] = {
+    "timestamp", "aileron", "elevator", "rudder", "flaps", "gear",
+    "throttle"
+};
+static const int flight_count = sizeof(flight_names) / sizeof(char *);
+static const int act_count = sizeof(act_names) / sizeof(char *);
+
 void actuators_t::init() {
     pyPropsInit();              // first things first
     // bind properties
@@ -26,27 +37,14 @@ void actuators_t::init() {
     pilot_node = pyGetNode("/sensors/pilot_input", true);
     act_node = pyGetNode("/actuators", true);
     ap_node = pyGetNode("/autopilot", true);
+    flight_batch.init( flight_node, flight_names, flight_count );
+    act_batch.init( act_node, act_names, act_count );
 }
 
 void actuators_t::update() {
-    // set time stamp for logging
-    act_node.setDouble( "timestamp", get_Time() );
-
-    float aileron = flight_node.getDouble("aileron");
-    act_node.setDouble( "aileron", aileron );
-
-    float elevator = flight_node.getDouble("elevator");
-    act_node.setDouble( "elevator", elevator );
-
-    // rudder
-    float rudder = flight_node.getDouble("rudder");
-    act_node.setDouble( "rudder", rudder );
-
-    double flaps = flight_node.getDouble("flaps");
-    act_node.setDouble("flaps", flaps );
-
-    double gear = flight_node.getDouble("gear");
-    act_node.setDouble("gear", gear );
+    // aileron, elevator, rudder, flaps, gear pass straight through
+    double flight[flight_count];
+    flight_batch.get( flight );
 
     // CAUTION!!! CAUTION!!! CAUTION!!! CAUTION!!! CAUTION!!! CAUTION!!!
     // CAUTION!!! CAUTION!!! CAUTION!!! CAUTION!!! CAUTION!!! CAUTION!!!
@@ -105,7 +103,14 @@ void actuators_t::update() {
     // throttle
 
     double throttle = engine_node.getDouble("throttle");
-    act_node.setDouble("throttle", throttle );
+
+    // set time stamp for logging
+    double act[] = {
+        get_Time(),                     // timestamp
+        flight[0], flight[1], flight[2], flight[3], flight[4],
+        throttle
+    };
+    act_batch.set( act );
 
     // add in excitation signals if excitation task is running
     if ( excite_node.getBool("running") ) {
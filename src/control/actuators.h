@@ -10,6 +10,8 @@
 
 #include <pyprops.h>
 
+#include "util/prop_handle.h"
+
 class actuators_t {
 private:
     pyPropertyNode flight_node;
@@ -18,6 +20,8 @@ private:
     pyPropertyNode act_node;
     pyPropertyNode ap_node;
     pyPropertyNode excite_node;
+    PropBatch flight_batch;
+    PropBatch act_batch;
     
 public:
     actuators_t() {}
@@ -25,11 +25,14 @@
 #include <math.h>
 #include <stdlib.h>
 
+#include <algorithm>
 #include <string>
 #include <sstream>
 using std::string;
 using std::ostringstream;
 
+#include "util/timing.h"
+
 #include "ap.h"
 #include "dig_filter.h"
 #include "dtss.h"
@@ -37,6 +40,7 @@ using std::ostringstream;
 #include "pid_vel.h"
 #include "predictor.h"
 #include "summer.h"
+#include "tecs.h"
 
 
 void AuraAutopilot::init() {
@@ -48,6 +52,13 @@ void AuraAutopilot::init() {
 }
 
 
+AuraAutopilot::~AuraAutopilot() {
+    for ( unsigned int i = 0; i < components.size(); ++i ) {
+        delete components[i];
+    }
+}
+
+
 void AuraAutopilot::reset() {
     for ( unsigned int i = 0; i < components.size(); ++i ) {
         components[i]->reset();
@@ -55,15 +66,39 @@ void AuraAutopilot::reset() {
 }
 
 
+// order "component[10]" after "component[9]" (pyprops doesn't
+// guarantee any order of children)
+static bool child_order( const string &a, const string &b ) {
+    size_t pa = a.find("[");
+    size_t pb = b.find("[");
+    string na = a.substr(0, pa);
+    string nb = b.substr(0, pb);
+    if ( na != nb ) {
+        return na < nb;
+    }
+    int ia = (pa == string::npos) ? 0 : atoi(a.c_str() + pa + 1);
+    int ib = (pb == string::npos) ? 0 : atoi(b.c_str() + pb + 1);
+    return ia < ib;
+}
+
+
 bool AuraAutopilot::build() {
     pyPropertyNode config_props = pyGetNode( "/config/autopilot", true );
 
-    // FIXME: we have always depended on the order of children
-    // components here to ensure PID stages are run in the correct
-    // order, however that is a bad thing to assume ... especially now
-    // with pyprops!!!
+    if ( config_props.getDouble("base_hz") > 0.0 ) {
+        base_hz = config_props.getDouble("base_hz");
+    }
+    ap_status_node = pyGetNode( "/status/autopilot", true );
+    stats_node = pyGetNode( "/autopilot/stats", true );
+
+    // the stages are created in config index order and then run in
+    // dependency order (see schedule())
     vector <string> children = config_props.getChildren();
+    std::sort( children.begin(), children.end(), child_order );
     for ( unsigned int i = 0; i < children.size(); ++i ) {
+        if ( children[i] == "base_hz" ) {
+            continue;           // (a value, not a section)
+        }
 	pyPropertyNode component = config_props.getChild(children[i].c_str(),
 							 true);
         printf("ap stage: %s\n", children[i].c_str());
@@ -107,17 +142,221 @@ bool AuraAutopilot::build() {
 	} else if ( name == "L1_controller" ) {
 	    // configuration placeholder, we don't do anything here.
 	} else if ( name == "TECS" ) {
-            // configuration placeholder, we don't do anything here.
+            // energy update rate (the rest is read by tecs.cpp)
+            tecs_hz = component.getDouble("rate_hz");
          } else {
 	    printf("Unknown top level section: %s\n", children[i].c_str() );
             return false;
         }
     }
 
+    // bind every stage input and output to the signal table
+    bind_tecs( &signals );
+    for ( unsigned int i = 0; i < components.size(); i++ ) {
+        components[i]->bind_signals( &signals );
+    }
+    printf("ap signals: %d values\n", signals.size() - 1);
+
+    return schedule();
+}
+
+
+// order the components so each one runs after every component that
+// writes one of its inputs (independent of the config order)
+bool AuraAutopilot::schedule() {
+    vector<APStageDeps> deps( components.size() );
+    for ( unsigned int i = 0; i < components.size(); i++ ) {
+        components[i]->get_dependencies( &deps[i] );
+    }
+    APSchedule plan;
+    if ( !plan.build( deps ) ) {
+        printf("AP: WARNING: dependency cycle, running these stages ahead of their inputs:\n");
+        for ( unsigned int i = 0; i < plan.cycle.size(); i++ ) {
+            printf("  %s\n", components[plan.cycle[i]]->get_name().c_str());
+        }
+    }
+    vector<APComponent *> ordered;
+    branch.clear();
+    for ( unsigned int i = 0; i < plan.order.size(); i++ ) {
+        int c = plan.order[i];
+        ordered.push_back( components[c] );
+        branch.push_back( plan.branch[c] );
+        printf("ap schedule: %d branch %d: %s\n", i, plan.branch[c],
+               components[c]->get_name().c_str());
+    }
+    components = ordered;
+    printf("ap schedule: %d stages in %d independent branches\n",
+           (int)components.size(), plan.branches);
+
+    // stats are published in execution order
+    component_stats_node.clear();
+    for ( unsigned int i = 0; i < components.size(); i++ ) {
+        pyPropertyNode node = stats_node.getChild( "component", i, true );
+        node.setString( "name", components[i]->get_name() );
+        component_stats_node.push_back( node );
+    }
+    stats_node.setLong( "size", components.size() );
+
+    plan_rates();
     return true;
 }
 
 
+// frames per run for a requested rate (0 = every frame)
+int AuraAutopilot::rate_divider( double rate_hz ) {
+    if ( rate_hz <= 0.0 || rate_hz >= base_hz ) {
+        return 1;
+    }
+    int divider = (int)(base_hz / rate_hz + 0.5);
+    return divider < 1 ? 1 : divider;
+}
+
+
+static int gcd( int a, int b ) {
+    while ( b ) {
+        int t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+
+// build the execution plan: every task in schedule order with its
+// divider, and a phase for each slow task that puts it on the least
+// loaded frames of the (divider) cycle
+void AuraAutopilot::plan_rates() {
+    plan.clear();
+    APTask tecs = { NULL, rate_divider(tecs_hz), 0, 0.0, 0 };
+    plan.push_back( tecs );
+    for ( unsigned int i = 0; i < components.size(); i++ ) {
+        APTask task = { components[i], rate_divider(components[i]->get_rate_hz()),
+                        0, 0.0, 0 };
+        plan.push_back( task );
+    }
+
+    // load over one full cycle of all the dividers (capped)
+    int cycle = 1;
+    for ( unsigned int i = 0; i < plan.size(); i++ ) {
+        cycle = cycle / gcd( cycle, plan[i].divider ) * plan[i].divider;
+        if ( cycle > 1000 ) {
+            cycle = 1000;
+        }
+    }
+    vector<int> load( cycle, 0 );
+    for ( unsigned int i = 0; i < plan.size(); i++ ) {
+        if ( plan[i].divider == 1 ) {
+            for ( int f = 0; f < cycle; f++ ) {
+                load[f]++;
+            }
+        }
+    }
+    for ( unsigned int i = 0; i < plan.size(); i++ ) {
+        int n = plan[i].divider;
+        if ( n == 1 ) {
+            continue;
+        }
+        int best = 0;
+        int best_load = -1;
+        for ( int p = 0; p < n; p++ ) {
+            int sum = 0;
+            for ( int f = p; f < cycle; f += n ) {
+                sum += load[f];
+            }
+            if ( best_load < 0 || sum < best_load ) {
+                best = p;
+                best_load = sum;
+            }
+        }
+        plan[i].phase = best;
+        for ( int f = best; f < cycle; f += n ) {
+            load[f]++;
+        }
+    }
+
+    // rate groups (fastest first)
+    groups.clear();
+    for ( unsigned int i = 0; i < plan.size(); i++ ) {
+        unsigned int g = 0;
+        while ( g < groups.size() && groups[g].divider != plan[i].divider ) {
+            g++;
+        }
+        if ( g == groups.size() ) {
+            APRateGroup group;
+            group.divider = plan[i].divider;
+            group.frame_sec = group.sum_sec = group.max_sec = 0.0;
+            group.runs = 0;
+            groups.push_back( group );
+        }
+        plan[i].group = g;
+    }
+    for ( unsigned int i = 0; i < groups.size(); i++ ) {
+        for ( unsigned int j = i + 1; j < groups.size(); j++ ) {
+            if ( groups[j].divider < groups[i].divider ) {
+                APRateGroup tmp = groups[i];
+                groups[i] = groups[j];
+                groups[j] = tmp;
+                for ( unsigned int k = 0; k < plan.size(); k++ ) {
+                    if ( plan[k].group == (int)i ) {
+                        plan[k].group = j;
+                    } else if ( plan[k].group == (int)j ) {
+                        plan[k].group = i;
+                    }
+                }
+            }
+        }
+    }
+    for ( unsigned int i = 0; i < groups.size(); i++ ) {
+        char buf[32];
+        snprintf( buf, 32, "rate_%.0fhz", base_hz / groups[i].divider );
+        groups[i].prefix = buf;
+    }
+    for ( unsigned int i = 0; i < plan.size(); i++ ) {
+        string name = plan[i].component ? plan[i].component->get_name() : "TECS";
+        printf("ap plan: %.0f hz (1/%d phase %d): %s\n",
+               base_hz / plan[i].divider, plan[i].divider, plan[i].phase,
+               name.c_str());
+    }
+}
+
+
+// publish the rate group timing (about once a second)
+void AuraAutopilot::report_rates() {
+    for ( unsigned int i = 0; i < groups.size(); i++ ) {
+        APRateGroup &g = groups[i];
+        double avg = g.runs ? g.sum_sec / g.runs : 0.0;
+        ap_status_node.setDouble( (g.prefix + "_avg_ms").c_str(), avg * 1000.0 );
+        ap_status_node.setDouble( (g.prefix + "_max_ms").c_str(),
+                                  g.max_sec * 1000.0 );
+        g.sum_sec = g.max_sec = 0.0;
+        g.runs = 0;
+    }
+    int frames = (int)(base_hz + 0.5);
+    if ( frames < 1 ) {
+        frames = 1;
+    }
+    ap_status_node.setDouble( "frame_avg_ms", frame_sum_sec * 1000.0 / frames );
+    ap_status_node.setDouble( "frame_max_ms", frame_max_sec * 1000.0 );
+    frame_sum_sec = frame_max_sec = 0.0;
+}
+
+
+// publish the stats of one component (each is sampled about once a
+// second, spread over the frames so the property writes are too)
+void AuraAutopilot::report_stats( int i ) {
+    APStats &st = components[i]->get_stats();
+    pyPropertyNode &node = component_stats_node[i];
+    double avg = st.runs ? st.sum_sec / st.runs : 0.0;
+    node.setDouble( "avg_ms", avg * 1000.0 );
+    node.setDouble( "min_ms", st.min_sec * 1000.0 );
+    node.setDouble( "max_ms", st.max_sec * 1000.0 );
+    node.setLong( "clamps", st.clamps );
+    node.setLong( "windups", st.windups );
+    node.setLong( "resets", st.resets );
+    st.clear_time();
+}
+
+
 // normalize a value to lie between min and max
 template <class T>
 inline void SG_NORMALIZE_RANGE( T &val, const T min, const T max ) {
@@ -131,9 +370,81 @@ inline void SG_NORMALIZE_RANGE( T &val, const T min, const T max ) {
  * Update the list of autopilot components
  */
 
+// run the tasks that are due this frame on the signal table (timed
+// per rate group if requested)
+void AuraAutopilot::run_tasks( double dt, bool timed ) {
+    for ( unsigned int i = 0; i < plan.size(); i++ ) {
+        APTask &task = plan[i];
+        task.elapsed += dt;
+        if ( frame % task.divider != task.phase ) {
+            continue;
+        }
+        double start = timed ? get_Time() : 0.0;
+        if ( task.component ) {
+            task.component->update( task.elapsed );
+        } else {
+            // update tecs (total energy) values and error metrics
+            update_tecs();
+        }
+        task.elapsed = 0.0;
+        if ( timed ) {
+            double sec = get_Time() - start;
+            APRateGroup &g = groups[task.group];
+            if ( g.frame_sec < 0.0 ) {
+                g.frame_sec = 0.0;
+            }
+            g.frame_sec += sec;
+            if ( task.component ) {
+                task.component->get_stats().add_time( sec );
+            }
+        }
+    }
+    frame++;
+}
+
+
 void AuraAutopilot::update( double dt ) {
-    for ( unsigned int i = 0; i < components.size(); ++i ) {
-        components[i]->update( dt );
+    for ( unsigned int i = 0; i < groups.size(); i++ ) {
+        groups[i].frame_sec = -1.0;
     }
+    double frame_start = get_Time();
+    signals.load();
+    run_tasks( dt, true );
+    signals.store();
+    double frame_sec = get_Time() - frame_start;
+
+    // timing
+    for ( unsigned int i = 0; i < groups.size(); i++ ) {
+        APRateGroup &g = groups[i];
+        if ( g.frame_sec >= 0.0 ) {
+            g.sum_sec += g.frame_sec;
+            if ( g.frame_sec > g.max_sec ) { g.max_sec = g.frame_sec; }
+            g.runs++;
+        }
+    }
+    frame_sum_sec += frame_sec;
+    if ( frame_sec > frame_max_sec ) { frame_max_sec = frame_sec; }
+    // one report period is about a second of frames: the rates are
+    // published on its first frame and the components are spread over
+    // all of its frames (several per frame when there are more
+    // components than frames), so each is sampled once per period
+    int frames = (int)(base_hz + 0.5);
+    if ( frames < 1 ) {
+        frames = 1;
+    }
+    int report = frame % frames;
+    if ( report == 0 ) {
+        report_rates();
+    }
+    int count = component_stats_node.size();
+    for ( int i = report * count / frames; i < (report + 1) * count / frames;
+          i++ ) {
+        report_stats( i );
+    }
+}
+
+
+void AuraAutopilot::step( double dt ) {
+    run_tasks( dt, false );
 }
 
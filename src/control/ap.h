@@ -24,23 +24,64 @@
 
 #include <pyprops.h>
 
+#include <string>
 #include <vector>
+using std::string;
 using std::vector;
 
 #include "component.h"
+#include "schedule.h"
+#include "signals.h"
+
+
+// one entry of the execution plan: runs on frames where frame %
+// divider == phase, with the time accumulated since its last run
+struct APTask {
+    APComponent *component;     // (NULL = the TECS energy update)
+    int divider;
+    int phase;
+    double elapsed;
+    int group;                  // rate group index
+};
+
+// timing of all the tasks that share a rate
+struct APRateGroup {
+    int divider;
+    string prefix;              // "rate_25hz" (/status/autopilot names)
+    double frame_sec;           // time spent in the current frame
+    double sum_sec;             // since the last report
+    double max_sec;
+    int runs;
+};
 
 
 /**
  * Model an autopilot system.
- * 
+ *
+ * Components (and the TECS update) may run at a lower rate than the
+ * main loop (rate_hz in their config, base_hz in /config/autopilot.)
+ * Slow tasks are given phases that spread them across frames, and
+ * the per rate group run times are reported in /status/autopilot.
+ * Per component run times and clamp / windup / reset counts (see
+ * APStats) are sampled into /autopilot/stats at the same rate.
+ *
+ * The components read and write a flat signal table rather than the
+ * property tree: it is loaded once before the components run and the
+ * values they set are written back once at the end of the frame.
  */
 
 class AuraAutopilot {
 
 public:
 
-    AuraAutopilot() {}
-    ~AuraAutopilot() {}
+    AuraAutopilot():
+        base_hz( 100.0 ),
+        tecs_hz( 0.0 ),
+        frame( 0 ),
+        frame_sum_sec( 0.0 ),
+        frame_max_sec( 0.0 )
+    {}
+    ~AuraAutopilot();
 
     void init();
     void reset();
@@ -48,8 +89,35 @@ public:
 
     bool build();
 
+    // run one frame on the signal table only, without the property
+    // tree traffic and timing of update() (for offline simulation,
+    // see ap_sim.cpp)
+    void step( double dt );
+    APSignals *get_signals() { return &signals; }
+    double get_base_hz() { return base_hz; }
+
 private:
 
     bool serviceable;
-    vector<APComponent *> components;
+    vector<APComponent *> components; // in execution order
+    vector<int> branch;         // independent branch of each component
+    APSignals signals;          // values the components exchange
+
+    double base_hz;
+    double tecs_hz;
+    long frame;
+    vector<APTask> plan;
+    vector<APRateGroup> groups;
+    double frame_sum_sec;
+    double frame_max_sec;
+    pyPropertyNode ap_status_node;
+    pyPropertyNode stats_node;
+    vector<pyPropertyNode> component_stats_node; // (by components index)
+
+    bool schedule();
+    void run_tasks( double dt, bool timed );
+    int rate_divider( double rate_hz );
+    void plan_rates();
+    void report_rates();
+    void report_stats( int i );
 };
@@ -0,0 +1,794 @@
+// ap_sim.cpp -- offline autopilot simulator for bench testing gains.
+//
+// Loads an autopilot config (the /config/autopilot json), builds the
+// same AuraAutopilot stages as the flight code and runs them on the
+// signal table (AuraAutopilot::step(), no property tree or python in
+// the loop) closed loop against a simple linear aircraft model, or
+// open loop on recorded inputs from a csv log.  A sweep runs a grid
+// of config values (i.e. pid gains) in parallel worker processes and
+// reports tracking error, overshoot and actuator saturation for each
+// point, so gain changes can be screened before they are flown.
+//
+// usage: ap_sim autopilot.json [options]
+//   --seconds sec        simulated time (default 30)
+//   --set /path=value    initial value (model state or target)
+//   --step /path=value@t change a value at time t
+//   --track /meas:/ref   report tracking of /meas against /ref
+//   --log file.csv       replay a log: a header line with "time" and
+//                        property paths, then one line per frame
+//   --sweep name=min:max:count
+//                        sweep /config/autopilot/name (i.e.
+//                        component[2]/config/Kp), repeat for a grid
+//   --jobs n             worker processes for a sweep
+//
+// Run from src with PYTHONPATH=. (for util.propwatch.)
+//
+// g++ -O3 -I.. -I/usr/include/eigen3 $(python3-config --includes)
+//     ap_sim.cpp ap.cpp schedule.cpp signals.cpp pid.cpp pid_vel.cpp
+//     summer.cpp dtss.cpp dig_filter.cpp predictor.cpp tecs.cpp
+//     ../util/prop_handle.cpp ../util/timing.cpp -lpyprops
+//     $(python3-config --ldflags --embed) -o ap_sim
+
+#include <fcntl.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <pyprops.h>
+
+#include <string>
+#include <vector>
+using std::string;
+using std::vector;
+
+#include "include/globaldefs.h"
+#include "util/timing.h"
+
+#include "ap.h"
+
+
+// a value change at a point in time (--set is a change at t = 0)
+struct SimEvent {
+    string path;
+    double value;
+    double time;
+};
+
+// one swept config value
+struct SimSweep {
+    string name;                // relative to /config/autopilot
+    double min, max;
+    int count;
+};
+
+// tracking of a measured value against its reference
+struct SimTrack {
+    string meas, ref;
+    bool wrap;                  // angle (wrap the error to +/- 180)
+    int meas_slot, ref_slot;
+    double *meas_state;         // model state (or NULL)
+    double sum_sq;
+    long count;
+    double step_from, step_to;  // last scripted step of the reference
+    double step_time;
+    double peak;                // max travel past the step target
+};
+
+// actuator (or other ap output) saturation / agreement with the log
+struct SimOutput {
+    string path;
+    int slot;
+    double min, max;
+    long saturated;
+    int log_column;             // recorded value (or -1)
+    double sum_sq;
+    long count;
+};
+
+// a simple linear aircraft: first order rate responses to the
+// surfaces, pitch stiffness, speed from throttle and drag, bank angle
+// turns.  Positive aileron rolls right, positive elevator pitches
+// down, positive rudder yaws right.
+struct SimModel {
+    double roll_deg, p_dps;
+    double pitch_deg, q_dps;
+    double r_dps;
+    double course_deg;
+    double airspeed_kt;
+    double alt_m;
+
+    double aileron, elevator, rudder, throttle;
+    double p_rad, q_rad, r_rad, alt_ft;
+
+    SimModel():
+        roll_deg(0.0), p_dps(0.0), pitch_deg(0.0), q_dps(0.0), r_dps(0.0),
+        course_deg(0.0), airspeed_kt(25.0), alt_m(100.0),
+        aileron(0.0), elevator(0.0), rudder(0.0), throttle(0.5)
+    {
+        outputs();
+    }
+
+    void update( double dt ) {
+        double p_dot = ( 120.0 * aileron - p_dps ) / 0.15;
+        double q_dot = -60.0 * elevator - 6.0 * pitch_deg - 4.0 * q_dps;
+        double r_dot = 30.0 * rudder - 3.0 * r_dps;
+        double v_dot = 10.0 * (throttle - 0.5) - 0.2 * (airspeed_kt - 25.0)
+            - 19.07 * sin( pitch_deg * SGD_DEGREES_TO_RADIANS );
+        double v_mps = airspeed_kt * SG_KT_TO_MPS;
+        if ( v_mps < 1.0 ) { v_mps = 1.0; }
+        p_dps += p_dot * dt;
+        roll_deg += p_dps * dt;
+        q_dps += q_dot * dt;
+        pitch_deg += q_dps * dt;
+        r_dps += r_dot * dt;
+        airspeed_kt += v_dot * dt;
+        alt_m += v_mps * sin( pitch_deg * SGD_DEGREES_TO_RADIANS ) * dt;
+        course_deg += 9.81 * tan( roll_deg * SGD_DEGREES_TO_RADIANS ) / v_mps
+            * SGD_RADIANS_TO_DEGREES * dt;
+        if ( course_deg < 0.0 ) { course_deg += 360.0; }
+        if ( course_deg >= 360.0 ) { course_deg -= 360.0; }
+        outputs();
+    }
+
+    void outputs() {
+        p_rad = p_dps * SGD_DEGREES_TO_RADIANS;
+        q_rad = q_dps * SGD_DEGREES_TO_RADIANS;
+        r_rad = r_dps * SGD_DEGREES_TO_RADIANS;
+        alt_ft = alt_m * SG_METER_TO_FEET;
+    }
+};
+
+// model values by property path
+struct SimModelValue {
+    const char *path;
+    size_t offset;
+    bool input;                 // read from the ap (vs. written to it)
+};
+
+static const SimModelValue model_values[] = {
+    { "/orientation/roll_deg", offsetof(SimModel, roll_deg), false },
+    { "/orientation/pitch_deg", offsetof(SimModel, pitch_deg), false },
+    { "/orientation/heading_deg", offsetof(SimModel, course_deg), false },
+    { "/orientation/groundtrack_deg", offsetof(SimModel, course_deg), false },
+    { "/sensors/imu/p_rad_sec", offsetof(SimModel, p_rad), false },
+    { "/sensors/imu/q_rad_sec", offsetof(SimModel, q_rad), false },
+    { "/sensors/imu/r_rad_sec", offsetof(SimModel, r_rad), false },
+    { "/sensors/imu/p_deg_sec", offsetof(SimModel, p_dps), false },
+    { "/sensors/imu/q_deg_sec", offsetof(SimModel, q_dps), false },
+    { "/sensors/imu/r_deg_sec", offsetof(SimModel, r_dps), false },
+    { "/velocity/airspeed_kt", offsetof(SimModel, airspeed_kt), false },
+    { "/velocity/airspeed_smoothed_kt", offsetof(SimModel, airspeed_kt), false },
+    { "/position/altitude_agl_m", offsetof(SimModel, alt_m), false },
+    { "/position/altitude_agl_ft", offsetof(SimModel, alt_ft), false },
+    { "/controls/flight/aileron", offsetof(SimModel, aileron), true },
+    { "/controls/flight/elevator", offsetof(SimModel, elevator), true },
+    { "/controls/flight/rudder", offsetof(SimModel, rudder), true },
+    { "/controls/engine/throttle", offsetof(SimModel, throttle), true },
+};
+static const int model_count = sizeof(model_values) / sizeof(SimModelValue);
+
+// default tracking pairs (used when they are part of the autopilot)
+static const char *default_tracks[][2] = {
+    { "/orientation/groundtrack_deg", "/autopilot/targets/groundtrack_deg" },
+    { "/orientation/roll_deg", "/autopilot/targets/roll_deg" },
+    { "/orientation/pitch_deg", "/autopilot/targets/pitch_deg" },
+    { "/velocity/airspeed_kt", "/autopilot/targets/airspeed_kt" },
+    { "/position/altitude_agl_ft", "/autopilot/targets/altitude_agl_ft" },
+};
+
+// actuator ranges
+static const struct { const char *path; double min, max; } actuators[] = {
+    { "/controls/flight/aileron", -1.0, 1.0 },
+    { "/controls/flight/elevator", -1.0, 1.0 },
+    { "/controls/flight/rudder", -1.0, 1.0 },
+    { "/controls/engine/throttle", 0.0, 1.0 },
+};
+
+// options
+static string config_file;
+static double seconds = 30.0;
+static vector<SimEvent> events;
+static vector<SimTrack> tracks;
+static vector<SimSweep> sweeps;
+static vector<string> outputs;      // reported ap outputs
+static string log_file;
+static int jobs = 0;
+
+// recorded log
+static vector<string> log_columns;
+static vector< vector<double> > log_rows;
+
+
+static double *model_state( SimModel *model, const string &path, bool *input ) {
+    for ( int i = 0; i < model_count; i++ ) {
+        if ( path == model_values[i].path ) {
+            if ( input != NULL ) {
+                *input = model_values[i].input;
+            }
+            return (double *)((char *)model + model_values[i].offset);
+        }
+    }
+    return NULL;
+}
+
+static bool parse_assign( const char *arg, string *path, string *value ) {
+    const char *eq = strchr( arg, '=' );
+    if ( eq == NULL ) {
+        return false;
+    }
+    *path = string( arg, eq - arg );
+    *value = eq + 1;
+    return true;
+}
+
+static bool load_log( const string &file ) {
+    FILE *fp = fopen( file.c_str(), "r" );
+    if ( fp == NULL ) {
+        printf("can't open log: %s\n", file.c_str());
+        return false;
+    }
+    char line[4096];
+    bool header = true;
+    while ( fgets(line, sizeof(line), fp) != NULL ) {
+        vector<string> fields;
+        char *save = NULL;
+        for ( char *tok = strtok_r(line, ",\r\n", &save); tok != NULL;
+              tok = strtok_r(NULL, ",\r\n", &save) ) {
+            fields.push_back( tok );
+        }
+        if ( fields.empty() ) {
+            continue;
+        }
+        if ( header ) {
+            log_columns = fields;
+            header = false;
+        } else {
+            vector<double> row( log_columns.size(), 0.0 );
+            for ( unsigned int i = 0; i < fields.size() && i < row.size(); i++ ) {
+                row[i] = atof( fields[i].c_str() );
+            }
+            log_rows.push_back( row );
+        }
+    }
+    fclose( fp );
+    if ( log_columns.empty() || log_columns[0] != "time" || log_rows.size() < 2 ) {
+        printf("log needs a 'time' first column and at least 2 rows\n");
+        return false;
+    }
+    return true;
+}
+
+// set a config value (name relative to /config/autopilot)
+static void set_config( const string &name, double value ) {
+    string path = "/config/autopilot/" + name;
+    size_t pos = path.rfind("/");
+    pyPropertyNode node = pyGetNode( path.substr(0, pos), true );
+    node.setDouble( path.substr(pos+1).c_str(), value );
+}
+
+// build an autopilot with the build chatter silenced
+static AuraAutopilot *build_ap( bool quiet ) {
+    int saved = -1;
+    if ( quiet ) {
+        fflush( stdout );
+        saved = dup( 1 );
+        int null = open( "/dev/null", O_WRONLY );
+        dup2( null, 1 );
+        close( null );
+    }
+    AuraAutopilot *ap = new AuraAutopilot;
+    bool ok = ap->build();
+    if ( quiet ) {
+        fflush( stdout );
+        dup2( saved, 1 );
+        close( saved );
+    }
+    if ( !ok ) {
+        delete ap;
+        return NULL;
+    }
+    return ap;
+}
+
+struct SimResult {
+    vector<double> rms;         // per track
+    vector<double> overshoot;   // per track (percent, < 0 if no step)
+    vector<double> saturated;   // per actuator (percent of frames)
+    vector<double> log_rms;     // per log compared output
+    long frames;
+    double sim_sec;
+    double cpu_sec;
+};
+
+// run the scenario on a freshly built autopilot
+static bool simulate( SimResult *result, bool quiet ) {
+    AuraAutopilot *ap = build_ap( quiet );
+    if ( ap == NULL ) {
+        return false;
+    }
+    APSignals *signals = ap->get_signals();
+    signals->load();
+    SimModel model;
+    bool replay = !log_rows.empty();
+
+    // model slots (closed loop)
+    vector<int> model_slot( model_count, 0 );
+    if ( !replay ) {
+        for ( int i = 0; i < model_count; i++ ) {
+            model_slot[i] = signals->find( model_values[i].path );
+        }
+    }
+
+    // log columns (open loop)
+    vector<int> column_slot( log_columns.size(), 0 );
+    for ( unsigned int i = 1; i < log_columns.size(); i++ ) {
+        column_slot[i] = signals->find( log_columns[i] );
+    }
+
+    // metrics
+    vector<SimTrack> track = tracks;
+    if ( track.empty() ) {
+        for ( unsigned int i = 0; i < sizeof(default_tracks) / sizeof(default_tracks[0]); i++ ) {
+            SimTrack t;
+            t.meas = default_tracks[i][0];
+            t.ref = default_tracks[i][1];
+            if ( signals->find(t.ref) == 0 ) {
+                continue;
+            }
+            t.wrap = false;
+            track.push_back( t );
+        }
+    }
+    for ( unsigned int i = 0; i < track.size(); i++ ) {
+        SimTrack &t = track[i];
+        t.wrap = t.meas.find("groundtrack") != string::npos
+            || t.meas.find("heading") != string::npos;
+        t.meas_slot = signals->find( t.meas );
+        t.ref_slot = signals->find( t.ref );
+        t.meas_state = replay ? NULL : model_state( &model, t.meas, NULL );
+        t.sum_sq = 0.0;
+        t.count = 0;
+        t.step_time = -1.0;
+        t.step_from = t.step_to = t.peak = 0.0;
+    }
+    vector<SimOutput> output;
+    for ( unsigned int i = 0; i < sizeof(actuators) / sizeof(actuators[0]); i++ ) {
+        SimOutput o;
+        o.path = actuators[i].path;
+        o.slot = signals->find( o.path );
+        if ( o.slot == 0 ) {
+            continue;
+        }
+        o.min = actuators[i].min;
+        o.max = actuators[i].max;
+        o.saturated = 0;
+        o.log_column = -1;
+        for ( unsigned int j = 1; j < log_columns.size(); j++ ) {
+            if ( log_columns[j] == o.path ) {
+                o.log_column = j;
+            }
+        }
+        o.sum_sq = 0.0;
+        o.count = 0;
+        output.push_back( o );
+    }
+
+    // scripted events
+    vector<int> event_slot( events.size() );
+    vector<double *> event_state( events.size() );
+    for ( unsigned int i = 0; i < events.size(); i++ ) {
+        event_slot[i] = signals->find( events[i].path );
+        event_state[i] = replay ? NULL : model_state( &model, events[i].path, NULL );
+    }
+    unsigned int next_event = 0;
+
+    double dt = 1.0 / ap->get_base_hz();
+    long frames = replay ? log_rows.size() : (long)(seconds / dt + 0.5);
+    double start = get_Time();
+    double t = 0.0;
+    double sim_sec = 0.0;
+    for ( long f = 0; f < frames; f++ ) {
+        if ( replay ) {
+            vector<double> &row = log_rows[f];
+            if ( f > 0 ) {
+                dt = row[0] - log_rows[f-1][0];
+                if ( dt <= 0.0 ) { dt = 1.0 / ap->get_base_hz(); }
+            }
+            t = row[0] - log_rows[0][0];
+            for ( unsigned int i = 1; i < row.size(); i++ ) {
+                if ( column_slot[i] && !signals->is_written(column_slot[i]) ) {
+                    signals->set( column_slot[i], row[i] );
+                }
+            }
+        } else {
+            model.outputs();
+            for ( int i = 0; i < model_count; i++ ) {
+                if ( model_slot[i] && !model_values[i].input ) {
+                    double *v = (double *)((char *)&model + model_values[i].offset);
+                    signals->set( model_slot[i], *v );
+                }
+            }
+        }
+
+        // scripted changes (events are sorted by time)
+        while ( next_event < events.size() && events[next_event].time <= t + 1e-9 ) {
+            SimEvent &e = events[next_event];
+            for ( unsigned int i = 0; i < track.size(); i++ ) {
+                SimTrack &tr = track[i];
+                if ( tr.ref == e.path && e.time > 0.0 ) {
+                    tr.step_from = signals->get( tr.ref_slot );
+                    tr.step_to = e.value;
+                    tr.step_time = e.time;
+                    tr.peak = 0.0;
+                }
+            }
+            if ( event_state[next_event] != NULL ) {
+                *event_state[next_event] = e.value;
+            }
+            if ( event_slot[next_event] ) {
+                signals->set( event_slot[next_event], e.value );
+            }
+            next_event++;
+        }
+
+        ap->step( dt );
+        sim_sec += dt;
+
+        // metrics
+        for ( unsigned int i = 0; i < track.size(); i++ ) {
+            SimTrack &tr = track[i];
+            double meas = tr.meas_state ? *tr.meas_state
+                : signals->get( tr.meas_slot );
+            double ref = signals->get( tr.ref_slot );
+            double err = meas - ref;
+            if ( tr.wrap ) {
+                while ( err < -180.0 ) { err += 360.0; }
+                while ( err > 180.0 ) { err -= 360.0; }
+            }
+            tr.sum_sq += err * err;
+            tr.count++;
+            if ( tr.step_time >= 0.0 && tr.step_to != tr.step_from ) {
+                double past = (tr.step_to > tr.step_from) ? err : -err;
+                if ( past > tr.peak ) { tr.peak = past; }
+            }
+        }
+        for ( unsigned int i = 0; i < output.size(); i++ ) {
+            SimOutput &o = output[i];
+            double u = signals->get( o.slot );
+            double range = o.max - o.min;
+            if ( u <= o.min + 0.001 * range || u >= o.max - 0.001 * range ) {
+                o.saturated++;
+            }
+            if ( replay && o.log_column > 0 ) {
+                double d = u - log_rows[f][o.log_column];
+                o.sum_sq += d * d;
+                o.count++;
+            }
+        }
+
+        // fly the model
+        if ( !replay ) {
+            for ( int i = 0; i < model_count; i++ ) {
+                if ( model_slot[i] && model_values[i].input ) {
+                    double *v = (double *)((char *)&model + model_values[i].offset);
+                    *v = signals->get( model_slot[i] );
+                }
+            }
+            if ( model.aileron < -1.0 ) { model.aileron = -1.0; }
+            if ( model.aileron > 1.0 ) { model.aileron = 1.0; }
+            if ( model.elevator < -1.0 ) { model.elevator = -1.0; }
+            if ( model.elevator > 1.0 ) { model.elevator = 1.0; }
+            if ( model.rudder < -1.0 ) { model.rudder = -1.0; }
+            if ( model.rudder > 1.0 ) { model.rudder = 1.0; }
+            if ( model.throttle < 0.0 ) { model.throttle = 0.0; }
+            if ( model.throttle > 1.0 ) { model.throttle = 1.0; }
+            model.update( dt );
+            t += dt;
+        }
+    }
+    result->cpu_sec = get_Time() - start;
+    result->frames = frames;
+    result->sim_sec = sim_sec;
+
+    result->rms.clear();
+    result->overshoot.clear();
+    for ( unsigned int i = 0; i < track.size(); i++ ) {
+        SimTrack &tr = track[i];
+        result->rms.push_back( tr.count ? sqrt(tr.sum_sq / tr.count) : 0.0 );
+        double size = fabs( tr.step_to - tr.step_from );
+        result->overshoot.push_back( size > 0.0 ? 100.0 * tr.peak / size : -1.0 );
+    }
+    result->saturated.clear();
+    result->log_rms.clear();
+    for ( unsigned int i = 0; i < output.size(); i++ ) {
+        result->saturated.push_back( frames ? 100.0 * output[i].saturated / frames : 0.0 );
+        if ( output[i].count ) {
+            result->log_rms.push_back( sqrt(output[i].sum_sq / output[i].count) );
+        } else {
+            result->log_rms.push_back( -1.0 );
+        }
+    }
+    if ( result->rms.size() != track.size() ) {
+        return false;
+    }
+
+    // labels for the report
+    tracks = track;
+    outputs.clear();
+    for ( unsigned int i = 0; i < output.size(); i++ ) {
+        outputs.push_back( output[i].path );
+    }
+    delete ap;
+    return true;
+}
+
+static string short_name( const string &path ) {
+    size_t pos = path.rfind("/");
+    return pos == string::npos ? path : path.substr(pos+1);
+}
+
+static void print_result( const SimResult &r ) {
+    for ( unsigned int i = 0; i < tracks.size(); i++ ) {
+        printf("  %-14s rms %8.3f", short_name(tracks[i].meas).c_str(), r.rms[i]);
+        if ( r.overshoot[i] >= 0.0 ) {
+            printf("  overshoot %6.1f%%", r.overshoot[i]);
+        }
+        printf("\n");
+    }
+    for ( unsigned int i = 0; i < r.saturated.size(); i++ ) {
+        printf("  %-14s saturated %5.1f%%",
+               short_name(outputs[i]).c_str(), r.saturated[i]);
+        if ( r.log_rms[i] >= 0.0 ) {
+            printf("  rms vs log %.4f", r.log_rms[i]);
+        }
+        printf("\n");
+    }
+}
+
+// values of sweep point index (odometer over the sweeps)
+static vector<double> sweep_point( long index ) {
+    vector<double> values;
+    for ( unsigned int i = 0; i < sweeps.size(); i++ ) {
+        const SimSweep &s = sweeps[i];
+        int k = index % s.count;
+        index /= s.count;
+        double v = s.min;
+        if ( s.count > 1 ) {
+            v += (s.max - s.min) * k / (s.count - 1);
+        }
+        values.push_back( v );
+    }
+    return values;
+}
+
+// run every sweep point in worker processes (each with its own copy of
+// the python property tree) and print a table, best first by total
+// tracking error
+static int run_sweep() {
+    long points = 1;
+    for ( unsigned int i = 0; i < sweeps.size(); i++ ) {
+        points *= sweeps[i].count;
+    }
+    if ( jobs <= 0 ) {
+        jobs = sysconf( _SC_NPROCESSORS_ONLN );
+        if ( jobs < 1 ) { jobs = 1; }
+    }
+    if ( jobs > points ) {
+        jobs = points;
+    }
+    printf("sweep: %ld points, %d worker(s)\n", points, jobs);
+
+    vector<int> fds;
+    vector<pid_t> pids;
+    double start = get_Time();
+    for ( int w = 0; w < jobs; w++ ) {
+        int fd[2];
+        if ( pipe(fd) != 0 ) {
+            perror("pipe");
+            return 1;
+        }
+        fflush( stdout );
+        pid_t pid = fork();
+        if ( pid == 0 ) {
+            close( fd[0] );
+            FILE *out = fdopen( fd[1], "w" );
+            for ( long p = w; p < points; p += jobs ) {
+                vector<double> values = sweep_point( p );
+                for ( unsigned int i = 0; i < sweeps.size(); i++ ) {
+                    set_config( sweeps[i].name, values[i] );
+                }
+                SimResult r;
+                if ( !simulate(&r, true) ) {
+                    continue;
+                }
+                fprintf( out, "%ld %.9f %.9f", p, r.sim_sec, r.cpu_sec );
+                for ( unsigned int i = 0; i < r.rms.size(); i++ ) {
+                    fprintf( out, " %.6g %.6g", r.rms[i], r.overshoot[i] );
+                }
+                double sat = 0.0;
+                for ( unsigned int i = 0; i < r.saturated.size(); i++ ) {
+                    if ( r.saturated[i] > sat ) { sat = r.saturated[i]; }
+                }
+                fprintf( out, " %.6g\n", sat );
+            }
+            fclose( out );
+            _exit( 0 );
+        }
+        close( fd[1] );
+        fds.push_back( fd[0] );
+        pids.push_back( pid );
+    }
+
+    // collect
+    struct Row { long point; double score; string text; };
+    vector<Row> rows;
+    double sim_sec = 0.0;
+    double cpu_sec = 0.0;
+    for ( int w = 0; w < jobs; w++ ) {
+        FILE *in = fdopen( fds[w], "r" );
+        char line[4096];
+        while ( fgets(line, sizeof(line), in) != NULL ) {
+            char *p = line;
+            Row row;
+            row.point = strtol( p, &p, 10 );
+            sim_sec += strtod( p, &p );
+            cpu_sec += strtod( p, &p );
+            vector<double> values = sweep_point( row.point );
+            char buf[64];
+            row.text.clear();
+            for ( unsigned int i = 0; i < values.size(); i++ ) {
+                snprintf( buf, sizeof(buf), " %10.4g", values[i] );
+                row.text += buf;
+            }
+            row.score = 0.0;
+            for ( unsigned int i = 0; i < tracks.size(); i++ ) {
+                double rms = strtod( p, &p );
+                double over = strtod( p, &p );
+                row.score += rms;
+                snprintf( buf, sizeof(buf), " %9.3f", rms );
+                row.text += buf;
+                if ( over >= 0.0 ) {
+                    snprintf( buf, sizeof(buf), " %6.1f%%", over );
+                } else {
+                    snprintf( buf, sizeof(buf), " %7s", "-" );
+                }
+                row.text += buf;
+            }
+            snprintf( buf, sizeof(buf), " %7.1f%%", strtod(p, &p) );
+            row.text += buf;
+            rows.push_back( row );
+        }
+        fclose( in );
+    }
+    for ( int w = 0; w < jobs; w++ ) {
+        waitpid( pids[w], NULL, 0 );
+    }
+    double wall_sec = get_Time() - start;
+
+    // best (lowest total rms) first
+    for ( unsigned int i = 1; i < rows.size(); i++ ) {
+        for ( unsigned int j = i; j > 0 && rows[j].score < rows[j-1].score; j-- ) {
+            Row tmp = rows[j];
+            rows[j] = rows[j-1];
+            rows[j-1] = tmp;
+        }
+    }
+    for ( unsigned int i = 0; i < sweeps.size(); i++ ) {
+        printf(" %10s", short_name(sweeps[i].name).c_str());
+    }
+    for ( unsigned int i = 0; i < tracks.size(); i++ ) {
+        printf(" %9s %7s", (short_name(tracks[i].meas) + "_rms").substr(0, 9).c_str(),
+               "over");
+    }
+    printf(" %8s\n", "sat");
+    for ( unsigned int i = 0; i < rows.size(); i++ ) {
+        printf("%s\n", rows[i].text.c_str());
+    }
+    printf("%.0f sec simulated in %.2f sec cpu (%.2f sec wall), %.0fx real time per worker\n",
+           sim_sec, cpu_sec, wall_sec, cpu_sec > 0.0 ? sim_sec / cpu_sec : 0.0);
+    return rows.size() == (unsigned int)points ? 0 : 1;
+}
+
+static void usage() {
+    printf("usage: ap_sim autopilot.json [--seconds sec] [--set /path=value]\n"
+           "       [--step /path=value@t] [--track /meas:/ref] [--log file.csv]\n"
+           "       [--sweep name=min:max:count] [--jobs n]\n");
+}
+
+int main( int argc, char **argv ) {
+    for ( int i = 1; i < argc; i++ ) {
+        string arg = argv[i];
+        string path, value;
+        if ( arg == "--seconds" && i + 1 < argc ) {
+            seconds = atof( argv[++i] );
+        } else if ( (arg == "--set" || arg == "--step") && i + 1 < argc
+                    && parse_assign(argv[++i], &path, &value) ) {
+            SimEvent e;
+            e.path = path;
+            e.value = atof( value.c_str() );
+            e.time = 0.0;
+            size_t at = value.find("@");
+            if ( at != string::npos ) {
+                e.time = atof( value.c_str() + at + 1 );
+            }
+            events.push_back( e );
+        } else if ( arg == "--track" && i + 1 < argc ) {
+            string spec = argv[++i];
+            size_t colon = spec.find(":");
+            if ( colon == string::npos ) {
+                usage();
+                return 1;
+            }
+            SimTrack t;
+            t.meas = spec.substr( 0, colon );
+            t.ref = spec.substr( colon + 1 );
+            tracks.push_back( t );
+        } else if ( arg == "--log" && i + 1 < argc ) {
+            log_file = argv[++i];
+        } else if ( arg == "--sweep" && i + 1 < argc
+                    && parse_assign(argv[++i], &path, &value) ) {
+            SimSweep s;
+            s.name = path;
+            if ( sscanf(value.c_str(), "%lf:%lf:%d", &s.min, &s.max, &s.count) != 3
+                 || s.count < 1 ) {
+                usage();
+                return 1;
+            }
+            sweeps.push_back( s );
+        } else if ( arg == "--jobs" && i + 1 < argc ) {
+            jobs = atoi( argv[++i] );
+        } else if ( arg[0] != '-' && config_file.empty() ) {
+            config_file = arg;
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if ( config_file.empty() ) {
+        usage();
+        return 1;
+    }
+    // stable sort of the events by time
+    for ( unsigned int i = 1; i < events.size(); i++ ) {
+        for ( unsigned int j = i; j > 0 && events[j].time < events[j-1].time; j-- ) {
+            SimEvent tmp = events[j];
+            events[j] = events[j-1];
+            events[j-1] = tmp;
+        }
+    }
+    if ( !log_file.empty() && !load_log(log_file) ) {
+        return 1;
+    }
+
+    Py_Initialize();
+    pyPropsInit();
+    pyPropertyNode config_node = pyGetNode( "/config/autopilot", true );
+    if ( !readJSON(config_file, &config_node) ) {
+        printf("can't load %s\n", config_file.c_str());
+        return 1;
+    }
+
+    if ( !sweeps.empty() ) {
+        // work out the reported tracks once
+        SimResult r;
+        if ( !simulate(&r, true) ) {
+            return 1;
+        }
+        return run_sweep();
+    }
+
+    SimResult r;
+    if ( !simulate(&r, true) ) {
+        printf("autopilot build failed\n");
+        return 1;
+    }
+    printf("%ld frames (%.1f sec) in %.3f sec cpu, %.0fx real time\n",
+           r.frames, r.sim_sec, r.cpu_sec,
+           r.cpu_sec > 0.0 ? r.sim_sec / r.cpu_sec : 0.0);
+    print_result( r );
+    return 0;
+}
@@ -0,0 +1,219 @@
+// ap_test.cpp -- time the autopilot update for a representative
+//                /config/autopilot (roll, pitch, TECS throttle / pitch,
+//                elevator summer, yaw damper, airspeed filter and
+//                predictor), check the stages drive the outputs the
+//                right way and the stats in /autopilot/stats add up,
+//                also with fewer frames per second than components.
+//                (Run from src with PYTHONPATH=. so the util python
+//                modules import.)
+//
+// g++ -O3 -I.. -I/usr/include/eigen3 $(python3-config --includes)
+//     ap_test.cpp ap.cpp schedule.cpp signals.cpp pid.cpp pid_vel.cpp
+//     summer.cpp dtss.cpp dig_filter.cpp predictor.cpp tecs.cpp
+//     ../util/prop_handle.cpp ../util/timing.cpp -lpyprops
+//     $(python3-config --ldflags --embed) -o ap_test
+
+#include <math.h>
+#include <stdio.h>
+
+#include <pyprops.h>
+
+#include "util/timing.h"
+
+#include "ap.h"
+
+static const char *config =
+    "import props\n"
+    "def prop(path, value):\n"
+    "    p = path.rfind('/')\n"
+    "    setattr(props.getNode(path[:p], True), path[p+1:], value)\n"
+    "def component(i, module, name, enable, inp, ref, out, cfg, **extra):\n"
+    "    base = '/config/autopilot/component[%d]' % i\n"
+    "    prop(base + '/module', module)\n"
+    "    prop(base + '/name', name)\n"
+    "    prop(base + '/enable/prop', enable)\n"
+    "    if inp: prop(base + '/input/prop', inp)\n"
+    "    if ref is not None:\n"
+    "        if isinstance(ref, str): prop(base + '/reference/prop', ref)\n"
+    "        else: prop(base + '/reference/value', str(ref))\n"
+    "    if out: prop(base + '/output/prop', out)\n"
+    "    for k, v in cfg.items(): prop(base + '/config/' + k, v)\n"
+    "    for k, v in extra.items(): prop(base + '/' + k, v)\n"
+    "lim = dict(u_min=-1.0, u_max=1.0, u_trim=0.0)\n"
+    "component(0, 'pid', 'heading hold', '/autopilot/locks/roll',\n"
+    "          '/orientation/groundtrack_deg', '/autopilot/targets/groundtrack_deg',\n"
+    "          '/autopilot/targets/roll_deg',\n"
+    "          dict(Kp=0.5, Ti=10.0, Td=0.0, u_min=-40.0, u_max=40.0, u_trim=0.0),\n"
+    "          wrap='180')\n"
+    "component(1, 'pid_velocity', 'roll hold', '/autopilot/locks/roll',\n"
+    "          '/orientation/roll_deg', '/autopilot/targets/roll_deg',\n"
+    "          '/autopilot/internal/roll_rate',\n"
+    "          dict(Kp=1.5, Ti=1.0, Td=0.0, beta=1.0, gamma=0.0, alpha=0.1,\n"
+    "               u_min=-90.0, u_max=90.0))\n"
+    "component(2, 'pid', 'roll rate', '/autopilot/locks/roll',\n"
+    "          '/sensors/imu/p_deg_sec', '/autopilot/internal/roll_rate',\n"
+    "          '/controls/flight/aileron',\n"
+    "          dict(Kp=0.01, Ti=2.0, Td=0.0, **lim))\n"
+    "component(3, 'pid', 'tecs throttle', '/autopilot/locks/tecs',\n"
+    "          '/autopilot/tecs/error_total', 0, '/controls/engine/throttle',\n"
+    "          dict(Kp=-0.0002, Ti=5.0, Td=0.0, u_min=0.0, u_max=1.0, u_trim=0.5))\n"
+    "component(4, 'pid', 'tecs pitch', '/autopilot/locks/tecs',\n"
+    "          '/autopilot/tecs/error_diff', 0, '/autopilot/targets/pitch_deg',\n"
+    "          dict(Kp=0.005, Ti=5.0, Td=0.0, u_min=-15.0, u_max=15.0,\n"
+    "               u_trim=0.0))\n"
+    "component(5, 'pid', 'pitch hold', '/autopilot/locks/pitch',\n"
+    "          '/orientation/pitch_deg', '/autopilot/targets/pitch_deg',\n"
+    "          '/autopilot/internal/elevator_pid',\n"
+    "          dict(Kp=-0.03, Ti=2.0, Td=0.0, **lim))\n"
+    "component(6, 'pid', 'pitch ff', '/autopilot/locks/pitch',\n"
+    "          '/autopilot/targets/pitch_deg', 0, '/autopilot/internal/elevator_ff',\n"
+    "          dict(Kp=-0.01, Ti=0.0, Td=0.0, **lim))\n"
+    "component(7, 'summer', 'elevator', '/autopilot/locks/pitch',\n"
+    "          None, None, '/controls/flight/elevator', dict(u_min=-1.0, u_max=1.0))\n"
+    "prop('/config/autopilot/component[7]/input/prop', '/autopilot/internal/elevator_pid')\n"
+    "prop('/config/autopilot/component[7]/input/prop1', '/autopilot/internal/elevator_ff')\n"
+    "component(8, 'dtss', 'yaw damper', '/autopilot/locks/yaw',\n"
+    "          None, None, None, {}, A=[-2.0], B=[1.0], C=[-0.5], D=[-0.1],\n"
+    "          z_trim=[0.0])\n"
+    "prop('/config/autopilot/component[8]/inputs/prop', '/sensors/imu/r_rad_sec')\n"
+    "c = props.getNode('/config/autopilot/component[8]/outputs[0]', True)\n"
+    "c.prop = '/controls/flight/rudder'; c.u_min = -1.0; c.u_max = 1.0; c.u_trim = 0.0\n"
+    "component(9, 'filter', 'airspeed filter', '/autopilot/locks/tecs',\n"
+    "          '/velocity/airspeed_kt', None, '/velocity/airspeed_smoothed_kt', {},\n"
+    "          type='exponential', filter_time=0.5)\n"
+    "component(10, 'predict_simple', 'airspeed trend', '/autopilot/locks/tecs',\n"
+    "          '/velocity/airspeed_smoothed_kt', None, '/velocity/airspeed_ahead_kt',\n"
+    "          {}, seconds=2.0, filter_gain=0.1)\n"
+    "prop('/config/autopilot/TECS/mass_kg', 3.0)\n"
+    "prop('/config/autopilot/TECS/min_kt', 20.0)\n"
+    "prop('/config/autopilot/TECS/max_kt', 40.0)\n"
+    "for lock in [ 'roll', 'pitch', 'tecs', 'yaw' ]:\n"
+    "    prop('/autopilot/locks/' + lock, True)\n"
+    "prop('/orientation/groundtrack_deg', 350.0)\n"
+    "prop('/autopilot/targets/groundtrack_deg', 10.0)\n"
+    "prop('/orientation/roll_deg', 0.0)\n"
+    "prop('/orientation/pitch_deg', 0.0)\n"
+    "prop('/sensors/imu/p_deg_sec', 0.0)\n"
+    "prop('/sensors/imu/r_rad_sec', 0.2)\n"
+    "prop('/velocity/airspeed_kt', 25.0)\n"
+    "prop('/velocity/airspeed_smoothed_kt', 25.0)\n"
+    "prop('/position/altitude_agl_m', 100.0)\n"
+    "prop('/autopilot/targets/altitude_agl_ft', 400.0)\n"
+    "prop('/autopilot/targets/airspeed_kt', 25.0)\n";
+
+int main() {
+    bool pass = true;
+
+    Py_Initialize();
+    pyPropsInit();
+    if ( PyRun_SimpleString(config) != 0 ) {
+        printf("FAIL: config\n");
+        return 1;
+    }
+
+    AuraAutopilot ap;
+    if ( !ap.build() ) {
+        printf("FAIL: build\n");
+        return 1;
+    }
+
+    const int frames = 20000;
+    double start = get_Time();
+    for ( int i = 0; i < frames; i++ ) {
+        ap.update( 0.01 );
+    }
+    double sec = get_Time() - start;
+    printf("ap update: %.2f us per frame\n", sec * 1e6 / frames);
+
+    // right turn to the target track, climb to the target altitude,
+    // oppose the yaw rate
+    pyPropertyNode targets_node = pyGetNode( "/autopilot/targets", true );
+    pyPropertyNode flight_node = pyGetNode( "/controls/flight", true );
+    pyPropertyNode engine_node = pyGetNode( "/controls/engine", true );
+    pyPropertyNode vel_node = pyGetNode( "/velocity", true );
+    pyPropertyNode tecs_node = pyGetNode( "/autopilot/tecs", true );
+    printf("roll %.2f pitch %.2f aileron %.3f elevator %.3f rudder %.3f "
+           "throttle %.3f airspeed %.2f/%.2f\n",
+           targets_node.getDouble("roll_deg"),
+           targets_node.getDouble("pitch_deg"),
+           flight_node.getDouble("aileron"),
+           flight_node.getDouble("elevator"),
+           flight_node.getDouble("rudder"),
+           engine_node.getDouble("throttle"),
+           vel_node.getDouble("airspeed_smoothed_kt"),
+           vel_node.getDouble("airspeed_ahead_kt"));
+    if ( targets_node.getDouble("roll_deg") <= 0.0
+         || flight_node.getDouble("aileron") <= 0.0
+         || targets_node.getDouble("pitch_deg") <= 0.0
+         || flight_node.getDouble("elevator") >= 0.0
+         || flight_node.getDouble("rudder") >= 0.0
+         || engine_node.getDouble("throttle") <= 0.5
+         || tecs_node.getDouble("error_total") <= 0.0
+         || fabs(vel_node.getDouble("airspeed_smoothed_kt") - 25.0) > 0.01 ) {
+        printf("FAIL: outputs\n");
+        pass = false;
+    }
+
+    // the saturated aileron loop clamped and held its integrator every
+    // frame after the reset when it was first enabled
+    pyPropertyNode stats_node = pyGetNode( "/autopilot/stats", true );
+    int found = 0;
+    for ( int i = 0; i < stats_node.getLong("size"); i++ ) {
+        pyPropertyNode node = stats_node.getChild( "component", i, true );
+        if ( node.getDouble("min_ms") > node.getDouble("avg_ms")
+             || node.getDouble("avg_ms") > node.getDouble("max_ms")
+             || node.getDouble("max_ms") <= 0.0 ) {
+            printf("FAIL: %s timing\n", node.getString("name").c_str());
+            pass = false;
+        }
+        if ( node.getString("name") == "roll rate" ) {
+            found++;
+            printf("roll rate: %.3f / %.3f / %.3f us, %ld clamps %ld windups "
+                   "%ld resets\n", node.getDouble("min_ms") * 1000.0,
+                   node.getDouble("avg_ms") * 1000.0,
+                   node.getDouble("max_ms") * 1000.0,
+                   node.getLong("clamps"), node.getLong("windups"),
+                   node.getLong("resets"));
+            if ( node.getLong("clamps") < frames / 2
+                 || node.getLong("windups") != node.getLong("clamps")
+                 || node.getLong("resets") != 1 ) {
+                printf("FAIL: roll rate counts\n");
+                pass = false;
+            }
+        }
+    }
+    if ( stats_node.getLong("size") != 11 || found != 1 ) {
+        printf("FAIL: stats components\n");
+        pass = false;
+    }
+
+    // at 5 frames a second every one of the 11 components is still
+    // sampled within one second of frames
+    pyPropertyNode config_node = pyGetNode( "/config/autopilot", true );
+    config_node.setDouble( "base_hz", 5.0 );
+    AuraAutopilot slow;
+    if ( !slow.build() ) {
+        printf("FAIL: build at 5 hz\n");
+        return 1;
+    }
+    for ( int i = 0; i < stats_node.getLong("size"); i++ ) {
+        stats_node.getChild( "component", i, true ).setDouble( "max_ms", 0.0 );
+    }
+    for ( int i = 0; i < 5; i++ ) {
+        slow.update( 0.2 );
+    }
+    for ( int i = 0; i < stats_node.getLong("size"); i++ ) {
+        pyPropertyNode node = stats_node.getChild( "component", i, true );
+        if ( node.getDouble("max_ms") <= 0.0 ) {
+            printf("FAIL: %s not sampled at 5 hz\n",
+                   node.getString("name").c_str());
+            pass = false;
+        }
+    }
+
+    if ( !pass ) {
+        return 1;
+    }
+    printf("PASS\n");
+    return 0;
+}
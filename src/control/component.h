@@ -23,12 +23,57 @@
 
 #include <pyprops.h>
 
+#include <stdio.h>
+#include <stdlib.h>
+
 #include <string>
 #include <vector>
 
 using std::vector;
 using std::string;
 
+#include "util/prop_handle.h"
+
+#include "schedule.h"
+#include "signals.h"
+
+// run time and saturation counts of one component.  Only the flight
+// loop touches these (the components count, AuraAutopilot times and
+// samples them), so they are plain fields: no locks or atomics.
+struct APStats {
+    // update time, since the last sample
+    int runs;
+    double sum_sec;
+    double min_sec;
+    double max_sec;
+
+    // events, since start up
+    unsigned int clamps;        // updates with an output held at u_min / u_max
+    unsigned int windups;       // updates where anti-windup held the integrator
+    unsigned int resets;        // integrator / state resets
+
+    APStats():
+        clamps( 0 ),
+        windups( 0 ),
+        resets( 0 )
+    {
+        clear_time();
+    }
+
+    inline void add_time( double sec ) {
+        runs++;
+        sum_sec += sec;
+        if ( sec < min_sec || runs == 1 ) { min_sec = sec; }
+        if ( sec > max_sec ) { max_sec = sec; }
+    }
+
+    inline void clear_time() {
+        runs = 0;
+        sum_sec = min_sec = max_sec = 0.0;
+    }
+};
+
+
 /**
  * Base class for other autopilot components
  */
@@ -57,11 +102,67 @@ protected:
 
     pyPropertyNode config_node;
 
+    // cached settings, refreshed by load_config() when anything in the
+    // component's config subtree is written (i.e. tuned from the ground)
+    PropWatch config_watch;
+    bool debug;
+    bool has_ref_value;         // constant reference (vs. ref_slot)
+    double ref_const;
+
+    // signal table slots of the enable, input, reference and output
+    // values above (see bind_signals())
+    APSignals *signals;
+    vector <int> enables_slot;
+    int input_slot;
+    int ref_slot;
+    vector <int> output_slot;
+
+    APStats stats;
+
+    // start watching the configuration, call at the end of the
+    // component constructor
+    void watch_config() {
+        config_watch.init( component_node );
+    }
+
+    // re-read the cached settings (components with settings of their
+    // own extend this)
+    virtual void load_config() {
+        debug = component_node.getBool("debug");
+        has_ref_value = ( ref_value != "" );
+        ref_const = atof( ref_value.c_str() );
+    }
+
+    // call at the start of update(), reloads the settings after a change
+    inline void update_config() {
+        if ( config_watch.changed() ) {
+            load_config();
+        }
+    }
+
+    inline double get_reference() {
+        return has_ref_value ? ref_const : signals->get( ref_slot );
+    }
+
+    // identify a property value for the scheduler (by python node, so
+    // different spellings of a path to the same node still match)
+    static string prop_key( pyPropertyNode &node, const string &attr ) {
+        char buf[32];
+        snprintf( buf, sizeof(buf), "%p/", (void *)node.pObj );
+        return buf + attr;
+    }
+
 public:
 
     APComponent() :
       honor_passive( false ),
-      enabled( false )
+      enabled( false ),
+      debug( false ),
+      has_ref_value( false ),
+      ref_const( 0.0 ),
+      signals( NULL ),
+      input_slot( 0 ),
+      ref_slot( 0 )
     { }
 
     virtual ~APComponent() {}
@@ -70,4 +171,45 @@ public:
     virtual void update( double dt ) = 0;
     
     inline string get_name() { return component_node.getString("name"); }
+
+    inline APStats &get_stats() { return stats; }
+
+    // execution rate (0 = every frame)
+    inline double get_rate_hz() { return component_node.getDouble("rate_hz"); }
+
+    // bind the values this component reads and writes to slots of the
+    // signal table (components with their own input / output lists add
+    // those)
+    virtual void bind_signals( APSignals *table ) {
+        signals = table;
+        enables_slot.clear();
+        for ( unsigned int i = 0; i < enables_node.size(); i++ ) {
+            enables_slot.push_back( table->bind(enables_node[i],
+                                                enables_attr[i], true) );
+        }
+        input_slot = table->bind( input_node, input_attr );
+        ref_slot = table->bind( ref_node, ref_attr );
+        output_slot.clear();
+        for ( unsigned int i = 0; i < output_node.size(); i++ ) {
+            output_slot.push_back( table->bind(output_node[i],
+                                               output_attr[i]) );
+        }
+    }
+
+    // the property values this component reads and writes (components
+    // with their own input / output lists add those)
+    virtual void get_dependencies( APStageDeps *deps ) {
+        for ( unsigned int i = 0; i < enables_node.size(); i++ ) {
+            deps->reads.push_back( prop_key(enables_node[i], enables_attr[i]) );
+        }
+        if ( !input_node.isNull() ) {
+            deps->reads.push_back( prop_key(input_node, input_attr) );
+        }
+        if ( !ref_node.isNull() ) {
+            deps->reads.push_back( prop_key(ref_node, ref_attr) );
+        }
+        for ( unsigned int i = 0; i < output_node.size(); i++ ) {
+            deps->writes.push_back( prop_key(output_node[i], output_attr[i]) );
+        }
+    }
 };
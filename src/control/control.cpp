@@ -24,7 +24,6 @@ namespace py = pybind11;
 
 #include <stdio.h>
 
-#include "tecs.h"
 #include "control.h"
 
 void control_t::init() {
@@ -98,9 +97,6 @@ void control_t::update(float dt) {
 	last_master_switch = ap_node.getBool("master_switch");
     }
     
-    // update tecs (total energy) values and error metrics
-    update_tecs();
-
     // navigation update (circle or route heading)
     // navigation.update(dt);
 
@@ -113,6 +113,8 @@ AuraDigitalFilter::AuraDigitalFilter( string config_path )
 
     output.resize(2, 0.0);
     input.resize(samples + 1, 0.0);
+
+    watch_config();
 }
 
 void AuraDigitalFilter::reset() {
@@ -120,16 +122,18 @@ void AuraDigitalFilter::reset() {
 
 void AuraDigitalFilter::update(double dt)
 {
+    update_config();
+
     // test if all of the provided enable flags are true
     enabled = true;
-    for ( unsigned int i = 0; i < enables_node.size(); i++ ) {
-        if ( !enables_node[i].getBool(enables_attr[i].c_str()) ) {
+    for ( unsigned int i = 0; i < enables_slot.size(); i++ ) {
+        if ( !signals->get_bool(enables_slot[i]) ) {
             enabled = false;
             break;
         }
     }
 
-    input.push_front( input_node.getDouble(input_attr.c_str()) );
+    input.push_front( signals->get( input_slot ) );
     input.resize(samples + 1, 0.0);
 
     if ( enabled && dt > 0.0 ) {
@@ -145,8 +149,8 @@ void AuraDigitalFilter::update(double dt)
             double alpha = 1 / ((Tf/dt) + 1);
             output.push_front(alpha * input[0] + 
                               (1 - alpha) * output[0]);
-	    for ( unsigned int i = 0; i < output_node.size(); i++ ) {
-		output_node[i].setDouble( output_attr[i].c_str(), output[0] );
+	    for ( unsigned int i = 0; i < output_slot.size(); i++ ) {
+		signals->set( output_slot[i], output[0] );
 	    }
             output.resize(1);
         } 
@@ -156,8 +160,8 @@ void AuraDigitalFilter::update(double dt)
             output.push_front(alpha * alpha * input[0] + 
                               2 * (1 - alpha) * output[0] -
                               (1 - alpha) * (1 - alpha) * output[1]);
- 	    for ( unsigned int i = 0; i < output_node.size(); i++ ) {
-		output_node[i].setDouble( output_attr[i].c_str(), output[0] );
+ 	    for ( unsigned int i = 0; i < output_slot.size(); i++ ) {
+		signals->set( output_slot[i], output[0] );
 	    }
             output.resize(2);
         }
@@ -165,8 +169,8 @@ void AuraDigitalFilter::update(double dt)
         {
             output.push_front(output[0] + 
                               (input[0] - input.back()) / samples);
- 	    for ( unsigned int i = 0; i < output_node.size(); i++ ) {
-		output_node[i].setDouble( output_attr[i].c_str(), output[0] );
+ 	    for ( unsigned int i = 0; i < output_slot.size(); i++ ) {
+		signals->set( output_slot[i], output[0] );
 	    }
             output.resize(1);
         }
@@ -187,12 +191,12 @@ void AuraDigitalFilter::update(double dt)
                 output.push_front(input[0]);
             }
 
- 	    for ( unsigned int i = 0; i < output_node.size(); i++ ) {
-		output_node[i].setDouble( output_attr[i].c_str(), output[0] );
+ 	    for ( unsigned int i = 0; i < output_slot.size(); i++ ) {
+		signals->set( output_slot[i], output[0] );
 	    }
 	    output.resize(1);
         }
-        if ( component_node.getBool("debug") ) {
+        if ( debug ) {
             printf("input: %.3f\toutput: %.3f\n", input[0], output[0]);
         }
     }
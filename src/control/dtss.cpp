@@ -30,7 +30,8 @@ AuraDTSS::AuraDTSS( string config_path ):
     nx(1),
     nz(1),
     nu(1),
-    do_reset(true)
+    do_reset(true),
+    kernel(NULL)
 {
     size_t pos;
     unsigned int len;
@@ -90,7 +91,7 @@ AuraDTSS::AuraDTSS( string config_path ):
     }
 
     // z_trim
-    z_trim = VectorXd(nz);
+    VectorXd z_trim = VectorXd::Zero(nz);
     len = component_node.getLen("z_trim");
     if ( len != nz ) {
         printf("WARNING: wrong number of elements for z_trim vector: %d\n", len);
@@ -135,7 +136,7 @@ AuraDTSS::AuraDTSS( string config_path ):
         printf("A improperly sized, len = %d\n", len);
         nx = (int)sqrt(len);
     }
-    A = MatrixXd(nx, nx);
+    MatrixXd A(nx, nx);
     for ( unsigned int r = 0; r < nx; ++r ) {
         for ( unsigned int c = 0; c < nx; ++c ) {
             A(r,c) = component_node.getDouble("A", r*nx + c);
@@ -148,7 +149,7 @@ AuraDTSS::AuraDTSS( string config_path ):
     if ( len != nx * nz ) {
         printf("B improperly sized, len = %d\n", len);
     }
-    B = MatrixXd(nx, nz);
+    MatrixXd B(nx, nz);
     for ( unsigned int r = 0; r < nx; ++r ) {
         for ( unsigned int c = 0; c < nz; ++c ) {
             B(r,c) = component_node.getDouble("B", r*nz + c);
@@ -161,7 +162,7 @@ AuraDTSS::AuraDTSS( string config_path ):
     if ( len != nu * nx ) {
         printf("C improperly sized, len = %d\n", len);
     }
-    C = MatrixXd(nu, nx);
+    MatrixXd C(nu, nx);
     for ( unsigned int r = 0; r < nu; ++r ) {
         for ( unsigned int c = 0; c < nx; ++c ) {
             C(r,c) = component_node.getDouble("C", r*nx + c);
@@ -174,7 +175,7 @@ AuraDTSS::AuraDTSS( string config_path ):
     if ( len != nu * nz ) {
         printf("D improperly sized, len = %d\n", len);
     }
-    D = MatrixXd(nu, nz);
+    MatrixXd D(nu, nz);
     for ( unsigned int r = 0; r < nu; ++r ) {
         for ( unsigned int c = 0; c < nz; ++c ) {
             D(r,c) = component_node.getDouble("D", r*nz + c);
@@ -183,22 +184,15 @@ AuraDTSS::AuraDTSS( string config_path ):
     std::cout << D << std::endl;
 
     // initial state is zero
-    x = VectorXd(nx);
-    z = VectorXd(nz);
-    u = VectorXd(nu);
-    x.setZero();
-    z.setZero();
-    u.setZero();
-
-    // allocate internally used matrices
-    M = MatrixXd(nx + nz, nx + nz);
-    S = MatrixXd(nx + nz, nx + nz);
-    T = MatrixXd(nx + nz, nx + nz);
-    F = MatrixXd(nx, nx);
-    G = MatrixXd(nx, nz);
+    kernel = dtss_kernel_new( nx, nz, nu );
+    kernel->set_model( A, B, C, D, z_trim );
+    z.assign( nz, 0.0 );
+    u.assign( nu, 0.0 );
 
     // config
     config_node = component_node.getChild( "config", true );
+
+    watch_config();
 }
 
 
@@ -208,55 +202,42 @@ void AuraDTSS::reset() {
 
 
 void AuraDTSS::update( double dt ) {
+    update_config();
+
     // test if all of the provided enable flags are true
     enabled = true;
-    for ( unsigned int i = 0; i < enables_node.size(); i++ ) {
-        if ( !enables_node[i].getBool(enables_attr[i].c_str()) ) {
+    for ( unsigned int i = 0; i < enables_slot.size(); i++ ) {
+        if ( !signals->get_bool(enables_slot[i]) ) {
             enabled = false;
             break;
         }
     }
 
-    bool debug = component_node.getBool("debug");
     if ( debug ) printf("Updating %s\n", get_name().c_str());
 
-    // construct the M matrix
-    M.topLeftCorner(nx,nx) = A * dt;
-    M.topRightCorner(nx,nz) = B * dt;
-    M.bottomRows(nz).setZero();
-
-    // compute the S matrix = I + M + M^2/2 + M^3/6
-    S.setIdentity();
-    T = M;                      // M
-    S += T;
-    T *= M;                     // M^2
-    S += T / 2.0;
-    T *= M;                     // M^3
-    S += T / 6.0;
-
-    // extract the F & G matrices
-    F = S.topLeftCorner(nx, nx);
-    G = S.topRightCorner(nx, nz);
+    // gather the inputs
+    for ( unsigned int i = 0; i < nz && i < inputs_slot.size(); ++i ) {
+        z[i] = signals->get( inputs_slot[i] );
+    }
 
     // update states
     if ( do_reset ) {
         do_reset = false;
-        x.setZero();
-        for ( unsigned int i = 0; i < nz; ++i ) {
-            z(i) = inputs_node[i].getDouble(inputs_attr[i].c_str());
+        kernel->reset( z.data(), u.data() );
+        if ( enabled ) {
+            stats.resets++;
         }
-        u = C*x + D*(z - z_trim);
     } else {
-        x = F*x + G*(z - z_trim);
-        for ( unsigned int i = 0; i < nz; ++i ) {
-            z(i) = inputs_node[i].getDouble(inputs_attr[i].c_str());
-        }
-        u = C*x + D*(z - z_trim);
+        kernel->update( dt, z.data(), u.data() );
     }
 
     if ( debug ) {
-        std::cout << "z: " << z << std::endl;
-        std::cout << "u: " << u << std::endl;
+        for ( unsigned int i = 0; i < nz; ++i ) {
+            printf("  z[%d] = %.3f\n", i, z[i]);
+        }
+        for ( unsigned int i = 0; i < nu; ++i ) {
+            printf("  u[%d] = %.3f\n", i, u[i]);
+        }
     }
 
     if ( !enabled ) {
@@ -264,13 +245,41 @@ void AuraDTSS::update( double dt ) {
         do_reset = true;
     } else {
         // write outputs
-        for ( unsigned int i = 0; i < nu; ++i ) {
-            double value = u(i) + u_trim[i];
-            if ( value < u_min[i] ) { value = u_min[i]; }
-            if ( value > u_max[i] ) { value = u_max[i]; }
-            outputs_node[i].setDouble( outputs_attr[i].c_str(), value );
+        bool clamped = false;
+        for ( unsigned int i = 0; i < outputs_slot.size(); ++i ) {
+            double value = u[i] + u_trim[i];
+            if ( value < u_min[i] ) { value = u_min[i]; clamped = true; }
+            if ( value > u_max[i] ) { value = u_max[i]; clamped = true; }
+            signals->set( outputs_slot[i], value );
+        }
+        if ( clamped ) {
+            stats.clamps++;
         }
     }
 }
 
 
+
+
+void AuraDTSS::bind_signals( APSignals *table ) {
+    APComponent::bind_signals( table );
+    inputs_slot.clear();
+    for ( unsigned int i = 0; i < inputs_node.size(); i++ ) {
+        inputs_slot.push_back( table->bind(inputs_node[i], inputs_attr[i]) );
+    }
+    outputs_slot.clear();
+    for ( unsigned int i = 0; i < outputs_node.size(); i++ ) {
+        outputs_slot.push_back( table->bind(outputs_node[i], outputs_attr[i]) );
+    }
+}
+
+
+void AuraDTSS::get_dependencies( APStageDeps *deps ) {
+    APComponent::get_dependencies( deps );
+    for ( unsigned int i = 0; i < inputs_node.size(); i++ ) {
+        deps->reads.push_back( prop_key(inputs_node[i], inputs_attr[i]) );
+    }
+    for ( unsigned int i = 0; i < outputs_node.size(); i++ ) {
+        deps->writes.push_back( prop_key(outputs_node[i], outputs_attr[i]) );
+    }
+}
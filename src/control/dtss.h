@@ -29,6 +29,7 @@ using std::string;
 using namespace Eigen;
 
 #include "component.h"
+#include "dtss_kernel.h"
 
 
 typedef Matrix<double, Dynamic, Dynamic> MatrixXd;
@@ -42,16 +43,18 @@ private:
     unsigned int nx, nz, nu;
     bool do_reset;
 
-    VectorXd x, z, u;
-    MatrixXd A, B, C, D;
-    MatrixXd M, S, T, F, G;
-    
+    // fixed size for small systems (see dtss_kernel.h)
+    DTSSKernel *kernel;
+    vector <double> z;          // gathered inputs
+    vector <double> u;          // outputs
+
     vector <pyPropertyNode> inputs_node;
     vector <string> inputs_attr;
-    VectorXd z_trim;
+    vector <int> inputs_slot;
     
     vector <pyPropertyNode> outputs_node;
     vector <string> outputs_attr;
+    vector <int> outputs_slot;
 
     vector <double> u_min;
     vector <double> u_max;
@@ -60,8 +63,10 @@ private:
 public:
 
     AuraDTSS( string config_path );
-    ~AuraDTSS() {}
+    ~AuraDTSS() { delete kernel; }
 
     void reset();
     void update( double dt );
+    void bind_signals( APSignals *table );
+    void get_dependencies( APStageDeps *deps );
 };
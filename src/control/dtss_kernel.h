@@ -0,0 +1,192 @@
+// dtss_kernel.h - the discrete time state space update
+//
+// Copyright (C) 2020  Curtis L. Olson  - curtolson@flightgear.org
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Library General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Library General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+
+
+#pragma once
+
+#include <eigen3/Eigen/Core>
+using namespace Eigen;
+
+
+// x' = A x + B z, u = C x + D z (z relative to z_trim), discretized
+// for the frame dt with the third order expansion of the matrix
+// exponential.  Inputs and outputs are passed as contiguous arrays.
+class DTSSKernel {
+
+public:
+
+    virtual ~DTSSKernel() {}
+
+    virtual void set_model( const Matrix<double, Dynamic, Dynamic> &A,
+                            const Matrix<double, Dynamic, Dynamic> &B,
+                            const Matrix<double, Dynamic, Dynamic> &C,
+                            const Matrix<double, Dynamic, Dynamic> &D,
+                            const Matrix<double, Dynamic, 1> &z_trim ) = 0;
+
+    // zero the state, u from the inputs z
+    virtual void reset( const double *z, double *u ) = 0;
+
+    // advance the state over dt with the previous inputs, then u from
+    // the new inputs z
+    virtual void update( double dt, const double *z, double *u ) = 0;
+};
+
+
+// NX states, NZ inputs, NU outputs: fixed sizes are unrolled /
+// vectorized by eigen and live inside the object, Dynamic sizes are
+// allocated once in the constructor.  Either way update() doesn't
+// touch the heap, and F, G are only recomputed when dt changes.
+template <int NX, int NZ, int NU>
+class DTSSKernelN : public DTSSKernel {
+
+    enum { NS = (NX == Dynamic || NZ == Dynamic) ? (int)Dynamic : NX + NZ };
+
+    typedef Matrix<double, NX, 1> VecX;
+    typedef Matrix<double, NZ, 1> VecZ;
+    typedef Matrix<double, NU, 1> VecU;
+
+    int nx, nz, nu;
+    double last_dt;
+
+    Matrix<double, NX, NX> A, F;
+    Matrix<double, NX, NZ> B, G;
+    Matrix<double, NU, NX> C;
+    Matrix<double, NU, NZ> D;
+    Matrix<double, NS, NS> M, S, T, T2;
+    VecX x, xn;
+    VecZ z, dz, z_trim;
+    VecU u;
+
+    void discretize( double dt ) {
+        M.template topLeftCorner<NX, NX>(nx, nx) = A * dt;
+        M.template topRightCorner<NX, NZ>(nx, nz) = B * dt;
+        M.template bottomRows<NZ>(nz).setZero();
+
+        // S = I + M + M^2/2 + M^3/6
+        S.setIdentity();
+        S += M;
+        T.noalias() = M * M;
+        S += T / 2.0;
+        T2.noalias() = T * M;
+        S += T2 / 6.0;
+
+        F = S.template topLeftCorner<NX, NX>(nx, nx);
+        G = S.template topRightCorner<NX, NZ>(nx, nz);
+        last_dt = dt;
+    }
+
+public:
+
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    DTSSKernelN( int nx, int nz, int nu ):
+        nx(nx),
+        nz(nz),
+        nu(nu),
+        last_dt(-1.0)
+    {
+        A.setZero(nx, nx);
+        F.setZero(nx, nx);
+        B.setZero(nx, nz);
+        G.setZero(nx, nz);
+        C.setZero(nu, nx);
+        D.setZero(nu, nz);
+        M.setZero(nx + nz, nx + nz);
+        S.setZero(nx + nz, nx + nz);
+        T.setZero(nx + nz, nx + nz);
+        T2.setZero(nx + nz, nx + nz);
+        x.setZero(nx);
+        xn.setZero(nx);
+        z.setZero(nz);
+        dz.setZero(nz);
+        z_trim.setZero(nz);
+        u.setZero(nu);
+    }
+
+    void set_model( const Matrix<double, Dynamic, Dynamic> &A,
+                    const Matrix<double, Dynamic, Dynamic> &B,
+                    const Matrix<double, Dynamic, Dynamic> &C,
+                    const Matrix<double, Dynamic, Dynamic> &D,
+                    const Matrix<double, Dynamic, 1> &z_trim ) {
+        this->A = A;
+        this->B = B;
+        this->C = C;
+        this->D = D;
+        this->z_trim = z_trim;
+        last_dt = -1.0;
+    }
+
+    void reset( const double *zin, double *uout ) {
+        x.setZero();
+        z = Map<const VecZ>(zin, nz);
+        dz = z - z_trim;
+        u.noalias() = C * x;
+        u.noalias() += D * dz;
+        Map<VecU>(uout, nu) = u;
+    }
+
+    void update( double dt, const double *zin, double *uout ) {
+        if ( dt != last_dt ) {
+            discretize( dt );
+        }
+        dz = z - z_trim;
+        xn.noalias() = F * x;
+        xn.noalias() += G * dz;
+        x = xn;
+        z = Map<const VecZ>(zin, nz);
+        dz = z - z_trim;
+        u.noalias() = C * x;
+        u.noalias() += D * dz;
+        Map<VecU>(uout, nu) = u;
+    }
+};
+
+
+// pick a fixed size kernel for up to 4 states, inputs and outputs
+template <int NX, int NZ>
+inline DTSSKernel *dtss_kernel_nu( int nx, int nz, int nu ) {
+    switch ( nu ) {
+    case 1: return new DTSSKernelN<NX, NZ, 1>( nx, nz, nu );
+    case 2: return new DTSSKernelN<NX, NZ, 2>( nx, nz, nu );
+    case 3: return new DTSSKernelN<NX, NZ, 3>( nx, nz, nu );
+    case 4: return new DTSSKernelN<NX, NZ, 4>( nx, nz, nu );
+    }
+    return new DTSSKernelN<Dynamic, Dynamic, Dynamic>( nx, nz, nu );
+}
+
+template <int NX>
+inline DTSSKernel *dtss_kernel_nz( int nx, int nz, int nu ) {
+    switch ( nz ) {
+    case 1: return dtss_kernel_nu<NX, 1>( nx, nz, nu );
+    case 2: return dtss_kernel_nu<NX, 2>( nx, nz, nu );
+    case 3: return dtss_kernel_nu<NX, 3>( nx, nz, nu );
+    case 4: return dtss_kernel_nu<NX, 4>( nx, nz, nu );
+    }
+    return new DTSSKernelN<Dynamic, Dynamic, Dynamic>( nx, nz, nu );
+}
+
+inline DTSSKernel *dtss_kernel_new( int nx, int nz, int nu ) {
+    switch ( nx ) {
+    case 1: return dtss_kernel_nz<1>( nx, nz, nu );
+    case 2: return dtss_kernel_nz<2>( nx, nz, nu );
+    case 3: return dtss_kernel_nz<3>( nx, nz, nu );
+    case 4: return dtss_kernel_nz<4>( nx, nz, nu );
+    }
+    return new DTSSKernelN<Dynamic, Dynamic, Dynamic>( nx, nz, nu );
+}
@@ -0,0 +1,158 @@
+// dtss_test.cpp -- check the state space kernels against the original
+//                  (dynamic, allocate per frame) update, check update()
+//                  doesn't allocate, and time both.
+//
+// g++ -O3 -march=native -I.. dtss_test.cpp ../util/timing.cpp -o dtss_test
+
+#define EIGEN_RUNTIME_NO_MALLOC
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "util/timing.h"
+
+#include "dtss_kernel.h"
+
+typedef Matrix<double, Dynamic, Dynamic> MatrixXd;
+typedef Matrix<double, Dynamic, 1> VectorXd;
+
+// the previous AuraDTSS::update() math
+struct Reference {
+    int nx, nz, nu;
+    MatrixXd A, B, C, D, M, S, T, F, G;
+    VectorXd x, z, u, z_trim;
+
+    void update( double dt, const double *zin, bool reset ) {
+        M.topLeftCorner(nx,nx) = A * dt;
+        M.topRightCorner(nx,nz) = B * dt;
+        M.bottomRows(nz).setZero();
+        S.setIdentity();
+        T = M;
+        S += T;
+        T *= M;
+        S += T / 2.0;
+        T *= M;
+        S += T / 6.0;
+        F = S.topLeftCorner(nx, nx);
+        G = S.topRightCorner(nx, nz);
+        if ( reset ) {
+            x.setZero();
+        } else {
+            x = F*x + G*(z - z_trim);
+        }
+        for ( int i = 0; i < nz; ++i ) {
+            z(i) = zin[i];
+        }
+        u = C*x + D*(z - z_trim);
+    }
+};
+
+static double rnd() {
+    return (double)rand() / RAND_MAX - 0.5;
+}
+
+// run one size: compare, check for allocations, time
+static bool run( int nx, int nz, int nu, bool fixed ) {
+    Reference ref;
+    ref.nx = nx; ref.nz = nz; ref.nu = nu;
+    ref.A = MatrixXd(nx, nx);
+    ref.B = MatrixXd(nx, nz);
+    ref.C = MatrixXd(nu, nx);
+    ref.D = MatrixXd(nu, nz);
+    ref.z_trim = VectorXd(nz);
+    for ( int r = 0; r < nx; r++ ) {
+        for ( int c = 0; c < nx; c++ ) {
+            ref.A(r, c) = (r == c) ? -2.0 - r : 0.5 * rnd();
+        }
+        for ( int c = 0; c < nz; c++ ) { ref.B(r, c) = rnd(); }
+    }
+    for ( int r = 0; r < nu; r++ ) {
+        for ( int c = 0; c < nx; c++ ) { ref.C(r, c) = rnd(); }
+        for ( int c = 0; c < nz; c++ ) { ref.D(r, c) = rnd(); }
+    }
+    for ( int i = 0; i < nz; i++ ) { ref.z_trim(i) = rnd(); }
+    ref.M = MatrixXd(nx + nz, nx + nz);
+    ref.S = MatrixXd(nx + nz, nx + nz);
+    ref.T = MatrixXd(nx + nz, nx + nz);
+    ref.x = VectorXd(nx);
+    ref.z = VectorXd(nz);
+    ref.u = VectorXd(nu);
+
+    DTSSKernel *kernel;
+    if ( fixed ) {
+        kernel = dtss_kernel_new( nx, nz, nu );
+    } else {
+        kernel = new DTSSKernelN<Dynamic, Dynamic, Dynamic>( nx, nz, nu );
+    }
+    kernel->set_model( ref.A, ref.B, ref.C, ref.D, ref.z_trim );
+
+    // same outputs (two dt's to exercise the rediscretization)
+    bool pass = true;
+    double z[8], u[8];
+    double max_err = 0.0;
+    for ( int f = 0; f < 1000; f++ ) {
+        double dt = (f < 500) ? 0.01 : 0.02;
+        for ( int i = 0; i < nz; i++ ) { z[i] = sin( 0.01 * f * (i + 1) ); }
+        ref.update( dt, z, f == 0 );
+        Eigen::internal::set_is_malloc_allowed( false );
+        if ( f == 0 ) {
+            kernel->reset( z, u );
+        } else {
+            kernel->update( dt, z, u );
+        }
+        Eigen::internal::set_is_malloc_allowed( true );
+        for ( int i = 0; i < nu; i++ ) {
+            double err = fabs( u[i] - ref.u(i) );
+            if ( err > max_err ) { max_err = err; }
+        }
+    }
+    if ( max_err > 1e-10 ) {
+        printf("FAIL: %dx%dx%d output differs by %g\n", nx, nz, nu, max_err);
+        pass = false;
+    }
+
+    // timing
+    const int frames = 200000;
+    double start = get_Time();
+    for ( int f = 0; f < frames; f++ ) {
+        z[0] = 0.001 * f;
+        ref.update( 0.01, z, false );
+    }
+    double ref_us = (get_Time() - start) * 1e6 / frames;
+    start = get_Time();
+    for ( int f = 0; f < frames; f++ ) {
+        z[0] = 0.001 * f;
+        kernel->update( 0.01, z, u );
+    }
+    double kernel_us = (get_Time() - start) * 1e6 / frames;
+    // (jittery dt: discretized every frame)
+    start = get_Time();
+    for ( int f = 0; f < frames; f++ ) {
+        z[0] = 0.001 * f;
+        kernel->update( 0.01 + 1e-6 * (f & 1), z, u );
+    }
+    double jitter_us = (get_Time() - start) * 1e6 / frames;
+    printf("%d states %d in %d out (%s): original %.3f us, kernel %.3f us "
+           "(%.1fx), new dt each frame %.3f us (%.1fx)\n",
+           nx, nz, nu, fixed ? "auto" : "dynamic", ref_us, kernel_us,
+           ref_us / kernel_us, jitter_us, ref_us / jitter_us);
+    delete kernel;
+    return pass;
+}
+
+int main() {
+    bool pass = true;
+    pass &= run( 1, 1, 1, true );
+    pass &= run( 2, 2, 2, true );
+    pass &= run( 4, 2, 1, true );
+    pass &= run( 4, 4, 4, true );
+    pass &= run( 4, 4, 4, false );
+    pass &= run( 6, 3, 2, true );   // beyond the fixed sizes
+
+    if ( !pass ) {
+        return 1;
+    }
+    printf("PASS\n");
+    return 0;
+}
@@ -0,0 +1,573 @@
+// nav_mgr.cpp - route following and circling (L1 guidance)
+//
+// Copyright (C) 2020  Curtis L. Olson  - curtolson@flightgear.org
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Library General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Library General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+
+#ifdef HAVE_PYBIND11
+  #include <pybind11/pybind11.h>
+  namespace py = pybind11;
+#endif
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <string>
+#include <vector>
+using std::string;
+using std::vector;
+
+#include "util/wgs84.h"
+#include "util/windtri.h"
+
+#include "nav_mgr.h"
+
+static const double d2r = M_PI / 180.0;
+static const double r2d = 180.0 / M_PI;
+static const double kt2mps = 0.5144444444444444444;
+static const double sqrt_of_2 = sqrt(2.0);
+static const double gravity = 9.81; // m/sec^2
+
+
+nav_mgr_t::nav_mgr_t():
+    active( 0 ),
+    current_wp( 0 ),
+    acquired( false ),
+    wp_counter( 0 )
+{
+}
+
+
+void nav_mgr_t::init() {
+    pyPropsInit();              // first things first
+
+    nav_node = pyGetNode( "/navigation", true );
+    route_node = pyGetNode( "/task/route", true );
+    active_route_node = pyGetNode( "/task/route/active", true );
+    circle_node = pyGetNode( "/task/circle/active", true );
+    pos_node = pyGetNode( "/position", true );
+    comms_node = pyGetNode( "/comms", true );
+    L1_node = pyGetNode( "/config/autopilot/L1_controller", true );
+    pyPropertyNode home_node = pyGetNode( "/task/home", true );
+    pyPropertyNode vel_node = pyGetNode( "/velocity", true );
+    pyPropertyNode orient_node = pyGetNode( "/orientation", true );
+    pyPropertyNode gps_node = pyGetNode( "/sensors/gps", true );
+    pyPropertyNode wind_node = pyGetNode( "/filters/wind", true );
+    pyPropertyNode targets_node = pyGetNode( "/autopilot/targets", true );
+
+    // sanity check, set some conservative values if none are
+    // provided in the autopilot config
+    if ( L1_node.getDouble("bank_limit_deg") < 0.1 ) {
+        L1_node.setDouble( "bank_limit_deg", 25.0 );
+    }
+    if ( L1_node.getDouble("period") < 0.1 ) {
+        L1_node.setDouble( "period", 25.0 );
+    }
+    if ( L1_node.getDouble("damping") < 0.1 ) {
+        L1_node.setDouble( "damping", 0.7 );
+    }
+
+    // defaults
+    route_node.setString( "follow_mode", "leader" );
+    route_node.setString( "start_mode", "first_wpt" );
+    route_node.setString( "completion_mode", "loop" );
+
+    home_lon.init( home_node, "longitude_deg" );
+    home_lat.init( home_node, "latitude_deg" );
+    home_az.init( home_node, "azimuth_deg" );
+    pos_lon.init( pos_node, "longitude_deg" );
+    pos_lat.init( pos_node, "latitude_deg" );
+    gs_mps.init( vel_node, "groundspeed_ms" );
+    groundtrack_deg.init( orient_node, "groundtrack_deg" );
+    heading_deg.init( orient_node, "heading_deg" );
+    gps_data_age.init( gps_node, "data_age" );
+    wind_speed_kt.init( wind_node, "wind_speed_kt" );
+    wind_dir_deg.init( wind_node, "wind_dir_deg" );
+    tas_kt.init( wind_node, "true_airspeed_kt" );
+    L1_period.init( L1_node, "period" );
+    L1_damping.init( L1_node, "damping" );
+    bank_bias_deg.init( L1_node, "bank_bias_deg" );
+    bank_limit_deg.init( L1_node, "bank_limit_deg" );
+    target_groundtrack_deg.init( targets_node, "groundtrack_deg" );
+    target_roll_deg.init( targets_node, "roll_deg" );
+    wind_heading_error_deg.init( targets_node, "wind_heading_error_deg" );
+    course_error_deg.init( targets_node, "course_error_deg" );
+    xtrack_dist_m.init( route_node, "xtrack_dist_m" );
+    projected_dist_m.init( route_node, "projected_dist_m" );
+    wp_dist_m.init( route_node, "wp_dist_m" );
+    wp_eta_sec.init( route_node, "wp_eta_sec" );
+    dist_remaining_m.init( route_node, "dist_remaining_m" );
+    route_size.init( route_node, "route_size" );
+    target_waypoint_idx.init( route_node, "target_waypoint_idx" );
+    active_route_size.init( active_route_node, "route_size" );
+    circle_radius_m.init( circle_node, "radius_m" );
+}
+
+
+void nav_mgr_t::clear_standby() {
+    routes[1 - active].clear( home_lon.getDouble(), home_lat.getDouble(),
+                              home_az.getDouble() );
+}
+
+
+void nav_mgr_t::add_standby_absolute( double lon_deg, double lat_deg ) {
+    routes[1 - active].add_absolute( lon_deg, lat_deg );
+}
+
+
+void nav_mgr_t::add_standby_relative( double hdg_deg, double dist_m ) {
+    routes[1 - active].add_relative( hdg_deg, dist_m );
+}
+
+
+// build the standby route from a request string: groups of four
+// tokens "mode,a,b,x" where mode 0 = relative (a = distance m, b =
+// heading deg) and anything else = absolute (a = lon, b = lat)
+bool nav_mgr_t::build_str( string request ) {
+    vector<string> tokens;
+    size_t start = 0;
+    while ( true ) {
+        size_t pos = request.find( ",", start );
+        tokens.push_back( request.substr(start, pos - start) );
+        if ( pos == string::npos ) {
+            break;
+        }
+        start = pos + 1;
+    }
+    if ( tokens.size() < 4 ) {
+        return false;
+    }
+    clear_standby();
+    for ( unsigned int i = 0; i + 4 <= tokens.size(); i += 4 ) {
+        int mode = atoi( tokens[i].c_str() );
+        double a = atof( tokens[i+1].c_str() );
+        double b = atof( tokens[i+2].c_str() );
+        if ( mode == 0 ) {
+            add_standby_relative( b, a );
+        } else {
+            add_standby_absolute( a, b );
+        }
+    }
+    printf("Loaded %d waypoints\n", routes[1 - active].size());
+    return true;
+}
+
+
+void nav_mgr_t::swap() {
+    active = 1 - active;
+    current_wp = 0;             // make sure we start at beginning
+}
+
+
+// publish the active route into /task/route/active (one waypoint
+// per call to keep the load consistent and light.)
+void nav_mgr_t::dribble( bool reset ) {
+    if ( reset ) {
+        wp_counter = 0;
+    }
+    AuraRoute &route = routes[active];
+    active_route_size.setLong( route.size() );
+    if ( route.size() > 0 ) {
+        if ( wp_counter >= route.size() ) {
+            wp_counter = 0;
+        }
+        const AuraWaypoint &wp = route.get( wp_counter );
+        char wp_str[32];
+        snprintf( wp_str, sizeof(wp_str), "wpt[%d]", wp_counter );
+        pyPropertyNode wp_node = active_route_node.getChild( wp_str, true );
+        wp_node.setDouble( "longitude_deg", wp.lon_deg );
+        wp_node.setDouble( "latitude_deg", wp.lat_deg );
+        wp_counter++;
+    }
+}
+
+
+// follow home with the relative waypoints of the active route
+void nav_mgr_t::reposition( bool force ) {
+    double lon = home_lon.getDouble();
+    double lat = home_lat.getDouble();
+    double az = home_az.getDouble();
+    if ( routes[active].set_home( lon, lat, az, force ) ) {
+        if ( comms_node.getBool("display_on") ) {
+            printf("ROUTE pattern updated: %.6f %.6f (course = %.1f)\n",
+                   lon, lat, az);
+        }
+    }
+}
+
+
+// Given wind speed, wind direction, and true airspeed, as well as a
+// current ground course, and a target ground course, compute the
+// estimated true heading (psi, aircraft body heading) difference
+// that will take us from the current ground course to the target
+// ground course.
+//
+// Note: this produces accurate tracking, even if the wind estimate
+// is wrong.  The primary affect of a poor wind estimate is
+// sub-optimal heading error gain.  i.e. the when the current course
+// and target course are aligned, this function always produces zero
+// error.  (If the wind is too strong to fly a course, wind_course()
+// points the nose into the wind to kite.)
+double nav_mgr_t::wind_heading_error( double current_crs_deg,
+                                      double target_crs_deg )
+{
+    double ws_kt = wind_speed_kt.getDouble();
+    double tas = tas_kt.getDouble();
+    double wd_deg = wind_dir_deg.getDouble();
+    double est_cur_hdg_deg, gs1_kt;
+    double est_nav_hdg_deg, gs2_kt;
+    wind_course( ws_kt, tas, wd_deg, current_crs_deg,
+                 &est_cur_hdg_deg, &gs1_kt );
+    wind_course( ws_kt, tas, wd_deg, target_crs_deg,
+                 &est_nav_hdg_deg, &gs2_kt );
+    double hdg_error = est_cur_hdg_deg - est_nav_hdg_deg;
+    if ( hdg_error < -180 ) { hdg_error += 360; }
+    if ( hdg_error > 180 ) { hdg_error -= 360; }
+    return hdg_error;
+}
+
+
+// bank angle for a lateral acceleration (with the configured bias
+// and limit.)  The bias is a crude fudge factor for non-straight
+// airframes or imu mounting errors: the bank angle that yields zero
+// turn rate.
+double nav_mgr_t::bank_target( double accel ) {
+    double bias_deg = bank_bias_deg.getDouble();
+    double limit_deg = bank_limit_deg.getDouble();
+    double target_bank_deg = -atan( accel / gravity ) * r2d + bias_deg;
+    if ( target_bank_deg < -limit_deg + bias_deg ) {
+        target_bank_deg = -limit_deg + bias_deg;
+    }
+    if ( target_bank_deg > limit_deg + bias_deg ) {
+        target_bank_deg = limit_deg + bias_deg;
+    }
+    return target_bank_deg;
+}
+
+
+void nav_mgr_t::update_route() {
+    reposition( false );
+
+    string request = route_node.getString( "route_request" );
+    if ( request.length() ) {
+        string result;
+        if ( build_str(request) ) {
+            swap();
+            reposition( true );
+            result = "success: " + request;
+            dribble( true );
+        } else {
+            result = "failed: " + request;
+        }
+        route_node.setString( "request_result", result );
+        route_node.setString( "route_request", "" );
+    }
+
+    AuraRoute &route = routes[active];
+    route_size.setLong( route.size() );
+
+    // track current waypoint of route (only!) if we have recent gps
+    // data.  FIXME: with no route defined we should probably do some
+    // sort of circle of our home position.
+    if ( route.size() > 0 && gps_data_age.getDouble() < 10.0 ) {
+        // route start up logic: if start_mode == first_wpt then there
+        // is nothing to do, we simply continue to track wpt 0 if that
+        // is the current waypoint.  If start_mode == 'first_leg',
+        // then if we are tracking wpt 0, increment it so we track the
+        // 2nd waypoint along the first leg.  If only a 1 point route
+        // is given along with first_leg startup behavior, then don't
+        // do that again, force some sort of sane route parameters
+        // instead!
+        if ( current_wp == 0
+             && route_node.getString("start_mode") == "first_leg" ) {
+            if ( route.size() > 1 ) {
+                current_wp++;
+            } else {
+                route_node.setString( "start_mode", "first_wpt" );
+                route_node.setString( "follow_mode", "direct" );
+            }
+        }
+
+        double period = L1_period.getDouble();
+        double damping = L1_damping.getDouble();
+        double gs = gs_mps.getDouble();
+        double tas_mps = tas_kt.getDouble() * kt2mps;
+
+        const AuraWaypoint &wp = route.get( current_wp );
+
+        // direct-to course and distance (the leg course and distance
+        // are cached with the route)
+        double direct_course, rev_course, direct_dist;
+        geo_inverse_wgs84( pos_lat.getDouble(), pos_lon.getDouble(),
+                           wp.lat_deg, wp.lon_deg,
+                           &direct_course, &rev_course, &direct_dist );
+
+        // difference between ideal (leg) course and direct course
+        double angle = wp.leg_course_deg - direct_course;
+        if ( angle < -180.0 ) {
+            angle += 360.0;
+        } else if ( angle > 180.0 ) {
+            angle -= 360.0;
+        }
+
+        // cross-track error
+        double angle_rad = angle * d2r;
+        double xtrack_m = sin(angle_rad) * direct_dist;
+        double dist_m = cos(angle_rad) * direct_dist;
+        xtrack_dist_m.setDouble( xtrack_m );
+        projected_dist_m.setDouble( dist_m );
+
+        // default distance for waypoint acquisition = direct distance
+        // to the target waypoint.  This can be overridden later by
+        // leg following and replaced with distance remaining along
+        // the leg.
+        double nav_dist_m = direct_dist;
+        double nav_course = 0.0;
+
+        string follow_mode = route_node.getString( "follow_mode" );
+        if ( follow_mode == "direct" ) {
+            // steer direct to
+            nav_course = direct_course;
+        } else if ( follow_mode == "leader" ) {
+            // scale our L1_dist (something like a target heading
+            // gain) proportional to ground speed
+            double L1_dist = (1.0 / M_PI) * damping * period * gs;
+            double wangle = 0.0;
+            if ( L1_dist < 1.0 ) {
+                // ground really small or negative (problem?!?)
+                L1_dist = 1.0;
+            }
+            if ( L1_dist <= fabs(xtrack_m) ) {
+                // beyond L1 distance, steer as directly toward leg as
+                // allowed
+                wangle = 0.0;
+            } else {
+                // steer towards imaginary point projected onto the
+                // route leg L1_distance ahead of us
+                wangle = acos(fabs(xtrack_m) / L1_dist) * r2d;
+            }
+            if ( wangle < 30.0 ) { wangle = 30.0; }
+            if ( xtrack_m > 0.0 ) {
+                nav_course = direct_course + angle - 90.0 + wangle;
+            } else {
+                nav_course = direct_course + angle + 90.0 - wangle;
+            }
+            if ( acquired ) {
+                nav_dist_m = dist_m;
+            } else {
+                // direct to first waypoint until we've acquired this
+                // route
+                nav_course = direct_course;
+                nav_dist_m = direct_dist;
+            }
+        }
+        // (cross track steering modes xtrack_direct_hdg and
+        // xtrack_leg_hdg are deprecated, see route_mgr.cxx in the
+        // historical archives for reference code.)
+
+        double eta_sec = 99.0;  // just any sorta big value
+        if ( gs > 0.1 && fabs(nav_dist_m) > 0.1 ) {
+            eta_sec = nav_dist_m / gs;
+        }
+        wp_eta_sec.setDouble( gs > 0.1 ? dist_m / gs : 0.0 );
+        wp_dist_m.setDouble( direct_dist );
+
+        if ( nav_course < 0.0 ) { nav_course += 360.0; }
+        if ( nav_course > 360.0 ) { nav_course -= 360.0; }
+        target_groundtrack_deg.setDouble( nav_course );
+
+        // heading error is computed with wind triangles so this is
+        // the actual body heading error, not the ground track error,
+        // thus Vomega is computed with tas_mps, not gs_mps
+        double omegaA = sqrt_of_2 * M_PI / period;
+        double VomegaA = tas_mps * omegaA;
+        double hdg_error = wind_heading_error( groundtrack_deg.getDouble(),
+                                               nav_course );
+        // clamp to +/-90 so we still get max turn input when flying
+        // directly away from the heading.
+        if ( hdg_error < -90.0 ) { hdg_error = -90.0; }
+        if ( hdg_error > 90.0 ) { hdg_error = 90.0; }
+        wind_heading_error_deg.setDouble( hdg_error );
+
+        double accel = 2.0 * sin(hdg_error * d2r) * VomegaA;
+        target_roll_deg.setDouble( bank_target(accel) );
+
+        // estimate distance remaining to completion of route
+        dist_remaining_m.setDouble( nav_dist_m
+                                    + route.get_remaining_dist(current_wp) );
+
+        // logic to mark completion of leg and move to next leg.
+        // (circle_last_wpt and extend_last_leg both hold the last
+        // waypoint for now.  FIXME: circle_last_wpt should switch to
+        // circle mode.)
+        string completion_mode = route_node.getString( "completion_mode" );
+        bool loop = (completion_mode == "loop");
+        if ( eta_sec < 1.0 && (loop || completion_mode == "circle_last_wpt"
+                               || completion_mode == "extend_last_leg") ) {
+            acquired = true;
+            if ( current_wp < route.size() - 1 ) {
+                current_wp++;
+            } else if ( loop ) {
+                current_wp = 0;
+            }
+        }
+
+        // publish current target waypoint
+        target_waypoint_idx.setLong( current_wp );
+    }
+
+    // dribble active route into property tree
+    dribble( false );
+}
+
+
+void nav_mgr_t::update_circle() {
+    string direction_str = circle_node.getString( "direction" );
+    double direction = 1.0;
+    if ( direction_str == "right" ) {
+        direction = -1.0;
+    } else if ( direction_str == "left" ) {
+        direction = 1.0;
+    } else {
+        circle_node.setString( "direction", "left" );
+    }
+
+    if ( !pos_node.hasChild("longitude_deg")
+         || !pos_node.hasChild("latitude_deg") ) {
+        // no valid current position, bail out.
+        return;
+    }
+    double lon = pos_lon.getDouble();
+    double lat = pos_lat.getDouble();
+
+    double center_lon, center_lat;
+    if ( circle_node.hasChild("longitude_deg")
+         && circle_node.hasChild("latitude_deg") ) {
+        // we have a valid circle center
+        center_lon = circle_node.getDouble( "longitude_deg" );
+        center_lat = circle_node.getDouble( "latitude_deg" );
+    } else {
+        // we have a valid position, but no valid circle center, use
+        // current position.  (sanity fallback)
+        circle_node.setDouble( "longitude_deg", lon );
+        circle_node.setDouble( "latitude_deg", lat );
+        circle_node.setDouble( "radius_m", 100.0 );
+        circle_node.setString( "direction", "left" );
+        center_lon = lon;
+        center_lat = lat;
+    }
+
+    // compute course and distance to center of target circle
+    double course_deg, rev_deg, dist_m;
+    geo_inverse_wgs84( lat, lon, center_lat, center_lon,
+                       &course_deg, &rev_deg, &dist_m );
+
+    // compute ideal ground course to be on the circle perimeter if at
+    // ideal radius
+    double ideal_crs = course_deg + direction * 90;
+    if ( ideal_crs > 360.0 ) { ideal_crs -= 360.0; }
+    if ( ideal_crs < 0.0 ) { ideal_crs += 360.0; }
+
+    // (in)sanity check
+    double radius_m = 100.0;
+    if ( circle_node.hasChild("radius_m") ) {
+        radius_m = circle_radius_m.getDouble();
+        if ( radius_m < 35 ) { radius_m = 35; }
+    } else {
+        circle_radius_m.setDouble( 100.0 );
+    }
+
+    // compute a target ground course based on our actual radius
+    // distance
+    double target_crs = ideal_crs;
+    if ( dist_m < radius_m ) {
+        // inside circle, adjust target heading to expand our circling
+        // radius
+        double offset_deg = direction * 90.0 * (1.0 - dist_m / radius_m);
+        target_crs += offset_deg;
+    } else if ( dist_m > radius_m ) {
+        // outside circle, adjust target heading to tighten our
+        // circling radius
+        double offset_dist = dist_m - radius_m;
+        if ( offset_dist > radius_m ) { offset_dist = radius_m; }
+        double offset_deg = direction * 90 * offset_dist / radius_m;
+        target_crs -= offset_deg;
+    }
+    if ( target_crs > 360.0 ) { target_crs -= 360.0; }
+    if ( target_crs < 0.0 ) { target_crs += 360.0; }
+    target_groundtrack_deg.setDouble( target_crs );
+
+    // L1 'mathematical' response to error
+    double gs = gs_mps.getDouble();
+    double omegaA = sqrt_of_2 * M_PI / L1_period.getDouble();
+    double VomegaA = gs * omegaA;
+    double course_error = groundtrack_deg.getDouble() - target_crs;
+    // wrap to +/- 180
+    if ( course_error < -180.0 ) { course_error += 360.0; }
+    if ( course_error > 180.0 ) { course_error -= 360.0; }
+    // clamp to +/-90
+    if ( course_error < -90.0 ) { course_error = -90.0; }
+    if ( course_error > 90.0 ) { course_error = 90.0; }
+    course_error_deg.setDouble( course_error );
+
+    // accel: is the lateral acceleration we need to compensate for
+    // heading error
+    double accel = 2.0 * sin(course_error * d2r) * VomegaA;
+
+    // circling acceleration needed for our current distance from
+    // center
+    double turn_accel = 0.0;
+    if ( dist_m > 0.1 ) {
+        turn_accel = direction * gs * gs / dist_m;
+    }
+
+    // desired acceleration = acceleration required for course
+    // correction + acceleration required to maintain turn at current
+    // distance from center.
+    target_roll_deg.setDouble( bank_target(accel + turn_accel) );
+
+    wp_dist_m.setDouble( dist_m );
+    wp_eta_sec.setDouble( gs > 0.1 ? dist_m / gs : 0.0 );
+}
+
+
+void nav_mgr_t::update( double dt ) {
+    string mode = nav_node.getString( "mode" );
+    if ( mode == "circle" ) {
+        update_circle();
+    } else if ( mode == "route" ) {
+        update_route();
+    }
+}
+
+
+#ifdef HAVE_PYBIND11
+PYBIND11_MODULE(nav_mgr, m) {
+    py::class_<nav_mgr_t>(m, "nav_mgr")
+        .def(py::init<>())
+        .def("init", &nav_mgr_t::init)
+        .def("update", &nav_mgr_t::update)
+        .def("clear_standby", &nav_mgr_t::clear_standby)
+        .def("add_standby_absolute", &nav_mgr_t::add_standby_absolute)
+        .def("add_standby_relative", &nav_mgr_t::add_standby_relative)
+        .def("build_str", &nav_mgr_t::build_str)
+        .def("swap", &nav_mgr_t::swap)
+        .def("dribble", &nav_mgr_t::dribble)
+        .def("dist_valid", &nav_mgr_t::dist_valid)
+    ;
+}
+#endif // HAVE_PYBIND11
@@ -0,0 +1,101 @@
+// nav_mgr.h - route following and circling (L1 guidance)
+//
+// Copyright (C) 2020  Curtis L. Olson  - curtolson@flightgear.org
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Library General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Library General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+
+
+#pragma once
+
+#include <pyprops.h>
+
+#include <string>
+using std::string;
+
+#include "util/prop_handle.h"
+
+#include "nav_route.h"
+
+
+/**
+ * The /navigation modes: follow the active route ("route") or circle
+ * /task/circle/active ("circle"), setting the target ground track and
+ * bank angle in /autopilot/targets each frame.
+ *
+ * Owns the active and standby routes.  A new route is built into the
+ * standby slot (from the mission config, a survey or a route_request
+ * string from the ground) and swap() makes it active without copying.
+ * The active route is published to /task/route/active one waypoint
+ * per frame (dribble()) for the ground station.
+ */
+
+class nav_mgr_t {
+
+public:
+
+    nav_mgr_t();
+    ~nav_mgr_t() {}
+
+    void init();
+    void update( double dt );
+
+    // build the standby route
+    void clear_standby();
+    void add_standby_absolute( double lon_deg, double lat_deg );
+    void add_standby_relative( double hdg_deg, double dist_m );
+    bool build_str( string request );
+
+    // make the standby route active (and the active one standby)
+    void swap();
+
+    void dribble( bool reset );
+    bool dist_valid() { return routes[active].size() > 0; }
+
+private:
+
+    AuraRoute routes[2];
+    int active;                 // routes[active] is flown
+    int current_wp;
+    bool acquired;
+    int wp_counter;             // next waypoint to dribble
+
+    pyPropertyNode nav_node;
+    pyPropertyNode route_node;
+    pyPropertyNode active_route_node;
+    pyPropertyNode circle_node;
+    pyPropertyNode pos_node;
+    pyPropertyNode comms_node;
+    pyPropertyNode L1_node;
+
+    PropHandle home_lon, home_lat, home_az;
+    PropHandle pos_lon, pos_lat;
+    PropHandle gs_mps, groundtrack_deg, heading_deg;
+    PropHandle gps_data_age;
+    PropHandle wind_speed_kt, wind_dir_deg, tas_kt;
+    PropHandle L1_period, L1_damping, bank_bias_deg, bank_limit_deg;
+    PropHandle target_groundtrack_deg, target_roll_deg;
+    PropHandle wind_heading_error_deg, course_error_deg;
+    PropHandle xtrack_dist_m, projected_dist_m, wp_dist_m, wp_eta_sec;
+    PropHandle dist_remaining_m, route_size, target_waypoint_idx;
+    PropHandle active_route_size;
+    PropHandle circle_radius_m;
+
+    void reposition( bool force );
+    double wind_heading_error( double current_crs_deg, double target_crs_deg );
+    double bank_target( double accel );
+    void update_route();
+    void update_circle();
+};
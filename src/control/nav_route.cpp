@@ -0,0 +1,123 @@
+// nav_route.cpp - a route (list of waypoints) with its legs precomputed
+//
+// Copyright (C) 2020  Curtis L. Olson  - curtolson@flightgear.org
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Library General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Library General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+
+
+#include <math.h>
+#include <stdio.h>
+
+#include "util/wgs84.h"
+
+#include "nav_route.h"
+
+
+AuraRoute::AuraRoute():
+    relative_count( 0 ),
+    home_lon( 0.0 ),
+    home_lat( 0.0 ),
+    home_az( 0.0 )
+{
+}
+
+
+void AuraRoute::clear( double lon, double lat, double az ) {
+    wpts.clear();
+    relative_count = 0;
+    home_lon = lon;
+    home_lat = lat;
+    home_az = az;
+}
+
+
+// position a relative waypoint from home
+void AuraRoute::place( AuraWaypoint &wp ) {
+    double course = home_az + wp.hdg_deg;
+    if ( course < 0.0 ) { course += 360.0; }
+    if ( course > 360.0 ) { course -= 360.0; }
+    double az2;
+    geo_direct_wgs84( home_lat, home_lon, course, wp.dist_m,
+                      &wp.lat_deg, &wp.lon_deg, &az2 );
+}
+
+
+// course and distance of the leg ending at waypoint i, and the route
+// distance up to it
+void AuraRoute::update_leg( int i ) {
+    int prev = (i > 0) ? i - 1 : wpts.size() - 1;
+    AuraWaypoint &wp = wpts[i];
+    double rev_course;
+    geo_inverse_wgs84( wpts[prev].lat_deg, wpts[prev].lon_deg,
+                       wp.lat_deg, wp.lon_deg,
+                       &wp.leg_course_deg, &rev_course, &wp.leg_dist_m );
+    if ( i == 0 ) {
+        wp.route_dist_m = 0.0;
+    } else {
+        wp.route_dist_m = wpts[i-1].route_dist_m + wp.leg_dist_m;
+    }
+}
+
+
+void AuraRoute::add_absolute( double lon_deg, double lat_deg ) {
+    AuraWaypoint wp;
+    wp.relative = false;
+    wp.lon_deg = lon_deg;
+    wp.lat_deg = lat_deg;
+    wp.hdg_deg = 0.0;
+    wp.dist_m = 0.0;
+    wpts.push_back( wp );
+    update_leg( wpts.size() - 1 );
+    update_leg( 0 );            // (now starts from this one)
+}
+
+
+void AuraRoute::add_relative( double hdg_deg, double dist_m ) {
+    AuraWaypoint wp;
+    wp.relative = true;
+    wp.hdg_deg = hdg_deg;
+    wp.dist_m = dist_m;
+    place( wp );
+    wpts.push_back( wp );
+    relative_count++;
+    update_leg( wpts.size() - 1 );
+    update_leg( 0 );
+}
+
+
+bool AuraRoute::set_home( double lon, double lat, double az, bool force ) {
+    if ( !force && fabs(lon - home_lon) <= 0.000001
+         && fabs(lat - home_lat) <= 0.000001 && fabs(az - home_az) <= 0.001 ) {
+        return false;
+    }
+    home_lon = lon;
+    home_lat = lat;
+    home_az = az;
+    if ( !relative_count ) {
+        return false;
+    }
+    for ( unsigned int i = 0; i < wpts.size(); i++ ) {
+        if ( wpts[i].relative ) {
+            place( wpts[i] );
+            printf("WPT: %.1f %.0f %.8f %.8f\n", wpts[i].hdg_deg,
+                   wpts[i].dist_m, wpts[i].lat_deg, wpts[i].lon_deg);
+        }
+    }
+    for ( unsigned int i = 0; i < wpts.size(); i++ ) {
+        update_leg( i );
+    }
+    return true;
+}
@@ -0,0 +1,88 @@
+// nav_route.h - a route (list of waypoints) with its legs precomputed
+//
+// Copyright (C) 2020  Curtis L. Olson  - curtolson@flightgear.org
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Library General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Library General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+
+
+#pragma once
+
+#include <vector>
+using std::vector;
+
+
+struct AuraWaypoint {
+    bool relative;              // positioned relative to home
+    double lon_deg;
+    double lat_deg;
+    double hdg_deg;             // (relative) offset from the home azimuth
+    double dist_m;              // (relative) distance from home
+
+    // the leg that ends here: from the previous waypoint (the first
+    // leg starts at the last waypoint of the route)
+    double leg_course_deg;
+    double leg_dist_m;
+
+    // route distance from the first waypoint to here
+    double route_dist_m;
+};
+
+
+/**
+ * A route: the waypoints with the geodesic course and distance of
+ * every leg computed when the waypoint is added (or moved with home),
+ * so following the route only needs the distance to the current
+ * waypoint each frame.  Adding a waypoint updates two legs.
+ */
+
+class AuraRoute {
+
+public:
+
+    AuraRoute();
+    ~AuraRoute() {}
+
+    // start an empty route (relative waypoints are placed from this
+    // home position)
+    void clear( double home_lon, double home_lat, double home_az );
+
+    void add_absolute( double lon_deg, double lat_deg );
+    void add_relative( double hdg_deg, double dist_m );
+
+    // move the relative waypoints to a new home position (if it has
+    // moved), returns true if they were moved
+    bool set_home( double lon, double lat, double az, bool force=false );
+
+    inline int size() { return wpts.size(); }
+    inline bool has_relative() { return relative_count > 0; }
+    inline const AuraWaypoint &get( int i ) { return wpts[i]; }
+
+    // the route distance from waypoint i to the last one
+    inline double get_remaining_dist( int i ) {
+        return wpts.back().route_dist_m - wpts[i].route_dist_m;
+    }
+
+private:
+
+    vector<AuraWaypoint> wpts;
+    int relative_count;
+    double home_lon;
+    double home_lat;
+    double home_az;
+
+    void place( AuraWaypoint &wp );
+    void update_leg( int i );
+};
@@ -0,0 +1,255 @@
+// nav_test.cpp -- fly a simple point mass around a route with the
+//                 native nav manager, check the targets against the
+//                 per-frame math of the old python route follower,
+//                 time the update, and check route requests, swap,
+//                 dribble and circle mode.  (Run from src with
+//                 PYTHONPATH=. so the util python modules import.)
+//
+// g++ -O3 -I.. $(python3-config --includes) nav_test.cpp nav_mgr.cpp
+//     nav_route.cpp ../util/prop_handle.cpp ../util/wgs84.cpp
+//     ../util/windtri.cpp ../util/timing.cpp -lpyprops
+//     $(python3-config --ldflags --embed) -o nav_test
+
+#include <math.h>
+#include <stdio.h>
+
+#include <pyprops.h>
+
+#include "util/timing.h"
+#include "util/wgs84.h"
+#include "util/windtri.h"
+
+#include "nav_mgr.h"
+
+static const double d2r = M_PI / 180.0;
+static const double r2d = 180.0 / M_PI;
+
+static const char *config =
+    "import props\n"
+    "def prop(path, value):\n"
+    "    p = path.rfind('/')\n"
+    "    setattr(props.getNode(path[:p], True), path[p+1:], value)\n"
+    "prop('/task/home/longitude_deg', -93.15)\n"
+    "prop('/task/home/latitude_deg', 45.14)\n"
+    "prop('/task/home/azimuth_deg', 30.0)\n"
+    "prop('/position/longitude_deg', -93.15)\n"
+    "prop('/position/latitude_deg', 45.14)\n"
+    "prop('/velocity/groundspeed_ms', 15.0)\n"
+    "prop('/orientation/groundtrack_deg', 0.0)\n"
+    "prop('/sensors/gps/data_age', 0.0)\n"
+    "prop('/filters/wind/wind_speed_kt', 8.0)\n"
+    "prop('/filters/wind/wind_dir_deg', 270.0)\n"
+    "prop('/filters/wind/true_airspeed_kt', 28.0)\n"
+    "prop('/navigation/mode', 'route')\n";
+
+// target ground track and bank as the old python route.update()
+// computed them (leg recomputed every frame)
+static void reference( double lon, double lat, double gs, double gt,
+                       const double wpt[][2], int n, int cur, bool acquired,
+                       double *nav_course, double *bank_deg )
+{
+    const double period = 25.0, damping = 0.7, limit = 25.0;
+    int prev = (cur > 0) ? cur - 1 : n - 1;
+    double direct_course, rev, direct_dist, leg_course, leg_dist;
+    geo_inverse_wgs84( lat, lon, wpt[cur][1], wpt[cur][0],
+                       &direct_course, &rev, &direct_dist );
+    geo_inverse_wgs84( wpt[prev][1], wpt[prev][0], wpt[cur][1], wpt[cur][0],
+                       &leg_course, &rev, &leg_dist );
+    double angle = leg_course - direct_course;
+    if ( angle < -180.0 ) { angle += 360.0; }
+    else if ( angle > 180.0 ) { angle -= 360.0; }
+    double xtrack_m = sin(angle * d2r) * direct_dist;
+    double L1_dist = (1.0 / M_PI) * damping * period * gs;
+    if ( L1_dist < 1.0 ) { L1_dist = 1.0; }
+    double wangle = 0.0;
+    if ( L1_dist > fabs(xtrack_m) ) {
+        wangle = acos(fabs(xtrack_m) / L1_dist) * r2d;
+    }
+    if ( wangle < 30.0 ) { wangle = 30.0; }
+    double nc;
+    if ( xtrack_m > 0.0 ) {
+        nc = direct_course + angle - 90.0 + wangle;
+    } else {
+        nc = direct_course + angle + 90.0 - wangle;
+    }
+    if ( !acquired ) { nc = direct_course; }
+    if ( nc < 0.0 ) { nc += 360.0; }
+    if ( nc > 360.0 ) { nc -= 360.0; }
+    double h1, h2, g1, g2;
+    wind_course( 8.0, 28.0, 270.0, gt, &h1, &g1 );
+    wind_course( 8.0, 28.0, 270.0, nc, &h2, &g2 );
+    double err = h1 - h2;
+    if ( err < -180 ) { err += 360; }
+    if ( err > 180 ) { err -= 360; }
+    if ( err < -90.0 ) { err = -90.0; }
+    if ( err > 90.0 ) { err = 90.0; }
+    double accel = 2.0 * sin(err * d2r) * 28.0 * 0.5144444444444444444
+        * sqrt(2.0) * M_PI / period;
+    double bank = -atan( accel / 9.81 ) * r2d;
+    if ( bank < -limit ) { bank = -limit; }
+    if ( bank > limit ) { bank = limit; }
+    *nav_course = nc;
+    *bank_deg = bank;
+}
+
+int main() {
+    bool pass = true;
+
+    Py_Initialize();
+    pyPropsInit();
+    if ( PyRun_SimpleString(config) != 0 ) {
+        printf("FAIL: config\n");
+        return 1;
+    }
+
+    nav_mgr_t nav;
+    nav.init();
+
+    // a 500m box off home (relative) plus one absolute point
+    nav.clear_standby();
+    nav.add_standby_relative( 0.0, 500.0 );
+    nav.add_standby_relative( 90.0, 700.0 );
+    nav.add_standby_relative( 180.0, 500.0 );
+    nav.add_standby_absolute( -93.152, 45.139 );
+    nav.swap();
+    nav.dribble( true );
+
+    pyPropertyNode home_node = pyGetNode( "/task/home", true );
+    pyPropertyNode pos_node = pyGetNode( "/position", true );
+    pyPropertyNode orient_node = pyGetNode( "/orientation", true );
+    pyPropertyNode targets_node = pyGetNode( "/autopilot/targets", true );
+    pyPropertyNode route_node = pyGetNode( "/task/route", true );
+    pyPropertyNode active_node = pyGetNode( "/task/route/active", true );
+
+    // waypoint positions for the reference
+    double wpt[4][2];
+    const double rel[3][2] = { {0.0, 500.0}, {90.0, 700.0}, {180.0, 500.0} };
+    for ( int i = 0; i < 3; i++ ) {
+        double az2;
+        geo_direct_wgs84( 45.14, -93.15, 30.0 + rel[i][0], rel[i][1],
+                          &wpt[i][1], &wpt[i][0], &az2 );
+    }
+    wpt[3][0] = -93.152;
+    wpt[3][1] = 45.139;
+
+    // fly it: the groundtrack turns toward the target at a fixed rate
+    const double dt = 0.1;
+    const double gs = 15.0;
+    double lon = -93.15, lat = 45.14, gt = 0.0;
+    int cur = 0;
+    bool acquired = false;
+    int switches = 0;
+    double max_crs_err = 0.0, max_bank_err = 0.0, max_xtrack = 0.0;
+    double nav_sec = 0.0;
+    const int frames = 4000;
+    for ( int i = 0; i < frames; i++ ) {
+        double ref_course, ref_bank;
+        reference( lon, lat, gs, gt, wpt, 4, cur, acquired,
+                   &ref_course, &ref_bank );
+
+        double start = get_Time();
+        nav.update( dt );
+        nav_sec += get_Time() - start;
+
+        double crs = targets_node.getDouble( "groundtrack_deg" );
+        double crs_err = fabs( crs - ref_course );
+        if ( crs_err > 180.0 ) { crs_err = 360.0 - crs_err; }
+        if ( crs_err > max_crs_err ) { max_crs_err = crs_err; }
+        double bank_err = fabs( targets_node.getDouble("roll_deg") - ref_bank );
+        if ( bank_err > max_bank_err ) { max_bank_err = bank_err; }
+        if ( acquired ) {
+            double xt = fabs( route_node.getDouble("xtrack_dist_m") );
+            if ( xt > max_xtrack ) { max_xtrack = xt; }
+        }
+
+        int next = route_node.getLong( "target_waypoint_idx" );
+        if ( next != cur ) {
+            switches++;
+            acquired = true;
+            cur = next;
+            max_xtrack = 0.0;   // (only judge the settled part of a leg)
+        }
+
+        double diff = crs - gt;
+        if ( diff < -180.0 ) { diff += 360.0; }
+        if ( diff > 180.0 ) { diff -= 360.0; }
+        const double rate = 15.0 * dt;
+        if ( diff > rate ) { diff = rate; }
+        if ( diff < -rate ) { diff = -rate; }
+        gt += diff;
+        if ( gt < 0.0 ) { gt += 360.0; }
+        if ( gt >= 360.0 ) { gt -= 360.0; }
+        double az2;
+        geo_direct_wgs84( lat, lon, gt, gs * dt, &lat, &lon, &az2 );
+        pos_node.setDouble( "longitude_deg", lon );
+        pos_node.setDouble( "latitude_deg", lat );
+        orient_node.setDouble( "groundtrack_deg", gt );
+    }
+    printf("nav update: %.2f us per frame\n", nav_sec * 1e6 / frames);
+    printf("waypoints: %d  max course err %.2e deg  max bank err %.2e deg  "
+           "xtrack %.1f m\n", switches, max_crs_err, max_bank_err,
+           max_xtrack);
+    if ( switches < 4 || max_crs_err > 1e-6 || max_bank_err > 1e-6 ) {
+        printf("FAIL: route following\n");
+        pass = false;
+    }
+
+    // the whole active route has been published
+    if ( active_node.getLong("route_size") != 4
+         || fabs(active_node.getChild("wpt[1]", true).getDouble("latitude_deg")
+                 - wpt[1][1]) > 1e-9 ) {
+        printf("FAIL: dribble\n");
+        pass = false;
+    }
+
+    // moving home moves the relative waypoints
+    home_node.setDouble( "azimuth_deg", 120.0 );
+    nav.update( dt );
+    double lat1, lon1, az2;
+    geo_direct_wgs84( 45.14, -93.15, 120.0 + 90.0, 700.0, &lat1, &lon1, &az2 );
+    for ( int i = 0; i < 4; i++ ) {
+        nav.dribble( false );
+    }
+    if ( fabs(active_node.getChild("wpt[1]", true).getDouble("latitude_deg")
+              - lat1) > 1e-9 ) {
+        printf("FAIL: reposition\n");
+        pass = false;
+    }
+
+    // a route request from the ground replaces the active route
+    route_node.setString( "route_request",
+                          "1,-93.1,45.1,0,1,-93.2,45.1,0,0,300,90,0" );
+    nav.update( dt );
+    if ( route_node.getString("request_result").find("success") != 0
+         || route_node.getLong("route_size") != 3
+         || active_node.getLong("route_size") != 3
+         || route_node.getString("route_request") != "" ) {
+        printf("FAIL: route request\n");
+        pass = false;
+    }
+    route_node.setString( "route_request", "1,2" );
+    nav.update( dt );
+    if ( route_node.getString("request_result").find("failed") != 0
+         || route_node.getLong("route_size") != 3 ) {
+        printf("FAIL: bad route request\n");
+        pass = false;
+    }
+
+    // circle the current position (100m default radius, left)
+    pyPropertyNode nav_node = pyGetNode( "/navigation", true );
+    pyPropertyNode circle_node = pyGetNode( "/task/circle/active", true );
+    nav_node.setString( "mode", "circle" );
+    nav.update( dt );
+    if ( circle_node.getDouble("radius_m") != 100.0
+         || circle_node.getString("direction") != "left"
+         || route_node.getDouble("wp_dist_m") > 0.001 ) {
+        printf("FAIL: circle\n");
+        pass = false;
+    }
+
+    if ( !pass ) {
+        return 1;
+    }
+    printf("PASS\n");
+    return 0;
+}
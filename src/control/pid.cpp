@@ -34,7 +34,14 @@ AuraPID::AuraPID( string config_path ):
     iterm( 0.0 ),
     y_n( 0.0 ),
     y_n_1( 0.0 ),
-    r_n( 0.0 )
+    r_n( 0.0 ),
+    Kp( 0.0 ),
+    Ti( 0.0 ),
+    Td( 0.0 ),
+    u_min( 0.0 ),
+    u_max( 0.0 ),
+    u_trim( 0.0 ),
+    wrap( WRAP_NONE )
 {
     size_t pos;
 
@@ -113,6 +120,27 @@ AuraPID::AuraPID( string config_path ):
  
     // config
     config_node = component_node.getChild( "config", true );
+
+    watch_config();
+}
+
+
+void AuraPID::load_config() {
+    APComponent::load_config();
+    string wrap_str = component_node.getString("wrap");
+    if ( wrap_str == "180" ) {
+        wrap = WRAP_180;
+    } else if ( wrap_str == "pi" ) {
+        wrap = WRAP_PI;
+    } else {
+        wrap = WRAP_NONE;
+    }
+    u_trim = config_node.getDouble("u_trim");
+    u_min = config_node.getDouble("u_min");
+    u_max = config_node.getDouble("u_max");
+    Kp = config_node.getDouble("Kp");
+    Ti = config_node.getDouble("Ti");
+    Td = config_node.getDouble("Td");
 }
 
 
@@ -122,35 +150,29 @@ void AuraPID::reset() {
 
 
 void AuraPID::update( double dt ) {
+    update_config();
+
     // test if all of the provided enable flags are true
     enabled = true;
-    for ( unsigned int i = 0; i < enables_node.size(); i++ ) {
-        if ( !enables_node[i].getBool(enables_attr[i].c_str()) ) {
+    for ( unsigned int i = 0; i < enables_slot.size(); i++ ) {
+        if ( !signals->get_bool(enables_slot[i]) ) {
             enabled = false;
             break;
         }
     }
 
-    bool debug = component_node.getBool("debug");
     if ( debug ) printf("Updating %s\n", get_name().c_str());
-    y_n = input_node.getDouble(input_attr.c_str());
+    y_n = signals->get( input_slot );
 
-    double r_n = 0.0;
-    if ( ref_value != "" ) {
-	// printf("nonzero ref_value\n");
-	r_n = atof(ref_value.c_str());
-    } else {
-	r_n = ref_node.getDouble(ref_attr.c_str());
-    }
+    double r_n = get_reference();
                       
     double error = r_n - y_n;
 
-    string wrap = component_node.getString("wrap");
-    if ( wrap == "180" ) {
+    if ( wrap == WRAP_180 ) {
         // wrap error (by +/- 360 degrees to put the result in [-180, 180]
         if ( error < -180 ) { error += 360; }
         if ( error > 180 ) { error -= 360; }
-    } else if ( wrap == "pi" ) {
+    } else if ( wrap == WRAP_PI ) {
         // wrap error (by +/- 2*pi degrees to put the result in [-pi, pi]
         if ( error < -M_PI ) { error += 2*M_PI; }
         if ( error > M_PI ) { error -= 2*M_PI; }
@@ -159,13 +181,6 @@ void AuraPID::update( double dt ) {
     if ( debug ) printf("input = %.3f reference = %.3f error = %.3f\n",
 			y_n, r_n, error);
 
-    double u_trim = config_node.getDouble("u_trim");
-    double u_min = config_node.getDouble("u_min");
-    double u_max = config_node.getDouble("u_max");
-
-    double Kp = config_node.getDouble("Kp");
-    double Ti = config_node.getDouble("Ti");
-    double Td = config_node.getDouble("Td");
     double Ki = 0.0;
     if ( Ti > 0.0001 ) {
 	Ki = Kp / Ti;
@@ -187,10 +202,8 @@ void AuraPID::update( double dt ) {
     // iterm) then unset the do_reset flag.
     if ( do_reset ) {
         if ( Ti > 0.0001 ) {
-            double u_n = output_node[0].getDouble(output_attr[0].c_str());
+            double u_n = signals->get( output_slot[0] );
             // and clip
-            double u_min = config_node.getDouble("u_min");
-            double u_max = config_node.getDouble("u_max");
             if ( u_n < u_min ) { u_n = u_min; }
             if ( u_n > u_max ) { u_n = u_max; }
             iterm = u_n - pterm;
@@ -198,6 +211,9 @@ void AuraPID::update( double dt ) {
             iterm = 0.0;
         }
         do_reset = false;
+        if ( enabled ) {
+            stats.resets++;
+        }
     }
     
     // derivative term: observe that dError/dt = -dInput/dt (except
@@ -209,17 +225,26 @@ void AuraPID::update( double dt ) {
     double dterm = Kd * -dy / dt;
 
     double output = pterm + iterm + dterm;
+    bool clamped = false;
     if ( output < u_min ) {
         if ( Ti > 0.0001 ) {
             iterm += u_min - output;
         }
 	output = u_min;
+        clamped = true;
     }
     if ( output > u_max ) {
         if ( Ti > 0.0001 ) {
             iterm -= output - u_max;
         }
 	output = u_max;
+        clamped = true;
+    }
+    if ( clamped && enabled ) {
+        stats.clamps++;
+        if ( Ti > 0.0001 ) {
+            stats.windups++;
+        }
     }
 
     if ( debug ) printf("pterm = %.3f iterm = %.3f\n",
@@ -230,8 +255,8 @@ void AuraPID::update( double dt ) {
         do_reset = true;
     } else {
 	// Copy the result to the output node(s)
-	for ( unsigned int i = 0; i < output_node.size(); i++ ) {
-	    output_node[i].setDouble( output_attr[i].c_str(), output );
+	for ( unsigned int i = 0; i < output_slot.size(); i++ ) {
+	    signals->set( output_slot[i], output );
 	}
     }
 }
@@ -43,6 +43,13 @@ private:
     double y_n_1;		// previous process value (input)
     double r_n;                 // reference (set point) value
 
+    // cached config
+    double Kp, Ti, Td;          // gains
+    double u_min, u_max, u_trim;
+    enum { WRAP_NONE, WRAP_180, WRAP_PI } wrap;
+
+    void load_config();
+
 public:
 
     AuraPID( string config_path );
@@ -30,7 +30,15 @@ AuraPIDVel::AuraPIDVel( string config_path ):
     edf_n_2( 0.0 ),
     u_n_1( 0.0 ),
     desiredTs( 0.00001 ),
-    elapsedTime( 0.0 )
+    elapsedTime( 0.0 ),
+    Kp( 0.0 ),
+    Ti( 0.0 ),
+    Td( 0.0 ),
+    beta( 1.0 ),
+    gamma( 0.0 ),
+    alpha( 0.1 ),
+    u_min( 0.0 ),
+    u_max( 0.0 )
 {
     size_t pos;
 
@@ -123,6 +131,21 @@ AuraPIDVel::AuraPIDVel( string config_path ):
 	// create with default value
 	config_node.setDouble( "alpha", 0.1 );
     }
+
+    watch_config();
+}
+
+
+void AuraPIDVel::load_config() {
+    APComponent::load_config();
+    Kp = config_node.getDouble("Kp");
+    Ti = config_node.getDouble("Ti");
+    Td = config_node.getDouble("Td");
+    beta = beta;
+    gamma = gamma;
+    alpha = alpha;
+    u_min = config_node.getDouble("u_min");
+    u_max = config_node.getDouble("u_max");
 }
 
 
@@ -199,34 +222,29 @@ void AuraPIDVel::update( double dt ) {
     Ts = elapsedTime;
     elapsedTime = 0.0;
 
+    update_config();
+
     // test if all of the provided enable flags are true
     enabled = true;
-    for ( unsigned int i = 0; i < enables_node.size(); i++ ) {
-        if ( !enables_node[i].getBool(enables_attr[i].c_str()) ) {
+    for ( unsigned int i = 0; i < enables_slot.size(); i++ ) {
+        if ( !signals->get_bool(enables_slot[i]) ) {
             enabled = false;
             break;
         }
     }
 
-    bool debug = component_node.getBool("debug");
-
     if ( Ts > 0.0) {
         if ( debug ) printf("Updating %s Ts = %.2f", get_name().c_str(), Ts );
 
         double y_n = 0.0;
-	y_n = input_node.getDouble(input_attr.c_str());
+	y_n = signals->get( input_slot );
 
-        double r_n = 0.0;
-	if ( ref_value != "" ) {
-	    r_n = atof(ref_value.c_str());
-	} else {
-            r_n = ref_node.getDouble(ref_attr.c_str());
-	}
+        double r_n = get_reference();
                       
         if ( debug ) printf("  input = %.3f ref = %.3f\n", y_n, r_n );
 
         // Calculates proportional error:
-        ep_n = config_node.getDouble("beta") * (r_n - y_n);
+        ep_n = beta * (r_n - y_n);
         if ( debug ) {
 	    printf( "  ep_n = %.3f", ep_n);
 	    printf( "  ep_n_1 = %.3f", ep_n_1);
@@ -237,13 +255,12 @@ void AuraPIDVel::update( double dt ) {
         if ( debug ) printf( " e_n = %.3f", e_n);
 
         // Calculates derivate error:
-        ed_n = config_node.getDouble("gamma") * r_n - y_n;
+        ed_n = gamma * r_n - y_n;
         if ( debug ) printf(" ed_n = %.3f", ed_n);
 
-	double Td = config_node.getDouble("Td");
         if ( Td > 0.0 ) {
             // Calculates filter time:
-            Tf = config_node.getDouble("alpha") * Td;
+            Tf = alpha * Td;
             if ( debug ) printf(" Tf = %.3f", Tf);
 
             // Filters the derivate error:
@@ -255,8 +272,6 @@ void AuraPIDVel::update( double dt ) {
         }
 
         // Calculates the incremental output:
-	double Ti = config_node.getDouble("Ti");
-	double Kp = config_node.getDouble("Kp");
         if ( Ti > 0.0 ) {
             delta_u_n = Kp * ( (ep_n - ep_n_1)
                                + ((Ts/Ti) * e_n)
@@ -272,14 +287,16 @@ void AuraPIDVel::update( double dt ) {
         }
 
         // Integrator anti-windup logic:
-	double u_min = config_node.getDouble("u_min");
-	double u_max = config_node.getDouble("u_max");
+        // (the output is the integrator here, so a clamp is also a
+        // windup event)
         if ( delta_u_n > (u_max - u_n_1) ) {
             delta_u_n = u_max - u_n_1;
             if ( debug ) printf(" max saturation\n");
+            if ( enabled ) { stats.clamps++; stats.windups++; }
         } else if ( delta_u_n < (u_min - u_n_1) ) {
             delta_u_n = u_min - u_n_1;
             if ( debug ) printf(" min saturation\n");
+            if ( enabled ) { stats.clamps++; stats.windups++; }
         }
 
         // Calculates absolute output:
@@ -295,18 +312,16 @@ void AuraPIDVel::update( double dt ) {
 
     if ( enabled ) {
 	// Copy the result to the output node(s)
-	for ( unsigned int i = 0; i < output_node.size(); i++ ) {
-	    output_node[i].setDouble( output_attr[i].c_str(), u_n );
+	for ( unsigned int i = 0; i < output_slot.size(); i++ ) {
+	    signals->set( output_slot[i], u_n );
 	}
-    } else if ( output_node.size() > 0 ) {
+    } else if ( output_slot.size() > 0 ) {
 	// Mirror the output value while we are not enabled so there
 	// is less of a continuity break when this module is enabled
 
 	// pull output value from the corresponding property tree value
-	u_n = output_node[0].getDouble(output_attr[0].c_str());
+	u_n = signals->get( output_slot[0] );
 	// and clip
-	double u_min = config_node.getDouble("u_min");
-	double u_max = config_node.getDouble("u_max");
  	if ( u_n < u_min ) { u_n = u_min; }
 	if ( u_n > u_max ) { u_n = u_max; }
 	u_n_1 = u_n;
@@ -38,6 +38,13 @@ private:
     double u_n_1;               // u[n-1]   (output)
     double desiredTs;            // desired sampling interval (sec)
     double elapsedTime;          // elapsed time (sec)
+
+    // cached config
+    double Kp, Ti, Td;           // gains
+    double beta, gamma, alpha;   // reference and filter weighing
+    double u_min, u_max;
+
+    void load_config();
     
 public:
 
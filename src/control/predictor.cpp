@@ -99,6 +99,8 @@ AuraPredictor::AuraPredictor ( string config_path ):
 		   children[i].c_str());
 	}
     }
+
+    watch_config();
 }
 
 void AuraPredictor::reset() {
@@ -121,14 +123,14 @@ void AuraPredictor::update( double dt ) {
 
     // test if all of the provided enable flags are true
     enabled = true;
-    for ( unsigned int i = 0; i < enables_node.size(); i++ ) {
-        if ( !enables_node[i].getBool(enables_attr[i].c_str()) ) {
+    for ( unsigned int i = 0; i < enables_slot.size(); i++ ) {
+        if ( !signals->get_bool(enables_slot[i]) ) {
             enabled = false;
             break;
         }
     }
 
-    ivalue = input_node.getDouble(input_attr.c_str());
+    ivalue = signals->get( input_slot );
 
     if ( enabled ) {
         // first time initialize average
@@ -148,8 +150,8 @@ void AuraPredictor::update( double dt ) {
             double output = ivalue + (1.0 - filter_gain) * (average * seconds) + filter_gain * (current * seconds);
 
 	    // Copy the result to the output node(s)
-	    for ( unsigned int i = 0; i < output_node.size(); i++ ) {
-		output_node[i].setDouble( output_attr[i].c_str(), output );
+	    for ( unsigned int i = 0; i < output_slot.size(); i++ ) {
+		signals->set( output_slot[i], output );
 	    }
         }
         last_value = ivalue;
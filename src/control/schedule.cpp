@@ -0,0 +1,208 @@
+// schedule.cpp - execution order for a set of autopilot stages
+//
+// Copyright (C) 2020  Curtis L. Olson  - curtolson@flightgear.org
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Library General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Library General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+
+
+#include <map>
+#include <set>
+using std::map;
+using std::set;
+
+#include "schedule.h"
+
+
+static int find_root( vector<int> &parent, int i ) {
+    while ( parent[i] != i ) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+
+// Tarjan's strongly connected components: comp[i] is the component
+// of stage i
+static void strong_connect( const vector< set<int> > &next, int i,
+                            int &counter, vector<int> &index,
+                            vector<int> &low, vector<int> &stack,
+                            vector<bool> &on_stack, vector<int> &comp,
+                            int &comps )
+{
+    index[i] = low[i] = counter++;
+    stack.push_back( i );
+    on_stack[i] = true;
+    for ( set<int>::const_iterator it = next[i].begin();
+          it != next[i].end(); it++ ) {
+        int j = *it;
+        if ( index[j] < 0 ) {
+            strong_connect( next, j, counter, index, low, stack, on_stack,
+                            comp, comps );
+            if ( low[j] < low[i] ) { low[i] = low[j]; }
+        } else if ( on_stack[j] && index[j] < low[i] ) {
+            low[i] = index[j];
+        }
+    }
+    if ( low[i] == index[i] ) {
+        int j;
+        do {
+            j = stack.back();
+            stack.pop_back();
+            on_stack[j] = false;
+            comp[j] = comps;
+        } while ( j != i );
+        comps++;
+    }
+}
+
+static int strong_components( const vector< set<int> > &next,
+                              vector<int> &comp )
+{
+    int n = next.size();
+    vector<int> index( n, -1 ), low( n, 0 ), stack;
+    vector<bool> on_stack( n, false );
+    comp.assign( n, -1 );
+    int counter = 0, comps = 0;
+    for ( int i = 0; i < n; i++ ) {
+        if ( index[i] < 0 ) {
+            strong_connect( next, i, counter, index, low, stack, on_stack,
+                            comp, comps );
+        }
+    }
+    return comps;
+}
+
+
+bool APSchedule::build( const vector<APStageDeps> &stages ) {
+    int n = stages.size();
+    order.clear();
+    branch.assign( n, 0 );
+    branches = 0;
+    cycle.clear();
+
+    // writers of each value (in index order)
+    map<string, vector<int> > writers;
+    for ( int i = 0; i < n; i++ ) {
+        for ( unsigned int j = 0; j < stages[i].writes.size(); j++ ) {
+            vector<int> &w = writers[stages[i].writes[j]];
+            if ( w.empty() || w.back() != i ) {
+                w.push_back( i );
+            }
+        }
+    }
+
+    // edges: writer -> reader, and between successive writers
+    vector< set<int> > next( n );
+    for ( map<string, vector<int> >::iterator it = writers.begin();
+          it != writers.end(); it++ ) {
+        for ( unsigned int j = 1; j < it->second.size(); j++ ) {
+            next[it->second[j-1]].insert( it->second[j] );
+        }
+    }
+    for ( int i = 0; i < n; i++ ) {
+        for ( unsigned int j = 0; j < stages[i].reads.size(); j++ ) {
+            map<string, vector<int> >::iterator it
+                = writers.find( stages[i].reads[j] );
+            if ( it == writers.end() ) {
+                continue;
+            }
+            for ( unsigned int k = 0; k < it->second.size(); k++ ) {
+                if ( it->second[k] != i ) {
+                    next[it->second[k]].insert( i );
+                }
+            }
+        }
+    }
+    vector<int> pending( n, 0 );
+    for ( int i = 0; i < n; i++ ) {
+        for ( set<int>::iterator it = next[i].begin();
+              it != next[i].end(); it++ ) {
+            pending[*it]++;
+        }
+    }
+
+    // topological sort, lowest index first among the ready stages.
+    // When nothing is ready the rest is blocked on cycles: pick a
+    // strongly connected component that no other unscheduled stage
+    // feeds (one always exists) and run its lowest index stage anyway.
+    vector<int> comp;
+    int comps = strong_components( next, comp );
+    set<int> ready;
+    vector<bool> done( n, false );
+    for ( int i = 0; i < n; i++ ) {
+        if ( pending[i] == 0 ) {
+            ready.insert( i );
+        }
+    }
+    while ( (int)order.size() < n ) {
+        int i;
+        if ( !ready.empty() ) {
+            i = *ready.begin();
+            ready.erase( ready.begin() );
+        } else {
+            vector<bool> fed( comps, false );
+            for ( int j = 0; j < n; j++ ) {
+                if ( done[j] ) {
+                    continue;
+                }
+                for ( set<int>::iterator it = next[j].begin();
+                      it != next[j].end(); it++ ) {
+                    if ( !done[*it] && comp[*it] != comp[j] ) {
+                        fed[comp[*it]] = true;
+                    }
+                }
+            }
+            i = 0;
+            while ( done[i] || fed[comp[i]] ) {
+                i++;
+            }
+            cycle.push_back( i );
+        }
+        done[i] = true;
+        order.push_back( i );
+        for ( set<int>::iterator it = next[i].begin();
+              it != next[i].end(); it++ ) {
+            pending[*it]--;
+            if ( pending[*it] == 0 && !done[*it] ) {
+                ready.insert( *it );
+            }
+        }
+    }
+
+    // branches: connected groups of stages (ignoring edge direction),
+    // numbered in order of their first stage
+    vector<int> parent( n );
+    for ( int i = 0; i < n; i++ ) {
+        parent[i] = i;
+    }
+    for ( int i = 0; i < n; i++ ) {
+        for ( set<int>::iterator it = next[i].begin();
+              it != next[i].end(); it++ ) {
+            parent[find_root(parent, i)] = find_root( parent, *it );
+        }
+    }
+    map<int, int> ids;
+    for ( int i = 0; i < n; i++ ) {
+        int root = find_root( parent, i );
+        if ( ids.find(root) == ids.end() ) {
+            ids[root] = branches++;
+        }
+        branch[i] = ids[root];
+    }
+
+    return cycle.empty();
+}
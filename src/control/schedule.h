@@ -0,0 +1,66 @@
+// schedule.h - execution order for a set of autopilot stages
+//
+// Copyright (C) 2020  Curtis L. Olson  - curtolson@flightgear.org
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Library General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Library General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+
+
+#pragma once
+
+#include <string>
+#include <vector>
+using std::string;
+using std::vector;
+
+
+// the values one stage reads and writes (any string that identifies a
+// value, see APComponent::get_dependencies())
+struct APStageDeps {
+    vector<string> reads;
+    vector<string> writes;
+};
+
+
+/**
+ * Dependency ordered schedule: a stage runs after every stage that
+ * writes a value it reads.  Several writers of the same value keep
+ * their relative (index) order, and ties are broken by index so the
+ * result is deterministic.  A cycle (strongly connected group of
+ * stages) is broken once every stage feeding it has run, by running
+ * its lowest index stage first; the stages run that way are reported
+ * in cycle.  Stages merely downstream of a cycle wait for it.
+ *
+ * Stages that share no values (directly or through other stages) land
+ * in different branches (i.e. the roll, pitch and throttle chains), so
+ * they could run in parallel or at their own rates.
+ */
+
+class APSchedule {
+
+public:
+
+    APSchedule() : branches(0) {}
+    ~APSchedule() {}
+
+    // returns false if the stages contain a dependency cycle (a usable
+    // order is computed anyway)
+    bool build( const vector<APStageDeps> &stages );
+
+    vector<int> order;          // stage indices in execution order
+    vector<int> branch;         // branch of each stage (by stage index)
+    int branches;               // number of independent branches
+    vector<int> cycle;          // stages that were run ahead of an input
+};
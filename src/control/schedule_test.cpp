@@ -0,0 +1,162 @@
+// schedule_test.cpp -- order a shuffled set of autopilot stages (roll,
+//                      pitch and throttle chains) by their inputs and
+//                      outputs, check the branches and cycles (alone
+//                      and with a stage downstream of the loop.)
+//
+// g++ -O3 schedule_test.cpp schedule.cpp -o schedule_test
+
+#include <stdio.h>
+
+#include "schedule.h"
+
+struct Stage {
+    const char *name;
+    const char *reads[3];
+    const char *writes[2];
+};
+
+// listed out of order on purpose: each chain's stages are reversed
+static const Stage stages[] = {
+    { "roll_rate_pid", { "targets/roll_rate", "imu/p", NULL },
+      { "flight/aileron", NULL } },
+    { "elevator_summer", { "internal/elevator_pid", "internal/elevator_ff",
+                           NULL }, { "flight/elevator", NULL } },
+    { "roll_pid", { "targets/roll_deg", "orient/roll_deg", NULL },
+      { "targets/roll_rate", NULL } },
+    { "throttle_pid", { "targets/airspeed_kt", "vel/airspeed_kt", NULL },
+      { "engine/throttle", NULL } },
+    { "pitch_ff", { "targets/pitch_deg", NULL, NULL },
+      { "internal/elevator_ff", NULL } },
+    { "pitch_pid", { "targets/pitch_deg", "orient/pitch_deg", NULL },
+      { "internal/elevator_pid", NULL } },
+    { "heading_pid", { "targets/groundtrack", "orient/groundtrack", NULL },
+      { "targets/roll_deg", NULL } },
+    { "alt_pid", { "targets/altitude", "pos/altitude", NULL },
+      { "targets/pitch_deg", NULL } },
+};
+static const int count = sizeof(stages) / sizeof(Stage);
+
+static vector<APStageDeps> make_deps( const Stage *s, int n ) {
+    vector<APStageDeps> deps( n );
+    for ( int i = 0; i < n; i++ ) {
+        for ( int j = 0; j < 3 && s[i].reads[j] != NULL; j++ ) {
+            deps[i].reads.push_back( s[i].reads[j] );
+        }
+        for ( int j = 0; j < 2 && s[i].writes[j] != NULL; j++ ) {
+            deps[i].writes.push_back( s[i].writes[j] );
+        }
+    }
+    return deps;
+}
+
+static int position( APSchedule &plan, int stage ) {
+    for ( unsigned int i = 0; i < plan.order.size(); i++ ) {
+        if ( plan.order[i] == stage ) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int main() {
+    bool pass = true;
+
+    vector<APStageDeps> deps = make_deps( stages, count );
+    APSchedule plan;
+    if ( !plan.build( deps ) || (int)plan.order.size() != count ) {
+        printf("FAIL: no clean schedule\n");
+        pass = false;
+    }
+    for ( unsigned int i = 0; i < plan.order.size(); i++ ) {
+        int s = plan.order[i];
+        printf("%d branch %d: %s\n", i, plan.branch[s], stages[s].name);
+    }
+
+    // every writer runs before its readers
+    for ( int a = 0; a < count; a++ ) {
+        for ( int b = 0; b < count; b++ ) {
+            for ( unsigned int i = 0; i < deps[a].writes.size(); i++ ) {
+                for ( unsigned int j = 0; j < deps[b].reads.size(); j++ ) {
+                    if ( deps[a].writes[i] == deps[b].reads[j]
+                         && position(plan, a) > position(plan, b) ) {
+                        printf("FAIL: %s runs after %s\n", stages[a].name,
+                               stages[b].name);
+                        pass = false;
+                    }
+                }
+            }
+        }
+    }
+
+    // roll (heading, roll, roll rate), pitch (alt, pitch, ff, summer)
+    // and throttle
+    if ( plan.branches != 3
+         || plan.branch[0] != plan.branch[2] || plan.branch[2] != plan.branch[6]
+         || plan.branch[1] != plan.branch[4] || plan.branch[4] != plan.branch[5]
+         || plan.branch[5] != plan.branch[7]
+         || plan.branch[0] == plan.branch[1]
+         || plan.branch[3] == plan.branch[0]
+         || plan.branch[3] == plan.branch[1] ) {
+        printf("FAIL: %d branches\n", plan.branches);
+        pass = false;
+    }
+
+    // the result doesn't depend on the input order beyond tie breaks
+    vector<APStageDeps> rev( deps.rbegin(), deps.rend() );
+    APSchedule plan2;
+    plan2.build( rev );
+    for ( unsigned int i = 0; i < plan2.order.size(); i++ ) {
+        int s = count - 1 - plan2.order[i];
+        for ( unsigned int j = 0; j < deps[s].reads.size(); j++ ) {
+            for ( unsigned int k = i + 1; k < plan2.order.size(); k++ ) {
+                int t = count - 1 - plan2.order[k];
+                for ( unsigned int m = 0; m < deps[t].writes.size(); m++ ) {
+                    if ( deps[t].writes[m] == deps[s].reads[j] ) {
+                        printf("FAIL: reversed input order\n");
+                        pass = false;
+                    }
+                }
+            }
+        }
+    }
+
+    // a cycle is reported and broken, downstream stages still follow
+    vector<APStageDeps> loop( 3 );
+    loop[0].reads.push_back( "b" );
+    loop[0].writes.push_back( "a" );
+    loop[1].reads.push_back( "a" );
+    loop[1].writes.push_back( "b" );
+    loop[2].reads.push_back( "b" );
+    loop[2].writes.push_back( "c" );
+    APSchedule plan3;
+    if ( plan3.build( loop ) || plan3.cycle.size() != 1
+         || plan3.order.size() != 3 || plan3.order[2] != 2 ) {
+        printf("FAIL: cycle handling\n");
+        pass = false;
+    }
+
+    // a stage downstream of a loop (listed first) is neither run ahead
+    // of its writer nor reported as part of the cycle
+    vector<APStageDeps> tail( 3 );
+    tail[0].reads.push_back( "c" );
+    tail[0].writes.push_back( "d" );
+    tail[1].reads.push_back( "b" );
+    tail[1].writes.push_back( "a" );
+    tail[2].reads.push_back( "a" );
+    tail[2].writes.push_back( "b" );
+    tail[2].writes.push_back( "c" );
+    APSchedule plan4;
+    if ( plan4.build( tail ) || plan4.cycle.size() != 1
+         || plan4.cycle[0] != 1 || plan4.order.size() != 3
+         || plan4.order[0] != 1 || plan4.order[1] != 2
+         || plan4.order[2] != 0 ) {
+        printf("FAIL: stage downstream of a cycle\n");
+        pass = false;
+    }
+
+    if ( !pass ) {
+        return 1;
+    }
+    printf("PASS\n");
+    return 0;
+}
@@ -0,0 +1,108 @@
+// signals.cpp - flat table of the values the autopilot stages exchange
+//
+// Copyright (C) 2020  Curtis L. Olson  - curtolson@flightgear.org
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Library General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Library General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+
+
+#include <stdio.h>
+
+#include "signals.h"
+
+
+// identify a value by python node, so different spellings of a path
+// still match
+static string slot_key( pyPropertyNode &node, const string &attr ) {
+    char buf[32];
+    snprintf( buf, sizeof(buf), "%p/", (void *)node.pObj );
+    return buf + attr;
+}
+
+
+APSignals::APSignals() {
+    // slot 0: unconfigured values
+    value.push_back( 0.0 );
+    written.push_back( 0 );
+    is_bool.push_back( 0 );
+    handle.push_back( PropHandle() );
+}
+
+
+int APSignals::bind( pyPropertyNode &node, const string &attr, bool as_bool ) {
+    if ( node.isNull() ) {
+        return 0;
+    }
+    string key = slot_key( node, attr );
+    map<string, int>::iterator it = index.find( key );
+    if ( it != index.end() ) {
+        if ( as_bool ) {
+            is_bool[it->second] = 1;
+        }
+        return it->second;
+    }
+    int slot = value.size();
+    value.push_back( 0.0 );
+    written.push_back( 0 );
+    is_bool.push_back( as_bool ? 1 : 0 );
+    handle.push_back( PropHandle(node, attr.c_str()) );
+    index[key] = slot;
+    return slot;
+}
+
+
+int APSignals::find( const string &prop ) {
+    size_t pos = prop.rfind("/");
+    if ( pos == string::npos ) {
+        return 0;
+    }
+    pyPropertyNode node = pyGetNode( prop.substr(0, pos), false );
+    if ( node.isNull() ) {
+        return 0;
+    }
+    map<string, int>::iterator it = index.find( slot_key(node, prop.substr(pos+1)) );
+    if ( it == index.end() ) {
+        return 0;
+    }
+    return it->second;
+}
+
+
+void APSignals::load() {
+    value[0] = 0.0;
+    for ( unsigned int i = 1; i < value.size(); i++ ) {
+        if ( is_bool[i] ) {
+            value[i] = handle[i].getBool() ? 1.0 : 0.0;
+        } else {
+            value[i] = handle[i].getDouble();
+        }
+        written[i] = 0;
+    }
+}
+
+
+void APSignals::store() {
+    for ( unsigned int i = 1; i < value.size(); i++ ) {
+        if ( !written[i] ) {
+            continue;
+        }
+        if ( is_bool[i] ) {
+            handle[i].setBool( value[i] != 0.0 );
+        } else {
+            handle[i].setDouble( value[i] );
+        }
+        written[i] = 0;
+    }
+}
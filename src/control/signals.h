@@ -0,0 +1,82 @@
+// signals.h - flat table of the values the autopilot stages exchange
+//
+// Copyright (C) 2020  Curtis L. Olson  - curtolson@flightgear.org
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Library General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Library General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+
+
+#pragma once
+
+#include <pyprops.h>
+
+#include <map>
+#include <string>
+#include <vector>
+using std::map;
+using std::string;
+using std::vector;
+
+#include "util/prop_handle.h"
+
+
+/**
+ * Every property value an autopilot stage reads or writes is bound to
+ * a numeric slot at build time (the same value used by several stages
+ * shares one slot.)  Once per frame load() copies the values in from
+ * the property tree, the stages then run entirely on the table, and
+ * store() writes the slots that were set during the frame back out.
+ *
+ * The table is kept as parallel arrays (values, flags, handles) so the
+ * stages only touch the packed value array.  Slot 0 is a placeholder
+ * for values that aren't configured: it reads as zero and is never
+ * written back.
+ */
+
+class APSignals {
+
+public:
+
+    APSignals();
+    ~APSignals() {}
+
+    // slot of node/attr (0 if node is null).  Bool values are loaded
+    // and stored as python bools.
+    int bind( pyPropertyNode &node, const string &attr, bool as_bool=false );
+
+    // slot of an already bound "/path/to/node/attr" (0 if it isn't)
+    int find( const string &prop );
+
+    void load();                // property tree -> table
+    void store();               // written slots -> property tree
+
+    inline double get( int slot ) { return value[slot]; }
+    inline bool get_bool( int slot ) { return value[slot] != 0.0; }
+    inline void set( int slot, double val ) {
+        value[slot] = val;
+        written[slot] = 1;
+    }
+    inline bool is_written( int slot ) { return written[slot] != 0; }
+
+    int size() { return value.size(); }
+
+private:
+
+    vector<double> value;
+    vector<unsigned char> written; // set since the last load()
+    vector<unsigned char> is_bool;
+    vector<PropHandle> handle;
+    map<string, int> index;     // node/attr key -> slot
+};
@@ -23,7 +23,11 @@
 #include "summer.h"
 
 
-AuraSummer::AuraSummer ( string config_path )
+AuraSummer::AuraSummer ( string config_path ):
+    has_u_min( false ),
+    has_u_max( false ),
+    u_min( 0.0 ),
+    u_max( 0.0 )
 {
     size_t pos;
 
@@ -103,6 +107,16 @@ AuraSummer::AuraSummer ( string config_path )
     
     // config
     config_node = component_node.getChild( "config", true );
+
+    watch_config();
+}
+
+void AuraSummer::load_config() {
+    APComponent::load_config();
+    has_u_min = config_node.hasChild("u_min");
+    u_min = config_node.getDouble("u_min");
+    has_u_max = config_node.hasChild("u_max");
+    u_max = config_node.getDouble("u_max");
 }
 
 void AuraSummer::reset() {
@@ -110,35 +124,47 @@ void AuraSummer::reset() {
 }
 
 void AuraSummer::update( double dt ) {
+    update_config();
+
     // test if all of the provided enable flags are true
     enabled = true;
-    for ( unsigned int i = 0; i < enables_node.size(); i++ ) {
-        if ( !enables_node[i].getBool(enables_attr[i].c_str()) ) {
+    for ( unsigned int i = 0; i < enables_slot.size(); i++ ) {
+        if ( !signals->get_bool(enables_slot[i]) ) {
             enabled = false;
             break;
         }
     }
 
     if ( enabled ) {
-	bool debug = component_node.getBool("debug");
 	if ( debug ) printf("Updating %s\n", get_name().c_str());
 	double sum = 0.0;
-	for ( unsigned int i = 0; i < input_node.size(); i++ ) {
-	    double val = input_node[i].getDouble( input_attr[i].c_str() );
+	for ( unsigned int i = 0; i < input_slots.size(); i++ ) {
+	    double val = signals->get( input_slots[i] );
 	    sum += val;
 	    if (debug) printf("  %s = %.3f\n", input_attr[i].c_str(), val);
 	}
-	if ( config_node.hasChild("u_min") ) {
-	    double u_min = config_node.getDouble("u_min");
-	    if ( sum < u_min ) { sum = u_min; }
-	}
-	if ( config_node.hasChild("u_max") ) {
-	    double u_max = config_node.getDouble("u_max");
-	    if ( sum > u_max ) { sum = u_max; }
-	}
+	if ( has_u_min && sum < u_min ) { sum = u_min; stats.clamps++; }
+	if ( has_u_max && sum > u_max ) { sum = u_max; stats.clamps++; }
 	if (debug) printf("  sum = %.3f\n", sum);
-	for ( unsigned int i = 0; i < output_node.size(); i++ ) {
-	    output_node[i].setDouble( output_attr[i].c_str(), sum );
+	for ( unsigned int i = 0; i < output_slot.size(); i++ ) {
+	    signals->set( output_slot[i], sum );
 	}
     }
 }
+
+
+void AuraSummer::bind_signals( APSignals *table ) {
+    APComponent::bind_signals( table );
+    input_slots.clear();
+    for ( unsigned int i = 0; i < input_node.size(); i++ ) {
+        input_slots.push_back( table->bind(input_node[i], input_attr[i]) );
+    }
+}
+
+
+void AuraSummer::get_dependencies( APStageDeps *deps ) {
+    APComponent::get_dependencies( deps );
+    for ( unsigned int i = 0; i < input_node.size(); i++ ) {
+        deps->reads.push_back( prop_key(input_node[i], input_attr[i]) );
+    }
+}
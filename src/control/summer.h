@@ -31,10 +31,17 @@ private:
     // support multiple input nodes
     vector <pyPropertyNode> input_node;
     vector <string> input_attr;
+    vector <int> input_slots;
 
     // debug flag
     bool debug_node;
 
+    // cached config (output limits)
+    bool has_u_min, has_u_max;
+    double u_min, u_max;
+
+    void load_config();
+
 public:
 
     AuraSummer( string config_path );
@@ -42,4 +49,6 @@ public:
 
     void reset();
     void update( double dt );
+    void bind_signals( APSignals *table );
+    void get_dependencies( APStageDeps *deps );
 };
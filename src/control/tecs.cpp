@@ -33,27 +33,48 @@
 #include <pyprops.h>
 #include "include/globaldefs.h"
 
+#include "util/prop_handle.h"
+
 #include "tecs.h"
 
-// input/output nodes
-static pyPropertyNode pos_node;
-static pyPropertyNode vel_node;
-static pyPropertyNode specs_node;
-static pyPropertyNode targets_node;
-static pyPropertyNode tecs_node;
-static pyPropertyNode tecs_config_node;
+// input/output values (signal table slots)
+static APSignals *signals = NULL;
+static int alt_slot, vel_slot;
+static int target_alt_slot, target_vel_slot;
+static int energy_pot_slot, energy_kin_slot;
+static int target_total_slot, target_pot_slot, target_kin_slot;
+static int error_pot_slot, error_kin_slot;
+static int error_total_slot, error_diff_slot;
 
-static bool tecs_inited = false;
+// config (re-read after a change)
+static pyPropertyNode tecs_config_node;
+static PropWatch config_watch;
+static double mass_kg, wb, config_min_kt, config_max_kt;
 
 static const float g = 9.81;
 
-static void init_tecs() {
-    pos_node = pyGetNode( "/position", true);
-    vel_node = pyGetNode( "/velocity", true);
-    targets_node = pyGetNode( "/autopilot/targets", true);
-    tecs_node = pyGetNode( "/autopilot/tecs", true);
+void bind_tecs( APSignals *table ) {
+    signals = table;
+    pyPropertyNode pos_node = pyGetNode( "/position", true);
+    pyPropertyNode vel_node = pyGetNode( "/velocity", true);
+    pyPropertyNode targets_node = pyGetNode( "/autopilot/targets", true);
+    pyPropertyNode tecs_node = pyGetNode( "/autopilot/tecs", true);
     tecs_config_node = pyGetNode( "/config/autopilot/TECS", true);
 
+    alt_slot = table->bind( pos_node, "altitude_agl_m" );
+    vel_slot = table->bind( vel_node, "airspeed_smoothed_kt" );
+    target_alt_slot = table->bind( targets_node, "altitude_agl_ft" );
+    target_vel_slot = table->bind( targets_node, "airspeed_kt" );
+    energy_pot_slot = table->bind( tecs_node, "energy_pot" );
+    energy_kin_slot = table->bind( tecs_node, "energy_kin" );
+    target_total_slot = table->bind( tecs_node, "target_total" );
+    target_pot_slot = table->bind( tecs_node, "target_pot" );
+    target_kin_slot = table->bind( tecs_node, "target_kin" );
+    error_pot_slot = table->bind( tecs_node, "error_pot" );
+    error_kin_slot = table->bind( tecs_node, "error_kin" );
+    error_total_slot = table->bind( tecs_node, "error_total" );
+    error_diff_slot = table->bind( tecs_node, "error_diff" );
+
     // quick sanity check
     if ( tecs_config_node.getDouble("mass_kg") < 0.01 ) {
         tecs_config_node.setDouble("mass_kg", 2.5);
@@ -61,50 +82,53 @@ static void init_tecs() {
     if ( ! tecs_config_node.hasChild("weight_bal") ) {
         tecs_config_node.setDouble("weight_bal", 1.0);
     }
-    tecs_inited = true;
+    config_watch.init( tecs_config_node );
 }
 
 // compute various energy metrics and errors
 void update_tecs() {
-    if ( !tecs_inited ) {
-        init_tecs();
+    if ( signals == NULL ) {
+        return;
+    }
+    if ( config_watch.changed() ) {
+        mass_kg = tecs_config_node.getDouble("mass_kg");
+        wb = tecs_config_node.getDouble("weight_bal");
+        config_min_kt = tecs_config_node.getDouble("min_kt");
+        config_max_kt = tecs_config_node.getDouble("max_kt");
     }
-
-    double mass_kg = tecs_config_node.getDouble("mass_kg");
-    double wb = tecs_config_node.getDouble("weight_bal");
 
     // Current energy
-    double alt_m = pos_node.getDouble("altitude_agl_m");
-    double vel_mps = vel_node.getDouble("airspeed_smoothed_kt") * SG_KT_TO_MPS;
+    double alt_m = signals->get( alt_slot );
+    double vel_mps = signals->get( vel_slot ) * SG_KT_TO_MPS;
     double energy_pot = mass_kg * g * alt_m;
     double energy_kin = 0.5 * mass_kg * vel_mps * vel_mps;
-    tecs_node.setDouble("energy_pot", energy_pot);
-    tecs_node.setDouble("energy_kin", energy_kin);
+    signals->set( energy_pot_slot, energy_pot );
+    signals->set( energy_kin_slot, energy_kin );
     
     // Target energy
-    double target_alt_m = targets_node.getDouble("altitude_agl_ft") * SG_FEET_TO_METER;
-    double target_vel_mps = targets_node.getDouble("airspeed_kt") * SG_KT_TO_MPS;
+    double target_alt_m = signals->get( target_alt_slot ) * SG_FEET_TO_METER;
+    double target_vel_mps = signals->get( target_vel_slot ) * SG_KT_TO_MPS;
     double target_pot = mass_kg * g * target_alt_m;
     double target_kin = 0.5 * mass_kg * target_vel_mps * target_vel_mps;
     double target_total = target_pot + target_kin;
-    tecs_node.setDouble("target_total", target_total);
-    tecs_node.setDouble("target_pot", target_pot);
-    tecs_node.setDouble("target_kin", target_kin);
+    signals->set( target_total_slot, target_total );
+    signals->set( target_pot_slot, target_pot );
+    signals->set( target_kin_slot, target_kin );
 
     // Energy error
     double error_pot = target_pot - energy_pot;
     double error_kin = target_kin - energy_kin;
-    tecs_node.setDouble("error_pot", error_pot);
-    tecs_node.setDouble("error_kin", error_kin);
+    signals->set( error_pot_slot, error_pot );
+    signals->set( error_kin_slot, error_kin );
     
     // Compute min & max kinetic energy allowed (based on configured
     // operational speed range)
-    double min_kt = tecs_config_node.getDouble("min_kt");
+    double min_kt = config_min_kt;
     if ( min_kt < 15 ) { min_kt = 15;}
     double min_mps = min_kt * SG_KT_TO_MPS;
     double min_kinetic = 0.5 * mass_kg * min_mps * min_mps;
 
-    double max_kt = tecs_config_node.getDouble("max_kt");
+    double max_kt = config_max_kt;
     if ( max_kt < 15 ) { max_kt = 2 * min_kt; }
     double max_mps = max_kt * SG_KT_TO_MPS;
     double max_kinetic = 0.5 * mass_kg * max_mps * max_mps;
@@ -136,8 +160,8 @@ void update_tecs() {
     if ( error_total > max_error ) { error_total = max_error; }
 
     // publish the final values
-    tecs_node.setDouble("error_total", error_total);
-    tecs_node.setDouble("error_diff", error_diff);
+    signals->set( error_total_slot, error_total );
+    signals->set( error_diff_slot, error_diff );
 }
 
 // Further notes:
@@ -1,4 +1,9 @@
 #pragma once
 
+#include "signals.h"
+
+// bind the tecs inputs and outputs to the autopilot signal table
+void bind_tecs( APSignals *signals );
+
 // compute various energy metrics and errors
 void update_tecs();
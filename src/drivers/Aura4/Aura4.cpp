@@ -52,6 +52,33 @@ void Aura4_t::hard_fail( const char *format, ... ) {
     exit(-1);
 }
 
+// per message property blocks (values are packed in this order)
+static const char *imu_names[] = {
+    "timestamp", "imu_sec", "p_rad_sec", "q_rad_sec", "r_rad_sec",
+    "ax_mps_sec", "ay_mps_sec", "az_mps_sec", "hx", "hy", "hz", "ax_raw",
+    "ay_raw", "az_raw", "hx_raw", "hy_raw", "hz_raw", "temp_C"
+};
+static const char *gps_names[] = {
+    "timestamp", "latitude_deg", "longitude_deg", "altitude_m",
+    "horiz_accuracy_m", "vert_accuracy_m", "vn_ms", "ve_ms", "vd_ms",
+    "pdop", "unix_time_sec"
+};
+static const char *gps_long_names[] = {
+    "year", "month", "day", "hour", "min", "sec", "satellites", "fixType"
+};
+static const char *airdata_names[] = {
+    "timestamp", "airspeed_mps", "airspeed_kt", "temp_C", "pressure_mbar",
+    "bme_temp_C", "humidity", "diff_pressure_pa", "ext_static_press_pa"
+};
+static const char *act_names[] = {
+    "throttle", "aileron", "elevator", "rudder", "flaps", "gear"
+};
+static const int imu_count = sizeof(imu_names) / sizeof(char *);
+static const int gps_count = sizeof(gps_names) / sizeof(char *);
+static const int gps_long_count = sizeof(gps_long_names) / sizeof(char *);
+static const int airdata_count = sizeof(airdata_names) / sizeof(char *);
+static const int act_count = sizeof(act_names) / sizeof(char *);
+
 void Aura4_t::init( pyPropertyNode *config ) {
     // bind main property nodes
     aura4_node = pyGetNode("/sensors/Aura4", true);
@@ -149,6 +176,8 @@ bool Aura4_t::open( pyPropertyNode *config ) {
 void Aura4_t::init_airdata( pyPropertyNode *config ) {
     string output_path = get_next_path("/sensors", "airdata", true);
     airdata_node = pyGetNode(output_path.c_str(), true);
+    airdata_batch.init( airdata_node, airdata_names, airdata_count );
+    airdata_error_count.init( airdata_node, "error_count" );
 }
 
 void Aura4_t::init_ekf( pyPropertyNode *config ) {
@@ -170,12 +199,17 @@ void Aura4_t::init_ekf( pyPropertyNode *config ) {
 void Aura4_t::init_gps( pyPropertyNode *config ) {
     string output_path = get_next_path("/sensors", "gps", true);
     gps_node = pyGetNode(output_path.c_str(), true);
+    gps_batch.init( gps_node, gps_names, gps_count );
+    gps_long_batch.init( gps_node, gps_long_names, gps_long_count );
 }
 
 void Aura4_t::init_imu( pyPropertyNode *config ) {
     string output_path = get_next_path("/sensors", "imu", true);
     imu_node = pyGetNode(output_path.c_str(), true);
 
+    imu_batch.init( imu_node, imu_names, imu_count );
+    imu_millis.init( imu_node, "imu_millis" );
+
     // FIXME:
     // if ( config->hasChild("calibration") ) {
     //     pyPropertyNode cal = config->getChild("calibration");
@@ -199,6 +233,7 @@ void Aura4_t::init_pilot( pyPropertyNode *config ) {
 
 void Aura4_t::init_actuators( pyPropertyNode *config ) {
     act_node = pyGetNode("/actuators", true);
+    act_batch.init( act_node, act_names, act_count );
 }
 
 bool Aura4_t::update_imu( message::imu_t *imu ) {
@@ -268,25 +303,18 @@ bool Aura4_t::update_imu( message::imu_t *imu ) {
 
     last_imu_millis = imu->millis;
 	
-    imu_node.setDouble( "timestamp", imu_remote_sec + fit_diff );
-    imu_node.setLong( "imu_millis", imu->millis );
-    imu_node.setDouble( "imu_sec", (double)imu->millis / 1000.0 );
-    imu_node.setDouble( "p_rad_sec", p_cal );
-    imu_node.setDouble( "q_rad_sec", q_cal );
-    imu_node.setDouble( "r_rad_sec", r_cal );
-    imu_node.setDouble( "ax_mps_sec", ax_cal );
-    imu_node.setDouble( "ay_mps_sec", ay_cal );
-    imu_node.setDouble( "az_mps_sec", az_cal );
-    imu_node.setDouble( "hx", hx_cal );
-    imu_node.setDouble( "hy", hy_cal );
-    imu_node.setDouble( "hz", hz_cal );
-    imu_node.setDouble( "ax_raw", ax_raw );
-    imu_node.setDouble( "ay_raw", ay_raw );
-    imu_node.setDouble( "az_raw", az_raw );
-    imu_node.setDouble( "hx_raw", hx_raw );
-    imu_node.setDouble( "hy_raw", hy_raw );
-    imu_node.setDouble( "hz_raw", hz_raw );
-    imu_node.setDouble( "temp_C", temp_C );
+    double vals[] = {
+        imu_remote_sec + fit_diff,      // timestamp
+        (double)imu->millis / 1000.0,   // imu_sec
+        p_cal, q_cal, r_cal,
+        ax_cal, ay_cal, az_cal,
+        hx_cal, hy_cal, hz_cal,
+        ax_raw, ay_raw, az_raw,
+        hx_raw, hy_raw, hz_raw,
+        temp_C
+    };
+    imu_batch.set( vals );
+    imu_millis.setLong( imu->millis );
 
     return true;
 }
@@ -1001,24 +1029,13 @@ bool Aura4_t::update_ekf( message::ekf_t *ekf ) {
 }
 
 bool Aura4_t::update_gps( message::aura_nav_pvt_t *nav_pvt ) {
-    gps_node.setDouble( "timestamp", get_Time() );
-    gps_node.setLong( "year", nav_pvt->year );
-    gps_node.setLong( "month", nav_pvt->month );
-    gps_node.setLong( "day", nav_pvt->day );
-    gps_node.setLong( "hour", nav_pvt->hour );
-    gps_node.setLong( "min", nav_pvt->min );
-    gps_node.setLong( "sec", nav_pvt->sec );
-    gps_node.setDouble( "latitude_deg", nav_pvt->lat / 10000000.0 );
-    gps_node.setDouble( "longitude_deg", nav_pvt->lon / 10000000.0 );
-    gps_node.setDouble( "altitude_m", nav_pvt->hMSL / 1000.0 );
-    gps_node.setDouble( "horiz_accuracy_m", nav_pvt->hAcc / 1000.0 );
-    gps_node.setDouble( "vert_accuracy_m", nav_pvt->vAcc / 1000.0 );
-    gps_node.setDouble( "vn_ms", nav_pvt->velN / 1000.0 );
-    gps_node.setDouble( "ve_ms", nav_pvt->velE / 1000.0 );
-    gps_node.setDouble( "vd_ms", nav_pvt->velD / 1000.0 );
-    gps_node.setLong( "satellites", nav_pvt->numSV);
-    gps_node.setDouble( "pdop", nav_pvt->pDOP / 100.0 );
-    gps_node.setLong( "fixType", nav_pvt->fixType );
+    long ivals[] = {
+        nav_pvt->year, nav_pvt->month, nav_pvt->day,
+        nav_pvt->hour, nav_pvt->min, nav_pvt->sec,
+        nav_pvt->numSV,                 // satellites
+        nav_pvt->fixType
+    };
+    gps_long_batch.set( ivals );
     // backwards compatibility
     if ( nav_pvt->fixType == 0 ) {
         gps_node.setLong( "status", 0 );
@@ -1036,7 +1053,20 @@ bool Aura4_t::update_gps( message::aura_nav_pvt_t *nav_pvt ) {
     gps_time.tm_year = nav_pvt->year - 1900;
     double unix_sec = (double)mktime( &gps_time ) - timezone;
     unix_sec += nav_pvt->nano / 1000000000.0;
-    gps_node.setDouble( "unix_time_sec", unix_sec );
+    double vals[] = {
+        get_Time(),                     // timestamp
+        nav_pvt->lat / 10000000.0,      // latitude_deg
+        nav_pvt->lon / 10000000.0,      // longitude_deg
+        nav_pvt->hMSL / 1000.0,         // altitude_m
+        nav_pvt->hAcc / 1000.0,         // horiz_accuracy_m
+        nav_pvt->vAcc / 1000.0,         // vert_accuracy_m
+        nav_pvt->velN / 1000.0,         // vn_ms
+        nav_pvt->velE / 1000.0,         // ve_ms
+        nav_pvt->velD / 1000.0,         // vd_ms
+        nav_pvt->pDOP / 100.0,          // pdop
+        unix_sec                        // unix_time_sec
+    };
+    gps_batch.set( vals );
     return true;
 }
 
@@ -1065,8 +1095,6 @@ bool Aura4_t::update_airdata( message::airdata_t *airdata ) {
         }
     }
 
-    airdata_node.setDouble( "timestamp", imu_timestamp );
-
     // basic pressure to airspeed formula: v = sqrt((2/p) * q)
     // where v = velocity, q = dynamic pressure (pitot tube sensor
     // value), and p = air density.
@@ -1096,17 +1124,21 @@ bool Aura4_t::update_airdata( message::airdata_t *airdata ) {
     if ( Pa < 0.0 ) { Pa = 0.0; } // avoid sqrt(neg_number) situation
     float airspeed_mps = sqrt( 2*Pa / 1.225 ) * pitot_calibrate;
     float airspeed_kt = airspeed_mps * SG_MPS_TO_KT;
-    airdata_node.setDouble( "airspeed_mps", airspeed_mps );
-    airdata_node.setDouble( "airspeed_kt", airspeed_kt );
-    airdata_node.setDouble( "temp_C", airdata->ext_temp_C );
 
     // publish sensor values
-    airdata_node.setDouble( "pressure_mbar", airdata->baro_press_pa / 100.0 );
-    airdata_node.setDouble( "bme_temp_C", airdata->baro_temp_C );
-    airdata_node.setDouble( "humidity", airdata->baro_hum );
-    airdata_node.setDouble( "diff_pressure_pa", airdata->ext_diff_press_pa );
-    airdata_node.setDouble( "ext_static_press_pa", airdata->ext_static_press_pa );
-    airdata_node.setLong( "error_count", airdata->error_count );
+    double vals[] = {
+        imu_timestamp,                  // timestamp
+        airspeed_mps,
+        airspeed_kt,
+        airdata->ext_temp_C,            // temp_C
+        airdata->baro_press_pa / 100.0, // pressure_mbar
+        airdata->baro_temp_C,           // bme_temp_C
+        airdata->baro_hum,              // humidity
+        airdata->ext_diff_press_pa,     // diff_pressure_pa
+        airdata->ext_static_press_pa    // ext_static_press_pa
+    };
+    airdata_batch.set( vals );
+    airdata_error_count.setLong( airdata->error_count );
 
     fresh_data = true;
 
@@ -1165,12 +1197,11 @@ void Aura4_t::write() {
     // send actuator commands to Aura4 servo subsystem
     if ( message::ap_channels == 6 ) {
         message::command_inceptors_t act;
-        act.channel[0] = act_node.getDouble("throttle");
-        act.channel[1] = act_node.getDouble("aileron");
-        act.channel[2] = act_node.getDouble("elevator");
-        act.channel[3] = act_node.getDouble("rudder");
-        act.channel[4] = act_node.getDouble("flaps");
-        act.channel[5] = act_node.getDouble("gear");
+        double vals[act_count];
+        act_batch.get( vals );
+        for ( int i = 0; i < act_count; i++ ) {
+            act.channel[i] = vals[i];
+        }
         act.pack();
         serial.write_packet( act.id, act.payload, act.len );
     }
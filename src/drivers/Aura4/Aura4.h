@@ -15,6 +15,7 @@ using namespace Eigen;
 #include "util/butter.h"
 #include "util/linearfit.h"
 #include "util/lowpass.h"
+#include "util/prop_handle.h"
 #include "util/serial_link.h"
 
 #include "aura4_messages.h"
@@ -43,6 +44,16 @@ private:
     pyPropertyNode power_node;
     pyPropertyNode act_node;
     pyPropertyNode status_node;
+
+    // per message values, moved as blocks (see the name lists in
+    // Aura4.cpp)
+    PropBatch imu_batch;
+    PropHandle imu_millis;
+    PropBatch gps_batch;
+    PropBatch gps_long_batch;
+    PropBatch airdata_batch;
+    PropHandle airdata_error_count;
+    PropBatch act_batch;
     
     string device_name = "/dev/ttyS4";
     int baud = 500000;
@@ -215,7 +215,8 @@ bool fgfs_t::update_gps() {
         // compute ideal magnetic vector in ned frame
         long int jd = now_to_julian_days();
         double field[6];
-        calc_magvar( lat*D2R, lon*D2R, alt / 1000.0, jd, field );
+        mag_cache.set_date( jd );
+        mag_cache.magvar( lat*D2R, lon*D2R, alt / 1000.0, field );
         mag_ned(0) = field[3];
         mag_ned(1) = field[4];
         mag_ned(2) = field[5];
@@ -10,6 +10,7 @@
 using namespace Eigen;
 
 #include "drivers/driver.h"
+#include "filters/nav_common/magcache.h"
 #include "util/netSocket.h"
 
 class fgfs_t: public driver_t {
@@ -41,6 +42,7 @@ private:
     netSocket sock_gps;
 
     Vector3f mag_ned;
+    MagFieldCache mag_cache;
     Quaternionf q_N2B;
     Matrix3f C_N2B;
     
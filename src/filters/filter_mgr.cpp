@@ -20,6 +20,7 @@ using std::string;
 #include "filters/nav_ekf15/aura_interface.h"
 #include "filters/nav_ekf15_mag/aura_interface.h"
 #include "include/globaldefs.h"
+#include "util/prop_handle.h"
 #include "util/props_helper.h"
 
 #include "ground.h"
@@ -48,6 +49,101 @@ static pyPropertyNode status_node;
 static vector<pyPropertyNode> sections;
 static vector<pyPropertyNode> outputs;
 
+// the official state (/orientation, /position, /velocity) is a set of
+// property aliases of the primary filter outputs, so nothing is copied
+// per frame and selecting a different primary filter just re-points
+// the aliases.  The official state only follows the filter while its
+// status is 2 (ok), otherwise the aliases point at a hold node with
+// the last good values.
+struct prop_alias_t {
+    pyPropertyNode *node;
+    const char *name;
+    pyPropertyNode *target;     // NULL = the official source
+    const char *target_name;
+};
+static PropHandle filter_status;
+static PropHandle imu_timestamp;
+static pyPropertyNode hold_node;
+static bool official_live = false; // aliases point at the filter
+static const char *filter_names[] = {
+    "roll_deg", "pitch_deg", "heading_deg", "latitude_deg", "longitude_deg",
+    "altitude_m", "altitude_ft", "vn_ms", "ve_ms", "vd_ms", "timestamp",
+    "groundtrack_deg", "groundspeed_ms", "vertical_speed_fps"
+};
+static const int filter_count = sizeof(filter_names) / sizeof(char *);
+static PropBatch filter_outputs;
+static PropBatch hold_outputs;
+static double last_good[filter_count];
+
+// point the official state at source (the primary filter or the hold
+// node)
+static void alias_official( pyPropertyNode &source ) {
+    const prop_alias_t aliases[] = {
+        { &orient_node, "roll_deg", NULL, "roll_deg" },
+        { &orient_node, "pitch_deg", NULL, "pitch_deg" },
+        { &orient_node, "heading_deg", NULL, "heading_deg" },
+        { &pos_node, "latitude_deg", NULL, "latitude_deg" },
+        { &pos_node, "longitude_deg", NULL, "longitude_deg" },
+        { &pos_filter_node, "altitude_m", NULL, "altitude_m" },
+        { &pos_filter_node, "altitude_ft", NULL, "altitude_ft" },
+        { &vel_node, "vn_ms", NULL, "vn_ms" },
+        { &vel_node, "ve_ms", NULL, "ve_ms" },
+        { &vel_node, "vd_ms", NULL, "vd_ms" },
+        { &filter_group_node, "timestamp", NULL, "timestamp" },
+        { &orient_node, "groundtrack_deg", NULL, "groundtrack_deg" },
+        { &vel_node, "groundspeed_ms", NULL, "groundspeed_ms" },
+        { &vel_node, "vertical_speed_fps", NULL, "vertical_speed_fps" },
+
+        // the official altitude favors the filter based altitude
+        // which can be adversely affected (significantly) by gps
+        // altitude errors (see publish_values()).  (After the
+        // /position/filter aliases above so the chain resolves to the
+        // new source.)
+        { &pos_node, "altitude_m", &pos_filter_node, "altitude_m" },
+        { &pos_node, "altitude_ft", &pos_filter_node, "altitude_ft" },
+        { &pos_node, "altitude_agl_m", &pos_filter_node, "altitude_agl_m" },
+        { &pos_node, "altitude_agl_ft", &pos_filter_node, "altitude_agl_ft" },
+        { &pos_node, "altitude_ground_m",
+          &pos_filter_node, "altitude_ground_m" }
+    };
+    int count = sizeof(aliases) / sizeof(prop_alias_t);
+    for ( int i = 0; i < count; i++ ) {
+        pyPropertyNode *target = aliases[i].target;
+        prop_alias( *aliases[i].node, aliases[i].name,
+                    target != NULL ? *target : source,
+                    aliases[i].target_name );
+    }
+    official_live = (source.pObj == filter_node.pObj);
+}
+
+static void select_primary( pyPropertyNode &primary_node ) {
+    if ( primary_node.pObj != filter_node.pObj ) {
+        filter_node = primary_node;
+    }
+    filter_status.init( filter_node, "status" );
+    filter_outputs.init( filter_node, filter_names, filter_count );
+    if ( filter_status.getLong() == 2 ) {
+        alias_official( filter_node );
+    } else {
+        alias_official( hold_node );
+    }
+}
+
+// follow the primary filter status: the official state tracks the
+// filter while it is ok and holds the last good values otherwise (the
+// aliases are only re-pointed when the status changes)
+static void update_official() {
+    if ( filter_status.getLong() == 2 ) {
+        if ( !official_live ) {
+            alias_official( filter_node );
+        }
+        filter_outputs.get( last_good );
+    } else if ( official_live ) {
+        hold_outputs.set( last_good );
+        alias_official( hold_node );
+    }
+}
+
 void Filter_init() {
     pyPropsInit();              // first thing
     
@@ -62,7 +158,11 @@ void Filter_init() {
     pos_filter_node = pyGetNode("/position/filter", true);
     pos_pressure_node = pyGetNode("/position/pressure", true);
     pos_combined_node = pyGetNode("/position/combined", true);
+    hold_node = pyGetNode("/filters/hold", true);
     status_node = pyGetNode("/status", true);
+    hold_outputs.init( hold_node, filter_names, filter_count );
+    imu_timestamp.init( imu_node, "timestamp" );
+    select_primary( filter_node );
 
     // traverse configured modules
     pyPropertyNode group_node = pyGetNode("/config/filters", true);
@@ -134,19 +234,7 @@ static void update_euler_rates() {
 
 
 static void publish_values() {
-    orient_node.setDouble( "roll_deg", filter_node.getDouble("roll_deg") );
-    orient_node.setDouble( "pitch_deg", filter_node.getDouble("pitch_deg") );
-    orient_node.setDouble( "heading_deg", filter_node.getDouble("heading_deg") );
-    pos_node.setDouble( "latitude_deg", filter_node.getDouble("latitude_deg") );
-    pos_node.setDouble( "longitude_deg", filter_node.getDouble("longitude_deg") );
-    pos_filter_node.setDouble("altitude_m", filter_node.getDouble("altitude_m"));
-    pos_filter_node.setDouble("altitude_ft", filter_node.getDouble("altitude_ft"));
-    vel_node.setDouble( "vn_ms", filter_node.getDouble("vn_ms") );
-    vel_node.setDouble( "ve_ms", filter_node.getDouble("ve_ms") );
-    vel_node.setDouble( "vd_ms", filter_node.getDouble("vd_ms") );
-    filter_group_node.setDouble( "timestamp",
-				 filter_node.getDouble("timestamp") );
-    int status = filter_node.getLong("status");
+    int status = filter_status.getLong();
     if ( status == 0 ) {
         status_node.setString( "navigation", "invalid" );
     } else if ( status == 1 ) {
@@ -154,23 +242,6 @@ static void publish_values() {
     } else if ( status == 2 ) {
         status_node.setString( "navigation", "ok" );
     }
-    bool use_filter = true;
-    bool use_gps = !use_filter;
-    if ( use_filter ) {
-	orient_node.setDouble( "groundtrack_deg",
-			       filter_node.getDouble("groundtrack_deg") );
-	vel_node.setDouble( "groundspeed_ms",
-			    filter_node.getDouble("groundspeed_ms") );
-    } else if ( use_gps ) {
-	const double R2D = 57.295779513082323;
-	double vn = gps_node.getDouble("vn_ms");
-	double ve = gps_node.getDouble("ve_ms");
-	filter_node.setDouble( "groundtrack_deg", 90 - atan2(vn, ve) * R2D );
-	filter_node.setDouble( "groundspeed_ms", sqrt(vn*vn + ve*ve) );
-    }
-   
-    vel_node.setDouble( "vertical_speed_fps",
-			filter_node.getDouble("vertical_speed_fps") );
     
     // select official source (currently AGL is pressure based,
     // absolute ground alt is based on average gps/filter value at
@@ -200,23 +271,13 @@ static void publish_values() {
     //     		pos_pressure_node.getDouble("altitude_agl_ft") );
     // pos_node.setDouble( "altitude_ground_m",
     //     		pos_filter_node.getDouble("altitude_ground_m") );
-
-    // the following block favor the filter based altitude which can
-    // be adversely affected (significantly) by gps altitude errors.
-    pos_node.setDouble( "altitude_m",
-			pos_filter_node.getDouble("altitude_m") );
-    pos_node.setDouble( "altitude_ft",
-			pos_filter_node.getDouble("altitude_ft") );
-    pos_node.setDouble( "altitude_agl_m",
-			pos_filter_node.getDouble("altitude_agl_m") );
-    pos_node.setDouble( "altitude_agl_ft",
-			pos_filter_node.getDouble("altitude_agl_ft") );
-    pos_node.setDouble( "altitude_ground_m",
-			pos_filter_node.getDouble("altitude_ground_m") );
+    //
+    // (the filter based altitude is currently selected, see
+    // select_primary())
 }
 
 bool Filter_update() {
-    double imu_time = imu_node.getDouble("timestamp");
+    double imu_time = imu_timestamp.getDouble();
     double imu_dt = imu_time - last_imu_time;
     bool fresh_filter_data = false;
 
@@ -262,8 +323,10 @@ bool Filter_update() {
 	}
     }
     
+    update_official();
+
     // only for primary filter
-    if ( filter_node.getLong("status") == 2 ) {
+    if ( filter_status.getLong() == 2 ) {
         update_euler_rates();
         update_ground(imu_dt);
         update_wind(imu_dt);
@@ -0,0 +1,104 @@
+// filter_mgr_test.cpp -- check the official state (/orientation,
+//                        /position, /velocity) follows the primary
+//                        filter only while its status is ok and holds
+//                        the last good values while it is invalid or
+//                        has no gps.  (Run from src with PYTHONPATH=.
+//                        so util.propalias imports.)
+//
+// g++ -O3 -I.. -I/usr/include/eigen3 $(python3-config --includes)
+//     filter_mgr_test.cpp filter_mgr.cpp ground.cpp wind.cpp
+//     nav_ekf15/aura_interface.cpp nav_ekf15/covariance.cpp
+//     nav_ekf15/EKF_15state.cpp nav_ekf15_mag/aura_interface.cpp
+//     nav_common/coremag.c nav_common/magcache.cpp
+//     nav_common/nav_functions.cpp ../util/lowpass.cpp
+//     ../util/prop_handle.cpp ../util/props_helper.cpp ../util/timing.cpp
+//     -lpyprops $(python3-config --ldflags --embed) -o filter_mgr_test
+
+#include <math.h>
+#include <stdio.h>
+
+#include <pyprops.h>
+
+#include "filter_mgr.h"
+
+static const char *config =
+    "import props\n"
+    "c = props.getNode('/config/filters/filter[0]', True)\n"
+    "c.module = 'null'\n"
+    "c.enable = True\n"
+    "c.primary = True\n";
+
+static pyPropertyNode filter_node;
+
+// one frame of primary filter output
+static void filter_frame( long status, double lat, double alt_m ) {
+    filter_node.setLong( "status", status );
+    filter_node.setDouble( "latitude_deg", lat );
+    filter_node.setDouble( "longitude_deg", -93.0 );
+    filter_node.setDouble( "altitude_m", alt_m );
+    filter_node.setDouble( "roll_deg", lat / 10.0 );
+    filter_node.setDouble( "vn_ms", lat / 2.0 );
+    Filter_update();
+}
+
+static bool check( const char *what, double lat, double alt_m ) {
+    pyPropertyNode pos_node = pyGetNode( "/position", true );
+    pyPropertyNode orient_node = pyGetNode( "/orientation", true );
+    pyPropertyNode vel_node = pyGetNode( "/velocity", true );
+    if ( fabs(pos_node.getDouble("latitude_deg") - lat) > 1e-9
+         || fabs(pos_node.getDouble("altitude_m") - alt_m) > 1e-9
+         || fabs(orient_node.getDouble("roll_deg") - lat / 10.0) > 1e-9
+         || fabs(vel_node.getDouble("vn_ms") - lat / 2.0) > 1e-9 ) {
+        printf("FAIL: %s: lat %.2f alt %.2f roll %.2f vn %.2f\n", what,
+               pos_node.getDouble("latitude_deg"),
+               pos_node.getDouble("altitude_m"),
+               orient_node.getDouble("roll_deg"),
+               vel_node.getDouble("vn_ms"));
+        return false;
+    }
+    return true;
+}
+
+int main() {
+    bool pass = true;
+
+    Py_Initialize();
+    pyPropsInit();
+    if ( PyRun_SimpleString(config) != 0 ) {
+        printf("FAIL: config\n");
+        return 1;
+    }
+    filter_node = pyGetNode( "/filters/filter[0]", true );
+    filter_node.setLong( "status", 0 );
+    Filter_init();
+
+    // not yet initialized: nothing official
+    filter_frame( 0, 12.0, 5.0 );
+    pyPropertyNode pos_node = pyGetNode( "/position", true );
+    if ( pos_node.hasChild("latitude_deg") ) {
+        printf("FAIL: official position before the filter is ok\n");
+        pass = false;
+    }
+
+    // ok: the official state tracks the filter
+    filter_frame( 2, 45.0, 300.0 );
+    pass &= check( "ok", 45.0, 300.0 );
+    filter_frame( 2, 45.5, 310.0 );
+    pass &= check( "ok", 45.5, 310.0 );
+
+    // invalid, then no gps: hold the last good values
+    filter_frame( 0, 99.0, -1000.0 );
+    pass &= check( "invalid", 45.5, 310.0 );
+    filter_frame( 1, 98.0, -900.0 );
+    pass &= check( "no_gps", 45.5, 310.0 );
+
+    // ok again: back to the filter
+    filter_frame( 2, 46.0, 320.0 );
+    pass &= check( "recovered", 46.0, 320.0 );
+
+    if ( !pass ) {
+        return 1;
+    }
+    printf("PASS\n");
+    return 0;
+}
@@ -0,0 +1,248 @@
+// magcache.cpp -- gridded cache of the magnetic field model
+//
+
+#include <math.h>
+
+#include "constants.h"
+#include "coremag.h"
+#include "magcache.h"
+
+// above this latitude the cache passes calls straight through
+static const double polar_limit = 88.0 * D2R;
+
+std::mutex &magcache_lock() {
+    static std::mutex lock;
+    return lock;
+}
+
+static uint64_t tile_key( int ilat, int ilon, int ialt ) {
+    return ((uint64_t)(ilat & 0xfffff) << 40)
+        | ((uint64_t)(ilon & 0xfffff) << 20)
+        | (uint64_t)(ialt & 0xfffff);
+}
+
+MagFieldCache::MagFieldCache( double tile_deg, double tile_km,
+                              int intervals, int max_tiles ):
+    tile_deg(tile_deg),
+    tile_km(tile_km),
+    n(intervals > 0 ? intervals : 1),
+    max_tiles(max_tiles > 0 ? max_tiles : 1),
+    date(now_to_julian_days()),
+    last(-1),
+    clock(0),
+    pending_next(-1)
+{
+    stats = MagCacheStats();
+}
+
+void MagFieldCache::set_date( long jd ) {
+    if ( jd != date ) {
+        date = jd;
+        clear();
+    }
+}
+
+void MagFieldCache::clear() {
+    tiles.clear();
+    index.clear();
+    last = -1;
+    pending_next = -1;
+}
+
+long MagFieldCache::bytes() {
+    long total = sizeof(*this);
+    for ( size_t i = 0; i < tiles.size(); i++ ) {
+        total += sizeof(Tile) + tiles[i].nodes.size() * sizeof(double);
+    }
+    return total;
+}
+
+// sample the model at nodes [first, first+count) of the tile (nodes
+// run lon fastest, then lat, then altitude)
+void MagFieldCache::fill_nodes( Tile &tile, int ilat, int ilon, int ialt,
+                                int first, int count )
+{
+    int m = n + 1;
+    if ( first == 0 ) {
+        tile.key = tile_key( ilat, ilon, ialt );
+        tile.nodes.resize( m * m * m * 6 );
+    }
+    double *node = &tile.nodes[first * 6];
+    std::lock_guard<std::mutex> lock( magcache_lock() );
+    for ( int idx = first; idx < first + count; idx++ ) {
+        int k = idx / (m * m);
+        int i = (idx / m) % m;
+        int j = idx % m;
+        double h = (ialt + (double)k / n) * tile_km;
+        double lat = (ilat + (double)i / n) * tile_deg * D2R;
+        double lon = (ilon + (double)j / n) * tile_deg * D2R;
+        calc_magvar( lat, lon, h, date, node );
+        node += 6;
+    }
+}
+
+int MagFieldCache::held_tile( uint64_t key ) {
+    if ( last >= 0 && tiles[last].key == key ) {
+        return last;
+    }
+    std::unordered_map<uint64_t, int>::iterator it = index.find( key );
+    if ( it != index.end() ) {
+        last = it->second;
+        return last;
+    }
+    return -1;
+}
+
+// a slot for a new tile: a new one or the least recently used one
+int MagFieldCache::new_tile( uint64_t key ) {
+    stats.misses++;
+    int slot;
+    if ( (int)tiles.size() < max_tiles ) {
+        tiles.push_back( Tile() );
+        slot = tiles.size() - 1;
+    } else {
+        slot = 0;
+        for ( int i = 1; i < (int)tiles.size(); i++ ) {
+            if ( tiles[i].last_use < tiles[slot].last_use ) {
+                slot = i;
+            }
+        }
+        index.erase( tiles[slot].key );
+        stats.evictions++;
+    }
+    index[key] = slot;
+    last = slot;
+    return slot;
+}
+
+// grid coordinates of a position (longitude wrapped to [-180, 180)),
+// false above the polar limit
+bool MagFieldCache::locate( double lat, double lon, double h, double *u,
+                            double *v, double *w, int *ilat, int *ilon,
+                            int *ialt )
+{
+    if ( fabs(lat) > polar_limit ) {
+        return false;
+    }
+    double lon_deg = fmod( lon * R2D + 180.0, 360.0 );
+    if ( lon_deg < 0.0 ) {
+        lon_deg += 360.0;
+    }
+    lon_deg -= 180.0;
+    *u = lat * R2D / tile_deg;
+    *v = lon_deg / tile_deg;
+    *w = h / tile_km;
+    *ilat = floor( *u );
+    *ilon = floor( *v );
+    *ialt = floor( *w );
+    return true;
+}
+
+double MagFieldCache::magvar( double lat, double lon, double h,
+                              double *field )
+{
+    stats.lookups++;
+    double u, v, w;
+    int ilat, ilon, ialt;
+    if ( !locate( lat, lon, h, &u, &v, &w, &ilat, &ilon, &ialt ) ) {
+        stats.direct++;
+        std::lock_guard<std::mutex> lock( magcache_lock() );
+        return calc_magvar( lat, lon, h, date, field );
+    }
+    uint64_t key = tile_key( ilat, ilon, ialt );
+    int slot = held_tile( key );
+    if ( slot < 0 ) {
+        slot = new_tile( key );
+        int m = n + 1;
+        fill_nodes( tiles[slot], ilat, ilon, ialt, 0, m * m * m );
+    }
+    interpolate( tiles[slot], u, v, w, ilat, ilon, ialt, field );
+    double X = field[3];
+    double Y = field[4];
+    return (X != 0.0 || Y != 0.0) ? atan2(Y, X) : 0.0;
+}
+
+bool MagFieldCache::lookup( double lat, double lon, double h,
+                            double *field )
+{
+    double u, v, w;
+    int ilat, ilon, ialt;
+    if ( !locate( lat, lon, h, &u, &v, &w, &ilat, &ilon, &ialt ) ) {
+        magvar( lat, lon, h, field );
+        return true;
+    }
+    int slot = held_tile( tile_key(ilat, ilon, ialt) );
+    if ( slot < 0 ) {
+        return false;
+    }
+    stats.lookups++;
+    interpolate( tiles[slot], u, v, w, ilat, ilon, ialt, field );
+    return true;
+}
+
+void MagFieldCache::prefill( double lat, double lon, double h,
+                             int max_nodes )
+{
+    double u, v, w;
+    int ilat, ilon, ialt;
+    if ( !locate( lat, lon, h, &u, &v, &w, &ilat, &ilon, &ialt ) ) {
+        return;
+    }
+    uint64_t key = tile_key( ilat, ilon, ialt );
+    if ( held_tile( key ) >= 0 ) {
+        return;
+    }
+    if ( pending_next < 0 || pending.key != key ) {
+        // start (or restart for a new position)
+        pending_next = 0;
+    }
+    int m = n + 1;
+    int count = m * m * m - pending_next;
+    if ( count > max_nodes ) {
+        count = max_nodes;
+    }
+    fill_nodes( pending, ilat, ilon, ialt, pending_next, count );
+    pending_next += count;
+    if ( pending_next == m * m * m ) {
+        int slot = new_tile( key );
+        tiles[slot].key = key;
+        tiles[slot].nodes.swap( pending.nodes );
+        tiles[slot].last_use = ++clock;
+        pending_next = -1;
+    }
+}
+
+// trilinear interpolation in the grid cell of (u, v, w)
+void MagFieldCache::interpolate( Tile &tile, double u, double v, double w,
+                                 int ilat, int ilon, int ialt,
+                                 double *field )
+{
+    tile.last_use = ++clock;
+    u = (u - ilat) * n;
+    v = (v - ilon) * n;
+    w = (w - ialt) * n;
+    int i = u < n ? (int)u : n - 1;
+    int j = v < n ? (int)v : n - 1;
+    int k = w < n ? (int)w : n - 1;
+    double fu = u - i;
+    double fv = v - j;
+    double fw = w - k;
+    int m = n + 1;
+    const double *c000 = &tile.nodes[((k * m + i) * m + j) * 6];
+    const double *c001 = c000 + 6;                  // +lon
+    const double *c010 = c000 + m * 6;              // +lat
+    const double *c011 = c010 + 6;
+    const double *c100 = c000 + m * m * 6;          // +alt
+    const double *c101 = c100 + 6;
+    const double *c110 = c100 + m * 6;
+    const double *c111 = c110 + 6;
+    for ( int c = 0; c < 6; c++ ) {
+        double f00 = c000[c] + (c001[c] - c000[c]) * fv;
+        double f01 = c010[c] + (c011[c] - c010[c]) * fv;
+        double f10 = c100[c] + (c101[c] - c100[c]) * fv;
+        double f11 = c110[c] + (c111[c] - c110[c]) * fv;
+        double f0 = f00 + (f01 - f00) * fu;
+        double f1 = f10 + (f11 - f10) * fu;
+        field[c] = f0 + (f1 - f0) * fw;
+    }
+}
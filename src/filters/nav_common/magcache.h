@@ -0,0 +1,105 @@
+// magcache.h -- gridded cache of the magnetic field model
+//
+// calc_magvar() evaluates the full order 12 spherical harmonic model on
+// every call.  MagFieldCache samples the model on a regular
+// lat/lon/altitude grid and interpolates trilinearly between the grid
+// nodes.  The grid is split into tiles (by default 1 deg x 1 deg x 4 km
+// with nodes every 0.25 deg and 1 km) which are filled on first use,
+// and the least recently used tile is dropped once max_tiles are held,
+// so the memory footprint is bounded (6 KB per default tile.)
+//
+// Within a tile the interpolated field is within a few nT of the model
+// (the model itself is good to about 200 nT.)  The model is ill defined
+// near the geographic poles, so above 88 deg latitude the cache passes
+// the call straight through.
+//
+// magvar() fills a missing tile on the spot (125 model evaluations by
+// default.)  A time critical caller instead spreads the fill over
+// several frames with prefill() and reads with lookup(), which never
+// fills.
+//
+// A cache is not thread safe.  calc_magvar() is not reentrant either:
+// the tile fills of all caches are serialized by a common lock, and
+// direct callers that run concurrently with a cache should hold
+// magcache_lock() around their call.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+using std::vector;
+
+struct MagCacheStats {
+    long lookups;
+    long misses;                // tile fills
+    long evictions;
+    long direct;                // polar pass through calls
+};
+
+class MagFieldCache {
+
+public:
+
+    MagFieldCache( double tile_deg = 1.0, double tile_km = 4.0,
+                   int intervals = 4, int max_tiles = 32 );
+
+    // the (julian) date of the model, changing it drops every tile
+    void set_date( long jd );
+    long get_date() { return date; }
+
+    // same contract as calc_magvar(): geodetic lat and lon (rad),
+    // height (km), returns the variation (rad) and fills field[6] with
+    // B_r, B_theta, B_phi, X (north), Y (east), Z (down) in nT
+    double magvar( double lat, double lon, double h, double *field );
+
+    // as magvar() but only from a tile already held, false (and field
+    // untouched) when the tile of the position is not filled yet
+    bool lookup( double lat, double lon, double h, double *field );
+
+    // fill the tile of the position with at most max_nodes model
+    // evaluations per call (a no-op once the tile is held)
+    void prefill( double lat, double lon, double h, int max_nodes );
+
+    void clear();
+    int size() { return tiles.size(); }
+    long bytes();
+    MagCacheStats get_stats() { return stats; }
+
+private:
+
+    struct Tile {
+        uint64_t key;
+        long last_use;
+        vector<double> nodes;   // (n+1)^3 nodes, 6 components each
+    };
+
+    double tile_deg;
+    double tile_km;
+    int n;                      // grid intervals per tile side
+    int max_tiles;
+    long date;
+
+    vector<Tile> tiles;
+    std::unordered_map<uint64_t, int> index;
+    int last;                   // most recently used tile
+    long clock;
+    MagCacheStats stats;
+
+    Tile pending;               // tile being prefilled
+    int pending_next;           // next node of pending (-1 = none)
+
+    bool locate( double lat, double lon, double h, double *u, double *v,
+                 double *w, int *ilat, int *ilon, int *ialt );
+    int held_tile( uint64_t key );
+    int new_tile( uint64_t key );
+    void fill_nodes( Tile &tile, int ilat, int ilon, int ialt, int first,
+                     int count );
+    void interpolate( Tile &tile, double u, double v, double w,
+                      int ilat, int ilon, int ialt, double *field );
+};
+
+// serializes calc_magvar() between the caches and direct callers
+std::mutex &magcache_lock();
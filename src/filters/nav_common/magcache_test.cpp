@@ -0,0 +1,150 @@
+// magcache_test.cpp -- compare the gridded magnetic field cache with
+//                      direct evaluation of the model, time both, and
+//                      check a tile fill spread over frames.
+//
+// g++ -O3 -I../.. magcache_test.cpp magcache.cpp coremag.c
+//     ../../util/timing.cpp -o magcache_test
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "util/timing.h"
+
+#include "constants.h"
+#include "coremag.h"
+#include "magcache.h"
+
+struct Errors {
+    double field_nT;            // max |B_cache - B_model| (north, east, down)
+    double magvar_deg;          // max variation difference
+    double dir_deg;             // max angle between the field vectors
+};
+
+static void compare( MagFieldCache &cache, long jd, double lat, double lon,
+                     double h, Errors *e )
+{
+    double a[6], b[6];
+    double va = calc_magvar( lat, lon, h, jd, a );
+    double vb = cache.magvar( lat, lon, h, b );
+    double dot = 0.0, na = 0.0, nb = 0.0;
+    for ( int c = 3; c < 6; c++ ) {
+        e->field_nT = fmax( e->field_nT, fabs(a[c] - b[c]) );
+        dot += a[c] * b[c];
+        na += a[c] * a[c];
+        nb += b[c] * b[c];
+    }
+    double dv = fabs( va - vb ) * R2D;
+    if ( dv > 180.0 ) { dv = 360.0 - dv; }
+    e->magvar_deg = fmax( e->magvar_deg, dv );
+    double cosang = fmin( dot / sqrt(na * nb), 1.0 );
+    e->dir_deg = fmax( e->dir_deg, acos(cosang) * R2D );
+}
+
+int main() {
+    long jd = yymmdd_to_julian_days( 18, 6, 1 );
+    bool pass = true;
+
+    // random points over a 4 x 4 deg operating area, 0-6 km (32 tiles)
+    MagFieldCache cache;
+    cache.set_date( jd );
+    Errors local = { 0.0, 0.0, 0.0 };
+    for ( int i = 0; i < 20000; i++ ) {
+        double lat = (45.0 + 4.0 * (drand48() - 0.5)) * D2R;
+        double lon = (-93.0 + 4.0 * (drand48() - 0.5)) * D2R;
+        double h = 6.0 * drand48();
+        compare( cache, jd, lat, lon, h, &local );
+    }
+    MagCacheStats stats = cache.get_stats();
+    long local_fills = stats.misses;
+    printf("local:  field %.2f nT  variation %.4f deg  direction %.4f deg  (%d tiles, %ld fills, %ld evictions, %.0f KB)\n",
+           local.field_nT, local.magvar_deg, local.dir_deg, cache.size(),
+           stats.misses, stats.evictions, cache.bytes() / 1024.0);
+
+    // worldwide (up to the polar pass through), across the date line,
+    // with a small cache that evicts constantly
+    MagFieldCache small( 1.0, 4.0, 4, 8 );
+    small.set_date( jd );
+    Errors world = { 0.0, 0.0, 0.0 };
+    for ( int i = 0; i < 20000; i++ ) {
+        double lat = 170.0 * (drand48() - 0.5) * D2R;
+        double lon = 360.0 * (drand48() - 0.5) * D2R;
+        double h = 10.0 * drand48();
+        compare( small, jd, lat, lon, h, &world );
+    }
+    stats = small.get_stats();
+    printf("world:  field %.2f nT  variation %.4f deg  direction %.4f deg  (%d tiles, %ld fills, %ld evictions, %.0f KB)\n",
+           world.field_nT, world.magvar_deg, world.dir_deg, small.size(),
+           stats.misses, stats.evictions, small.bytes() / 1024.0);
+    if ( local_fills > 32 ) {
+        printf("FAIL: the operating area did not stay cached\n");
+        pass = false;
+    }
+    if ( small.size() > 8 ) {
+        printf("FAIL: the cache grew past max_tiles\n");
+        pass = false;
+    }
+    if ( local.field_nT > 20.0 || local.magvar_deg > 0.02
+         || world.field_nT > 100.0 || world.dir_deg > 0.1 ) {
+        printf("FAIL: interpolation error\n");
+        pass = false;
+    }
+
+    // timing along a 100hz flight path (30 m/s east for 10 minutes)
+    const int steps = 60000;
+    double lat = 45.0 * D2R;
+    double lon0 = -93.0 * D2R;
+    double dlon = 0.3 / (6378137.0 * cos(lat));
+    double field[6];
+    double sum = 0.0;
+    double start = get_Time();
+    for ( int i = 0; i < steps; i++ ) {
+        sum += calc_magvar( lat, lon0 + i * dlon, 0.3, jd, field );
+    }
+    double direct_sec = get_Time() - start;
+    MagFieldCache path;
+    path.set_date( jd );
+    start = get_Time();
+    for ( int i = 0; i < steps; i++ ) {
+        sum -= path.magvar( lat, lon0 + i * dlon, 0.3, field );
+    }
+    double cache_sec = get_Time() - start;
+    printf("flight path: direct %.3f us  cached %.3f us per call (%.0fx, %ld fills)  [%.1e]\n",
+           direct_sec * 1e6 / steps, cache_sec * 1e6 / steps,
+           direct_sec / cache_sec, path.get_stats().misses, sum);
+
+    // a tile filled 5 nodes per frame: lookup() misses until the tile
+    // is complete and then matches the tile magvar() filled at once
+    MagFieldCache spread;
+    spread.set_date( jd );
+    double a[6], b[6];
+    int frames = 0;
+    double max_frame_sec = 0.0;
+    while ( !spread.lookup( lat, lon0, 0.3, a ) && frames < 1000 ) {
+        start = get_Time();
+        spread.prefill( lat, lon0, 0.3, 5 );
+        max_frame_sec = fmax( max_frame_sec, get_Time() - start );
+        frames++;
+    }
+    MagFieldCache whole;
+    whole.set_date( jd );
+    start = get_Time();
+    whole.magvar( lat, lon0, 0.3, b );
+    double fill_sec = get_Time() - start;
+    printf("tile fill: at once %.1f us, spread over %d frames %.1f us max per frame\n",
+           fill_sec * 1e6, frames, max_frame_sec * 1e6);
+    bool same = true;
+    for ( int c = 0; c < 6; c++ ) {
+        same &= (a[c] == b[c]);
+    }
+    if ( frames != 25 || !same || spread.get_stats().misses != 1 ) {
+        printf("FAIL: spread tile fill\n");
+        pass = false;
+    }
+
+    if ( !pass ) {
+        return 1;
+    }
+    printf("PASS\n");
+    return 0;
+}
@@ -19,6 +19,9 @@ using std::cout;
 using std::endl;
 #include <stdio.h>
 
+#include "util/timing.h"
+
+#include "../nav_common/coremag.h"
 #include "../nav_common/nav_functions.h"
 #include "EKF_15state.h"
 
@@ -40,15 +43,18 @@ const double Rns = 6.386034030458164e+006; // earth radius
 // lot of these multi line equations with temp matrices can be
 // compressed.
 
-void EKF15::set_config(NAVconfig config) {
+template <int Sensors>
+void EKF15T<Sensors>::set_config(NAVconfig config) {
     this->config = config;
 }
 
-NAVconfig EKF15::get_config() {
+template <int Sensors>
+NAVconfig EKF15T<Sensors>::get_config() {
     return config;
 }
 
-void EKF15::default_config()
+template <int Sensors>
+void EKF15T<Sensors>::default_config()
 {
     config.sig_w_ax = 0.05;     // Std dev of Accelerometer Wide Band Noise (m/s^2)
     config.sig_w_ay = 0.05;
@@ -67,7 +73,8 @@ void EKF15::default_config()
     config.sig_mag      = 0.3;  // Magnetometer measurement noise std dev (normalized -1 to 1)
 }
 
-void EKF15::init(IMUdata imu, GPSdata gps) {
+template <int Sensors>
+void EKF15T<Sensors>::init(IMUdata imu, GPSdata gps) {
     I15.setIdentity();
     I3.setIdentity();
 
@@ -102,6 +109,9 @@ void EKF15::init(IMUdata imu, GPSdata gps) {
     R.setZero();
     R(0,0) = config.sig_gps_p_ne*config.sig_gps_p_ne;	 R(1,1) = config.sig_gps_p_ne*config.sig_gps_p_ne;  R(2,2) = config.sig_gps_p_d*config.sig_gps_p_d;
     R(3,3) = config.sig_gps_v_ne*config.sig_gps_v_ne;	 R(4,4) = config.sig_gps_v_ne*config.sig_gps_v_ne;  R(5,5) = config.sig_gps_v_d*config.sig_gps_v_d;
+    if ( Sensors & EKF_MAG ) {
+        R(6,6) = config.sig_mag*config.sig_mag;            R(7,7) = config.sig_mag*config.sig_mag;            R(8,8) = config.sig_mag*config.sig_mag;
+    }
 	
     // ... update P in get_nav
     nav.Pp0 = P(0,0);	  nav.Pp1 = P(1,1);	nav.Pp2 = P(2,2);
@@ -120,6 +130,25 @@ void EKF15::init(IMUdata imu, GPSdata gps) {
     nav.ve = gps.ve;
     nav.vd = gps.vd;
 	
+    if ( Sensors & EKF_MAG ) {
+        // ideal magnetic vector
+        long int jd = now_to_julian_days();
+        double field[6];
+        if ( mag_tracking ) {
+            mag_cache.set_date( jd );
+            mag_cache.magvar( nav.lat, nav.lon, nav.alt / 1000.0, field );
+        } else {
+            calc_magvar( nav.lat, nav.lon,
+                         nav.alt / 1000.0, jd, field );
+        }
+        mag_ned(0) = field[3];
+        mag_ned(1) = field[4];
+        mag_ned(2) = field[5];
+        mag_ned.normalize();
+        cout << field[0] << " " << field[1] << " " << field[2] << endl;
+        cout << "Ideal mag vector (ned): " << mag_ned << endl;
+    }
+	
     // ... and initialize states with IMU Data, theta from Ax, aircraft
     // at rest
     nav.the = asin(imu.ax/g); 
@@ -152,10 +181,74 @@ void EKF15::init(IMUdata imu, GPSdata gps) {
 	
     nav.time = imu.time;
     nav.err_type = data_valid;
+
+    cov_acc.clear();
+    cov_steps = 0;
+    history.clear();
+    if ( gps_lag > 0.0 ) {
+        C_N2B = quat2dcm(quat);
+        C_B2N = C_N2B.transpose();
+        save_state( history.push() );
+    }
 }
 
 // Main get_nav filter function
-void EKF15::time_update(IMUdata imu) {
+template <int Sensors>
+void EKF15T<Sensors>::time_update(IMUdata imu) {
+    propagate( imu );
+    if ( mag_tracking ) {
+        mag_cache.prefill( nav.lat, nav.lon, nav.alt / 1000.0,
+                           mag_prefill_nodes );
+    }
+    if ( gps_lag > 0.0 ) {
+        save_state( history.push() );
+        if ( history.size() == history.capacity() ) {
+            // the history now spans its full depth at the imu rate
+            float span = history.newest().imu.time - history[0].imu.time;
+            if ( gps_lag > span ) {
+                printf("ekf15: gps lag %.3f sec exceeds the %d sample "
+                       "state history (%.3f sec), clamping\n",
+                       gps_lag, history_len, span);
+                gps_lag = span;
+            }
+        }
+    }
+}
+
+template <int Sensors>
+void EKF15T<Sensors>::propagate(IMUdata imu) {
+    float imu_dt = mechanize( imu );
+    double mech_end = get_Time();
+
+    // Covariance Time Update: P = PHI*P*PHI' + Q
+    if ( cov_decimation <= 1 && !keep_transition ) {
+        covariance_update( P, C_B2N, f_b, om_ib, Rw, config, imu_dt );
+        cov_steps++;
+	
+        nav.Pp0 = P(0,0);     nav.Pp1 = P(1,1);     nav.Pp2 = P(2,2);
+        nav.Pv0 = P(3,3);     nav.Pv1 = P(4,4);     nav.Pv2 = P(5,5);
+        nav.Pa0 = P(6,6);     nav.Pa1 = P(7,7);     nav.Pa2 = P(8,8);
+        nav.Pabx = P(9,9);    nav.Paby = P(10,10);  nav.Pabz = P(11,11);
+        nav.Pgbx = P(12,12);  nav.Pgby = P(13,13);  nav.Pgbz = P(14,14);
+
+        timing.cov_sec += get_Time() - mech_end;
+        timing.cov_count++;
+    } else {
+        cov_acc.add( C_B2N, f_b, om_ib, Rw, imu_dt );
+        if ( cov_acc.count >= cov_decimation ) {
+            propagate_covariance();
+        }
+    }
+
+    // ==================  DONE TU  ===================
+}
+
+// strapdown mechanization of one imu sample (leaves f_b, om_ib and
+// C_B2N set for the covariance step), returns the sample interval
+template <int Sensors>
+float EKF15T<Sensors>::mechanize(IMUdata imu) {
+    double start = get_Time();
+
     // compute time-elapsed 'dt'
     // This compute the navigation state at the DAQ's Time Stamp
     float imu_dt = imu.time - imu_last.time;
@@ -234,75 +327,97 @@ void EKF15::time_update(IMUdata imu) {
     nav.lon += imu_dt*dx(1);
     nav.alt += imu_dt*dx(2);
 	
-    // JACOBIAN
-    F.setZero();
-    // ... pos2gs
-    F(0,3) = 1.0; 	F(1,4) = 1.0; 	F(2,5) = 1.0;
-    // ... gs2pos
-    F(5,2) = -2 * g / EarthRadius;
-	
-    // ... gs2att
-    temp33 = C_B2N * sk(f_b);
-	
-    F(3,6) = -2.0*temp33(0,0);  F(3,7) = -2.0*temp33(0,1);  F(3,8) = -2.0*temp33(0,2);
-    F(4,6) = -2.0*temp33(1,0);  F(4,7) = -2.0*temp33(1,1);  F(4,8) = -2.0*temp33(1,2);
-    F(5,6) = -2.0*temp33(2,0);  F(5,7) = -2.0*temp33(2,1);  F(5,8) = -2.0*temp33(2,2);
-	
-    // ... gs2acc
-    F(3,9) = -C_B2N(0,0);  F(3,10) = -C_B2N(0,1);  F(3,11) = -C_B2N(0,2);
-    F(4,9) = -C_B2N(1,0);  F(4,10) = -C_B2N(1,1);  F(4,11) = -C_B2N(1,2);
-    F(5,9) = -C_B2N(2,0);  F(5,10) = -C_B2N(2,1);  F(5,11) = -C_B2N(2,2);
-	
-    // ... att2att
-    temp33 = sk(om_ib);
-    F(6,6) = -temp33(0,0);  F(6,7) = -temp33(0,1);  F(6,8) = -temp33(0,2);
-    F(7,6) = -temp33(1,0);  F(7,7) = -temp33(1,1);  F(7,8) = -temp33(1,2);
-    F(8,6) = -temp33(2,0);  F(8,7) = -temp33(2,1);  F(8,8) = -temp33(2,2);
-	
-    // ... att2gyr
-    F(6,12) = -0.5;
-    F(7,13) = -0.5;
-    F(8,14) = -0.5;
-	
-    // ... Accel Markov Bias
-    F(9,9) = -1.0/config.tau_a;    F(10,10) = -1.0/config.tau_a;  F(11,11) = -1.0/config.tau_a;
-    F(12,12) = -1.0/config.tau_g;  F(13,13) = -1.0/config.tau_g;  F(14,14) = -1.0/config.tau_g;
-	
-    // State Transition Matrix: PHI = I15 + F*dt;
-    PHI = I15 + F * imu_dt;
-	
-    // Process Noise
-    G.setZero();
-    G(3,0) = -C_B2N(0,0);   G(3,1) = -C_B2N(0,1);   G(3,2) = -C_B2N(0,2);
-    G(4,0) = -C_B2N(1,0);   G(4,1) = -C_B2N(1,1);   G(4,2) = -C_B2N(1,2);
-    G(5,0) = -C_B2N(2,0);   G(5,1) = -C_B2N(2,1);   G(5,2) = -C_B2N(2,2);
-	
-    G(6,3) = -0.5;
-    G(7,4) = -0.5;
-    G(8,5) = -0.5;
-	
-    G(9,6) = 1.0; 	    G(10,7) = 1.0; 	    G(11,8) = 1.0;
-    G(12,9) = 1.0; 	    G(13,10) = 1.0; 	    G(14,11) = 1.0;
+    timing.mech_sec += get_Time() - start;
+    timing.mech_count++;
+
+    return imu_dt;
+}
+
+// propagate P over the accumulated interval
+template <int Sensors>
+void EKF15T<Sensors>::propagate_covariance() {
+    double start = get_Time();
+
+    covariance_update_accum( P, cov_acc, Rw, config );
+    if ( keep_transition ) {
+        cov_last = cov_acc;
+    }
+    cov_acc.clear();
+    cov_steps++;
 
-    // Discrete Process Noise
-    Qw = G * Rw * G.transpose() * imu_dt;		// Qw = dt*G*Rw*G'
-    Q = PHI * Qw;					// Q = (I+F*dt)*Qw
-    Q = (Q + Q.transpose()) * 0.5;			// Q = 0.5*(Q+Q')
-	
-    // Covariance Time Update
-    P = PHI * P * PHI.transpose() + Q;			// P = PHI*P*PHI' + Q
-    P = (P + P.transpose()) * 0.5;			// P = 0.5*(P+P')
-	
     nav.Pp0 = P(0,0);     nav.Pp1 = P(1,1);     nav.Pp2 = P(2,2);
     nav.Pv0 = P(3,3);     nav.Pv1 = P(4,4);     nav.Pv2 = P(5,5);
     nav.Pa0 = P(6,6);     nav.Pa1 = P(7,7);     nav.Pa2 = P(8,8);
     nav.Pabx = P(9,9);    nav.Paby = P(10,10);  nav.Pabz = P(11,11);
     nav.Pgbx = P(12,12);  nav.Pgby = P(13,13);  nav.Pgbz = P(14,14);
 
-    // ==================  DONE TU  ===================
+    timing.cov_sec += get_Time() - start;
+    timing.cov_count++;
 }
 
-void EKF15::measurement_update(GPSdata gps) {
+template <int Sensors>
+void EKF15T<Sensors>::measurement_update(IMUdata imu, GPSdata gps) {
+    if ( gps_lag <= 0.0 || history.empty() ) {
+        update( imu, gps );
+        return;
+    }
+
+    // Find the newest saved state at or before the time of validity
+    // of the fix (or the oldest one while the history is still
+    // filling), fuse the fix there, and re-propagate forward through
+    // the saved imu samples.  The corrected states replace the saved
+    // ones so the next fix starts from them.
+    float valid_time = gps.time - gps_lag;
+    int k = history.size() - 1;
+    while ( k > 0 && history[k].imu.time > valid_time ) {
+        k--;
+    }
+    restore_state( history[k] );
+    update( history[k].imu, gps );
+    save_state( history[k] );
+
+    // The state is re-propagated every sample, P once over the whole
+    // interval (the saved entries keep the corrected P and the
+    // interval accumulated up to them as a pending decimated step.)
+    for ( int i = k + 1; i < history.size(); i++ ) {
+        float imu_dt = mechanize( history[i].imu );
+        cov_acc.add( C_B2N, f_b, om_ib, Rw, imu_dt );
+        save_state( history[i] );
+    }
+    if ( cov_acc.count > 0 ) {
+        propagate_covariance();
+        save_state( history.newest() );
+    }
+}
+
+template <int Sensors>
+void EKF15T<Sensors>::save_state(HistoryEntry &entry) {
+    entry.imu = imu_last;
+    entry.nav = nav;
+    entry.quat = quat;
+    entry.P = P;
+    entry.C_N2B = C_N2B;
+    entry.cov_acc = cov_acc;
+}
+
+template <int Sensors>
+void EKF15T<Sensors>::restore_state(const HistoryEntry &entry) {
+    imu_last = entry.imu;
+    nav = entry.nav;
+    quat = entry.quat;
+    P = entry.P;
+    C_N2B = entry.C_N2B;
+    C_B2N = C_N2B.transpose();
+    cov_acc = entry.cov_acc;
+}
+
+template <int Sensors>
+void EKF15T<Sensors>::update(IMUdata imu, GPSdata gps) {
+    // bring P up to date with any pending decimated interval
+    if ( cov_acc.count > 0 ) {
+        propagate_covariance();
+    }
+
     // ==================  GPS Update  ===================
 
     // Position, converted to NED
@@ -324,17 +439,89 @@ void EKF15::measurement_update(GPSdata gps) {
     y(3) = gps.vn - nav.vn;
     y(4) = gps.ve - nav.ve;
     y(5) = gps.vd - nav.vd;
+
+    if ( Sensors & EKF_MAG ) {
+        // ideal magnetic vector at the current position (the previous
+        // one is kept while time_update() fills a new tile)
+        double field[6];
+        if ( mag_tracking
+             && mag_cache.lookup( nav.lat, nav.lon, nav.alt / 1000.0,
+                                  field ) ) {
+            mag_ned(0) = field[3];
+            mag_ned(1) = field[4];
+            mag_ned(2) = field[5];
+            mag_ned.normalize();
+        }
+
+        // measured mag vector (body frame)
+        Vector3f mag_sense;
+        mag_sense(0) = imu.hx;
+        mag_sense(1) = imu.hy;
+        mag_sense(2) = imu.hz;
+        mag_sense.normalize();
+
+        Vector3f mag_error; // magnetometer measurement error
+        bool mag_error_in_ned = false;
+        if ( mag_error_in_ned ) {
+            // rotate measured mag vector into ned frame (then normalized)
+            Vector3f mag_sense_ned = C_B2N * mag_sense;
+            mag_sense_ned.normalize();
+            mag_error = mag_sense_ned - mag_ned;
+        } else {
+            // rotate ideal mag vector into body frame (then normalized)
+            Vector3f mag_ideal = C_N2B * mag_ned;
+            mag_ideal.normalize();
+            mag_error = mag_sense - mag_ideal;
+
+            // Matrix<double,3,3> tmp1 = C_N2B * sk(mag_ned);
+            H.template block<3,3>(6,6) = sk(mag_sense) * 2.0;
+        }
+
+        y(6) = mag_error(0);
+        y(7) = mag_error(1);
+        y(8) = mag_error(2);
+    }
 		
-    // Kalman Gain
-    // K = P*H'*inv(H*P*H'+R)
-    K = P * H.transpose() * (H * P * H.transpose() + R).inverse();
+    if ( sequential_update ) {
+        // R is diagonal, so the measurement components can be
+        // processed one at a time as scalar updates (no matrix
+        // inverse and no dense 15x15 products.)
+        x.setZero();
+        nis = 0.0;
+
+        // Row i of the gps part of H simply selects state i
+        for ( int i = 0; i < 6; i++ ) {
+            float s = P(i,i) + R(i,i);	// s = h*P*h' + r
+            scalar_update( P.col(i), P.row(i), s, y(i) - x(i) );
+        }
+
+        // The mag rows of H only touch the attitude states
+        if ( Sensors & EKF_MAG ) {
+            for ( int i = 6; i < 9; i++ ) {
+                Vector3f h = H.template block<1,3>(i,6).transpose();
+                Vector15f Pc = P.template middleCols<3>(6) * h;
+                Matrix<float,1,15> Pr = h.transpose() * P.template middleRows<3>(6);
+                float s = h.dot(Pc.segment<3>(6)) + R(i,i);
+                scalar_update( Pc, Pr, s, y(i) - h.dot(x.segment<3>(6)) );
+            }
+        }
+    } else {
+        // Kalman Gain
+        // K = P*H'*inv(H*P*H'+R)
+        MatrixMf Sinv = (H * P * H.transpose() + R).inverse();
+        K = P * H.transpose() * Sinv;
+        nis = y.dot(Sinv * y);
 		
-    // Covariance Update
-    ImKH = I15 - K * H;	                // ImKH = I - K*H
+        // Covariance Update
+        ImKH = I15 - K * H;	                // ImKH = I - K*H
 		
-    KRKt = K * R * K.transpose();		// KRKt = K*R*K'
+        KRKt = K * R * K.transpose();		// KRKt = K*R*K'
 		
-    P = ImKH * P * ImKH.transpose() + KRKt;	// P = ImKH*P*ImKH' + KRKt
+        P = ImKH * P * ImKH.transpose() + KRKt;	// P = ImKH*P*ImKH' + KRKt
+
+        // State Update
+        x = K * y;
+    }
 		
     nav.Pp0 = P(0,0);     nav.Pp1 = P(1,1);     nav.Pp2 = P(2,2);
     nav.Pv0 = P(3,3);     nav.Pv1 = P(4,4);     nav.Pv2 = P(5,5);
@@ -343,39 +530,63 @@ void EKF15::measurement_update(GPSdata gps) {
     nav.Pgbx = P(12,12);  nav.Pgby = P(13,13);  nav.Pgbz = P(14,14);
 		
     // State Update
-    x = K * y;
-    double denom = fabs(1.0 - (ECC2 * sin(nav.lat) * sin(nav.lat)));
+    ekf15_correct( &nav, &quat, x );
+}
+
+void ekf15_correct(NAVdata *nav, Quaternionf *quat, const Vector15f &x) {
+    double denom = fabs(1.0 - (ECC2 * sin(nav->lat) * sin(nav->lat)));
     double denom_sqrt = sqrt(denom);
     double Re = EarthRadius / denom_sqrt;
     double Rn = EarthRadius * (1-ECC2) * denom_sqrt / denom;
-    nav.alt = nav.alt - x(2);
-    nav.lat = nav.lat + x(0)/(Re + nav.alt);
-    nav.lon = nav.lon + x(1)/(Rn + nav.alt)/cos(nav.lat);
+    nav->alt = nav->alt - x(2);
+    nav->lat = nav->lat + x(0)/(Re + nav->alt);
+    nav->lon = nav->lon + x(1)/(Rn + nav->alt)/cos(nav->lat);
 		
-    nav.vn = nav.vn + x(3);
-    nav.ve = nav.ve + x(4);
-    nav.vd = nav.vd + x(5);
+    nav->vn = nav->vn + x(3);
+    nav->ve = nav->ve + x(4);
+    nav->vd = nav->vd + x(5);
 		
     // Attitude correction
     Quaternionf dq = Quaternionf(1.0, x(6), x(7), x(8));
-    quat = (quat * dq).normalized();
+    *quat = (*quat * dq).normalized();
 		
-    Vector3f att_vec = quat2eul(quat);
-    nav.phi = att_vec(0);
-    nav.the = att_vec(1);
-    nav.psi = att_vec(2);
+    Vector3f att_vec = quat2eul(*quat);
+    nav->phi = att_vec(0);
+    nav->the = att_vec(1);
+    nav->psi = att_vec(2);
 	
-    nav.abx += x(9);
-    nav.aby += x(10);
-    nav.abz += x(11);
+    nav->abx += x(9);
+    nav->aby += x(10);
+    nav->abz += x(11);
+
+    nav->gbx += x(12);
+    nav->gby += x(13);
+    nav->gbz += x(14);
+}
+
 
-    nav.gbx += x(12);
-    nav.gby += x(13);
-    nav.gbz += x(14);
+// One scalar measurement update: Pc = P*h', Pr = h*P, s = h*P*h' + r
+// and innov = y - h*x (relative to the corrections accumulated so
+// far.)
+template <int Sensors>
+void EKF15T<Sensors>::scalar_update(const Vector15f &Pc,
+                                    const Matrix<float,1,15> &Pr,
+                                    float s, float innov)
+{
+    Vector15f k = Pc / s;		// k = P*h'/s
+    x += k * innov;
+
+    // the sequential innovations are whitened by construction, so
+    // their normalized squares sum to the batch y'*inv(S)*y
+    nis += innov * innov / s;
+
+    // Joseph form: P = (I-k*h)*P*(I-k*h)' + k*r*k'
+    P += (s * k) * k.transpose() - k * Pr - Pc * k.transpose();
 }
 
 
-NAVdata EKF15::get_nav() {
+template <int Sensors>
+NAVdata EKF15T<Sensors>::get_nav() {
     nav.qw = quat.w();
     nav.qx = quat.x();
     nav.qy = quat.y();
@@ -385,22 +596,6 @@ NAVdata EKF15::get_nav() {
 }
 
 
-#ifdef HAVE_BOOST_PYTHON
-
-// The following constructs a python interface for this class.
-
-#include <boost/python.hpp>
-using namespace boost::python;
-
-BOOST_PYTHON_MODULE(EKF15)
-{
-    class_<EKF15>("EKF15")
-        .def("set_config", &EKF15::set_config)
-        .def("init", &EKF15::init)
-        .def("time_update", &EKF15::time_update)
-        .def("measurement_update", &EKF15::measurement_update)
-        .def("get_nav", &EKF15::get_nav)
-    ;
-}
-
-#endif // HAVE_BOOST_PYTHON
+// build the filter variants
+template class EKF15T<EKF_GPS>;
+template class EKF15T<EKF_GPS | EKF_MAG>;
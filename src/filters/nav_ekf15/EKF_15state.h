@@ -17,65 +17,218 @@
 #pragma once
 
 #include <math.h>
+#include <type_traits>
 #include <eigen3/Eigen/Core>
 #include <eigen3/Eigen/Geometry>
 #include <eigen3/Eigen/LU>
 using namespace Eigen;
 
+#include "util/ring_buffer.h"
+
 #include "../nav_common/constants.h"
+#include "../nav_common/magcache.h"
 #include "../nav_common/structs.h"
+#include "covariance.h"
 
 // usefule constants
 const float g = 9.814;
 
 // define some types for notational convenience and consistency
-typedef Matrix<float,6,6> Matrix6f;
-typedef Matrix<float,12,12> Matrix12f;
-typedef Matrix<float,15,15> Matrix15f;
-typedef Matrix<float,6,15> Matrix6x15f;
-typedef Matrix<float,15,6> Matrix15x6f;
-typedef Matrix<float,15,12> Matrix15x12f;
-typedef Matrix<float,6,1> Vector6f;
 typedef Matrix<float,15,1> Vector15f;
 
-class EKF15 {
+// Measurement sets available to the filter.  These are combined as a
+// bit mask to form the Sensors template parameter.  GPS position and
+// velocity are always required (they also initialize the filter.)
+enum EKFMeasurements {
+    EKF_GPS = 1,                // gps position and velocity (6 rows)
+    EKF_MAG = 2                 // normalized magnetometer vector (3 rows)
+};
+
+// stand-in for the MagFieldCache in the variants without the
+// magnetometer update
+struct EKFNoMagCache {
+    void set_date(long) {}
+    double magvar(double, double, double, double *) { return 0.0; }
+    bool lookup(double, double, double, double *) { return false; }
+    void prefill(double, double, double, int) {}
+};
+
+// accumulated execution time of the two halves of the time update
+struct EKFTiming {
+    double mech_sec;            // strapdown mechanization (every imu sample)
+    long mech_count;
+    double cov_sec;             // covariance propagation steps
+    long cov_count;
+};
+
+template <int Sensors>
+class EKF15T {
 
 public:
 
-    EKF15() {
+    // number of measurement rows for this sensor set
+    static const int M = 6 + ((Sensors & EKF_MAG) ? 3 : 0);
+
+    // depth of the state history used for delayed gps fusion (0.63
+    // sec at 100hz), this bounds the usable gps lag (a longer lag is
+    // clamped to the history span with a warning once it fills)
+    static const int history_len = 64;
+
+    // field model evaluations per imu sample while mag tracking fills
+    // a new cache tile (125 per tile, so 0.25 sec at 100hz)
+    static const int mag_prefill_nodes = 5;
+
+    typedef Matrix<float,M,M> MatrixMf;
+    typedef Matrix<float,M,15> MatrixMx15f;
+    typedef Matrix<float,15,M> Matrix15xMf;
+    typedef Matrix<float,M,1> VectorMf;
+
+    EKF15T() {
 	default_config();
+	sequential_update = false;
+	nis = 0.0;
+	gps_lag = 0.0;
+	cov_decimation = 1;
+	keep_transition = false;
+	cov_steps = 0;
+	mag_tracking = false;
+	reset_timing();
     }
-    ~EKF15() {}
+    ~EKF15T() {}
 
     // set/get error characteristics of navigation sensors
     void set_config(NAVconfig config);
     NAVconfig get_config();
     void default_config();
 
+    // select the measurement update: false = batch MxM inverse
+    // (default), true = sequential scalar updates (Joseph form)
+    void set_sequential_update(bool sequential) {
+        sequential_update = sequential;
+    }
+
+    // gps fixes are valid this many seconds before their timestamp
+    // (receiver latency.)  When non-zero the filter keeps a history of
+    // past states, fuses each fix at its time of validity and then
+    // re-propagates to the current imu sample.  0 (default) fuses the
+    // fix as if it were current.
+    void set_gps_lag(float sec) {
+        gps_lag = sec;
+    }
+    float get_gps_lag() { return gps_lag; }
+
+    // run the covariance propagation once per n imu samples (the
+    // mechanization still runs every sample.)  The F and Q inputs are
+    // integrated over the skipped samples, and any pending interval is
+    // propagated before a measurement update.  1 (default) propagates
+    // every sample.
+    void set_cov_decimation(int n) {
+        cov_decimation = n;
+    }
+
+    // EKF15_mag: follow the field model as the aircraft moves (the
+    // ideal mag vector is looked up through a MagFieldCache at every
+    // measurement update) instead of fixing it at init.  The tile
+    // under the aircraft is filled at init and then by time_update(),
+    // mag_prefill_nodes model evaluations per imu sample, so the
+    // measurement update never evaluates the model.
+    void set_mag_tracking(bool track) {
+        mag_tracking = track;
+    }
+
+    EKFTiming get_timing() { return timing; }
+    void reset_timing() {
+        timing.mech_sec = timing.cov_sec = 0.0;
+        timing.mech_count = timing.cov_count = 0;
+    }
+
     // main interface
     void init(IMUdata imu, GPSdata gps);
     void time_update(IMUdata imu);
-    void measurement_update(GPSdata gps);
+    void measurement_update(IMUdata imu, GPSdata gps);
     
     NAVdata get_nav();
+
+    // innovation (measurement - prediction) of the most recent
+    // measurement update and its normalized innovation squared,
+    // y'*inv(H*P*H'+R)*y (chi-square with M dof when consistent)
+    VectorMf get_innovation() { return y; }
+    float get_nis() { return nis; }
+
+    // Filter internals for post processing (the smoother.)  When
+    // keep_transition is set, every covariance propagation goes
+    // through the accumulated form (also at decimation 1) and the
+    // interval of the most recent one is kept for get_transition().
+    // get_cov_steps() counts the covariance propagations since init and
+    // get_correction() is the error state applied by the most recent
+    // measurement update.
+    void set_keep_transition(bool keep) {
+        keep_transition = keep;
+    }
+    const CovarianceAccum &get_transition() { return cov_last; }
+    long get_cov_steps() { return cov_steps; }
+    const Matrix15f &get_P() { return P; }
+    const Matrix12f &get_Rw() { return Rw; }
+    const Quaternionf &get_quat() { return quat; }
+    const Vector15f &get_correction() { return x; }
     
 private:
 
-    Matrix15f F, PHI, P, Qw, Q, ImKH, KRKt, I15 /* identity */;
-    Matrix15x12f G;
-    Matrix15x6f K;
+    Matrix15f P, ImKH, KRKt, I15 /* identity */;
+    Matrix15xMf K;
     Vector15f x;
     Matrix12f Rw;
-    Matrix6x15f H;
-    Matrix6f R;
-    Vector6f y;
-    Matrix3f C_N2B, C_B2N, I3 /* identity */, temp33;
+    MatrixMx15f H;
+    MatrixMf R;
+    VectorMf y;
+    Matrix3f C_N2B, C_B2N, I3 /* identity */;
     Vector3d pos_ins_ecef, pos_gps, pos_gps_ecef;
     Vector3f grav, f_b, om_ib, /*nr,*/ pos_ins_ned, pos_gps_ned, dx, mag_ned;
 
     Quaternionf quat;
 
+    bool sequential_update;
+    float nis;
+    float gps_lag;
+    int cov_decimation;
+    CovarianceAccum cov_acc;
+    EKFTiming timing;
+    bool keep_transition;
+    CovarianceAccum cov_last;
+    long cov_steps;
+    bool mag_tracking;
+    typename std::conditional<(Sensors & EKF_MAG) != 0, MagFieldCache,
+                              EKFNoMagCache>::type mag_cache;
+
     IMUdata imu_last;
     NAVconfig config;
     NAVdata nav;
+
+    // filter state after the time update with imu
+    struct HistoryEntry {
+        IMUdata imu;
+        NAVdata nav;
+        Quaternionf quat;
+        Matrix15f P;
+        Matrix3f C_N2B;
+        CovarianceAccum cov_acc;
+    };
+    AuraRingBuffer<HistoryEntry, history_len> history;
+
+    void propagate(IMUdata imu);
+    float mechanize(IMUdata imu);
+    void propagate_covariance();
+    void update(IMUdata imu, GPSdata gps);
+    void save_state(HistoryEntry &entry);
+    void restore_state(const HistoryEntry &entry);
+    void scalar_update(const Vector15f &Pc, const Matrix<float,1,15> &Pr,
+                       float s, float innov);
 };
+
+// apply an error state correction x (as estimated by the measurement
+// update) to the nominal navigation state and attitude quaternion
+void ekf15_correct(NAVdata *nav, Quaternionf *quat, const Vector15f &x);
+
+// the filter variants
+typedef EKF15T<EKF_GPS> EKF15;
+typedef EKF15T<EKF_GPS | EKF_MAG> EKF15_mag;
@@ -0,0 +1,515 @@
+// EKF_15state_batch.cpp -- a bank of 15 state EKFs (GPS only) advanced
+//                          in lockstep, structure of arrays
+//
+// Each function below is the EKF15 code path written once for a pack
+// of EKF15_BATCH_LANES filters using the gcc/clang vector extensions,
+// so every arithmetic operation compiles to one SIMD instruction
+// across the lanes.
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "EKF_15state_batch.h"
+
+#if EKF15_BATCH_LANES == 8 && defined(__AVX__)
+#include <immintrin.h>
+#elif EKF15_BATCH_LANES == 4 && defined(__SSE2__)
+#include <emmintrin.h>
+#elif EKF15_BATCH_LANES == 4 && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include "../nav_common/constants.h"
+#include "../nav_common/nav_functions.h"
+#include "EKF_15state.h"
+
+const int L = EKF15_BATCH_LANES;
+
+typedef float vfloat __attribute__((vector_size(L * sizeof(float))));
+
+// initial covariance (as EKF_15state.cpp)
+const float P_P_INIT = 10.0;
+const float P_V_INIT = 1.0;
+const float P_A_INIT = 0.34906;   // 20 deg
+const float P_HDG_INIT = 3.14159; // 180 deg
+const float P_AB_INIT = 0.9810;   // 0.5*g
+const float P_GB_INIT = 0.01745;  // 5 deg/s
+
+struct EKF15BatchPack {
+    vfloat P[15][15];
+    vfloat vn, ve, vd, alt;
+    vfloat qw, qx, qy, qz;
+    vfloat ab[3], gb[3];
+    vfloat time;                // time of the last imu sample
+    vfloat Rw[12];              // diagonal of Rw
+    vfloat R[6];                // diagonal of R
+    vfloat tau_a, tau_g;
+    vfloat y[6];                // innovation of the last update
+    vfloat nis;
+    double lat[L], lon[L];
+};
+
+static inline vfloat vsqrt( vfloat v ) {
+#if EKF15_BATCH_LANES == 8 && defined(__AVX__)
+    return (vfloat)_mm256_sqrt_ps( (__m256)v );
+#elif EKF15_BATCH_LANES == 4 && defined(__SSE2__)
+    return (vfloat)_mm_sqrt_ps( (__m128)v );
+#elif EKF15_BATCH_LANES == 4 && defined(__aarch64__)
+    return (vfloat)vsqrtq_f32( (float32x4_t)v );
+#else
+    vfloat r;
+    for ( int l = 0; l < L; l++ ) {
+        r[l] = sqrtf( v[l] );
+    }
+    return r;
+#endif
+}
+
+static inline vfloat vsplat( float f ) {
+    vfloat v = {};
+    return v + f;
+}
+
+// q = (q * (1, dx, dy, dz)).normalized()
+static inline void quat_rotate( EKF15BatchPack &k, vfloat dx, vfloat dy,
+                                vfloat dz )
+{
+    vfloat w = k.qw - k.qx * dx - k.qy * dy - k.qz * dz;
+    vfloat x = k.qw * dx + k.qx + k.qy * dz - k.qz * dy;
+    vfloat y = k.qw * dy + k.qy + k.qz * dx - k.qx * dz;
+    vfloat z = k.qw * dz + k.qz + k.qx * dy - k.qy * dx;
+    vfloat n = vsqrt( w * w + x * x + y * y + z * z );
+    k.qw = w / n;
+    k.qx = x / n;
+    k.qy = y / n;
+    k.qz = z / n;
+}
+
+// nonzero blocks of PHI = I15 + F*dt (see covariance.cpp)
+struct BatchPhi {
+    vfloat dt;
+    vfloat va[3][3];            // vel/att
+    vfloat vab[3][3];           // vel/accel-bias
+    vfloat aa[3][3];            // att/att
+    vfloat vp, agb, ab, gb;
+};
+
+// M = PHI * M for columns first..14, one column at a time
+static void phi_left( vfloat M[15][15], const BatchPhi &phi, int first ) {
+    for ( int c = first; c < 15; c++ ) {
+        vfloat pos_d = M[2][c];
+        for ( int i = 0; i < 3; i++ ) {
+            M[i][c] += phi.dt * M[3+i][c];
+        }
+        for ( int i = 0; i < 3; i++ ) {
+            M[3+i][c] += phi.va[i][0] * M[6][c] + phi.va[i][1] * M[7][c]
+                + phi.va[i][2] * M[8][c] + phi.vab[i][0] * M[9][c]
+                + phi.vab[i][1] * M[10][c] + phi.vab[i][2] * M[11][c];
+        }
+        M[5][c] += phi.vp * pos_d;
+        vfloat a0 = M[6][c], a1 = M[7][c], a2 = M[8][c];
+        for ( int i = 0; i < 3; i++ ) {
+            M[6+i][c] = phi.aa[i][0] * a0 + phi.aa[i][1] * a1
+                + phi.aa[i][2] * a2 + phi.agb * M[12+i][c];
+        }
+        for ( int i = 9; i < 12; i++ ) {
+            M[i][c] *= phi.ab;
+        }
+        for ( int i = 12; i < 15; i++ ) {
+            M[i][c] *= phi.gb;
+        }
+    }
+}
+
+// M = 0.5*(M+M')
+static void symmetrize( vfloat M[15][15] ) {
+    for ( int i = 0; i < 15; i++ ) {
+        for ( int j = i + 1; j < 15; j++ ) {
+            vfloat m = (M[i][j] + M[j][i]) * 0.5f;
+            M[i][j] = M[j][i] = m;
+        }
+    }
+}
+
+static void transpose( vfloat M[15][15] ) {
+    for ( int i = 0; i < 15; i++ ) {
+        for ( int j = i + 1; j < 15; j++ ) {
+            vfloat m = M[i][j];
+            M[i][j] = M[j][i];
+            M[j][i] = m;
+        }
+    }
+}
+
+// P = PHI*P*PHI' + Q for one imu step
+static void covariance_update( EKF15BatchPack &k, const vfloat C[3][3],
+                               const vfloat *f, const vfloat *w, vfloat dt )
+{
+    BatchPhi phi;
+    phi.dt = dt;
+    for ( int i = 0; i < 3; i++ ) {
+        // C_B2N*sk(f_b)
+        vfloat cs0 = C[i][1] * f[2] - C[i][2] * f[1];
+        vfloat cs1 = C[i][2] * f[0] - C[i][0] * f[2];
+        vfloat cs2 = C[i][0] * f[1] - C[i][1] * f[0];
+        phi.va[i][0] = (cs0 * dt) * -2.0f;
+        phi.va[i][1] = (cs1 * dt) * -2.0f;
+        phi.va[i][2] = (cs2 * dt) * -2.0f;
+        for ( int j = 0; j < 3; j++ ) {
+            phi.vab[i][j] = -(C[i][j] * dt);
+        }
+    }
+    // I3 - sk(om_ib)*dt
+    vfloat one = vsplat( 1.0 );
+    phi.aa[0][0] = one;  phi.aa[1][1] = one;  phi.aa[2][2] = one;
+    phi.aa[0][1] = w[2] * dt;   phi.aa[1][0] = -(w[2] * dt);
+    phi.aa[0][2] = -(w[1] * dt);  phi.aa[2][0] = w[1] * dt;
+    phi.aa[1][2] = w[0] * dt;   phi.aa[2][1] = -(w[0] * dt);
+    phi.vp = (float)(-2 * g / EarthRadius) * dt;
+    phi.agb = -0.5f * dt;
+    phi.ab = 1.0f - dt / k.tau_a;
+    phi.gb = 1.0f - dt / k.tau_g;
+
+    // Q = (I+F*dt)*Qw, Qw is block diagonal (the first three columns
+    // stay zero)
+    vfloat Q[15][15];
+    memset( Q, 0, sizeof(Q) );
+    for ( int i = 0; i < 3; i++ ) {
+        for ( int j = 0; j < 3; j++ ) {
+            vfloat sum = C[i][0] * k.Rw[0] * C[j][0];
+            sum += C[i][1] * k.Rw[1] * C[j][1];
+            sum += C[i][2] * k.Rw[2] * C[j][2];
+            Q[3+i][3+j] = sum * dt;
+        }
+    }
+    for ( int i = 0; i < 3; i++ ) {
+        Q[6+i][6+i] = k.Rw[3+i] * (0.25f * dt);
+    }
+    for ( int i = 0; i < 6; i++ ) {
+        Q[9+i][9+i] = k.Rw[6+i] * dt;
+    }
+    phi_left( Q, phi, 3 );
+    symmetrize( Q );
+
+    // P = PHI*(PHI*P)'
+    phi_left( k.P, phi, 0 );
+    transpose( k.P );
+    phi_left( k.P, phi, 0 );
+    for ( int i = 0; i < 15; i++ ) {
+        for ( int j = 0; j < 15; j++ ) {
+            k.P[i][j] += Q[i][j];
+        }
+    }
+    symmetrize( k.P );
+}
+
+// imu samples for the lanes of a pack: time, p, q, r, ax, ay, az
+static void gather_imu( const IMUdata *imu, int stride, int first,
+                        int count, vfloat *v )
+{
+    for ( int l = 0; l < L; l++ ) {
+        int i = first + l < count ? first + l : count - 1;
+        const IMUdata &s = imu[i * stride];
+        v[0][l] = s.time;
+        v[1][l] = s.p;  v[2][l] = s.q;  v[3][l] = s.r;
+        v[4][l] = s.ax; v[5][l] = s.ay; v[6][l] = s.az;
+    }
+}
+
+static void propagate( EKF15BatchPack &k, const vfloat *imu ) {
+    vfloat dt = imu[0] - k.time;
+    k.time = imu[0];
+
+    vfloat f[3], w[3];
+    for ( int i = 0; i < 3; i++ ) {
+        f[i] = imu[4+i] - k.ab[i];
+        w[i] = imu[1+i] - k.gb[i];
+    }
+    vfloat vn = k.vn, ve = k.ve, vd = k.vd;
+
+    // Attitude Update
+    quat_rotate( k, 0.5f * w[0] * dt, 0.5f * w[1] * dt, 0.5f * w[2] * dt );
+    // avoid quaternion sign flips
+    vfloat sign = k.qw < 0.0f ? vsplat( -1.0 ) : vsplat( 1.0 );
+    k.qw *= sign;  k.qx *= sign;  k.qy *= sign;  k.qz *= sign;
+
+    // C_B2N (the transpose of quat2dcm())
+    vfloat q0 = k.qw, q1 = k.qx, q2 = k.qy, q3 = k.qz;
+    vfloat C[3][3];
+    C[0][0] = 2.0f * (q0 * q0 + q1 * q1) - 1.0f;
+    C[1][1] = 2.0f * (q0 * q0 + q2 * q2) - 1.0f;
+    C[2][2] = 2.0f * (q0 * q0 + q3 * q3) - 1.0f;
+    C[1][0] = 2.0f * (q1 * q2 + q0 * q3);
+    C[2][0] = 2.0f * (q1 * q3 - q0 * q2);
+    C[0][1] = 2.0f * (q1 * q2 - q0 * q3);
+    C[2][1] = 2.0f * (q2 * q3 + q0 * q1);
+    C[0][2] = 2.0f * (q1 * q3 + q0 * q2);
+    C[1][2] = 2.0f * (q2 * q3 - q0 * q1);
+
+    // Velocity Update
+    k.vn += dt * (C[0][0] * f[0] + C[0][1] * f[1] + C[0][2] * f[2]);
+    k.ve += dt * (C[1][0] * f[0] + C[1][1] * f[1] + C[1][2] * f[2]);
+    k.vd += dt * (C[2][0] * f[0] + C[2][1] * f[1] + C[2][2] * f[2] + g);
+
+    // Position Update (llarate() lane by lane)
+    for ( int l = 0; l < L; l++ ) {
+        double lat = k.lat[l];
+        double h = k.alt[l];
+        double denom = fabs(1.0 - (ECC2 * sin(lat) * sin(lat)));
+        double sqrt_denom = sqrt(denom);
+        double Rew = EarthRadius / sqrt_denom;
+        double Rns = EarthRadius*(1-ECC2) / (denom*sqrt_denom);
+        float lat_dot = vn[l] / (Rns + h);
+        float lon_dot = ve[l] / ((Rew + h) * cos(lat));
+        k.lat[l] += dt[l] * lat_dot;
+        k.lon[l] += dt[l] * lon_dot;
+    }
+    k.alt += dt * -vd;
+
+    // Covariance Time Update
+    covariance_update( k, C, f, w, dt );
+}
+
+// the gps position error (ned) of lane l
+static void gps_position_error( EKF15BatchPack &k, int l,
+                                const GPSdata &gps )
+{
+    Vector3d pos_ref(k.lat[l], k.lon[l], k.alt[l]);
+    Vector3d pos_ins_ecef = lla2ecef(pos_ref);
+    Vector3d pos_gps(gps.lat*D2R, gps.lon*D2R, gps.alt);
+    Vector3d pos_gps_ecef = lla2ecef(pos_gps);
+    Vector3f pos_error_ned = ecef2ned(pos_gps_ecef - pos_ins_ecef, pos_ref);
+    k.y[0][l] = pos_error_ned(0);
+    k.y[1][l] = pos_error_ned(1);
+    k.y[2][l] = pos_error_ned(2);
+    k.y[3][l] = gps.vn - k.vn[l];
+    k.y[4][l] = gps.ve - k.ve[l];
+    k.y[5][l] = gps.vd - k.vd[l];
+}
+
+// sequential scalar updates (Joseph form) and the state correction,
+// as EKF15T::update() with set_sequential_update(true)
+static void update( EKF15BatchPack &k ) {
+    vfloat x[15];
+    for ( int j = 0; j < 15; j++ ) {
+        x[j] = vsplat( 0.0 );
+    }
+    k.nis = vsplat( 0.0 );
+
+    // Row i of H simply selects state i
+    for ( int i = 0; i < 6; i++ ) {
+        vfloat s = k.P[i][i] + k.R[i];
+        vfloat Pc[15], Pr[15], kg[15], skg[15];
+        for ( int j = 0; j < 15; j++ ) {
+            Pc[j] = k.P[j][i];
+            Pr[j] = k.P[i][j];
+            kg[j] = Pc[j] / s;
+            skg[j] = s * kg[j];
+        }
+        vfloat innov = k.y[i] - x[i];
+        for ( int j = 0; j < 15; j++ ) {
+            x[j] += kg[j] * innov;
+        }
+        k.nis += innov * innov / s;
+        for ( int a = 0; a < 15; a++ ) {
+            for ( int b = 0; b < 15; b++ ) {
+                k.P[a][b] += skg[a] * kg[b] - kg[a] * Pr[b] - Pc[a] * kg[b];
+            }
+        }
+    }
+
+    // State Update (ekf15_correct())
+    vfloat alt = k.alt;
+    k.alt = alt - x[2];
+    for ( int l = 0; l < L; l++ ) {
+        double denom = fabs(1.0 - (ECC2 * sin(k.lat[l]) * sin(k.lat[l])));
+        double denom_sqrt = sqrt(denom);
+        double Re = EarthRadius / denom_sqrt;
+        double Rn = EarthRadius * (1-ECC2) * denom_sqrt / denom;
+        k.lat[l] = k.lat[l] + x[0][l]/(Re + k.alt[l]);
+        k.lon[l] = k.lon[l] + x[1][l]/(Rn + k.alt[l])/cos(k.lat[l]);
+    }
+    k.vn += x[3];
+    k.ve += x[4];
+    k.vd += x[5];
+    quat_rotate( k, x[6], x[7], x[8] );
+    for ( int i = 0; i < 3; i++ ) {
+        k.ab[i] += x[9+i];
+        k.gb[i] += x[12+i];
+    }
+}
+
+EKF15Batch::EKF15Batch(int count):
+    count(count),
+    npacks((count + L - 1) / L),
+    packs(NULL)
+{
+    void *p = NULL;
+    if ( npacks > 0
+         && posix_memalign(&p, 64, npacks * sizeof(EKF15BatchPack)) == 0 ) {
+        memset( p, 0, npacks * sizeof(EKF15BatchPack) );
+        packs = (EKF15BatchPack *)p;
+    } else {
+        npacks = 0;
+        this->count = 0;
+    }
+    EKF15 ekf;
+    configs.resize( this->count, ekf.get_config() );
+}
+
+EKF15Batch::~EKF15Batch() {
+    free( packs );
+}
+
+void EKF15Batch::set_config(int i, NAVconfig config) {
+    configs[i] = config;
+}
+
+NAVconfig EKF15Batch::get_config(int i) {
+    return configs[i];
+}
+
+void EKF15Batch::init(const IMUdata *imu, const GPSdata *gps) {
+    for ( int p = 0; p < npacks; p++ ) {
+        EKF15BatchPack &k = packs[p];
+        memset( &k, 0, sizeof(k) );
+        for ( int l = 0; l < L; l++ ) {
+            // unused lanes of the last pack duplicate the last filter
+            int i = p * L + l < count ? p * L + l : count - 1;
+            const NAVconfig &c = configs[i];
+            const IMUdata &s = imu[i];
+
+            k.Rw[0][l] = c.sig_w_ax*c.sig_w_ax;
+            k.Rw[1][l] = c.sig_w_ay*c.sig_w_ay;
+            k.Rw[2][l] = c.sig_w_az*c.sig_w_az;
+            k.Rw[3][l] = c.sig_w_gx*c.sig_w_gx;
+            k.Rw[4][l] = c.sig_w_gy*c.sig_w_gy;
+            k.Rw[5][l] = c.sig_w_gz*c.sig_w_gz;
+            for ( int j = 6; j < 9; j++ ) {
+                k.Rw[j][l] = 2*c.sig_a_d*c.sig_a_d/c.tau_a;
+                k.Rw[j+3][l] = 2*c.sig_g_d*c.sig_g_d/c.tau_g;
+            }
+            k.tau_a[l] = c.tau_a;
+            k.tau_g[l] = c.tau_g;
+            k.R[0][l] = c.sig_gps_p_ne*c.sig_gps_p_ne;
+            k.R[1][l] = c.sig_gps_p_ne*c.sig_gps_p_ne;
+            k.R[2][l] = c.sig_gps_p_d*c.sig_gps_p_d;
+            k.R[3][l] = c.sig_gps_v_ne*c.sig_gps_v_ne;
+            k.R[4][l] = c.sig_gps_v_ne*c.sig_gps_v_ne;
+            k.R[5][l] = c.sig_gps_v_d*c.sig_gps_v_d;
+
+            // initialize states with gps and (at rest) imu data
+            k.lat[l] = gps[i].lat*D2R;
+            k.lon[l] = gps[i].lon*D2R;
+            k.alt[l] = gps[i].alt;
+            k.vn[l] = gps[i].vn;
+            k.ve[l] = gps[i].ve;
+            k.vd[l] = gps[i].vd;
+
+            float the = asin(s.ax/g);
+            float phi = asin(s.ay/(g*cos(the)));
+            float psi = atan2(s.hz*sin(phi)-s.hy*cos(phi),s.hx*cos(the)+s.hy*sin(the)*sin(phi)+s.hz*sin(the)*cos(phi));
+            Quaternionf quat = eul2quat(phi, the, psi);
+            k.qw[l] = quat.w();
+            k.qx[l] = quat.x();
+            k.qy[l] = quat.y();
+            k.qz[l] = quat.z();
+
+            k.gb[0][l] = s.p;
+            k.gb[1][l] = s.q;
+            k.gb[2][l] = s.r;
+            k.time[l] = s.time;
+        }
+        const float p_init[15] = {
+            P_P_INIT, P_P_INIT, P_P_INIT, P_V_INIT, P_V_INIT, P_V_INIT,
+            P_A_INIT, P_A_INIT, P_HDG_INIT, P_AB_INIT, P_AB_INIT, P_AB_INIT,
+            P_GB_INIT, P_GB_INIT, P_GB_INIT
+        };
+        for ( int j = 0; j < 15; j++ ) {
+            k.P[j][j] = vsplat( p_init[j] * p_init[j] );
+        }
+    }
+}
+
+void EKF15Batch::time_update(const IMUdata *imu) {
+    vfloat v[7];
+    for ( int p = 0; p < npacks; p++ ) {
+        gather_imu( imu, 1, p * L, count, v );
+        propagate( packs[p], v );
+    }
+}
+
+void EKF15Batch::measurement_update(const GPSdata *gps) {
+    for ( int p = 0; p < npacks; p++ ) {
+        for ( int l = 0; l < L; l++ ) {
+            int i = p * L + l < count ? p * L + l : count - 1;
+            gps_position_error( packs[p], l, gps[i] );
+        }
+        update( packs[p] );
+    }
+}
+
+void EKF15Batch::init(IMUdata imu, GPSdata gps) {
+    vector<IMUdata> imus( count, imu );
+    vector<GPSdata> fixes( count, gps );
+    init( &imus[0], &fixes[0] );
+}
+
+void EKF15Batch::time_update(IMUdata imu) {
+    vfloat v[7];
+    gather_imu( &imu, 0, 0, 1, v );
+    for ( int p = 0; p < npacks; p++ ) {
+        propagate( packs[p], v );
+    }
+}
+
+void EKF15Batch::measurement_update(GPSdata gps) {
+    for ( int p = 0; p < npacks; p++ ) {
+        for ( int l = 0; l < L; l++ ) {
+            gps_position_error( packs[p], l, gps );
+        }
+        update( packs[p] );
+    }
+}
+
+NAVdata EKF15Batch::get_nav(int i) {
+    const EKF15BatchPack &k = packs[i / L];
+    int l = i % L;
+    NAVdata nav;
+    nav.time = k.time[l];
+    nav.lat = k.lat[l];
+    nav.lon = k.lon[l];
+    nav.alt = k.alt[l];
+    nav.vn = k.vn[l];
+    nav.ve = k.ve[l];
+    nav.vd = k.vd[l];
+    Quaternionf quat(k.qw[l], k.qx[l], k.qy[l], k.qz[l]);
+    Vector3f att_vec = quat2eul(quat);
+    nav.phi = att_vec(0);
+    nav.the = att_vec(1);
+    nav.psi = att_vec(2);
+    nav.qw = quat.w();
+    nav.qx = quat.x();
+    nav.qy = quat.y();
+    nav.qz = quat.z();
+    nav.abx = k.ab[0][l];  nav.aby = k.ab[1][l];  nav.abz = k.ab[2][l];
+    nav.gbx = k.gb[0][l];  nav.gby = k.gb[1][l];  nav.gbz = k.gb[2][l];
+    nav.Pp0 = k.P[0][0][l];    nav.Pp1 = k.P[1][1][l];    nav.Pp2 = k.P[2][2][l];
+    nav.Pv0 = k.P[3][3][l];    nav.Pv1 = k.P[4][4][l];    nav.Pv2 = k.P[5][5][l];
+    nav.Pa0 = k.P[6][6][l];    nav.Pa1 = k.P[7][7][l];    nav.Pa2 = k.P[8][8][l];
+    nav.Pabx = k.P[9][9][l];   nav.Paby = k.P[10][10][l]; nav.Pabz = k.P[11][11][l];
+    nav.Pgbx = k.P[12][12][l]; nav.Pgby = k.P[13][13][l]; nav.Pgbz = k.P[14][14][l];
+    nav.err_type = data_valid;
+    return nav;
+}
+
+void EKF15Batch::get_innovation(int i, float *y) {
+    for ( int j = 0; j < 6; j++ ) {
+        y[j] = packs[i / L].y[j][i % L];
+    }
+}
+
+float EKF15Batch::get_nis(int i) {
+    return packs[i / L].nis[i % L];
+}
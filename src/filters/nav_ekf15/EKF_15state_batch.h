@@ -0,0 +1,83 @@
+// EKF_15state_batch.h -- a bank of 15 state EKFs (GPS only) advanced in
+//                        lockstep, for Monte Carlo runs and tuning
+//                        sweeps
+//
+// The filters are stored structure of arrays: every scalar of the
+// filter state (each element of P included) is a short vector holding
+// that scalar for EKF15_BATCH_LANES filters, so each operation of the
+// time and measurement update runs across the lanes at once (8 floats
+// with AVX, 4 with SSE2 or NEON, plain scalar code otherwise.)  The
+// quantities that need double precision trigonometry (lat/lon
+// integration and the gps position error) are still computed lane by
+// lane.
+//
+// The algorithm is the one of EKF15 with set_sequential_update(true)
+// and the default (sparse, undecimated) covariance propagation, so
+// each lane follows the scalar filter up to float rounding.  The
+// magnetometer variant, gps lag compensation and covariance decimation
+// are not supported.
+
+#pragma once
+
+#include <vector>
+using std::vector;
+
+#include "../nav_common/structs.h"
+
+#ifndef EKF15_BATCH_LANES
+#if defined(__AVX__)
+#define EKF15_BATCH_LANES 8
+#elif defined(__SSE2__) || defined(__ARM_NEON)
+#define EKF15_BATCH_LANES 4
+#else
+#define EKF15_BATCH_LANES 1
+#endif
+#endif
+
+// the state of EKF15_BATCH_LANES filters (defined in the .cpp)
+struct EKF15BatchPack;
+
+class EKF15Batch {
+
+public:
+
+    static const int lanes = EKF15_BATCH_LANES;
+
+    EKF15Batch(int count);
+    ~EKF15Batch();
+
+    // number of filters
+    int size() { return count; }
+
+    // set/get error characteristics of filter i (takes effect at init)
+    void set_config(int i, NAVconfig config);
+    NAVconfig get_config(int i);
+
+    // Main interface.  The array forms take one sample per filter
+    // (size() entries), the others feed the same sample to every
+    // filter (a parameter sweep over one log.)
+    void init(const IMUdata *imu, const GPSdata *gps);
+    void time_update(const IMUdata *imu);
+    void measurement_update(const GPSdata *gps);
+    void init(IMUdata imu, GPSdata gps);
+    void time_update(IMUdata imu);
+    void measurement_update(GPSdata gps);
+
+    NAVdata get_nav(int i);
+
+    // innovation (6 entries) and normalized innovation squared of the
+    // most recent measurement update of filter i
+    void get_innovation(int i, float *y);
+    float get_nis(int i);
+
+private:
+
+    int count;
+    int npacks;
+    EKF15BatchPack *packs;
+    vector<NAVconfig> configs;
+
+    // not copyable (owns packs)
+    EKF15Batch( const EKF15Batch & );
+    EKF15Batch & operator= ( const EKF15Batch & );
+};
@@ -0,0 +1,196 @@
+// batch_test.cpp -- run a bank of filters over independent noisy
+//                   copies of a simulated flight, once as separate
+//                   EKF15 objects and once as one EKF15Batch, check that
+//                   every lane agrees with its scalar filter and compare
+//                   the time per filter step.
+//
+// g++ -O3 -I../.. batch_test.cpp EKF_15state_batch.cpp covariance.cpp
+//     EKF_15state.cpp ../nav_common/nav_functions.cpp
+//     ../nav_common/coremag.c ../nav_common/magcache.cpp
+//     ../../util/timing.cpp -o batch_test
+//
+// (add -mavx for 8 lanes, the default x86-64 build uses 4 sse lanes)
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <vector>
+using std::vector;
+
+#include "util/timing.h"
+
+#include "../nav_common/nav_functions.h"
+#include "EKF_15state.h"
+#include "EKF_15state_batch.h"
+
+static const float dt = 0.01;
+static const int steps = 9000;          // 90 sec
+static const int straight = 1000;       // level for the first 10 sec
+static const int leg = 1500;            // 15 sec per turn direction
+static const int filters = 64;
+
+static float noise(float sigma) {
+    // cheap approximately gaussian noise
+    float sum = 0.0;
+    for ( int i = 0; i < 12; i++ ) {
+        sum += drand48();
+    }
+    return (sum - 6.0) * sigma;
+}
+
+// 25 m/s, straight for 10 sec and then alternating 15 degree banked
+// coordinated turns (rolling at 20 deg/sec), one noisy imu stream (and
+// gps every 20th sample) per filter
+static void simulate( vector<IMUdata> &imu, vector<GPSdata> &gps ) {
+    const float speed = 25.0;
+    const float bank = 15.0 * D2R;
+    const float roll_rate = 20.0 * D2R;
+
+    Vector3d pos(45.0 * D2R, -93.0 * D2R, 300.0);
+    float phi = 0.0;
+    float psi = 30.0 * D2R;
+    Vector3f vel(speed * cos(psi), speed * sin(psi), 0.0);
+    for ( int i = 0; i < steps; i++ ) {
+        float phi_dot = 0.0;
+        if ( i > 0 ) {
+            float target = 0.0;
+            if ( i >= straight ) {
+                target = (((i - straight) / leg) % 2 == 0) ? bank : -bank;
+            }
+            float dphi = target - phi;
+            if ( dphi > roll_rate * dt ) { dphi = roll_rate * dt; }
+            if ( dphi < -roll_rate * dt ) { dphi = -roll_rate * dt; }
+            phi += dphi;
+            phi_dot = dphi / dt;
+            psi += g * tan(phi) / speed * dt;
+            Vector3f dx = llarate(vel, pos);
+            pos += dt * dx.cast<double>();
+            vel = Vector3f(speed * cos(psi), speed * sin(psi), 0.0);
+        }
+        float rate = g * tan(phi) / speed;
+        Matrix3f C_N2B = quat2dcm(eul2quat(phi, 0.0, psi));
+        Vector3f acc_ned(-vel(1) * rate, vel(0) * rate, 0.0);
+        Vector3f f_b = C_N2B * (acc_ned - Vector3f(0.0, 0.0, g));
+        for ( int k = 0; k < filters; k++ ) {
+            IMUdata &m = imu[i * filters + k];
+            m.time = i * dt;
+            m.p = phi_dot + noise(0.002);
+            m.q = rate * sin(phi) + noise(0.002);
+            m.r = rate * cos(phi) + noise(0.002);
+            m.ax = f_b(0) + noise(0.05);
+            m.ay = f_b(1) + noise(0.05);
+            m.az = f_b(2) + noise(0.05);
+            // level mag vector for the initial heading
+            m.hx = cos(psi); m.hy = -sin(psi); m.hz = 0.0;
+            m.temp = 20.0;
+            if ( i % 20 == 0 ) {
+                GPSdata &f = gps[(i / 20) * filters + k];
+                f.time = m.time;
+                f.unix_sec = 1.6e9 + m.time;
+                f.lat = pos(0) * R2D + noise(1.0) / 111120.0;
+                f.lon = pos(1) * R2D + noise(1.0) / 78600.0;
+                f.alt = pos(2) + noise(2.0);
+                f.vn = vel(0) + noise(0.1);
+                f.ve = vel(1) + noise(0.1);
+                f.vd = vel(2) + noise(0.2);
+                f.sats = 9;
+            }
+        }
+    }
+}
+
+static float wrap_pi(float a) {
+    while ( a > M_PI ) { a -= 2.0 * M_PI; }
+    while ( a < -M_PI ) { a += 2.0 * M_PI; }
+    return a;
+}
+
+static NAVconfig lane_config( int k ) {
+    // spread the accel noise so the lanes do not share a tuning
+    EKF15 ekf;
+    NAVconfig config = ekf.get_config();
+    config.sig_w_ax = config.sig_w_ay = config.sig_w_az
+        = 0.04 + 0.0005 * k;
+    return config;
+}
+
+int main() {
+    vector<IMUdata> imu( steps * filters );
+    vector<GPSdata> gps( (steps / 20 + 1) * filters );
+    simulate( imu, gps );
+
+    // separate scalar filters (sequential update, as the batch)
+    vector<EKF15> scalar( filters );
+    for ( int k = 0; k < filters; k++ ) {
+        scalar[k].set_config( lane_config(k) );
+        scalar[k].set_sequential_update( true );
+        scalar[k].init( imu[k], gps[k] );
+    }
+    double start = get_Time();
+    for ( int i = 1; i < steps; i++ ) {
+        for ( int k = 0; k < filters; k++ ) {
+            scalar[k].time_update( imu[i * filters + k] );
+            if ( i % 20 == 0 ) {
+                scalar[k].measurement_update( imu[i * filters + k],
+                                              gps[(i / 20) * filters + k] );
+            }
+        }
+    }
+    double scalar_sec = get_Time() - start;
+
+    // the same filters as one batch
+    EKF15Batch batch( filters );
+    for ( int k = 0; k < filters; k++ ) {
+        batch.set_config( k, lane_config(k) );
+    }
+    batch.init( &imu[0], &gps[0] );
+    start = get_Time();
+    for ( int i = 1; i < steps; i++ ) {
+        batch.time_update( &imu[i * filters] );
+        if ( i % 20 == 0 ) {
+            batch.measurement_update( &gps[(i / 20) * filters] );
+        }
+    }
+    double batch_sec = get_Time() - start;
+
+    // every lane must follow its scalar filter
+    float att_err = 0.0, pos_err = 0.0, vel_err = 0.0, cov_err = 0.0;
+    float nis_err = 0.0;
+    for ( int k = 0; k < filters; k++ ) {
+        NAVdata a = scalar[k].get_nav();
+        NAVdata b = batch.get_nav( k );
+        att_err = fmax( att_err, fabs(wrap_pi(a.phi - b.phi)) * R2D );
+        att_err = fmax( att_err, fabs(wrap_pi(a.the - b.the)) * R2D );
+        att_err = fmax( att_err, fabs(wrap_pi(a.psi - b.psi)) * R2D );
+        Vector3d pa(a.lat, a.lon, a.alt);
+        Vector3d pb(b.lat, b.lon, b.alt);
+        Vector3f d = ecef2ned( lla2ecef(pb) - lla2ecef(pa), pa );
+        pos_err = fmax( pos_err, d.norm() );
+        vel_err = fmax( vel_err, Vector3f(a.vn - b.vn, a.ve - b.ve,
+                                          a.vd - b.vd).norm() );
+        float Pa[6] = { a.Pp0, a.Pv0, a.Pa0, a.Pa2, a.Pabx, a.Pgbz };
+        float Pb[6] = { b.Pp0, b.Pv0, b.Pa0, b.Pa2, b.Pabx, b.Pgbz };
+        for ( int j = 0; j < 6; j++ ) {
+            cov_err = fmax( cov_err, fabs(Pa[j] - Pb[j]) / Pa[j] );
+        }
+        nis_err = fmax( nis_err, fabs(scalar[k].get_nis()
+                                      - batch.get_nis(k)) );
+    }
+
+    double per_step = 1.0e6 / ((double)(steps - 1) * filters);
+    printf("%d filters, %d lanes\n", filters, EKF15Batch::lanes);
+    printf("scalar EKF15: %.3f us per filter step\n", scalar_sec * per_step);
+    printf("EKF15Batch:   %.3f us per filter step (%.2fx)\n",
+           batch_sec * per_step, scalar_sec / batch_sec);
+    printf("max lane difference: att %.2e deg  pos %.2e m  vel %.2e m/s  cov %.2e (rel)  nis %.2e\n",
+           att_err, pos_err, vel_err, cov_err, nis_err);
+
+    if ( att_err > 0.01 || pos_err > 0.05 || vel_err > 0.01
+         || cov_err > 0.01 || nis_err > 0.1 ) {
+        printf("FAIL: the batch lanes do not match the scalar filters\n");
+        return 1;
+    }
+    printf("PASS\n");
+    return 0;
+}
@@ -0,0 +1,57 @@
+// config.h -- apply the filter section options common to the ekf15
+//             aura interfaces (both variants), so the interfaces
+//             parse them in one place
+//
+
+#pragma once
+
+#include <pyprops.h>
+
+#include <stdio.h>
+
+#include <string>
+using std::string;
+
+#include "EKF_15state.h"
+
+template <int Sensors>
+void ekf15_configure( EKF15T<Sensors> &filter, pyPropertyNode *config,
+                      const char *name )
+{
+    // gps measurement update: "batch" (default) or "sequential"
+    string update_mode = config->getString("update_mode");
+    if ( update_mode == "sequential" ) {
+        printf("%s: sequential scalar gps measurement update\n", name);
+        filter.set_sequential_update( true );
+    } else {
+        filter.set_sequential_update( false );
+    }
+
+    // gps receiver latency (fixes are fused at their time of validity)
+    float gps_lag = config->getDouble("gps_lag_sec");
+    if ( gps_lag > 0.0 ) {
+        printf("%s: gps lag compensation %.3f sec\n", name, gps_lag);
+    }
+    filter.set_gps_lag( gps_lag );
+
+    // propagate the covariance once per n imu samples (mechanization
+    // still runs at the full imu rate)
+    int cov_decimation = config->getLong("cov_decimation");
+    if ( cov_decimation > 1 ) {
+        printf("%s: covariance propagation every %d imu samples\n", name,
+               cov_decimation);
+    } else {
+        cov_decimation = 1;
+    }
+    filter.set_cov_decimation( cov_decimation );
+
+    if ( Sensors & EKF_MAG ) {
+        // look up the ideal mag vector at the current position on
+        // every update (long range flights) rather than once at init
+        bool mag_tracking = config->getBool("mag_tracking");
+        if ( mag_tracking ) {
+            printf("%s: tracking the magnetic field model\n", name);
+        }
+        filter.set_mag_tracking( mag_tracking );
+    }
+}
@@ -0,0 +1,204 @@
+// covariance.cpp -- covariance time update (propagation) for the 15
+//                   state EKF
+//
+
+#include "../nav_common/nav_functions.h"
+#include "EKF_15state.h"
+#include "covariance.h"
+
+typedef Matrix<float,15,12> Matrix15x12f;
+
+void covariance_update_dense( Matrix15f &P, const Matrix3f &C_B2N,
+                              const Vector3f &f_b, const Vector3f &om_ib,
+                              const Matrix12f &Rw, const NAVconfig &config,
+                              float dt )
+{
+    Matrix15f F, PHI, Qw, Q;
+    Matrix15x12f G;
+    Matrix3f temp33;
+
+    // JACOBIAN
+    F.setZero();
+    // ... pos2gs
+    F(0,3) = 1.0; 	F(1,4) = 1.0; 	F(2,5) = 1.0;
+    // ... gs2pos
+    F(5,2) = -2 * g / EarthRadius;
+
+    // ... gs2att
+    temp33 = C_B2N * sk(f_b);
+
+    F(3,6) = -2.0*temp33(0,0);  F(3,7) = -2.0*temp33(0,1);  F(3,8) = -2.0*temp33(0,2);
+    F(4,6) = -2.0*temp33(1,0);  F(4,7) = -2.0*temp33(1,1);  F(4,8) = -2.0*temp33(1,2);
+    F(5,6) = -2.0*temp33(2,0);  F(5,7) = -2.0*temp33(2,1);  F(5,8) = -2.0*temp33(2,2);
+
+    // ... gs2acc
+    F(3,9) = -C_B2N(0,0);  F(3,10) = -C_B2N(0,1);  F(3,11) = -C_B2N(0,2);
+    F(4,9) = -C_B2N(1,0);  F(4,10) = -C_B2N(1,1);  F(4,11) = -C_B2N(1,2);
+    F(5,9) = -C_B2N(2,0);  F(5,10) = -C_B2N(2,1);  F(5,11) = -C_B2N(2,2);
+
+    // ... att2att
+    temp33 = sk(om_ib);
+    F(6,6) = -temp33(0,0);  F(6,7) = -temp33(0,1);  F(6,8) = -temp33(0,2);
+    F(7,6) = -temp33(1,0);  F(7,7) = -temp33(1,1);  F(7,8) = -temp33(1,2);
+    F(8,6) = -temp33(2,0);  F(8,7) = -temp33(2,1);  F(8,8) = -temp33(2,2);
+
+    // ... att2gyr
+    F(6,12) = -0.5;
+    F(7,13) = -0.5;
+    F(8,14) = -0.5;
+
+    // ... Accel Markov Bias
+    F(9,9) = -1.0/config.tau_a;    F(10,10) = -1.0/config.tau_a;  F(11,11) = -1.0/config.tau_a;
+    F(12,12) = -1.0/config.tau_g;  F(13,13) = -1.0/config.tau_g;  F(14,14) = -1.0/config.tau_g;
+
+    // State Transition Matrix: PHI = I15 + F*dt;
+    PHI = Matrix15f::Identity() + F * dt;
+
+    // Process Noise
+    G.setZero();
+    G(3,0) = -C_B2N(0,0);   G(3,1) = -C_B2N(0,1);   G(3,2) = -C_B2N(0,2);
+    G(4,0) = -C_B2N(1,0);   G(4,1) = -C_B2N(1,1);   G(4,2) = -C_B2N(1,2);
+    G(5,0) = -C_B2N(2,0);   G(5,1) = -C_B2N(2,1);   G(5,2) = -C_B2N(2,2);
+
+    G(6,3) = -0.5;
+    G(7,4) = -0.5;
+    G(8,5) = -0.5;
+
+    G(9,6) = 1.0; 	    G(10,7) = 1.0; 	    G(11,8) = 1.0;
+    G(12,9) = 1.0; 	    G(13,10) = 1.0; 	    G(14,11) = 1.0;
+
+    // Discrete Process Noise
+    Qw = G * Rw * G.transpose() * dt;			// Qw = dt*G*Rw*G'
+    Q = PHI * Qw;					// Q = (I+F*dt)*Qw
+    Q = (Q + Q.transpose()) * 0.5;			// Q = 0.5*(Q+Q')
+
+    // Covariance Time Update
+    P = PHI * P * PHI.transpose() + Q;			// P = PHI*P*PHI' + Q
+    P = (P + P.transpose()) * 0.5;			// P = 0.5*(P+P')
+}
+
+// M = PHI * M where PHI = I15 + F*dt, expanded block by block so only
+// the nonzero blocks of F are visited.  The caller supplies the
+// blocks of PHI already scaled by dt.
+static inline void phi_left( Matrix15f &M, float dt,
+                             const Matrix3f &PHI_va, const Matrix3f &PHI_vab,
+                             const Matrix3f &PHI_aa, float PHI_vp,
+                             float PHI_agb, float PHI_ab, float PHI_gb )
+{
+    // the vel (down) row needs the original pos (down) row
+    Matrix<float,1,15> pos_d = M.row(2);
+
+    // ... pos2gs
+    M.middleRows<3>(0) += dt * M.middleRows<3>(3);
+
+    // ... gs2att, gs2acc (reads att and accel bias rows before they
+    // are overwritten below)
+    M.middleRows<3>(3) += PHI_va * M.middleRows<3>(6)
+        + PHI_vab * M.middleRows<3>(9);
+    // ... gs2pos
+    M.row(5) += PHI_vp * pos_d;
+
+    // ... att2att, att2gyr
+    M.middleRows<3>(6) = PHI_aa * M.middleRows<3>(6)
+        + PHI_agb * M.middleRows<3>(12);
+
+    // ... Accel and Gyro Markov Bias
+    M.middleRows<3>(9) *= PHI_ab;
+    M.middleRows<3>(12) *= PHI_gb;
+}
+
+void CovarianceAccum::clear() {
+    CSf.setZero();
+    C.setZero();
+    Sw.setZero();
+    Qv.setZero();
+    dt = 0.0;
+    count = 0;
+}
+
+void CovarianceAccum::add( const Matrix3f &C_B2N, const Vector3f &f_b,
+                           const Vector3f &om_ib, const Matrix12f &Rw,
+                           float step_dt )
+{
+    CSf += (C_B2N * sk(f_b)) * step_dt;
+    C += C_B2N * step_dt;
+    Sw += sk(om_ib) * step_dt;
+    Qv += C_B2N * Rw.diagonal().segment<3>(0).asDiagonal()
+        * C_B2N.transpose() * step_dt;
+    dt += step_dt;
+    count++;
+}
+
+// P = PHI*P*PHI' + Q over an interval dt given the input dependent
+// blocks of PHI (already scaled by dt) and the vel noise block of Qw
+static void covariance_update_blocks( Matrix15f &P, float dt,
+                                      const Matrix3f &PHI_va,
+                                      const Matrix3f &PHI_vab,
+                                      const Matrix3f &PHI_aa,
+                                      const Matrix3f &Qv,
+                                      const Matrix12f &Rw,
+                                      const NAVconfig &config )
+{
+    float PHI_vp = (-2 * g / EarthRadius) * dt;
+    float PHI_agb = -0.5 * dt;
+    float PHI_ab = 1.0 - dt / config.tau_a;
+    float PHI_gb = 1.0 - dt / config.tau_g;
+
+    // Discrete Process Noise: Qw = dt*G*Rw*G' is block diagonal
+    // since G only maps noise into the vel, att and bias states
+    Matrix15f Q;
+    Q.setZero();
+    Q.block<3,3>(3,3) = Qv;
+    Q.diagonal().segment<3>(6) = Rw.diagonal().segment<3>(3) * (0.25 * dt);
+    Q.diagonal().segment<6>(9) = Rw.diagonal().segment<6>(6) * dt;
+
+    // Q = (I+F*dt)*Qw
+    phi_left( Q, dt, PHI_va, PHI_vab, PHI_aa, PHI_vp, PHI_agb,
+              PHI_ab, PHI_gb );
+    // Q = 0.5*(Q+Q')
+    Q = (Q + Q.transpose()) * 0.5;
+
+    // Covariance Time Update: P = PHI*P*PHI' + Q, computed as
+    // PHI*(PHI*P)' which equals PHI*P*PHI' for symmetric P
+    phi_left( P, dt, PHI_va, PHI_vab, PHI_aa, PHI_vp, PHI_agb,
+              PHI_ab, PHI_gb );
+    P.transposeInPlace();
+    phi_left( P, dt, PHI_va, PHI_vab, PHI_aa, PHI_vp, PHI_agb,
+              PHI_ab, PHI_gb );
+    P += Q;
+    P = (P + P.transpose()) * 0.5;			// P = 0.5*(P+P')
+}
+
+void covariance_update_accum( Matrix15f &P, const CovarianceAccum &acc,
+                              const Matrix12f &Rw, const NAVconfig &config )
+{
+    // nonzero blocks of PHI = I15 + sum(F*dt)
+    covariance_update_blocks( P, acc.dt, acc.CSf * -2.0f, -acc.C,
+                              Matrix3f::Identity() - acc.Sw, acc.Qv,
+                              Rw, config );
+}
+
+Matrix15f covariance_phi( const CovarianceAccum &acc,
+                          const NAVconfig &config )
+{
+    float dt = acc.dt;
+    Matrix15f PHI = Matrix15f::Identity();
+    phi_left( PHI, dt, acc.CSf * -2.0f, -acc.C,
+              Matrix3f::Identity() - acc.Sw, (-2 * g / EarthRadius) * dt,
+              -0.5 * dt, 1.0 - dt / config.tau_a, 1.0 - dt / config.tau_g );
+    return PHI;
+}
+
+void covariance_update_sparse( Matrix15f &P, const Matrix3f &C_B2N,
+                               const Vector3f &f_b, const Vector3f &om_ib,
+                               const Matrix12f &Rw, const NAVconfig &config,
+                               float dt )
+{
+    // nonzero blocks of PHI = I15 + F*dt
+    covariance_update_blocks( P, dt, (C_B2N * sk(f_b)) * (-2.0f * dt),
+                              C_B2N * -dt,
+                              Matrix3f::Identity() - sk(om_ib) * dt,
+                              C_B2N * Rw.diagonal().segment<3>(0).asDiagonal()
+                              * C_B2N.transpose() * dt,
+                              Rw, config );
+}
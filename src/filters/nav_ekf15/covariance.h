@@ -0,0 +1,79 @@
+// covariance.h -- covariance time update (propagation) for the 15
+//                 state EKF
+//
+// The state transition matrix PHI = I15 + F*dt is mostly zero or
+// identity, so the default path only touches the nonzero blocks of
+// F and G:
+//
+//   pos/vel, vel/pos (down channel gravity term), vel/att,
+//   vel/accel-bias, att/att, att/gyro-bias, and the diagonal
+//   accel/gyro Markov bias terms.
+//
+// The original dense formulation is kept as the reference
+// implementation.  Build with -DEKF_SPARSE_COVARIANCE=0 to select it.
+//
+// The propagation can also be decimated: CovarianceAccum integrates
+// the input dependent blocks of F*dt and Qw over several imu steps and
+// covariance_update_accum() then applies one PHI = I15 + sum(F*dt)
+// step for the whole interval.
+
+#pragma once
+
+#include <eigen3/Eigen/Core>
+using namespace Eigen;
+
+#include "../nav_common/structs.h"
+
+#ifndef EKF_SPARSE_COVARIANCE
+#define EKF_SPARSE_COVARIANCE 1
+#endif
+
+typedef Matrix<float,12,12> Matrix12f;
+typedef Matrix<float,15,15> Matrix15f;
+
+// P = PHI*P*PHI' + Q using full 15x15 matrix products (reference)
+void covariance_update_dense( Matrix15f &P, const Matrix3f &C_B2N,
+                              const Vector3f &f_b, const Vector3f &om_ib,
+                              const Matrix12f &Rw, const NAVconfig &config,
+                              float dt );
+
+// P = PHI*P*PHI' + Q using only the nonzero blocks of F and G
+void covariance_update_sparse( Matrix15f &P, const Matrix3f &C_B2N,
+                               const Vector3f &f_b, const Vector3f &om_ib,
+                               const Matrix12f &Rw, const NAVconfig &config,
+                               float dt );
+
+// time integrated inputs of the covariance propagation
+struct CovarianceAccum {
+    Matrix3f CSf;               // sum C_B2N*sk(f_b)*dt (vel/att)
+    Matrix3f C;                 // sum C_B2N*dt (vel/accel-bias)
+    Matrix3f Sw;                // sum sk(om_ib)*dt (att/att)
+    Matrix3f Qv;                // sum C_B2N*Ra*C_B2N'*dt (vel noise)
+    float dt;
+    int count;
+
+    CovarianceAccum() { clear(); }
+    void clear();
+    void add( const Matrix3f &C_B2N, const Vector3f &f_b,
+              const Vector3f &om_ib, const Matrix12f &Rw, float step_dt );
+};
+
+// P = PHI*P*PHI' + Q over the accumulated interval (block-sparse)
+void covariance_update_accum( Matrix15f &P, const CovarianceAccum &acc,
+                              const Matrix12f &Rw, const NAVconfig &config );
+
+// the transition matrix PHI of the accumulated interval (dense)
+Matrix15f covariance_phi( const CovarianceAccum &acc,
+                          const NAVconfig &config );
+
+inline void covariance_update( Matrix15f &P, const Matrix3f &C_B2N,
+                               const Vector3f &f_b, const Vector3f &om_ib,
+                               const Matrix12f &Rw, const NAVconfig &config,
+                               float dt )
+{
+#if EKF_SPARSE_COVARIANCE
+    covariance_update_sparse( P, C_B2N, f_b, om_ib, Rw, config, dt );
+#else
+    covariance_update_dense( P, C_B2N, f_b, om_ib, Rw, config, dt );
+#endif
+}
@@ -0,0 +1,148 @@
+// covariance_test.cpp -- check the block-sparse covariance time update
+//                        against the dense reference implementation
+//                        and time both.
+//
+// g++ -O3 -I../.. covariance_test.cpp covariance.cpp EKF_15state.cpp
+//     ../nav_common/nav_functions.cpp ../nav_common/coremag.c
+//     ../nav_common/magcache.cpp ../../util/timing.cpp -o covariance_test
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "util/timing.h"
+
+#include "../nav_common/nav_functions.h"
+#include "EKF_15state.h"
+#include "covariance.h"
+
+static float frand(float range) {
+    return (drand48() * 2.0 - 1.0) * range;
+}
+
+static void random_inputs( Matrix3f &C_B2N, Vector3f &f_b, Vector3f &om_ib ) {
+    Quaternionf q = eul2quat(frand(M_PI/4), frand(M_PI/6), frand(M_PI));
+    C_B2N = quat2dcm(q).transpose();
+    f_b = Vector3f(frand(2.0), frand(2.0), -g + frand(2.0));
+    om_ib = Vector3f(frand(0.5), frand(0.5), frand(0.5));
+}
+
+static float rel_error( const Matrix15f &A, const Matrix15f &B ) {
+    return (A - B).cwiseAbs().maxCoeff() / A.cwiseAbs().maxCoeff();
+}
+
+int main() {
+    EKF15 ekf;
+    NAVconfig config = ekf.get_config();
+    const float dt = 0.01;
+
+    Matrix12f Rw;
+    Rw.setZero();
+    Rw(0,0) = config.sig_w_ax*config.sig_w_ax;	Rw(1,1) = config.sig_w_ay*config.sig_w_ay;	      Rw(2,2) = config.sig_w_az*config.sig_w_az;
+    Rw(3,3) = config.sig_w_gx*config.sig_w_gx;	Rw(4,4) = config.sig_w_gy*config.sig_w_gy;	      Rw(5,5) = config.sig_w_gz*config.sig_w_gz;
+    Rw(6,6) = 2*config.sig_a_d*config.sig_a_d/config.tau_a;	Rw(7,7) = 2*config.sig_a_d*config.sig_a_d/config.tau_a;    Rw(8,8) = 2*config.sig_a_d*config.sig_a_d/config.tau_a;
+    Rw(9,9) = 2*config.sig_g_d*config.sig_g_d/config.tau_g;	Rw(10,10) = 2*config.sig_g_d*config.sig_g_d/config.tau_g;  Rw(11,11) = 2*config.sig_g_d*config.sig_g_d/config.tau_g;
+
+    Matrix3f C_B2N;
+    Vector3f f_b, om_ib;
+
+    // single step agreement from random symmetric positive definite P
+    float max_err = 0.0;
+    for ( int i = 0; i < 10000; i++ ) {
+        Matrix15f A = Matrix15f::Random();
+        Matrix15f P0 = A * A.transpose() + Matrix15f::Identity();
+        random_inputs( C_B2N, f_b, om_ib );
+        Matrix15f Pd = P0;
+        Matrix15f Ps = P0;
+        covariance_update_dense( Pd, C_B2N, f_b, om_ib, Rw, config, dt );
+        covariance_update_sparse( Ps, C_B2N, f_b, om_ib, Rw, config, dt );
+        float err = rel_error( Pd, Ps );
+        if ( err > max_err ) { max_err = err; }
+    }
+    printf("single step max relative error: %g\n", max_err);
+    if ( max_err > 1.0e-5 ) {
+        printf("FAIL: sparse and dense covariance updates disagree\n");
+        return 1;
+    }
+
+    // long run agreement (one minute of 100hz propagation)
+    Matrix15f Pd = Matrix15f::Identity();
+    Matrix15f Ps = Matrix15f::Identity();
+    for ( int i = 0; i < 6000; i++ ) {
+        random_inputs( C_B2N, f_b, om_ib );
+        covariance_update_dense( Pd, C_B2N, f_b, om_ib, Rw, config, dt );
+        covariance_update_sparse( Ps, C_B2N, f_b, om_ib, Rw, config, dt );
+    }
+    float run_err = rel_error( Pd, Ps );
+    printf("6000 step relative error: %g\n", run_err);
+    if ( run_err > 1.0e-4 ) {
+        printf("FAIL: sparse and dense covariance updates diverge\n");
+        return 1;
+    }
+
+    // decimated propagation (one step per 5 samples) against every
+    // sample: one second (the longest expected gps gap) of a slowly
+    // varying trajectory from a converged covariance
+    const int decimation = 5;
+    Matrix15f Pe;
+    Pe.setZero();
+    Pe.diagonal() << 4.0, 4.0, 9.0, 0.04, 0.04, 0.09,
+        1.2e-3, 1.2e-3, 1.0e-2, 2.5e-3, 2.5e-3, 2.5e-3,
+        1.0e-6, 1.0e-6, 1.0e-6;
+    Matrix15f Pa = Pe;
+    CovarianceAccum acc;
+    for ( int i = 0; i < 100; i++ ) {
+        float t = i * dt;
+        Quaternionf q = eul2quat(0.3*sin(0.5*t), 0.1*cos(0.3*t), 0.2*t);
+        C_B2N = quat2dcm(q).transpose();
+        f_b = Vector3f(0.5*sin(t), 0.3*cos(0.7*t), -g);
+        om_ib = Vector3f(0.15*cos(0.5*t), -0.03*sin(0.3*t), 0.2);
+        covariance_update_sparse( Pe, C_B2N, f_b, om_ib, Rw, config, dt );
+        acc.add( C_B2N, f_b, om_ib, Rw, dt );
+        if ( acc.count == decimation ) {
+            covariance_update_accum( Pa, acc, Rw, config );
+            acc.clear();
+        }
+    }
+    float dec_err = rel_error( Pe, Pa );
+    printf("100 step decimated (%d) relative error: %g\n", decimation,
+           dec_err);
+    if ( dec_err > 1.0e-2 ) {
+        printf("FAIL: decimated covariance propagation diverges\n");
+        return 1;
+    }
+
+    // timing
+    const int count = 100000;
+    random_inputs( C_B2N, f_b, om_ib );
+    Matrix15f P = Matrix15f::Identity();
+    double start = get_Time();
+    for ( int i = 0; i < count; i++ ) {
+        covariance_update_dense( P, C_B2N, f_b, om_ib, Rw, config, dt );
+    }
+    double dense_us = (get_Time() - start) * 1000000.0 / count;
+    P = Matrix15f::Identity();
+    start = get_Time();
+    for ( int i = 0; i < count; i++ ) {
+        covariance_update_sparse( P, C_B2N, f_b, om_ib, Rw, config, dt );
+    }
+    double sparse_us = (get_Time() - start) * 1000000.0 / count;
+    printf("dense: %.3f us/update  sparse: %.3f us/update  (%.1fx)\n",
+           dense_us, sparse_us, dense_us / sparse_us);
+    P = Matrix15f::Identity();
+    acc.clear();
+    start = get_Time();
+    for ( int i = 0; i < count; i++ ) {
+        acc.add( C_B2N, f_b, om_ib, Rw, dt );
+        if ( acc.count == decimation ) {
+            covariance_update_accum( P, acc, Rw, config );
+            acc.clear();
+        }
+    }
+    double dec_us = (get_Time() - start) * 1000000.0 / count;
+    printf("decimated (%d): %.3f us/sample  (%.1fx sparse)\n", decimation,
+           dec_us, sparse_us / dec_us);
+
+    printf("PASS\n");
+    return 0;
+}
@@ -0,0 +1,180 @@
+// lag_test.cpp -- fly a simulated coordinated turn with gps fixes that
+//                 arrive 200ms late and compare the filter with and
+//                 without delayed gps fusion, and check a lag past
+//                 the state history is clamped.
+//
+// g++ -O3 -I../.. lag_test.cpp covariance.cpp EKF_15state.cpp
+//     ../nav_common/nav_functions.cpp ../nav_common/coremag.c
+//     ../nav_common/magcache.cpp ../../util/timing.cpp -o lag_test
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "util/timing.h"
+
+#include "../nav_common/nav_functions.h"
+#include "EKF_15state.h"
+
+static const float dt = 0.01;
+static const float lag = 0.2;
+static const int lag_steps = 20;
+static const int steps = 18000;         // 3 minutes
+static const int turn_step = 3000;      // straight for 30 sec, then turn
+
+static float noise(float sigma) {
+    // cheap approximately gaussian noise
+    float sum = 0.0;
+    for ( int i = 0; i < 12; i++ ) {
+        sum += drand48();
+    }
+    return (sum - 6.0) * sigma;
+}
+
+struct Truth {
+    Vector3d pos;               // lat (rad), lon (rad), alt
+    Vector3f vel;               // ned
+    float phi, psi;
+};
+
+struct Result {
+    double roll_rms;            // deg, during the turn
+    double pos_rms;             // m, during the turn
+    double update_us;           // per gps update
+};
+
+static float wrap_pi(float a) {
+    while ( a > M_PI ) { a -= 2.0 * M_PI; }
+    while ( a < -M_PI ) { a += 2.0 * M_PI; }
+    return a;
+}
+
+// flight path: 25 m/s, 30 sec straight then a 0.1 rad/sec level turn
+static void simulate( Truth *truth, IMUdata *imu ) {
+    const float speed = 25.0;
+    const float omega = 0.1;
+    const float bank = atan(speed * omega / g);
+
+    truth[0].pos = Vector3d(45.0 * D2R, -93.0 * D2R, 300.0);
+    truth[0].psi = 30.0 * D2R;
+    truth[0].phi = 0.0;
+    truth[0].vel = Vector3f(speed * cos(truth[0].psi),
+                            speed * sin(truth[0].psi), 0.0);
+    for ( int i = 0; i < steps; i++ ) {
+        float rate = (i >= turn_step) ? omega : 0.0;
+        if ( i > 0 ) {
+            Truth &prev = truth[i-1];
+            Truth &cur = truth[i];
+            cur.phi = (i >= turn_step) ? bank : 0.0;
+            cur.psi = prev.psi + rate * dt;
+            cur.vel = Vector3f(speed * cos(cur.psi), speed * sin(cur.psi), 0.0);
+            // same position integration as the filter (previous velocity)
+            Vector3f dx = llarate(prev.vel, prev.pos);
+            cur.pos = prev.pos + dt * dx.cast<double>();
+        }
+
+        const Truth &t = truth[i];
+        Matrix3f C_N2B = quat2dcm(eul2quat(t.phi, 0.0, t.psi));
+        Vector3f acc_ned(-t.vel(1) * rate, t.vel(0) * rate, 0.0);
+        Vector3f f_b = C_N2B * (acc_ned - Vector3f(0.0, 0.0, g));
+        IMUdata &m = imu[i];
+        m.time = i * dt;
+        m.p = (i == turn_step) ? bank / dt : 0.0;       // roll into the turn
+        m.q = rate * sin(t.phi);
+        m.r = rate * cos(t.phi);
+        m.ax = f_b(0);
+        m.ay = f_b(1);
+        m.az = f_b(2);
+        m.hx = cos(t.psi);
+        m.hy = -sin(t.psi);
+        m.hz = 0.0;
+        m.temp = 20.0;
+    }
+}
+
+static Result run( const Truth *truth, const IMUdata *imu,
+                   const GPSdata *gps, float gps_lag ) {
+    EKF15 filter;
+    filter.set_gps_lag( gps_lag );
+    GPSdata gps0 = gps[0];
+    gps0.lat = truth[0].pos(0) * R2D;
+    gps0.lon = truth[0].pos(1) * R2D;
+    filter.init( imu[0], gps0 );
+
+    Result r = { 0.0, 0.0, 0.0 };
+    int n = 0;
+    int updates = 0;
+    double update_time = 0.0;
+    for ( int i = 1; i < steps; i++ ) {
+        filter.time_update( imu[i] );
+        if ( i % 20 == 0 && i > lag_steps ) {
+            double start = get_Time();
+            filter.measurement_update( imu[i], gps[i] );
+            update_time += get_Time() - start;
+            updates++;
+        }
+        if ( i >= turn_step + 3000 ) {
+            NAVdata nav = filter.get_nav();
+            float droll = wrap_pi(nav.phi - truth[i].phi) * R2D;
+            Vector3f dpos = ecef2ned(lla2ecef(Vector3d(nav.lat, nav.lon, nav.alt))
+                                     - lla2ecef(truth[i].pos), truth[i].pos);
+            r.roll_rms += droll * droll;
+            r.pos_rms += dpos.squaredNorm();
+            n++;
+        }
+    }
+    r.roll_rms = sqrt(r.roll_rms / n);
+    r.pos_rms = sqrt(r.pos_rms / n);
+    r.update_us = update_time * 1000000.0 / updates;
+    return r;
+}
+
+int main() {
+    static Truth truth[steps];
+    static IMUdata imu[steps];
+    static GPSdata gps[steps];
+    simulate( truth, imu );
+
+    // the fix received at step i describes the aircraft lag seconds
+    // earlier
+    for ( int i = 0; i < steps; i++ ) {
+        const Truth &t = truth[i >= lag_steps ? i - lag_steps : 0];
+        gps[i].time = imu[i].time;
+        gps[i].unix_sec = 0.0;
+        gps[i].lat = t.pos(0) * R2D + noise(0.5) / 111120.0;
+        gps[i].lon = t.pos(1) * R2D + noise(0.5) / 78600.0;
+        gps[i].alt = t.pos(2) + noise(1.0);
+        gps[i].vn = t.vel(0) + noise(0.05);
+        gps[i].ve = t.vel(1) + noise(0.05);
+        gps[i].vd = t.vel(2) + noise(0.1);
+        gps[i].sats = 9;
+    }
+
+    Result current = run( truth, imu, gps, 0.0 );
+    Result delayed = run( truth, imu, gps, lag );
+    printf("gps fused as current:      roll rms = %.3f deg  pos rms = %.2f m  %.2f us/update\n",
+           current.roll_rms, current.pos_rms, current.update_us);
+    printf("gps fused %.0fms in past:  roll rms = %.3f deg  pos rms = %.2f m  %.2f us/update\n",
+           lag * 1000.0, delayed.roll_rms, delayed.pos_rms, delayed.update_us);
+
+    if ( delayed.roll_rms > 0.5 * current.roll_rms
+         || delayed.pos_rms > 0.5 * current.pos_rms ) {
+        printf("FAIL: delayed fusion did not reduce the lag error\n");
+        return 1;
+    }
+
+    // a lag longer than the state history is clamped to its span once
+    // the history fills
+    EKF15 deep;
+    deep.set_gps_lag( 1.0 );
+    deep.init( imu[0], gps[0] );
+    for ( int i = 1; i < EKF15::history_len; i++ ) {
+        deep.time_update( imu[i] );
+    }
+    if ( fabs(deep.get_gps_lag() - (EKF15::history_len - 1) * dt) > 1e-4 ) {
+        printf("FAIL: gps lag not clamped (%.3f)\n", deep.get_gps_lag());
+        return 1;
+    }
+    printf("PASS\n");
+    return 0;
+}
@@ -0,0 +1,125 @@
+// update_test.cpp -- regression test for the batch and sequential
+//                    (scalar, Joseph form) measurement updates of
+//                    both filter variants.
+//
+// g++ -O3 -I../.. update_test.cpp covariance.cpp EKF_15state.cpp
+//     ../nav_common/nav_functions.cpp ../nav_common/coremag.c
+//     ../nav_common/magcache.cpp ../../util/timing.cpp -o update_test
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "util/timing.h"
+
+#include "../nav_common/constants.h"
+#include "EKF_15state.h"
+
+static float noise(float sigma) {
+    // cheap approximately gaussian noise
+    float sum = 0.0;
+    for ( int i = 0; i < 12; i++ ) {
+        sum += drand48();
+    }
+    return (sum - 6.0) * sigma;
+}
+
+// one minute of 100hz imu data with 5hz gps on a slowly turning
+// aircraft.  The same data stream is fed to both filters.
+template <class Filter>
+static bool run( const char *name ) {
+    Filter batch;
+    Filter seq;
+    batch.set_sequential_update( false );
+    seq.set_sequential_update( true );
+
+    IMUdata imu;
+    GPSdata gps;
+    imu.time = 0.0;
+    imu.p = 0.002; imu.q = -0.001; imu.r = 0.05;
+    imu.ax = 0.0; imu.ay = 0.0; imu.az = -g;
+    imu.hx = 0.3; imu.hy = 0.05; imu.hz = 0.5;
+    imu.temp = 20.0;
+    gps.time = 0.0;
+    gps.unix_sec = 0.0;
+    gps.lat = 45.0; gps.lon = -93.0; gps.alt = 300.0;
+    gps.vn = 0.0; gps.ve = 0.0; gps.vd = 0.0;
+    gps.sats = 8;
+
+    batch.init( imu, gps );
+    seq.init( imu, gps );
+
+    double batch_time = 0.0;
+    double seq_time = 0.0;
+    int updates = 0;
+    float max_att_err = 0.0;
+    double max_pos_err = 0.0;
+    float max_vel_err = 0.0;
+    float max_cov_err = 0.0;
+    float max_nis_err = 0.0;
+    for ( int i = 1; i <= 6000; i++ ) {
+        imu.time = i * 0.01;
+        imu.ax = noise(0.05); imu.ay = noise(0.05); imu.az = -g + noise(0.05);
+        batch.time_update( imu );
+        seq.time_update( imu );
+        if ( i % 20 == 0 ) {
+            gps.time = imu.time;
+            gps.lat = 45.0 + noise(2.0e-5);
+            gps.lon = -93.0 + noise(2.0e-5);
+            gps.alt = 300.0 + noise(4.0);
+            gps.vn = noise(0.2); gps.ve = noise(0.2); gps.vd = noise(0.4);
+            double start = get_Time();
+            batch.measurement_update( imu, gps );
+            batch_time += get_Time() - start;
+            start = get_Time();
+            seq.measurement_update( imu, gps );
+            seq_time += get_Time() - start;
+            updates++;
+            float nis_err = fabs(batch.get_nis() - seq.get_nis())
+                / batch.get_nis();
+            if ( nis_err > max_nis_err ) { max_nis_err = nis_err; }
+        }
+        NAVdata nb = batch.get_nav();
+        NAVdata ns = seq.get_nav();
+        float att_err = fabs(nb.phi - ns.phi) + fabs(nb.the - ns.the)
+            + fabs(nb.psi - ns.psi);
+        double pos_err = (fabs(nb.lat - ns.lat) + fabs(nb.lon - ns.lon))
+            * EARTH_RADIUS + fabs(nb.alt - ns.alt);
+        float vel_err = fabs(nb.vn - ns.vn) + fabs(nb.ve - ns.ve)
+            + fabs(nb.vd - ns.vd);
+        float cov_err = fabs(nb.Pp0 - ns.Pp0) / nb.Pp0
+            + fabs(nb.Pv0 - ns.Pv0) / nb.Pv0
+            + fabs(nb.Pa2 - ns.Pa2) / nb.Pa2
+            + fabs(nb.Pgbz - ns.Pgbz) / nb.Pgbz;
+        if ( att_err > max_att_err ) { max_att_err = att_err; }
+        if ( pos_err > max_pos_err ) { max_pos_err = pos_err; }
+        if ( vel_err > max_vel_err ) { max_vel_err = vel_err; }
+        if ( cov_err > max_cov_err ) { max_cov_err = cov_err; }
+    }
+
+    printf("%s max difference: att = %.2e (rad) pos = %.2e (m) vel = %.2e (m/s) cov = %.2e (rel)\n",
+           name, max_att_err, max_pos_err, max_vel_err, max_cov_err);
+    printf("%s max nis difference: %.2e (rel)\n", name, max_nis_err);
+    printf("%s batch: %.3f us/update  sequential: %.3f us/update\n",
+           name, batch_time * 1000000.0 / updates,
+           seq_time * 1000000.0 / updates);
+
+    NAVdata nav = seq.get_nav();
+    printf("%s final (sequential): lat = %.7f lon = %.7f alt = %.2f psi = %.2f\n",
+           name, nav.lat * R2D, nav.lon * R2D, nav.alt, nav.psi * R2D);
+
+    return max_att_err < 1.0e-3 && max_pos_err < 0.05 && max_vel_err < 1.0e-2
+        && max_cov_err < 1.0e-2 && max_nis_err < 1.0e-2;
+}
+
+int main() {
+    bool result = run<EKF15>( "ekf15" );
+    result = run<EKF15_mag>( "ekf15_mag" ) && result;
+
+    if ( !result ) {
+        printf("FAIL: batch and sequential measurement updates disagree\n");
+        return 1;
+    }
+    printf("PASS\n");
+    return 0;
+}
@@ -9,11 +9,13 @@
 #include <string.h>
 
 #include "include/globaldefs.h"
+#include "util/prop_handle.h"
 
 #include "../nav_common/constants.h"
 
 #include "aura_interface.h"
-#include "EKF_15state.h"
+#include "../nav_ekf15/EKF_15state.h"
+#include "../nav_ekf15/config.h"
 
 // these are the important sensor and result structures used by the
 // UMN code.  To avoid pointers and dynamic allocation, create static
@@ -30,30 +32,68 @@ static pyPropertyNode imu_node;
 static pyPropertyNode gps_node;
 static pyPropertyNode filter_node;
 
+// per frame values, moved as blocks (in the order of the names)
+static const char *imu_names[] = {
+    "timestamp", "p_rad_sec", "q_rad_sec", "r_rad_sec", "ax_mps_sec",
+    "ay_mps_sec", "az_mps_sec", "hx", "hy", "hz"
+};
+static const char *gps_names[] = {
+    "timestamp", "latitude_deg", "longitude_deg", "altitude_m", "vn_ms",
+    "ve_ms", "vd_ms"
+};
+static const char *filter_names[] = {
+    "timestamp", "roll_deg", "pitch_deg", "heading_deg", "latitude_deg",
+    "longitude_deg", "altitude_m", "vn_ms", "ve_ms", "vd_ms", "p_bias",
+    "q_bias", "r_bias", "ax_bias", "ay_bias", "az_bias", "max_pos_cov",
+    "max_vel_cov", "max_att_cov", "altitude_ft", "groundtrack_deg",
+    "groundspeed_ms", "groundspeed_kt", "vertical_speed_fps"
+};
+static const int imu_count = sizeof(imu_names) / sizeof(char *);
+static const int gps_count = sizeof(gps_names) / sizeof(char *);
+static const int filter_count = sizeof(filter_names) / sizeof(char *);
+static PropBatch imu_batch;
+static PropBatch gps_batch;
+static PropBatch filter_batch;
+static PropHandle gps_data_age;
+static PropHandle gps_settle;
+
 // when false will trigger a nav init if gps is alive and settled
 static bool nav_inited = false;
 
+// resolve the per frame property blocks
+static void bind_props(void) {
+    imu_batch.init( imu_node, imu_names, imu_count );
+    gps_batch.init( gps_node, gps_names, gps_count );
+    filter_batch.init( filter_node, filter_names, filter_count );
+    gps_data_age.init( gps_node, "data_age" );
+    gps_settle.init( gps_node, "settle" );
+}
+
 // update the imu_data and gps_data structures with most recent sensor
 // data prior to calling the filter init or update routines
 static void props2umn(void) {
-    imu_data.time = imu_node.getDouble("timestamp");
-    imu_data.p = imu_node.getDouble("p_rad_sec");
-    imu_data.q = imu_node.getDouble("q_rad_sec");
-    imu_data.r = imu_node.getDouble("r_rad_sec");
-    imu_data.ax = imu_node.getDouble("ax_mps_sec");
-    imu_data.ay = imu_node.getDouble("ay_mps_sec");
-    imu_data.az = imu_node.getDouble("az_mps_sec");
-    imu_data.hx = imu_node.getDouble("hx");
-    imu_data.hy = imu_node.getDouble("hy");
-    imu_data.hz = imu_node.getDouble("hz");
-
-    gps_data.time = gps_node.getDouble("timestamp");
-    gps_data.lat = gps_node.getDouble("latitude_deg");
-    gps_data.lon = gps_node.getDouble("longitude_deg");
-    gps_data.alt = gps_node.getDouble("altitude_m");
-    gps_data.vn = gps_node.getDouble("vn_ms");
-    gps_data.ve = gps_node.getDouble("ve_ms");
-    gps_data.vd = gps_node.getDouble("vd_ms");
+    double imu[imu_count];
+    imu_batch.get( imu );
+    imu_data.time = imu[0];
+    imu_data.p = imu[1];
+    imu_data.q = imu[2];
+    imu_data.r = imu[3];
+    imu_data.ax = imu[4];
+    imu_data.ay = imu[5];
+    imu_data.az = imu[6];
+    imu_data.hx = imu[7];
+    imu_data.hy = imu[8];
+    imu_data.hz = imu[9];
+
+    double gps[gps_count];
+    gps_batch.get( gps );
+    gps_data.time = gps[0];
+    gps_data.lat = gps[1];
+    gps_data.lon = gps[2];
+    gps_data.alt = gps[3];
+    gps_data.vn = gps[4];
+    gps_data.ve = gps[5];
+    gps_data.vd = gps[6];
 }
 
 // update the property tree values from the nav_data structure
@@ -62,16 +102,6 @@ static void umn2props(void) {
     double psi = nav_data.psi;
     if ( psi < 0 ) { psi += M_PI*2.0; }
     if ( psi > M_PI*2.0 ) { psi -= M_PI*2.0; }
-    filter_node.setDouble( "timestamp", imu_data.time );
-    filter_node.setDouble( "roll_deg", nav_data.phi * R2D );
-    filter_node.setDouble( "pitch_deg", nav_data.the * R2D );
-    filter_node.setDouble( "heading_deg", psi * R2D );
-    filter_node.setDouble( "latitude_deg", nav_data.lat * R2D );
-    filter_node.setDouble( "longitude_deg", nav_data.lon * R2D );
-    filter_node.setDouble( "altitude_m", nav_data.alt );
-    filter_node.setDouble( "vn_ms", nav_data.vn );
-    filter_node.setDouble( "ve_ms", nav_data.ve );
-    filter_node.setDouble( "vd_ms", nav_data.vd );
     if ( nav_data.err_type == data_valid ||
 	 nav_data.err_type == TU_only ||
 	 nav_data.err_type == gps_aided )
@@ -81,13 +111,6 @@ static void umn2props(void) {
 	filter_node.setString( "navigation", "invalid" );
     }
 
-    filter_node.setDouble( "p_bias", nav_data.gbx );
-    filter_node.setDouble( "q_bias", nav_data.gby );
-    filter_node.setDouble( "r_bias", nav_data.gbz );
-    filter_node.setDouble( "ax_bias", nav_data.abx );
-    filter_node.setDouble( "ay_bias", nav_data.aby );
-    filter_node.setDouble( "az_bias", nav_data.abz );
-    
     float max_pos_cov = nav_data.Pp0;
     if ( nav_data.Pp1 > max_pos_cov ) { max_pos_cov = nav_data.Pp1; }
     if ( nav_data.Pp2 > max_pos_cov ) { max_pos_cov = nav_data.Pp2; }
@@ -100,19 +123,35 @@ static void umn2props(void) {
     if ( nav_data.Pa1 > max_att_cov ) { max_att_cov = nav_data.Pa1; }
     if ( nav_data.Pa2 > max_att_cov ) { max_att_cov = nav_data.Pa2; }
     if ( max_att_cov > 6.55 ) { max_vel_cov = 6.55; }
-    filter_node.setDouble( "max_pos_cov", max_pos_cov );
-    filter_node.setDouble( "max_vel_cov", max_vel_cov );
-    filter_node.setDouble( "max_att_cov", max_att_cov );
-    
-    filter_node.setDouble( "altitude_ft",
-			   nav_data.alt * M2F );
-    filter_node.setDouble( "groundtrack_deg",
-			   90 - atan2(nav_data.vn, nav_data.ve) * R2D );
+
     double gs_ms = sqrt(nav_data.vn * nav_data.vn + nav_data.ve * nav_data.ve);
-    filter_node.setDouble( "groundspeed_ms", gs_ms );
-    filter_node.setDouble( "groundspeed_kt", gs_ms * SG_MPS_TO_KT );
-    filter_node.setDouble( "vertical_speed_fps",
-			   -nav_data.vd * M2F );
+    double filter[] = {
+        imu_data.time,                                  // timestamp
+        nav_data.phi * R2D,                             // roll_deg
+        nav_data.the * R2D,                             // pitch_deg
+        psi * R2D,                                      // heading_deg
+        nav_data.lat * R2D,                             // latitude_deg
+        nav_data.lon * R2D,                             // longitude_deg
+        nav_data.alt,                                   // altitude_m
+        nav_data.vn,                                    // vn_ms
+        nav_data.ve,                                    // ve_ms
+        nav_data.vd,                                    // vd_ms
+        nav_data.gbx,                                   // p_bias
+        nav_data.gby,                                   // q_bias
+        nav_data.gbz,                                   // r_bias
+        nav_data.abx,                                   // ax_bias
+        nav_data.aby,                                   // ay_bias
+        nav_data.abz,                                   // az_bias
+        max_pos_cov,                                    // max_pos_cov
+        max_vel_cov,                                    // max_vel_cov
+        max_att_cov,                                    // max_att_cov
+        nav_data.alt * M2F,                             // altitude_ft
+        90 - atan2(nav_data.vn, nav_data.ve) * R2D,     // groundtrack_deg
+        gs_ms,                                          // groundspeed_ms
+        gs_ms * SG_MPS_TO_KT,                           // groundspeed_kt
+        -nav_data.vd * M2F                              // vertical_speed_fps
+    };
+    filter_batch.set( filter );
 }
 
 
@@ -121,8 +160,11 @@ void nav_ekf15_mag_init( string output_path, pyPropertyNode *config ) {
     imu_node = pyGetNode("/sensors/imu", true);
     gps_node = pyGetNode("/sensors/gps", true);
     filter_node = pyGetNode(output_path, true);
+    bind_props();
     filter_node.setString( "navigation", "invalid" );
 
+    ekf15_configure( filter, config, "ekf15_mag" );
+
 #if 0
     // set tuning value for specific gps and imu noise characteristics
     cov_gps_hpos_node = config.getChild("cov-gps-hpos", 0, true);
@@ -158,8 +200,24 @@ bool nav_ekf15_mag_update() {
             filter.measurement_update( imu_data, gps_data );
         }
         nav_data = filter.get_nav();
+
+        // publish the average cost of each half of the time update
+        static int timing_count = 0;
+        if ( ++timing_count >= 100 ) {
+            timing_count = 0;
+            EKFTiming t = filter.get_timing();
+            if ( t.mech_count > 0 ) {
+                filter_node.setDouble( "mech_us",
+                                       t.mech_sec * 1000000.0 / t.mech_count );
+            }
+            if ( t.cov_count > 0 ) {
+                filter_node.setDouble( "cov_us",
+                                       t.cov_sec * 1000000.0 / t.cov_count );
+            }
+            filter.reset_timing();
+        }
     } else {
-	if ( gps_node.getDouble("data_age") < 1.0 && gps_node.getBool("settle") ) {
+	if ( gps_data_age.getDouble() < 1.0 && gps_settle.getBool() ) {
 	    filter.init( imu_data, gps_data );
             nav_data = filter.get_nav();
 	    nav_inited = true;
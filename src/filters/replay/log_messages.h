@@ -0,0 +1,721 @@
+#pragma once
+
+#include <stdint.h>  // uint8_t, et. al.
+#include <string.h>  // memcpy()
+
+namespace message {
+
+static inline int32_t intround(float f) {
+    return (int32_t)(f >= 0.0 ? (f + 0.5) : (f - 0.5));
+}
+
+static inline uint32_t uintround(float f) {
+    return (int32_t)(f + 0.5);
+}
+
+// Message id constants
+const uint8_t gps_v2_id = 16;
+const uint8_t gps_v3_id = 26;
+const uint8_t gps_v4_id = 34;
+const uint8_t imu_v3_id = 17;
+const uint8_t imu_v4_id = 35;
+const uint8_t imu_v5_id = 45;
+const uint8_t filter_v5_id = 47;
+
+// max of one byte used to store message len
+static const uint8_t message_max_len = 255;
+
+// Constants
+static const uint8_t max_raw_sats = 12;  // maximum array size to store satellite raw data
+
+// Message: gps_v2 (id: 16)
+struct gps_v2_t {
+    // public fields
+    uint8_t index;
+    double timestamp_sec;
+    double latitude_deg;
+    double longitude_deg;
+    float altitude_m;
+    float vn_ms;
+    float ve_ms;
+    float vd_ms;
+    double unixtime_sec;
+    uint8_t satellites;
+    uint8_t status;
+
+    // internal structure for packing
+    uint8_t payload[message_max_len];
+    #pragma pack(push, 1)
+    struct _compact_t {
+        uint8_t index;
+        double timestamp_sec;
+        double latitude_deg;
+        double longitude_deg;
+        float altitude_m;
+        int16_t vn_ms;
+        int16_t ve_ms;
+        int16_t vd_ms;
+        double unixtime_sec;
+        uint8_t satellites;
+        uint8_t status;
+    };
+    #pragma pack(pop)
+
+    // public info fields
+    static const uint8_t id = 16;
+    int len = 0;
+
+    bool pack() {
+        len = sizeof(_compact_t);
+        // size sanity check
+        int size = len;
+        if ( size > message_max_len ) {
+            return false;
+        }
+        // copy values
+        _compact_t *_buf = (_compact_t *)payload;
+        _buf->index = index;
+        _buf->timestamp_sec = timestamp_sec;
+        _buf->latitude_deg = latitude_deg;
+        _buf->longitude_deg = longitude_deg;
+        _buf->altitude_m = altitude_m;
+        _buf->vn_ms = intround(vn_ms * 100);
+        _buf->ve_ms = intround(ve_ms * 100);
+        _buf->vd_ms = intround(vd_ms * 100);
+        _buf->unixtime_sec = unixtime_sec;
+        _buf->satellites = satellites;
+        _buf->status = status;
+        return true;
+    }
+
+    bool unpack(uint8_t *external_message, int message_size) {
+        if ( message_size > message_max_len ) {
+            return false;
+        }
+        memcpy(payload, external_message, message_size);
+        _compact_t *_buf = (_compact_t *)payload;
+        len = sizeof(_compact_t);
+        index = _buf->index;
+        timestamp_sec = _buf->timestamp_sec;
+        latitude_deg = _buf->latitude_deg;
+        longitude_deg = _buf->longitude_deg;
+        altitude_m = _buf->altitude_m;
+        vn_ms = _buf->vn_ms / (float)100;
+        ve_ms = _buf->ve_ms / (float)100;
+        vd_ms = _buf->vd_ms / (float)100;
+        unixtime_sec = _buf->unixtime_sec;
+        satellites = _buf->satellites;
+        status = _buf->status;
+        return true;
+    }
+};
+
+// Message: gps_v3 (id: 26)
+struct gps_v3_t {
+    // public fields
+    uint8_t index;
+    double timestamp_sec;
+    double latitude_deg;
+    double longitude_deg;
+    float altitude_m;
+    float vn_ms;
+    float ve_ms;
+    float vd_ms;
+    double unixtime_sec;
+    uint8_t satellites;
+    float horiz_accuracy_m;
+    float vert_accuracy_m;
+    float pdop;
+    uint8_t fix_type;
+
+    // internal structure for packing
+    uint8_t payload[message_max_len];
+    #pragma pack(push, 1)
+    struct _compact_t {
+        uint8_t index;
+        double timestamp_sec;
+        double latitude_deg;
+        double longitude_deg;
+        float altitude_m;
+        int16_t vn_ms;
+        int16_t ve_ms;
+        int16_t vd_ms;
+        double unixtime_sec;
+        uint8_t satellites;
+        uint16_t horiz_accuracy_m;
+        uint16_t vert_accuracy_m;
+        uint16_t pdop;
+        uint8_t fix_type;
+    };
+    #pragma pack(pop)
+
+    // public info fields
+    static const uint8_t id = 26;
+    int len = 0;
+
+    bool pack() {
+        len = sizeof(_compact_t);
+        // size sanity check
+        int size = len;
+        if ( size > message_max_len ) {
+            return false;
+        }
+        // copy values
+        _compact_t *_buf = (_compact_t *)payload;
+        _buf->index = index;
+        _buf->timestamp_sec = timestamp_sec;
+        _buf->latitude_deg = latitude_deg;
+        _buf->longitude_deg = longitude_deg;
+        _buf->altitude_m = altitude_m;
+        _buf->vn_ms = intround(vn_ms * 100);
+        _buf->ve_ms = intround(ve_ms * 100);
+        _buf->vd_ms = intround(vd_ms * 100);
+        _buf->unixtime_sec = unixtime_sec;
+        _buf->satellites = satellites;
+        _buf->horiz_accuracy_m = uintround(horiz_accuracy_m * 100);
+        _buf->vert_accuracy_m = uintround(vert_accuracy_m * 100);
+        _buf->pdop = uintround(pdop * 100);
+        _buf->fix_type = fix_type;
+        return true;
+    }
+
+    bool unpack(uint8_t *external_message, int message_size) {
+        if ( message_size > message_max_len ) {
+            return false;
+        }
+        memcpy(payload, external_message, message_size);
+        _compact_t *_buf = (_compact_t *)payload;
+        len = sizeof(_compact_t);
+        index = _buf->index;
+        timestamp_sec = _buf->timestamp_sec;
+        latitude_deg = _buf->latitude_deg;
+        longitude_deg = _buf->longitude_deg;
+        altitude_m = _buf->altitude_m;
+        vn_ms = _buf->vn_ms / (float)100;
+        ve_ms = _buf->ve_ms / (float)100;
+        vd_ms = _buf->vd_ms / (float)100;
+        unixtime_sec = _buf->unixtime_sec;
+        satellites = _buf->satellites;
+        horiz_accuracy_m = _buf->horiz_accuracy_m / (float)100;
+        vert_accuracy_m = _buf->vert_accuracy_m / (float)100;
+        pdop = _buf->pdop / (float)100;
+        fix_type = _buf->fix_type;
+        return true;
+    }
+};
+
+// Message: gps_v4 (id: 34)
+struct gps_v4_t {
+    // public fields
+    uint8_t index;
+    float timestamp_sec;
+    double latitude_deg;
+    double longitude_deg;
+    float altitude_m;
+    float vn_ms;
+    float ve_ms;
+    float vd_ms;
+    double unixtime_sec;
+    uint8_t satellites;
+    float horiz_accuracy_m;
+    float vert_accuracy_m;
+    float pdop;
+    uint8_t fix_type;
+
+    // internal structure for packing
+    uint8_t payload[message_max_len];
+    #pragma pack(push, 1)
+    struct _compact_t {
+        uint8_t index;
+        float timestamp_sec;
+        double latitude_deg;
+        double longitude_deg;
+        float altitude_m;
+        int16_t vn_ms;
+        int16_t ve_ms;
+        int16_t vd_ms;
+        double unixtime_sec;
+        uint8_t satellites;
+        uint16_t horiz_accuracy_m;
+        uint16_t vert_accuracy_m;
+        uint16_t pdop;
+        uint8_t fix_type;
+    };
+    #pragma pack(pop)
+
+    // public info fields
+    static const uint8_t id = 34;
+    int len = 0;
+
+    bool pack() {
+        len = sizeof(_compact_t);
+        // size sanity check
+        int size = len;
+        if ( size > message_max_len ) {
+            return false;
+        }
+        // copy values
+        _compact_t *_buf = (_compact_t *)payload;
+        _buf->index = index;
+        _buf->timestamp_sec = timestamp_sec;
+        _buf->latitude_deg = latitude_deg;
+        _buf->longitude_deg = longitude_deg;
+        _buf->altitude_m = altitude_m;
+        _buf->vn_ms = intround(vn_ms * 100);
+        _buf->ve_ms = intround(ve_ms * 100);
+        _buf->vd_ms = intround(vd_ms * 100);
+        _buf->unixtime_sec = unixtime_sec;
+        _buf->satellites = satellites;
+        _buf->horiz_accuracy_m = uintround(horiz_accuracy_m * 100);
+        _buf->vert_accuracy_m = uintround(vert_accuracy_m * 100);
+        _buf->pdop = uintround(pdop * 100);
+        _buf->fix_type = fix_type;
+        return true;
+    }
+
+    bool unpack(uint8_t *external_message, int message_size) {
+        if ( message_size > message_max_len ) {
+            return false;
+        }
+        memcpy(payload, external_message, message_size);
+        _compact_t *_buf = (_compact_t *)payload;
+        len = sizeof(_compact_t);
+        index = _buf->index;
+        timestamp_sec = _buf->timestamp_sec;
+        latitude_deg = _buf->latitude_deg;
+        longitude_deg = _buf->longitude_deg;
+        altitude_m = _buf->altitude_m;
+        vn_ms = _buf->vn_ms / (float)100;
+        ve_ms = _buf->ve_ms / (float)100;
+        vd_ms = _buf->vd_ms / (float)100;
+        unixtime_sec = _buf->unixtime_sec;
+        satellites = _buf->satellites;
+        horiz_accuracy_m = _buf->horiz_accuracy_m / (float)100;
+        vert_accuracy_m = _buf->vert_accuracy_m / (float)100;
+        pdop = _buf->pdop / (float)100;
+        fix_type = _buf->fix_type;
+        return true;
+    }
+};
+
+// Message: imu_v3 (id: 17)
+struct imu_v3_t {
+    // public fields
+    uint8_t index;
+    double timestamp_sec;
+    float p_rad_sec;
+    float q_rad_sec;
+    float r_rad_sec;
+    float ax_mps_sec;
+    float ay_mps_sec;
+    float az_mps_sec;
+    float hx;
+    float hy;
+    float hz;
+    float temp_C;
+    uint8_t status;
+
+    // internal structure for packing
+    uint8_t payload[message_max_len];
+    #pragma pack(push, 1)
+    struct _compact_t {
+        uint8_t index;
+        double timestamp_sec;
+        float p_rad_sec;
+        float q_rad_sec;
+        float r_rad_sec;
+        float ax_mps_sec;
+        float ay_mps_sec;
+        float az_mps_sec;
+        float hx;
+        float hy;
+        float hz;
+        int16_t temp_C;
+        uint8_t status;
+    };
+    #pragma pack(pop)
+
+    // public info fields
+    static const uint8_t id = 17;
+    int len = 0;
+
+    bool pack() {
+        len = sizeof(_compact_t);
+        // size sanity check
+        int size = len;
+        if ( size > message_max_len ) {
+            return false;
+        }
+        // copy values
+        _compact_t *_buf = (_compact_t *)payload;
+        _buf->index = index;
+        _buf->timestamp_sec = timestamp_sec;
+        _buf->p_rad_sec = p_rad_sec;
+        _buf->q_rad_sec = q_rad_sec;
+        _buf->r_rad_sec = r_rad_sec;
+        _buf->ax_mps_sec = ax_mps_sec;
+        _buf->ay_mps_sec = ay_mps_sec;
+        _buf->az_mps_sec = az_mps_sec;
+        _buf->hx = hx;
+        _buf->hy = hy;
+        _buf->hz = hz;
+        _buf->temp_C = intround(temp_C * 10);
+        _buf->status = status;
+        return true;
+    }
+
+    bool unpack(uint8_t *external_message, int message_size) {
+        if ( message_size > message_max_len ) {
+            return false;
+        }
+        memcpy(payload, external_message, message_size);
+        _compact_t *_buf = (_compact_t *)payload;
+        len = sizeof(_compact_t);
+        index = _buf->index;
+        timestamp_sec = _buf->timestamp_sec;
+        p_rad_sec = _buf->p_rad_sec;
+        q_rad_sec = _buf->q_rad_sec;
+        r_rad_sec = _buf->r_rad_sec;
+        ax_mps_sec = _buf->ax_mps_sec;
+        ay_mps_sec = _buf->ay_mps_sec;
+        az_mps_sec = _buf->az_mps_sec;
+        hx = _buf->hx;
+        hy = _buf->hy;
+        hz = _buf->hz;
+        temp_C = _buf->temp_C / (float)10;
+        status = _buf->status;
+        return true;
+    }
+};
+
+// Message: imu_v4 (id: 35)
+struct imu_v4_t {
+    // public fields
+    uint8_t index;
+    float timestamp_sec;
+    float p_rad_sec;
+    float q_rad_sec;
+    float r_rad_sec;
+    float ax_mps_sec;
+    float ay_mps_sec;
+    float az_mps_sec;
+    float hx;
+    float hy;
+    float hz;
+    float temp_C;
+    uint8_t status;
+
+    // internal structure for packing
+    uint8_t payload[message_max_len];
+    #pragma pack(push, 1)
+    struct _compact_t {
+        uint8_t index;
+        float timestamp_sec;
+        float p_rad_sec;
+        float q_rad_sec;
+        float r_rad_sec;
+        float ax_mps_sec;
+        float ay_mps_sec;
+        float az_mps_sec;
+        float hx;
+        float hy;
+        float hz;
+        int16_t temp_C;
+        uint8_t status;
+    };
+    #pragma pack(pop)
+
+    // public info fields
+    static const uint8_t id = 35;
+    int len = 0;
+
+    bool pack() {
+        len = sizeof(_compact_t);
+        // size sanity check
+        int size = len;
+        if ( size > message_max_len ) {
+            return false;
+        }
+        // copy values
+        _compact_t *_buf = (_compact_t *)payload;
+        _buf->index = index;
+        _buf->timestamp_sec = timestamp_sec;
+        _buf->p_rad_sec = p_rad_sec;
+        _buf->q_rad_sec = q_rad_sec;
+        _buf->r_rad_sec = r_rad_sec;
+        _buf->ax_mps_sec = ax_mps_sec;
+        _buf->ay_mps_sec = ay_mps_sec;
+        _buf->az_mps_sec = az_mps_sec;
+        _buf->hx = hx;
+        _buf->hy = hy;
+        _buf->hz = hz;
+        _buf->temp_C = intround(temp_C * 10);
+        _buf->status = status;
+        return true;
+    }
+
+    bool unpack(uint8_t *external_message, int message_size) {
+        if ( message_size > message_max_len ) {
+            return false;
+        }
+        memcpy(payload, external_message, message_size);
+        _compact_t *_buf = (_compact_t *)payload;
+        len = sizeof(_compact_t);
+        index = _buf->index;
+        timestamp_sec = _buf->timestamp_sec;
+        p_rad_sec = _buf->p_rad_sec;
+        q_rad_sec = _buf->q_rad_sec;
+        r_rad_sec = _buf->r_rad_sec;
+        ax_mps_sec = _buf->ax_mps_sec;
+        ay_mps_sec = _buf->ay_mps_sec;
+        az_mps_sec = _buf->az_mps_sec;
+        hx = _buf->hx;
+        hy = _buf->hy;
+        hz = _buf->hz;
+        temp_C = _buf->temp_C / (float)10;
+        status = _buf->status;
+        return true;
+    }
+};
+
+// Message: imu_v5 (id: 45)
+struct imu_v5_t {
+    // public fields
+    uint8_t index;
+    float timestamp_sec;
+    float p_rad_sec;
+    float q_rad_sec;
+    float r_rad_sec;
+    float ax_mps_sec;
+    float ay_mps_sec;
+    float az_mps_sec;
+    float hx;
+    float hy;
+    float hz;
+    float ax_raw;
+    float ay_raw;
+    float az_raw;
+    float hx_raw;
+    float hy_raw;
+    float hz_raw;
+    float temp_C;
+    uint8_t status;
+
+    // internal structure for packing
+    uint8_t payload[message_max_len];
+    #pragma pack(push, 1)
+    struct _compact_t {
+        uint8_t index;
+        float timestamp_sec;
+        float p_rad_sec;
+        float q_rad_sec;
+        float r_rad_sec;
+        float ax_mps_sec;
+        float ay_mps_sec;
+        float az_mps_sec;
+        float hx;
+        float hy;
+        float hz;
+        float ax_raw;
+        float ay_raw;
+        float az_raw;
+        float hx_raw;
+        float hy_raw;
+        float hz_raw;
+        int16_t temp_C;
+        uint8_t status;
+    };
+    #pragma pack(pop)
+
+    // public info fields
+    static const uint8_t id = 45;
+    int len = 0;
+
+    bool pack() {
+        len = sizeof(_compact_t);
+        // size sanity check
+        int size = len;
+        if ( size > message_max_len ) {
+            return false;
+        }
+        // copy values
+        _compact_t *_buf = (_compact_t *)payload;
+        _buf->index = index;
+        _buf->timestamp_sec = timestamp_sec;
+        _buf->p_rad_sec = p_rad_sec;
+        _buf->q_rad_sec = q_rad_sec;
+        _buf->r_rad_sec = r_rad_sec;
+        _buf->ax_mps_sec = ax_mps_sec;
+        _buf->ay_mps_sec = ay_mps_sec;
+        _buf->az_mps_sec = az_mps_sec;
+        _buf->hx = hx;
+        _buf->hy = hy;
+        _buf->hz = hz;
+        _buf->ax_raw = ax_raw;
+        _buf->ay_raw = ay_raw;
+        _buf->az_raw = az_raw;
+        _buf->hx_raw = hx_raw;
+        _buf->hy_raw = hy_raw;
+        _buf->hz_raw = hz_raw;
+        _buf->temp_C = intround(temp_C * 10);
+        _buf->status = status;
+        return true;
+    }
+
+    bool unpack(uint8_t *external_message, int message_size) {
+        if ( message_size > message_max_len ) {
+            return false;
+        }
+        memcpy(payload, external_message, message_size);
+        _compact_t *_buf = (_compact_t *)payload;
+        len = sizeof(_compact_t);
+        index = _buf->index;
+        timestamp_sec = _buf->timestamp_sec;
+        p_rad_sec = _buf->p_rad_sec;
+        q_rad_sec = _buf->q_rad_sec;
+        r_rad_sec = _buf->r_rad_sec;
+        ax_mps_sec = _buf->ax_mps_sec;
+        ay_mps_sec = _buf->ay_mps_sec;
+        az_mps_sec = _buf->az_mps_sec;
+        hx = _buf->hx;
+        hy = _buf->hy;
+        hz = _buf->hz;
+        ax_raw = _buf->ax_raw;
+        ay_raw = _buf->ay_raw;
+        az_raw = _buf->az_raw;
+        hx_raw = _buf->hx_raw;
+        hy_raw = _buf->hy_raw;
+        hz_raw = _buf->hz_raw;
+        temp_C = _buf->temp_C / (float)10;
+        status = _buf->status;
+        return true;
+    }
+};
+
+// Message: filter_v5 (id: 47)
+struct filter_v5_t {
+    // public fields
+    uint8_t index;
+    float timestamp_sec;
+    double latitude_deg;
+    double longitude_deg;
+    float altitude_m;
+    float vn_ms;
+    float ve_ms;
+    float vd_ms;
+    float roll_deg;
+    float pitch_deg;
+    float yaw_deg;
+    float p_bias;
+    float q_bias;
+    float r_bias;
+    float ax_bias;
+    float ay_bias;
+    float az_bias;
+    float max_pos_cov;
+    float max_vel_cov;
+    float max_att_cov;
+    uint8_t sequence_num;
+    uint8_t status;
+
+    // internal structure for packing
+    uint8_t payload[message_max_len];
+    #pragma pack(push, 1)
+    struct _compact_t {
+        uint8_t index;
+        float timestamp_sec;
+        double latitude_deg;
+        double longitude_deg;
+        float altitude_m;
+        int16_t vn_ms;
+        int16_t ve_ms;
+        int16_t vd_ms;
+        int16_t roll_deg;
+        int16_t pitch_deg;
+        int16_t yaw_deg;
+        int16_t p_bias;
+        int16_t q_bias;
+        int16_t r_bias;
+        int16_t ax_bias;
+        int16_t ay_bias;
+        int16_t az_bias;
+        uint16_t max_pos_cov;
+        uint16_t max_vel_cov;
+        uint16_t max_att_cov;
+        uint8_t sequence_num;
+        uint8_t status;
+    };
+    #pragma pack(pop)
+
+    // public info fields
+    static const uint8_t id = 47;
+    int len = 0;
+
+    bool pack() {
+        len = sizeof(_compact_t);
+        // size sanity check
+        int size = len;
+        if ( size > message_max_len ) {
+            return false;
+        }
+        // copy values
+        _compact_t *_buf = (_compact_t *)payload;
+        _buf->index = index;
+        _buf->timestamp_sec = timestamp_sec;
+        _buf->latitude_deg = latitude_deg;
+        _buf->longitude_deg = longitude_deg;
+        _buf->altitude_m = altitude_m;
+        _buf->vn_ms = intround(vn_ms * 100);
+        _buf->ve_ms = intround(ve_ms * 100);
+        _buf->vd_ms = intround(vd_ms * 100);
+        _buf->roll_deg = intround(roll_deg * 10);
+        _buf->pitch_deg = intround(pitch_deg * 10);
+        _buf->yaw_deg = intround(yaw_deg * 10);
+        _buf->p_bias = intround(p_bias * 10000);
+        _buf->q_bias = intround(q_bias * 10000);
+        _buf->r_bias = intround(r_bias * 10000);
+        _buf->ax_bias = intround(ax_bias * 1000);
+        _buf->ay_bias = intround(ay_bias * 1000);
+        _buf->az_bias = intround(az_bias * 1000);
+        _buf->max_pos_cov = uintround(max_pos_cov * 100);
+        _buf->max_vel_cov = uintround(max_vel_cov * 1000);
+        _buf->max_att_cov = uintround(max_att_cov * 10000);
+        _buf->sequence_num = sequence_num;
+        _buf->status = status;
+        return true;
+    }
+
+    bool unpack(uint8_t *external_message, int message_size) {
+        if ( message_size > message_max_len ) {
+            return false;
+        }
+        memcpy(payload, external_message, message_size);
+        _compact_t *_buf = (_compact_t *)payload;
+        len = sizeof(_compact_t);
+        index = _buf->index;
+        timestamp_sec = _buf->timestamp_sec;
+        latitude_deg = _buf->latitude_deg;
+        longitude_deg = _buf->longitude_deg;
+        altitude_m = _buf->altitude_m;
+        vn_ms = _buf->vn_ms / (float)100;
+        ve_ms = _buf->ve_ms / (float)100;
+        vd_ms = _buf->vd_ms / (float)100;
+        roll_deg = _buf->roll_deg / (float)10;
+        pitch_deg = _buf->pitch_deg / (float)10;
+        yaw_deg = _buf->yaw_deg / (float)10;
+        p_bias = _buf->p_bias / (float)10000;
+        q_bias = _buf->q_bias / (float)10000;
+        r_bias = _buf->r_bias / (float)10000;
+        ax_bias = _buf->ax_bias / (float)1000;
+        ay_bias = _buf->ay_bias / (float)1000;
+        az_bias = _buf->az_bias / (float)1000;
+        max_pos_cov = _buf->max_pos_cov / (float)100;
+        max_vel_cov = _buf->max_vel_cov / (float)1000;
+        max_att_cov = _buf->max_att_cov / (float)10000;
+        sequence_num = _buf->sequence_num;
+        status = _buf->status;
+        return true;
+    }
+};
+
+} // namespace message
@@ -0,0 +1,249 @@
+// log_reader.cpp -- stream imu and gps records out of a flight.dat.gz
+//                   log written by comms/logging.py
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "log_messages.h"
+#include "log_reader.h"
+
+static const uint8_t START_OF_MSG0 = 147;
+static const uint8_t START_OF_MSG1 = 224;
+
+// decompressed read buffer (large reads keep zlib out of the inner loop)
+static const int buf_size = 256 * 1024;
+
+// sync + id + len + max payload + checksum
+static const int max_packet = 4 + message::message_max_len + 2;
+
+LogReader::LogReader():
+    packets(0),
+    bad_checksum(0),
+    imu_count(0),
+    gps_count(0),
+    fd(NULL),
+    buf(NULL),
+    head(0),
+    tail(0),
+    eof(true)
+{
+}
+
+LogReader::~LogReader() {
+    close();
+}
+
+bool LogReader::open( const char *path ) {
+    close();
+    fd = gzopen( path, "rb" );
+    if ( fd == NULL ) {
+        printf("Cannot open: %s\n", path);
+        return false;
+    }
+    gzbuffer( fd, buf_size );
+    buf = (uint8_t *)malloc( buf_size );
+    head = tail = 0;
+    eof = false;
+    packets = bad_checksum = imu_count = gps_count = 0;
+    return true;
+}
+
+void LogReader::close() {
+    if ( fd != NULL ) {
+        gzclose( fd );
+        fd = NULL;
+    }
+    if ( buf != NULL ) {
+        free( buf );
+        buf = NULL;
+    }
+    eof = true;
+}
+
+// make sure at least 'need' unparsed bytes are buffered
+bool LogReader::fill( int need ) {
+    if ( tail - head >= need ) {
+        return true;
+    }
+    if ( eof ) {
+        return false;
+    }
+    int remain = tail - head;
+    memmove( buf, buf + head, remain );
+    head = 0;
+    tail = remain;
+    while ( tail < need ) {
+        int result = gzread( fd, buf + tail, buf_size - tail );
+        if ( result <= 0 ) {
+            eof = true;
+            break;
+        }
+        tail += result;
+    }
+    return tail - head >= need;
+}
+
+// simple 2-byte checksum (matches comms/serial_parser.py)
+static void checksum( uint8_t id, const uint8_t *payload, uint8_t size,
+                      uint8_t *c0, uint8_t *c1 )
+{
+    uint8_t a = id;
+    uint8_t b = a;
+    a += size;
+    b += a;
+    for ( int i = 0; i < size; i++ ) {
+        a += payload[i];
+        b += a;
+    }
+    *c0 = a;
+    *c1 = b;
+}
+
+LogRecordType LogReader::next( LogRecord *rec ) {
+    while ( fill(4) ) {
+        if ( buf[head] != START_OF_MSG0 || buf[head+1] != START_OF_MSG1 ) {
+            // resync
+            head++;
+            continue;
+        }
+        uint8_t id = buf[head+2];
+        uint8_t len = buf[head+3];
+        if ( !fill(4 + len + 2) ) {
+            break;
+        }
+        uint8_t *payload = buf + head + 4;
+        uint8_t c0, c1;
+        checksum( id, payload, len, &c0, &c1 );
+        if ( c0 != payload[len] || c1 != payload[len+1] ) {
+            bad_checksum++;
+            head++;
+            continue;
+        }
+        head += 4 + len + 2;
+        packets++;
+        if ( decode(id, payload, len, rec) ) {
+            return rec->type;
+        }
+    }
+    rec->type = LOG_END;
+    return LOG_END;
+}
+
+bool LogReader::decode( uint8_t id, uint8_t *payload, int len,
+                        LogRecord *rec )
+{
+    if ( id == message::imu_v5_id ) {
+        message::imu_v5_t imu;
+        if ( len != sizeof(message::imu_v5_t::_compact_t)
+             || !imu.unpack(payload, len) || imu.index != 0 ) {
+            return false;
+        }
+        rec->imu.time = imu.timestamp_sec;
+        rec->imu.p = imu.p_rad_sec;
+        rec->imu.q = imu.q_rad_sec;
+        rec->imu.r = imu.r_rad_sec;
+        rec->imu.ax = imu.ax_mps_sec;
+        rec->imu.ay = imu.ay_mps_sec;
+        rec->imu.az = imu.az_mps_sec;
+        rec->imu.hx = imu.hx;
+        rec->imu.hy = imu.hy;
+        rec->imu.hz = imu.hz;
+        rec->imu.temp = imu.temp_C;
+    } else if ( id == message::imu_v4_id ) {
+        message::imu_v4_t imu;
+        if ( len != sizeof(message::imu_v4_t::_compact_t)
+             || !imu.unpack(payload, len) || imu.index != 0 ) {
+            return false;
+        }
+        rec->imu.time = imu.timestamp_sec;
+        rec->imu.p = imu.p_rad_sec;
+        rec->imu.q = imu.q_rad_sec;
+        rec->imu.r = imu.r_rad_sec;
+        rec->imu.ax = imu.ax_mps_sec;
+        rec->imu.ay = imu.ay_mps_sec;
+        rec->imu.az = imu.az_mps_sec;
+        rec->imu.hx = imu.hx;
+        rec->imu.hy = imu.hy;
+        rec->imu.hz = imu.hz;
+        rec->imu.temp = imu.temp_C;
+    } else if ( id == message::imu_v3_id ) {
+        message::imu_v3_t imu;
+        if ( len != sizeof(message::imu_v3_t::_compact_t)
+             || !imu.unpack(payload, len) || imu.index != 0 ) {
+            return false;
+        }
+        rec->imu.time = imu.timestamp_sec;
+        rec->imu.p = imu.p_rad_sec;
+        rec->imu.q = imu.q_rad_sec;
+        rec->imu.r = imu.r_rad_sec;
+        rec->imu.ax = imu.ax_mps_sec;
+        rec->imu.ay = imu.ay_mps_sec;
+        rec->imu.az = imu.az_mps_sec;
+        rec->imu.hx = imu.hx;
+        rec->imu.hy = imu.hy;
+        rec->imu.hz = imu.hz;
+        rec->imu.temp = imu.temp_C;
+    } else if ( id == message::gps_v4_id ) {
+        message::gps_v4_t gps;
+        if ( len != sizeof(message::gps_v4_t::_compact_t)
+             || !gps.unpack(payload, len) || gps.index != 0 ) {
+            return false;
+        }
+        rec->gps.time = gps.timestamp_sec;
+        rec->gps.unix_sec = gps.unixtime_sec;
+        rec->gps.lat = gps.latitude_deg;
+        rec->gps.lon = gps.longitude_deg;
+        rec->gps.alt = gps.altitude_m;
+        rec->gps.vn = gps.vn_ms;
+        rec->gps.ve = gps.ve_ms;
+        rec->gps.vd = gps.vd_ms;
+        rec->gps.sats = gps.satellites;
+        rec->gps_fix = gps.fix_type >= 3;
+    } else if ( id == message::gps_v3_id ) {
+        message::gps_v3_t gps;
+        if ( len != sizeof(message::gps_v3_t::_compact_t)
+             || !gps.unpack(payload, len) || gps.index != 0 ) {
+            return false;
+        }
+        rec->gps.time = gps.timestamp_sec;
+        rec->gps.unix_sec = gps.unixtime_sec;
+        rec->gps.lat = gps.latitude_deg;
+        rec->gps.lon = gps.longitude_deg;
+        rec->gps.alt = gps.altitude_m;
+        rec->gps.vn = gps.vn_ms;
+        rec->gps.ve = gps.ve_ms;
+        rec->gps.vd = gps.vd_ms;
+        rec->gps.sats = gps.satellites;
+        rec->gps_fix = gps.fix_type >= 3;
+    } else if ( id == message::gps_v2_id ) {
+        message::gps_v2_t gps;
+        if ( len != sizeof(message::gps_v2_t::_compact_t)
+             || !gps.unpack(payload, len) || gps.index != 0 ) {
+            return false;
+        }
+        rec->gps.time = gps.timestamp_sec;
+        rec->gps.unix_sec = gps.unixtime_sec;
+        rec->gps.lat = gps.latitude_deg;
+        rec->gps.lon = gps.longitude_deg;
+        rec->gps.alt = gps.altitude_m;
+        rec->gps.vn = gps.vn_ms;
+        rec->gps.ve = gps.ve_ms;
+        rec->gps.vd = gps.vd_ms;
+        rec->gps.sats = gps.satellites;
+        rec->gps_fix = gps.status == 2;
+    } else {
+        return false;
+    }
+
+    if ( id == message::gps_v2_id || id == message::gps_v3_id
+         || id == message::gps_v4_id ) {
+        rec->type = LOG_GPS;
+        gps_count++;
+    } else {
+        rec->type = LOG_IMU;
+        imu_count++;
+    }
+    return true;
+}
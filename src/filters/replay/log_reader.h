@@ -0,0 +1,89 @@
+// log_reader.h -- stream imu and gps records out of a flight.dat.gz
+//                 log written by comms/logging.py
+//
+// The log is a gzip'd sequence of serial_parser packets:
+//
+//   147 224 <id> <len> <payload[len]> <cksum0> <cksum1>
+//
+// Payloads use the aura_messages layouts.  log_messages.h is the
+// autogen.py output for the subset of tools/messages/aura_messages.json
+// that the replay needs (imu_v3-v5, gps_v2-v4, filter_v5.)  Other
+// packet types are skipped.
+
+#pragma once
+
+#include <stdint.h>
+#include <zlib.h>
+
+#include <vector>
+using std::vector;
+
+#include "../nav_common/structs.h"
+
+enum LogRecordType {
+    LOG_END = 0,                // end of file (or read error)
+    LOG_IMU,
+    LOG_GPS
+};
+
+struct LogRecord {
+    LogRecordType type;
+    IMUdata imu;
+    GPSdata gps;                // lat/lon in degrees (as logged)
+    bool gps_fix;               // gps reports a 3d fix
+};
+
+class LogReader {
+
+public:
+
+    LogReader();
+    ~LogReader();
+
+    bool open( const char *path );
+    void close();
+
+    // advance to the next imu or gps record (sensor index 0 only)
+    LogRecordType next( LogRecord *rec );
+
+    // statistics
+    long packets;               // valid packets seen (all types)
+    long bad_checksum;          // dropped due to checksum mismatch
+    long imu_count;
+    long gps_count;
+
+private:
+
+    gzFile fd;
+    uint8_t *buf;
+    int head;                   // next unparsed byte
+    int tail;                   // end of valid data
+    bool eof;
+
+    bool fill( int need );
+    bool decode( uint8_t id, uint8_t *payload, int len, LogRecord *rec );
+};
+
+// cursor over a stream already decoded into memory.  The records are
+// only read, so any number of cursors can share one vector across
+// threads.
+class LogBuffer {
+
+public:
+
+    LogBuffer( const vector<LogRecord> &r ): records(r), pos(0) {}
+
+    LogRecordType next( LogRecord *rec ) {
+        if ( pos >= records.size() ) {
+            rec->type = LOG_END;
+            return LOG_END;
+        }
+        *rec = records[pos++];
+        return rec->type;
+    }
+
+private:
+
+    const vector<LogRecord> &records;
+    size_t pos;
+};
@@ -0,0 +1,99 @@
+// nav_writer.cpp -- write replayed (or smoothed) navigation solutions
+//                   as csv rows or filter_v5 packets
+//
+
+#include <math.h>
+
+#include "../nav_common/constants.h"
+
+#include "log_messages.h"
+#include "nav_writer.h"
+
+bool NavWriter::open( const string &path, ReplayFormat fmt ) {
+    format = fmt;
+    if ( format == REPLAY_NONE ) {
+        return true;
+    }
+    fd = fopen( path.c_str(), format == REPLAY_CSV ? "w" : "wb" );
+    if ( fd == NULL ) {
+        printf("Cannot open: %s\n", path.c_str());
+        return false;
+    }
+    if ( format == REPLAY_CSV ) {
+        fprintf( fd, "timestamp,latitude_deg,longitude_deg,altitude_m,vn_ms,ve_ms,vd_ms,roll_deg,pitch_deg,heading_deg,p_bias,q_bias,r_bias,ax_bias,ay_bias,az_bias,max_pos_cov,max_vel_cov,max_att_cov,status\n" );
+    }
+    return true;
+}
+
+void NavWriter::close() {
+    if ( fd != NULL ) {
+        fclose( fd );
+        fd = NULL;
+    }
+}
+
+void NavWriter::write( float time, const NAVdata &nav ) {
+    double psi = nav.psi;
+    if ( psi < 0 ) { psi += M_PI*2.0; }
+    if ( psi > M_PI*2.0 ) { psi -= M_PI*2.0; }
+    float max_pos_cov = fmax( nav.Pp0, fmax(nav.Pp1, nav.Pp2) );
+    float max_vel_cov = fmax( nav.Pv0, fmax(nav.Pv1, nav.Pv2) );
+    float max_att_cov = fmax( nav.Pa0, fmax(nav.Pa1, nav.Pa2) );
+    int status = ( nav.err_type == data_valid || nav.err_type == TU_only
+                   || nav.err_type == gps_aided ) ? 2 : 1;
+    if ( format == REPLAY_CSV ) {
+        fprintf( fd, "%.4f,%.10f,%.10f,%.2f,%.4f,%.4f,%.4f,%.3f,%.3f,%.3f,%.6f,%.6f,%.6f,%.5f,%.5f,%.5f,%.4f,%.5f,%.6f,%d\n",
+                 time, nav.lat * R2D, nav.lon * R2D, nav.alt,
+                 nav.vn, nav.ve, nav.vd,
+                 nav.phi * R2D, nav.the * R2D, psi * R2D,
+                 nav.gbx, nav.gby, nav.gbz, nav.abx, nav.aby, nav.abz,
+                 max_pos_cov, max_vel_cov, max_att_cov, status );
+    } else {
+        // same clamping as the onboard filter_v5 packer
+        if ( max_pos_cov > 655.0 ) { max_pos_cov = 655.0; }
+        if ( max_vel_cov > 65.5 ) { max_vel_cov = 65.5; }
+        if ( max_att_cov > 6.55 ) { max_att_cov = 6.55; }
+        message::filter_v5_t msg;
+        msg.index = 0;
+        msg.timestamp_sec = time;
+        msg.latitude_deg = nav.lat * R2D;
+        msg.longitude_deg = nav.lon * R2D;
+        msg.altitude_m = nav.alt;
+        msg.vn_ms = nav.vn;
+        msg.ve_ms = nav.ve;
+        msg.vd_ms = nav.vd;
+        msg.roll_deg = nav.phi * R2D;
+        msg.pitch_deg = nav.the * R2D;
+        msg.yaw_deg = psi * R2D;
+        msg.p_bias = nav.gbx;
+        msg.q_bias = nav.gby;
+        msg.r_bias = nav.gbz;
+        msg.ax_bias = nav.abx;
+        msg.ay_bias = nav.aby;
+        msg.az_bias = nav.abz;
+        msg.max_pos_cov = max_pos_cov;
+        msg.max_vel_cov = max_vel_cov;
+        msg.max_att_cov = max_att_cov;
+        msg.sequence_num = sequence_num++;
+        msg.status = status;
+        msg.pack();
+        write_packet( msg.id, msg.payload, msg.len );
+    }
+}
+
+// wrap the payload the same way as comms/serial_parser.py
+void NavWriter::write_packet( uint8_t id, const uint8_t *payload, uint8_t len ) {
+    uint8_t header[4] = { 147, 224, id, len };
+    uint8_t c0 = id;
+    uint8_t c1 = c0;
+    c0 += len;
+    c1 += c0;
+    for ( int i = 0; i < len; i++ ) {
+        c0 += payload[i];
+        c1 += c0;
+    }
+    uint8_t cksum[2] = { c0, c1 };
+    fwrite( header, 1, 4, fd );
+    fwrite( payload, 1, len, fd );
+    fwrite( cksum, 1, 2, fd );
+}
@@ -0,0 +1,45 @@
+// nav_writer.h -- write replayed (or smoothed) navigation solutions as
+//                 csv rows or filter_v5 packets
+//
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <string>
+using std::string;
+
+#include "../nav_common/structs.h"
+#include "replay.h"
+
+class NavWriter {
+
+public:
+
+    NavWriter(): fd(NULL), format(REPLAY_NONE), sequence_num(0) {}
+    ~NavWriter() { close(); }
+
+    bool open( const string &path, ReplayFormat fmt );
+    void close();
+
+    // replay_filter() sink interface
+    template <class Filter>
+    void output( float time, Filter &filter ) {
+        if ( fd != NULL ) {
+            write( time, filter.get_nav() );
+        }
+    }
+    template <class Filter>
+    void gps_update( Filter &filter ) {}
+
+    void write( float time, const NAVdata &nav );
+
+private:
+
+    FILE *fd;
+    ReplayFormat format;
+    uint8_t sequence_num;
+
+    void write_packet( uint8_t id, const uint8_t *payload, uint8_t len );
+};
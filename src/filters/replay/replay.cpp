@@ -0,0 +1,341 @@
+// replay.cpp -- run a flight.dat.gz log through the 15 state EKF as
+//               fast as possible
+//
+
+#ifdef HAVE_PYBIND11
+  #include <pybind11/pybind11.h>
+  namespace py = pybind11;
+#endif
+
+#include <math.h>
+#include <stdio.h>
+
+#include "util/timing.h"
+
+#include "../nav_common/constants.h"
+#include "../nav_ekf15/EKF_15state.h"
+
+#include "log_reader.h"
+#include "nav_writer.h"
+#include "replay.h"
+#include "smoother.h"
+#include "sweep.h"
+
+ReplayOptions::ReplayOptions():
+    format(REPLAY_NONE),
+    mag(false),
+    sequential(false),
+    gps_lag(0.0),
+    cov_decimation(1)
+{
+    EKF15 ekf;
+    config = ekf.get_config();
+}
+
+bool replay_set_config( NAVconfig *config, const string &name, float value ) {
+    if ( name == "sig_w_ax" ) { config->sig_w_ax = value; }
+    else if ( name == "sig_w_ay" ) { config->sig_w_ay = value; }
+    else if ( name == "sig_w_az" ) { config->sig_w_az = value; }
+    else if ( name == "sig_w_gx" ) { config->sig_w_gx = value; }
+    else if ( name == "sig_w_gy" ) { config->sig_w_gy = value; }
+    else if ( name == "sig_w_gz" ) { config->sig_w_gz = value; }
+    else if ( name == "sig_a_d" ) { config->sig_a_d = value; }
+    else if ( name == "tau_a" ) { config->tau_a = value; }
+    else if ( name == "sig_g_d" ) { config->sig_g_d = value; }
+    else if ( name == "tau_g" ) { config->tau_g = value; }
+    else if ( name == "sig_gps_p_ne" ) { config->sig_gps_p_ne = value; }
+    else if ( name == "sig_gps_p_d" ) { config->sig_gps_p_d = value; }
+    else if ( name == "sig_gps_v_ne" ) { config->sig_gps_v_ne = value; }
+    else if ( name == "sig_gps_v_d" ) { config->sig_gps_v_d = value; }
+    else if ( name == "sig_mag" ) { config->sig_mag = value; }
+    else {
+        return false;
+    }
+    return true;
+}
+
+template <class Filter>
+static void run( LogReader &reader, const ReplayOptions &options,
+                 NavWriter &writer, ReplayStats *stats )
+{
+    Filter filter;
+    filter.set_config( options.config );
+    filter.set_sequential_update( options.sequential );
+    filter.set_gps_lag( options.gps_lag );
+    filter.set_cov_decimation( options.cov_decimation );
+    replay_filter( reader, filter, writer, stats );
+
+    EKFTiming timing = filter.get_timing();
+    if ( timing.mech_count > 0 ) {
+        stats->mech_us = timing.mech_sec * 1000000.0 / timing.mech_count;
+    }
+    if ( timing.cov_count > 0 ) {
+        stats->cov_us = timing.cov_sec * 1000000.0 / timing.cov_count;
+    }
+}
+
+bool replay_load( const string &log_path, vector<LogRecord> *records,
+                  ReplayStats *stats )
+{
+    *stats = ReplayStats();
+
+    LogReader reader;
+    if ( !reader.open(log_path.c_str()) ) {
+        return false;
+    }
+    double start = get_Time();
+    records->clear();
+    LogRecord rec;
+    double first_imu_time = -1.0;
+    while ( reader.next(&rec) != LOG_END ) {
+        records->push_back( rec );
+        if ( rec.type == LOG_IMU ) {
+            if ( first_imu_time < 0.0 ) {
+                first_imu_time = rec.imu.time;
+            }
+            stats->flight_sec = rec.imu.time - first_imu_time;
+        }
+    }
+    stats->wall_sec = get_Time() - start;
+
+    stats->imu_records = reader.imu_count;
+    stats->gps_records = reader.gps_count;
+    stats->records = reader.imu_count + reader.gps_count;
+    stats->bad_checksum = reader.bad_checksum;
+    if ( stats->wall_sec > 0.0 ) {
+        stats->records_per_sec = stats->records / stats->wall_sec;
+        stats->realtime_factor = stats->flight_sec / stats->wall_sec;
+    }
+    return true;
+}
+
+bool replay_log( const ReplayOptions &options, ReplayStats *stats ) {
+    *stats = ReplayStats();
+
+    LogReader reader;
+    if ( !reader.open(options.log_path.c_str()) ) {
+        return false;
+    }
+    NavWriter writer;
+    if ( !writer.open(options.output_path, options.format) ) {
+        return false;
+    }
+
+    double start = get_Time();
+    if ( options.mag ) {
+        run<EKF15_mag>( reader, options, writer, stats );
+    } else {
+        run<EKF15>( reader, options, writer, stats );
+    }
+    writer.close();
+    stats->wall_sec = get_Time() - start;
+
+    stats->imu_records = reader.imu_count;
+    stats->gps_records = reader.gps_count;
+    stats->records = reader.imu_count + reader.gps_count;
+    stats->bad_checksum = reader.bad_checksum;
+    if ( stats->wall_sec > 0.0 ) {
+        stats->records_per_sec = stats->records / stats->wall_sec;
+        stats->realtime_factor = stats->flight_sec / stats->wall_sec;
+    }
+    return true;
+}
+
+#ifdef HAVE_PYBIND11
+
+// run(log, output="", format="", mag=False, sequential=False,
+//     gps_lag=0.0, config={}, cov_decimation=1)
+// returns a dict of replay statistics.  The output format defaults to
+// csv for a .csv output path and binary (filter_v5 packets) otherwise.
+static py::dict py_replay_run( string log_path, string output_path,
+                               string format, bool mag, bool sequential,
+                               float gps_lag, py::dict config,
+                               int cov_decimation )
+{
+    ReplayOptions options;
+    options.log_path = log_path;
+    options.output_path = output_path;
+    options.mag = mag;
+    options.sequential = sequential;
+    options.gps_lag = gps_lag;
+    options.cov_decimation = cov_decimation;
+    if ( output_path == "" ) {
+        options.format = REPLAY_NONE;
+    } else if ( format == "csv" || (format == "" && output_path.size() > 4
+                && output_path.substr(output_path.size() - 4) == ".csv") ) {
+        options.format = REPLAY_CSV;
+    } else {
+        options.format = REPLAY_BIN;
+    }
+    for ( auto item: config ) {
+        string name = py::str(item.first);
+        if ( !replay_set_config(&options.config, name,
+                                item.second.cast<float>()) ) {
+            throw py::key_error("unknown NAVconfig field: " + name);
+        }
+    }
+
+    ReplayStats stats;
+    bool result;
+    {
+        py::gil_scoped_release release;
+        result = replay_log( options, &stats );
+    }
+    if ( !result ) {
+        throw std::runtime_error("replay failed: " + log_path);
+    }
+
+    py::dict d;
+    d["records"] = stats.records;
+    d["imu_records"] = stats.imu_records;
+    d["gps_records"] = stats.gps_records;
+    d["nav_records"] = stats.nav_records;
+    d["bad_checksum"] = stats.bad_checksum;
+    d["flight_sec"] = stats.flight_sec;
+    d["wall_sec"] = stats.wall_sec;
+    d["records_per_sec"] = stats.records_per_sec;
+    d["realtime_factor"] = stats.realtime_factor;
+    d["mech_us"] = stats.mech_us;
+    d["cov_us"] = stats.cov_us;
+    return d;
+}
+
+// smooth(log, output, format="", mag=False, sequential=False,
+//        cov_decimation=1, scratch_dir="/tmp", config={})
+// runs the forward filter and the backward RTS pass over the log and
+// writes the smoothed solution (csv for a .csv output path, filter_v5
+// packets otherwise.)  Returns a dict of statistics.
+static py::dict py_replay_smooth( string log_path, string output_path,
+                                  string format, bool mag, bool sequential,
+                                  int cov_decimation, string scratch_dir,
+                                  py::dict config )
+{
+    SmoothOptions options;
+    options.log_path = log_path;
+    options.output_path = output_path;
+    options.mag = mag;
+    options.sequential = sequential;
+    options.cov_decimation = cov_decimation;
+    options.scratch_dir = scratch_dir;
+    if ( format == "csv" || (format == "" && output_path.size() > 4
+         && output_path.substr(output_path.size() - 4) == ".csv") ) {
+        options.format = REPLAY_CSV;
+    } else {
+        options.format = REPLAY_BIN;
+    }
+    for ( auto item: config ) {
+        string name = py::str(item.first);
+        if ( !replay_set_config(&options.config, name,
+                                item.second.cast<float>()) ) {
+            throw py::key_error("unknown NAVconfig field: " + name);
+        }
+    }
+
+    SmoothStats stats;
+    bool result;
+    {
+        py::gil_scoped_release release;
+        result = smooth_log( options, &stats );
+    }
+    if ( !result ) {
+        throw std::runtime_error("smoother failed: " + log_path);
+    }
+
+    py::dict d;
+    d["records"] = stats.records;
+    d["imu_records"] = stats.imu_records;
+    d["gps_records"] = stats.gps_records;
+    d["bad_checksum"] = stats.bad_checksum;
+    d["steps"] = stats.steps;
+    d["gps_updates"] = stats.gps_updates;
+    d["flight_sec"] = stats.flight_sec;
+    d["forward_sec"] = stats.forward_sec;
+    d["backward_sec"] = stats.backward_sec;
+    d["output_sec"] = stats.output_sec;
+    d["scratch_mb"] = stats.scratch_mb;
+    return d;
+}
+
+// sweep(log, configs, threads=0, mag=False, sequential=False,
+//       gps_lag=0.0, cov_decimation=1, batch=0) runs
+// every config (a dict of NAVconfig overrides) over the log and
+// returns a list of result dicts ranked best first.  batch only takes
+// effect with sequential=True (see sweep.h.)
+static py::list py_replay_sweep( string log_path, py::list configs,
+                                 int threads, bool mag, bool sequential,
+                                 float gps_lag, int cov_decimation,
+                                 int batch )
+{
+    ReplayOptions defaults;
+    vector<NAVconfig> navconfigs;
+    for ( auto item: configs ) {
+        NAVconfig config = defaults.config;
+        for ( auto field: item.cast<py::dict>() ) {
+            string name = py::str(field.first);
+            if ( !replay_set_config(&config, name,
+                                    field.second.cast<float>()) ) {
+                throw py::key_error("unknown NAVconfig field: " + name);
+            }
+        }
+        navconfigs.push_back( config );
+    }
+
+    SweepOptions options;
+    options.threads = threads;
+    options.mag = mag;
+    options.sequential = sequential;
+    options.gps_lag = gps_lag;
+    options.cov_decimation = cov_decimation;
+    options.batch = batch;
+
+    vector<SweepResult> results;
+    bool loaded;
+    {
+        py::gil_scoped_release release;
+        vector<LogRecord> records;
+        ReplayStats load;
+        loaded = replay_load( log_path, &records, &load );
+        if ( loaded ) {
+            results = sweep_run( records, navconfigs, options );
+        }
+    }
+    if ( !loaded ) {
+        throw std::runtime_error("cannot load: " + log_path);
+    }
+
+    py::list l;
+    for ( size_t i = 0; i < results.size(); i++ ) {
+        py::dict d;
+        d["index"] = results[i].index;
+        d["gps_updates"] = results[i].gps_updates;
+        d["dof"] = results[i].dof;
+        d["nis_mean"] = results[i].nis_mean;
+        d["nis_in_bound"] = results[i].nis_in_bound;
+        d["pos_rms"] = results[i].pos_rms;
+        d["vel_rms"] = results[i].vel_rms;
+        d["score"] = results[i].score;
+        l.append( d );
+    }
+    return l;
+}
+
+PYBIND11_MODULE(replay, m) {
+    m.doc() = "native flight.dat.gz replay through the 15 state ekf";
+    m.def("run", &py_replay_run,
+          py::arg("log"), py::arg("output") = "", py::arg("format") = "",
+          py::arg("mag") = false, py::arg("sequential") = false,
+          py::arg("gps_lag") = 0.0, py::arg("config") = py::dict(),
+          py::arg("cov_decimation") = 1);
+    m.def("sweep", &py_replay_sweep,
+          py::arg("log"), py::arg("configs"), py::arg("threads") = 0,
+          py::arg("mag") = false, py::arg("sequential") = false,
+          py::arg("gps_lag") = 0.0, py::arg("cov_decimation") = 1,
+          py::arg("batch") = 0);
+    m.def("smooth", &py_replay_smooth,
+          py::arg("log"), py::arg("output"), py::arg("format") = "",
+          py::arg("mag") = false, py::arg("sequential") = false,
+          py::arg("cov_decimation") = 1, py::arg("scratch_dir") = "/tmp",
+          py::arg("config") = py::dict());
+}
+
+#endif // HAVE_PYBIND11
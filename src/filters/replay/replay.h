@@ -0,0 +1,142 @@
+// replay.h -- run a flight.dat.gz log through the 15 state EKF as fast
+//             as possible (for tuning the NAVconfig noise parameters)
+//
+// The replay follows the same sequencing as the onboard filter
+// (nav_ekf15/aura_interface.cpp): the filter is initialized once the
+// gps has held a 3d fix for 10 seconds, then every imu record is a
+// time update and every new gps record is a measurement update at the
+// following imu record.
+
+#pragma once
+
+#include <mutex>
+#include <string>
+using std::string;
+
+#include "../nav_common/structs.h"
+#include "../nav_ekf15/EKF_15state_batch.h"
+#include "log_reader.h"
+
+// matches the gps_helper settle time before the filter is initialized
+static const double replay_gps_settle = 10.0;
+
+enum ReplayFormat {
+    REPLAY_NONE = 0,            // run the filter, write nothing
+    REPLAY_CSV,                 // one text row per imu record
+    REPLAY_BIN                  // filter_v5 packets (same framing as the log)
+};
+
+struct ReplayOptions {
+    string log_path;
+    string output_path;
+    ReplayFormat format;
+    bool mag;                   // EKF15_mag instead of EKF15
+    bool sequential;            // sequential scalar measurement update
+    float gps_lag;              // sec, gps latency (0 = fuse as current)
+    int cov_decimation;         // imu samples per covariance propagation
+    NAVconfig config;
+
+    ReplayOptions();
+};
+
+struct ReplayStats {
+    long records;               // imu + gps records consumed
+    long imu_records;
+    long gps_records;
+    long nav_records;           // filter outputs (after init)
+    long bad_checksum;
+    double flight_sec;          // span of imu time in the log
+    double wall_sec;            // elapsed processing time
+    double records_per_sec;
+    double realtime_factor;     // flight_sec / wall_sec
+    double mech_us;             // average strapdown mechanization step
+    double cov_us;              // average covariance propagation step
+};
+
+// decode the whole imu/gps stream of a log into memory
+bool replay_load( const string &log_path, vector<LogRecord> *records,
+                  ReplayStats *stats );
+
+// set a NAVconfig field by name (e.g. "sig_w_ax"), false if unknown
+bool replay_set_config( NAVconfig *config, const string &name, float value );
+
+// replay the log, true on success
+bool replay_log( const ReplayOptions &options, ReplayStats *stats );
+
+// a measurement update with the fix received at imu sample imu (the
+// batch filter takes no imu sample)
+template <class Filter>
+inline void replay_measurement_update( Filter &filter, IMUdata imu,
+                                       GPSdata gps )
+{
+    filter.measurement_update( imu, gps );
+}
+
+inline void replay_measurement_update( EKF15Batch &filter, IMUdata,
+                                       GPSdata gps )
+{
+    filter.measurement_update( gps );
+}
+
+// The replay sequencing shared by the single run and the sweep.
+// Source provides next(LogRecord *), Sink is called with
+// output(time, filter) after every filter step (once initialized) and
+// with gps_update(filter) after every measurement update.  Filter init
+// computes the magnetic field reference with calc_magvar() which is not
+// reentrant, so concurrent callers pass a common init_lock.
+template <class Filter, class Source, class Sink>
+void replay_filter( Source &source, Filter &filter, Sink &sink,
+                    ReplayStats *stats, std::mutex *init_lock = NULL )
+{
+    LogRecord rec;
+    IMUdata imu;
+    GPSdata gps;
+    bool have_imu = false;
+    bool have_gps = false;
+    bool nav_inited = false;
+    double gps_acq_time = -1.0;
+    double last_gps_time = 0.0;
+    double first_imu_time = 0.0;
+
+    while ( source.next(&rec) != LOG_END ) {
+        if ( rec.type == LOG_GPS ) {
+            gps = rec.gps;
+            have_gps = true;
+            if ( rec.gps_fix && gps_acq_time < 0.0 ) {
+                gps_acq_time = gps.time;
+            }
+            continue;
+        }
+
+        imu = rec.imu;
+        if ( !have_imu ) {
+            first_imu_time = imu.time;
+            have_imu = true;
+        }
+        stats->flight_sec = imu.time - first_imu_time;
+
+        if ( nav_inited ) {
+            filter.time_update( imu );
+            if ( gps.time > last_gps_time ) {
+                last_gps_time = gps.time;
+                replay_measurement_update( filter, imu, gps );
+                sink.gps_update( filter );
+            }
+        } else if ( have_gps && gps_acq_time >= 0.0
+                    && gps.time - gps_acq_time >= replay_gps_settle
+                    && imu.time - gps.time < 1.0 ) {
+            if ( init_lock != NULL ) {
+                std::lock_guard<std::mutex> lock( *init_lock );
+                filter.init( imu, gps );
+            } else {
+                filter.init( imu, gps );
+            }
+            last_gps_time = gps.time;
+            nav_inited = true;
+        }
+        if ( nav_inited ) {
+            sink.output( imu.time, filter );
+            stats->nav_records++;
+        }
+    }
+}
@@ -0,0 +1,92 @@
+// replay_main.cpp -- command line front end for the native ekf replay
+//
+// g++ -O3 -I../.. replay_main.cpp replay.cpp nav_writer.cpp
+//     log_reader.cpp ../nav_ekf15/EKF_15state.cpp
+//     ../nav_ekf15/covariance.cpp ../nav_common/nav_functions.cpp
+//     ../nav_common/coremag.c ../nav_common/magcache.cpp
+//     ../../util/timing.cpp -lz -o replay
+//
+// replay [--mag] [--sequential] [--gps-lag sec] [--cov-decimation n]
+//        [--csv | --bin] [--set name=value ...] flight.dat.gz [output]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "replay.h"
+
+static void usage( const char *prog ) {
+    printf("usage: %s [--mag] [--sequential] [--gps-lag sec] [--cov-decimation n] [--csv | --bin] [--set name=value ...] flight.dat.gz [output]\n", prog);
+    printf("  --mag         use the gps + magnetometer filter (EKF15_mag)\n");
+    printf("  --sequential  sequential scalar measurement update\n");
+    printf("  --gps-lag     gps latency in seconds (fuse fixes at their time of validity)\n");
+    printf("  --cov-decimation  imu samples per covariance propagation\n");
+    printf("  --csv         write csv output (default for a .csv output name)\n");
+    printf("  --bin         write filter_v5 packets (default otherwise)\n");
+    printf("  --set         override a NAVconfig field, e.g. --set sig_w_ax=0.1\n");
+}
+
+int main( int argc, char **argv ) {
+    ReplayOptions options;
+    string format = "";
+    int i = 1;
+    for ( ; i < argc && argv[i][0] == '-'; i++ ) {
+        if ( !strcmp(argv[i], "--mag") ) {
+            options.mag = true;
+        } else if ( !strcmp(argv[i], "--sequential") ) {
+            options.sequential = true;
+        } else if ( !strcmp(argv[i], "--gps-lag") && i + 1 < argc ) {
+            options.gps_lag = atof( argv[++i] );
+        } else if ( !strcmp(argv[i], "--cov-decimation") && i + 1 < argc ) {
+            options.cov_decimation = atoi( argv[++i] );
+        } else if ( !strcmp(argv[i], "--csv") ) {
+            format = "csv";
+        } else if ( !strcmp(argv[i], "--bin") ) {
+            format = "bin";
+        } else if ( !strcmp(argv[i], "--set") && i + 1 < argc ) {
+            i++;
+            const char *eq = strchr( argv[i], '=' );
+            if ( eq == NULL || !replay_set_config(&options.config,
+                                                  string(argv[i], eq - argv[i]),
+                                                  atof(eq + 1)) ) {
+                printf("Unknown config setting: %s\n", argv[i]);
+                return 1;
+            }
+        } else {
+            usage( argv[0] );
+            return 1;
+        }
+    }
+    if ( i >= argc ) {
+        usage( argv[0] );
+        return 1;
+    }
+    options.log_path = argv[i++];
+    if ( i < argc ) {
+        options.output_path = argv[i++];
+        size_t n = options.output_path.size();
+        if ( format == "csv" || (format == "" && n > 4
+             && options.output_path.substr(n - 4) == ".csv") ) {
+            options.format = REPLAY_CSV;
+        } else {
+            options.format = REPLAY_BIN;
+        }
+    }
+
+    ReplayStats stats;
+    if ( !replay_log(options, &stats) ) {
+        return 1;
+    }
+
+    printf("records: %ld (imu: %ld gps: %ld) nav: %ld bad checksum: %ld\n",
+           stats.records, stats.imu_records, stats.gps_records,
+           stats.nav_records, stats.bad_checksum);
+    printf("flight: %.1f sec  wall: %.3f sec\n", stats.flight_sec,
+           stats.wall_sec);
+    printf("%.0f records/sec  %.1fx real time\n", stats.records_per_sec,
+           stats.realtime_factor);
+    printf("mechanization: %.2f us/step  covariance: %.2f us/step\n",
+           stats.mech_us, stats.cov_us);
+
+    return 0;
+}
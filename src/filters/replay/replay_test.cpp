@@ -0,0 +1,175 @@
+// replay_test.cpp -- write a synthetic flight.dat.gz and replay it
+//                    through both filter variants.
+//
+// g++ -O3 -I../.. replay_test.cpp replay.cpp nav_writer.cpp
+//     log_reader.cpp ../nav_ekf15/EKF_15state.cpp
+//     ../nav_ekf15/covariance.cpp ../nav_common/nav_functions.cpp
+//     ../nav_common/coremag.c ../nav_common/magcache.cpp
+//     ../../util/timing.cpp -lz -o replay_test
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <zlib.h>
+
+#include "../nav_common/constants.h"
+
+#include "log_messages.h"
+#include "log_reader.h"
+#include "replay.h"
+
+static const char *log_file = "/tmp/replay_test.dat.gz";
+static const char *csv_file = "/tmp/replay_test.csv";
+static const char *bin_file = "/tmp/replay_test.dat";
+
+static float noise(float sigma) {
+    // cheap approximately gaussian noise
+    float sum = 0.0;
+    for ( int i = 0; i < 12; i++ ) {
+        sum += drand48();
+    }
+    return (sum - 6.0) * sigma;
+}
+
+static void write_packet( gzFile fd, uint8_t id, uint8_t *payload,
+                          uint8_t len, bool corrupt = false )
+{
+    uint8_t header[4] = { 147, 224, id, len };
+    uint8_t c0 = id;
+    uint8_t c1 = c0;
+    c0 += len;
+    c1 += c0;
+    for ( int i = 0; i < len; i++ ) {
+        c0 += payload[i];
+        c1 += c0;
+    }
+    uint8_t cksum[2] = { c0, c1 };
+    if ( corrupt ) {
+        // flip a payload byte after the checksum is computed
+        payload[len / 2] ^= 0xff;
+    }
+    gzwrite( fd, header, 4 );
+    gzwrite( fd, payload, len );
+    gzwrite( fd, cksum, 2 );
+}
+
+// ten minutes of a stationary aircraft: 100hz imu_v5, 5hz gps_v4, 1hz
+// of an unrelated packet type and a few corrupted packets
+static void write_log() {
+    gzFile fd = gzopen( log_file, "wb" );
+    message::imu_v5_t imu;
+    message::gps_v4_t gps;
+    message::filter_v5_t other;
+    for ( int i = 0; i < 60000; i++ ) {
+        float t = i * 0.01;
+        imu.index = 0;
+        imu.timestamp_sec = t;
+        imu.p_rad_sec = noise(0.002);
+        imu.q_rad_sec = noise(0.002);
+        imu.r_rad_sec = noise(0.002);
+        imu.ax_mps_sec = noise(0.05);
+        imu.ay_mps_sec = noise(0.05);
+        imu.az_mps_sec = -9.81 + noise(0.05);
+        imu.hx = 0.3; imu.hy = 0.05; imu.hz = 0.5;
+        imu.ax_raw = imu.ay_raw = imu.az_raw = 0.0;
+        imu.hx_raw = imu.hy_raw = imu.hz_raw = 0.0;
+        imu.temp_C = 20.0;
+        imu.status = 0;
+        imu.pack();
+        write_packet( fd, imu.id, imu.payload, imu.len );
+        if ( i % 20 == 0 ) {
+            gps.index = 0;
+            gps.timestamp_sec = t;
+            gps.latitude_deg = 45.0 + noise(2.0e-5);
+            gps.longitude_deg = -93.0 + noise(2.0e-5);
+            gps.altitude_m = 300.0 + noise(4.0);
+            gps.vn_ms = noise(0.2);
+            gps.ve_ms = noise(0.2);
+            gps.vd_ms = noise(0.4);
+            gps.unixtime_sec = 1.6e9 + t;
+            gps.satellites = 9;
+            gps.horiz_accuracy_m = 2.0;
+            gps.vert_accuracy_m = 4.0;
+            gps.pdop = 1.5;
+            gps.fix_type = 3;
+            gps.pack();
+            // corrupt a few (the checksum should reject them)
+            write_packet( fd, gps.id, gps.payload, gps.len,
+                          i % 10000 == 20 );
+        }
+        if ( i % 100 == 50 ) {
+            other.pack();
+            write_packet( fd, other.id, other.payload, other.len );
+        }
+    }
+    gzclose( fd );
+}
+
+static bool check( const char *name, const ReplayOptions &options ) {
+    ReplayStats stats;
+    if ( !replay_log(options, &stats) ) {
+        printf("%s: replay failed\n", name);
+        return false;
+    }
+    printf("%s: records: %ld (imu: %ld gps: %ld) nav: %ld bad checksum: %ld\n",
+           name, stats.records, stats.imu_records, stats.gps_records,
+           stats.nav_records, stats.bad_checksum);
+    printf("%s: %.0f records/sec  %.1fx real time\n", name,
+           stats.records_per_sec, stats.realtime_factor);
+    return stats.imu_records == 60000 && stats.gps_records == 2994
+        && stats.bad_checksum == 6 && stats.nav_records > 58000;
+}
+
+// read back the binary output and check the final csv position
+static bool check_bin() {
+    LogReader reader;
+    reader.open( bin_file );
+    LogRecord rec;
+    while ( reader.next(&rec) != LOG_END );
+    printf("bin: %ld filter packets\n", reader.packets);
+    reader.close();
+
+    FILE *fd = fopen( csv_file, "r" );
+    char line[1024];
+    char last[1024] = "";
+    while ( fgets(line, sizeof(line), fd) != NULL ) {
+        memcpy( last, line, sizeof(line) );
+    }
+    fclose( fd );
+    double t, lat, lon, alt;
+    sscanf( last, "%lf,%lf,%lf,%lf", &t, &lat, &lon, &alt );
+    printf("csv final: t = %.2f lat = %.7f lon = %.7f alt = %.2f\n",
+           t, lat, lon, alt);
+    return reader.packets > 58000 && fabs(lat - 45.0) < 1.0e-4
+        && fabs(lon + 93.0) < 1.0e-4 && fabs(alt - 300.0) < 10.0;
+}
+
+int main() {
+    write_log();
+
+    ReplayOptions options;
+    options.log_path = log_file;
+    options.output_path = csv_file;
+    options.format = REPLAY_CSV;
+    bool result = check( "ekf15 csv", options );
+
+    options.output_path = bin_file;
+    options.format = REPLAY_BIN;
+    result = check( "ekf15 bin", options ) && result;
+    result = check_bin() && result;
+
+    options.output_path = "";
+    options.format = REPLAY_NONE;
+    options.sequential = true;
+    result = check( "ekf15 sequential", options ) && result;
+
+    options.mag = true;
+    result = check( "ekf15_mag sequential", options ) && result;
+
+    if ( !result ) {
+        printf("FAIL\n");
+        return 1;
+    }
+    printf("PASS\n");
+    return 0;
+}
@@ -0,0 +1,91 @@
+// smooth_main.cpp -- command line front end for the post flight
+//                    smoother
+//
+// g++ -O3 -I../.. smooth_main.cpp smoother.cpp nav_writer.cpp
+//     replay.cpp log_reader.cpp ../nav_ekf15/EKF_15state.cpp
+//     ../nav_ekf15/covariance.cpp ../nav_common/nav_functions.cpp
+//     ../nav_common/coremag.c ../nav_common/magcache.cpp
+//     ../../util/timing.cpp -lz -o smooth
+//
+// smooth [--mag] [--sequential] [--cov-decimation n] [--scratch dir]
+//        [--csv | --bin] [--set name=value ...] flight.dat.gz output
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "replay.h"
+#include "smoother.h"
+
+static void usage( const char *prog ) {
+    printf("usage: %s [--mag] [--sequential] [--cov-decimation n] [--scratch dir] [--csv | --bin] [--set name=value ...] flight.dat.gz output\n", prog);
+    printf("  --mag             use the gps + magnetometer filter (EKF15_mag)\n");
+    printf("  --sequential      sequential scalar measurement update\n");
+    printf("  --cov-decimation  imu samples per covariance (and output) step\n");
+    printf("  --scratch         directory for the scratch file (default /tmp)\n");
+    printf("  --csv             write csv output (default for a .csv output name)\n");
+    printf("  --bin             write filter_v5 packets (default otherwise)\n");
+    printf("  --set             override a NAVconfig field, e.g. --set sig_w_ax=0.1\n");
+}
+
+int main( int argc, char **argv ) {
+    SmoothOptions options;
+    string format = "";
+    int i = 1;
+    for ( ; i < argc && argv[i][0] == '-'; i++ ) {
+        if ( !strcmp(argv[i], "--mag") ) {
+            options.mag = true;
+        } else if ( !strcmp(argv[i], "--sequential") ) {
+            options.sequential = true;
+        } else if ( !strcmp(argv[i], "--cov-decimation") && i + 1 < argc ) {
+            options.cov_decimation = atoi( argv[++i] );
+        } else if ( !strcmp(argv[i], "--scratch") && i + 1 < argc ) {
+            options.scratch_dir = argv[++i];
+        } else if ( !strcmp(argv[i], "--csv") ) {
+            format = "csv";
+        } else if ( !strcmp(argv[i], "--bin") ) {
+            format = "bin";
+        } else if ( !strcmp(argv[i], "--set") && i + 1 < argc ) {
+            i++;
+            const char *eq = strchr( argv[i], '=' );
+            if ( eq == NULL || !replay_set_config(&options.config,
+                                                  string(argv[i], eq - argv[i]),
+                                                  atof(eq + 1)) ) {
+                printf("Unknown config setting: %s\n", argv[i]);
+                return 1;
+            }
+        } else {
+            usage( argv[0] );
+            return 1;
+        }
+    }
+    if ( i + 2 != argc ) {
+        usage( argv[0] );
+        return 1;
+    }
+    options.log_path = argv[i];
+    options.output_path = argv[i+1];
+    size_t n = options.output_path.size();
+    if ( format == "csv" || (format == "" && n > 4
+         && options.output_path.substr(n - 4) == ".csv") ) {
+        options.format = REPLAY_CSV;
+    } else {
+        options.format = REPLAY_BIN;
+    }
+
+    SmoothStats stats;
+    if ( !smooth_log(options, &stats) ) {
+        return 1;
+    }
+
+    printf("records: %ld (imu: %ld gps: %ld) bad checksum: %ld\n",
+           stats.records, stats.imu_records, stats.gps_records,
+           stats.bad_checksum);
+    printf("flight: %.1f sec  steps: %ld  gps updates: %ld  scratch: %.1f MB\n",
+           stats.flight_sec, stats.steps, stats.gps_updates,
+           stats.scratch_mb);
+    printf("forward: %.3f sec  backward: %.3f sec  output: %.3f sec\n",
+           stats.forward_sec, stats.backward_sec, stats.output_sec);
+
+    return 0;
+}
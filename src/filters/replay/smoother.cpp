@@ -0,0 +1,322 @@
+// smoother.cpp -- fixed interval Rauch-Tung-Striebel smoother for post
+//                 flight navigation
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <vector>
+using std::vector;
+
+#include "util/timing.h"
+
+#include "../nav_ekf15/EKF_15state.h"
+#include "../nav_ekf15/covariance.h"
+
+#include "log_reader.h"
+#include "nav_writer.h"
+#include "replay.h"
+#include "smoother.h"
+
+typedef Matrix<double,15,15> Matrix15d;
+typedef Matrix<double,15,1> Vector15d;
+
+SmoothOptions::SmoothOptions():
+    format(REPLAY_NONE),
+    mag(false),
+    sequential(false),
+    cov_decimation(1),
+    scratch_dir("/tmp")
+{
+    EKF15 ekf;
+    config = ekf.get_config();
+}
+
+// one covariance step of the forward pass
+struct SmootherRecord {
+    float time;
+    NAVdata nav;                // posterior (smoothed after the backward pass)
+    Quaternionf quat;
+    float c[15];                // correction applied by an update at this step
+    float P[120];               // upper triangle of the posterior covariance
+    CovarianceAccum transition; // from the previous step
+};
+
+static void pack_P( const Matrix15f &P, float *packed ) {
+    for ( int i = 0; i < 15; i++ ) {
+        for ( int j = i; j < 15; j++ ) {
+            *packed++ = P(i,j);
+        }
+    }
+}
+
+static Matrix15f unpack_P( const float *packed ) {
+    Matrix15f P;
+    for ( int i = 0; i < 15; i++ ) {
+        for ( int j = i; j < 15; j++ ) {
+            P(i,j) = P(j,i) = *packed++;
+        }
+    }
+    return P;
+}
+
+// Growable array of plain records in a memory mapped scratch file.
+// The file is unlinked as soon as it is created so it never outlives
+// the process.
+template <class T>
+class ScratchFile {
+
+public:
+
+    ScratchFile(): fd(-1), base(NULL), count(0), capacity(0) {}
+    ~ScratchFile() { close(); }
+
+    bool open( const string &dir ) {
+        string path = dir + "/aura-smooth-XXXXXX";
+        vector<char> name( path.begin(), path.end() );
+        name.push_back( 0 );
+        fd = mkstemp( &name[0] );
+        if ( fd < 0 ) {
+            printf("Cannot create a scratch file in: %s\n", dir.c_str());
+            return false;
+        }
+        unlink( &name[0] );
+        return true;
+    }
+
+    void close() {
+        if ( base != NULL ) {
+            munmap( base, capacity * sizeof(T) );
+            base = NULL;
+        }
+        if ( fd >= 0 ) {
+            ::close( fd );
+            fd = -1;
+        }
+        count = capacity = 0;
+    }
+
+    // next record, NULL if the file cannot grow
+    T *push() {
+        if ( count == capacity && !grow() ) {
+            return NULL;
+        }
+        return &base[count++];
+    }
+
+    T &operator[]( long i ) { return base[i]; }
+    long size() { return count; }
+    double bytes() { return (double)count * sizeof(T); }
+
+private:
+
+    int fd;
+    T *base;
+    long count;
+    long capacity;
+
+    bool grow() {
+        long n = capacity > 0 ? capacity * 2 : 65536;
+        if ( ftruncate(fd, n * sizeof(T)) != 0 ) {
+            printf("Cannot grow the scratch file to %ld records\n", n);
+            return false;
+        }
+        if ( base != NULL ) {
+            munmap( base, capacity * sizeof(T) );
+        }
+        void *p = mmap( NULL, n * sizeof(T), PROT_READ | PROT_WRITE,
+                        MAP_SHARED, fd, 0 );
+        if ( p == MAP_FAILED ) {
+            printf("Cannot map the scratch file (%ld records)\n", n);
+            base = NULL;
+            capacity = 0;
+            return false;
+        }
+        base = (T *)p;
+        capacity = n;
+        return true;
+    }
+};
+
+// replay_filter() sink that stores a record for every covariance step
+class SmootherRecorder {
+
+public:
+
+    ScratchFile<SmootherRecord> &scratch;
+    long last_steps;
+    bool updated;
+    long gps_updates;
+    bool ok;
+
+    SmootherRecorder( ScratchFile<SmootherRecord> &scratch ):
+        scratch(scratch), last_steps(-1), updated(false), gps_updates(0),
+        ok(true) {}
+
+    template <class Filter>
+    void gps_update( Filter & ) {
+        updated = true;
+        gps_updates++;
+    }
+
+    template <class Filter>
+    void output( float time, Filter &filter ) {
+        long steps = filter.get_cov_steps();
+        if ( steps == last_steps ) {
+            // mechanization only (decimated covariance)
+            return;
+        }
+        last_steps = steps;
+        SmootherRecord *r = scratch.push();
+        if ( r == NULL ) {
+            ok = false;
+            return;
+        }
+        r->time = time;
+        r->nav = filter.get_nav();
+        r->quat = filter.get_quat();
+        Map<Vector15f> c( r->c );
+        if ( updated ) {
+            c = filter.get_correction();
+            updated = false;
+        } else {
+            c.setZero();
+        }
+        pack_P( filter.get_P(), r->P );
+        r->transition = filter.get_transition();
+    }
+};
+
+template <class Filter>
+static void forward( LogReader &reader, const SmoothOptions &options,
+                     SmootherRecorder &recorder, ReplayStats *stats,
+                     Matrix12f *Rw, NAVconfig *config )
+{
+    Filter filter;
+    filter.set_config( options.config );
+    filter.set_sequential_update( options.sequential );
+    filter.set_cov_decimation( options.cov_decimation );
+    filter.set_keep_transition( true );
+    replay_filter( reader, filter, recorder, stats );
+    *Rw = filter.get_Rw();
+    *config = filter.get_config();
+}
+
+// apply the smoothed error state and covariance to a record
+static void finish( SmootherRecord &r, const Vector15d &dx,
+                    const Matrix15d &P )
+{
+    ekf15_correct( &r.nav, &r.quat, dx.cast<float>() );
+    pack_P( P.cast<float>(), r.P );
+}
+
+static void backward( ScratchFile<SmootherRecord> &scratch,
+                      const Matrix12f &Rw, const NAVconfig &config )
+{
+    long n = scratch.size();
+    if ( n == 0 ) {
+        return;
+    }
+
+    // the last step is already smoothed (it has seen all the data)
+    Matrix15d Ps = unpack_P( scratch[n-1].P ).cast<double>();
+    Vector15d dx = Vector15d::Zero();
+
+    for ( long k = n - 2; k >= 0; k-- ) {
+        SmootherRecord &r0 = scratch[k];
+        SmootherRecord &r1 = scratch[k+1];
+
+        // prior at k+1, recomputed exactly as the forward pass did
+        Matrix15f Pk = unpack_P( r0.P );
+        Matrix15f Pp = Pk;
+        covariance_update_accum( Pp, r1.transition, Rw, config );
+
+        Matrix15d Pkd = Pk.cast<double>();
+        Matrix15d Ppd = Pp.cast<double>();
+        Matrix15d PHI = covariance_phi( r1.transition, config ).cast<double>();
+
+        // A = Pk*PHI'*inv(Pp), solved as A' = inv(Pp)*PHI*Pk
+        Matrix15d A = Ppd.ldlt().solve( PHI * Pkd ).transpose();
+
+        // smoothed error at k+1 relative to its prior (the update
+        // correction moved the forward solution away from the prior)
+        Vector15d e = dx + Map<Vector15f>( r1.c ).cast<double>();
+        Vector15d dx_k = A * e;
+        Matrix15d Ps_k = Pkd + A * (Ps - Ppd) * A.transpose();
+        Ps_k = (Ps_k + Ps_k.transpose()) * 0.5;
+
+        // record k+1 is no longer needed in its forward form
+        finish( r1, dx, Ps );
+        dx = dx_k;
+        Ps = Ps_k;
+    }
+    finish( scratch[0], dx, Ps );
+}
+
+bool smooth_log( const SmoothOptions &options, SmoothStats *stats ) {
+    *stats = SmoothStats();
+
+    LogReader reader;
+    if ( !reader.open(options.log_path.c_str()) ) {
+        return false;
+    }
+    ScratchFile<SmootherRecord> scratch;
+    if ( !scratch.open(options.scratch_dir) ) {
+        return false;
+    }
+    NavWriter writer;
+    if ( !writer.open(options.output_path, options.format) ) {
+        return false;
+    }
+
+    // forward filter pass
+    double start = get_Time();
+    SmootherRecorder recorder( scratch );
+    ReplayStats replay_stats = ReplayStats();
+    Matrix12f Rw;
+    NAVconfig config;
+    if ( options.mag ) {
+        forward<EKF15_mag>( reader, options, recorder, &replay_stats, &Rw,
+                            &config );
+    } else {
+        forward<EKF15>( reader, options, recorder, &replay_stats, &Rw,
+                        &config );
+    }
+    if ( !recorder.ok ) {
+        return false;
+    }
+    double backward_start = get_Time();
+    stats->forward_sec = backward_start - start;
+
+    // backward smoothing pass
+    backward( scratch, Rw, config );
+    double output_start = get_Time();
+    stats->backward_sec = output_start - backward_start;
+
+    // output in time order
+    for ( long i = 0; i < scratch.size(); i++ ) {
+        SmootherRecord &r = scratch[i];
+        NAVdata nav = r.nav;
+        Matrix15f P = unpack_P( r.P );
+        nav.Pp0 = P(0,0);     nav.Pp1 = P(1,1);     nav.Pp2 = P(2,2);
+        nav.Pv0 = P(3,3);     nav.Pv1 = P(4,4);     nav.Pv2 = P(5,5);
+        nav.Pa0 = P(6,6);     nav.Pa1 = P(7,7);     nav.Pa2 = P(8,8);
+        nav.Pabx = P(9,9);    nav.Paby = P(10,10);  nav.Pabz = P(11,11);
+        nav.Pgbx = P(12,12);  nav.Pgby = P(13,13);  nav.Pgbz = P(14,14);
+        writer.write( r.time, nav );
+    }
+    writer.close();
+    stats->output_sec = get_Time() - output_start;
+
+    stats->imu_records = reader.imu_count;
+    stats->gps_records = reader.gps_count;
+    stats->records = reader.imu_count + reader.gps_count;
+    stats->bad_checksum = reader.bad_checksum;
+    stats->steps = scratch.size();
+    stats->gps_updates = recorder.gps_updates;
+    stats->flight_sec = replay_stats.flight_sec;
+    stats->scratch_mb = scratch.bytes() / (1024.0 * 1024.0);
+    return true;
+}
@@ -0,0 +1,258 @@
+// smoother_test.cpp -- write a synthetic flight.dat.gz of an aircraft
+//                      flying alternating turns with noisy, biased
+//                      gyros, then compare the forward filter and the
+//                      smoothed solution against the truth.
+//
+// g++ -O3 -I../.. smoother_test.cpp smoother.cpp nav_writer.cpp
+//     replay.cpp log_reader.cpp ../nav_ekf15/EKF_15state.cpp
+//     ../nav_ekf15/covariance.cpp ../nav_common/nav_functions.cpp
+//     ../nav_common/coremag.c ../nav_common/magcache.cpp
+//     ../../util/timing.cpp -lz -o smoother_test
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <zlib.h>
+
+#include <vector>
+using std::vector;
+
+#include "../nav_common/constants.h"
+#include "../nav_common/nav_functions.h"
+#include "../nav_ekf15/EKF_15state.h"
+
+#include "log_messages.h"
+#include "replay.h"
+#include "smoother.h"
+
+static const char *log_file = "/tmp/smoother_test.dat.gz";
+static const char *forward_file = "/tmp/smoother_test_forward.csv";
+static const char *smooth_file = "/tmp/smoother_test_smooth.csv";
+
+static const float dt = 0.01;
+static const int steps = 60000;         // 10 minutes
+static const int straight = 6000;       // level for the first minute
+static const int leg = 3000;            // 30 sec per turn direction
+
+static float noise(float sigma) {
+    // cheap approximately gaussian noise
+    float sum = 0.0;
+    for ( int i = 0; i < 12; i++ ) {
+        sum += drand48();
+    }
+    return (sum - 6.0) * sigma;
+}
+
+struct Truth {
+    Vector3d pos;               // lat (rad), lon (rad), alt
+    Vector3f vel;               // ned
+    float phi, psi;
+};
+
+static void write_packet( gzFile fd, uint8_t id, uint8_t *payload,
+                          uint8_t len )
+{
+    uint8_t header[4] = { 147, 224, id, len };
+    uint8_t c0 = id;
+    uint8_t c1 = c0;
+    c0 += len;
+    c1 += c0;
+    for ( int i = 0; i < len; i++ ) {
+        c0 += payload[i];
+        c1 += c0;
+    }
+    uint8_t cksum[2] = { c0, c1 };
+    gzwrite( fd, header, 4 );
+    gzwrite( fd, payload, len );
+    gzwrite( fd, cksum, 2 );
+}
+
+// 25 m/s level flight, straight for a minute (the filter initializes
+// its gyro biases from the first sample) and then alternating 15
+// degree banked coordinated turns (rolling at 20 deg/sec), 100hz
+// imu_v5 with gyro biases and 5hz gps_v4
+static void write_log( Truth *truth ) {
+    const float speed = 25.0;
+    const float bank = 15.0 * D2R;
+    const float roll_rate = 20.0 * D2R;
+    const float gyro_bias[3] = { 0.004, -0.006, 0.005 };
+
+    gzFile fd = gzopen( log_file, "wb" );
+    message::imu_v5_t imu;
+    message::gps_v4_t gps;
+    truth[0].pos = Vector3d(45.0 * D2R, -93.0 * D2R, 300.0);
+    truth[0].psi = 30.0 * D2R;
+    truth[0].phi = 0.0;
+    for ( int i = 0; i < steps; i++ ) {
+        Truth &cur = truth[i];
+        float phi_dot = 0.0;
+        if ( i > 0 ) {
+            Truth &prev = truth[i-1];
+            float target = 0.0;
+            if ( i >= straight ) {
+                target = (((i - straight) / leg) % 2 == 0) ? bank : -bank;
+            }
+            float dphi = target - prev.phi;
+            if ( dphi > roll_rate * dt ) { dphi = roll_rate * dt; }
+            if ( dphi < -roll_rate * dt ) { dphi = -roll_rate * dt; }
+            cur.phi = prev.phi + dphi;
+            phi_dot = dphi / dt;
+            cur.psi = prev.psi + g * tan(cur.phi) / speed * dt;
+            Vector3f dx = llarate(prev.vel, prev.pos);
+            cur.pos = prev.pos + dt * dx.cast<double>();
+        }
+        float rate = g * tan(cur.phi) / speed;
+        cur.vel = Vector3f(speed * cos(cur.psi), speed * sin(cur.psi), 0.0);
+
+        Matrix3f C_N2B = quat2dcm(eul2quat(cur.phi, 0.0, cur.psi));
+        Vector3f acc_ned(-cur.vel(1) * rate, cur.vel(0) * rate, 0.0);
+        Vector3f f_b = C_N2B * (acc_ned - Vector3f(0.0, 0.0, g));
+        float t = i * dt;
+        imu.index = 0;
+        imu.timestamp_sec = t;
+        imu.p_rad_sec = phi_dot + gyro_bias[0] + noise(0.002);
+        imu.q_rad_sec = rate * sin(cur.phi) + gyro_bias[1] + noise(0.002);
+        imu.r_rad_sec = rate * cos(cur.phi) + gyro_bias[2] + noise(0.002);
+        imu.ax_mps_sec = f_b(0) + noise(0.05);
+        imu.ay_mps_sec = f_b(1) + noise(0.05);
+        imu.az_mps_sec = f_b(2) + noise(0.05);
+        // level mag vector for the initial heading
+        imu.hx = cos(cur.psi); imu.hy = -sin(cur.psi); imu.hz = 0.0;
+        imu.ax_raw = imu.ay_raw = imu.az_raw = 0.0;
+        imu.hx_raw = imu.hy_raw = imu.hz_raw = 0.0;
+        imu.temp_C = 20.0;
+        imu.status = 0;
+        imu.pack();
+        write_packet( fd, imu.id, imu.payload, imu.len );
+        if ( i % 20 == 0 ) {
+            gps.index = 0;
+            gps.timestamp_sec = t;
+            gps.latitude_deg = cur.pos(0) * R2D + noise(1.0) / 111120.0;
+            gps.longitude_deg = cur.pos(1) * R2D + noise(1.0) / 78600.0;
+            gps.altitude_m = cur.pos(2) + noise(2.0);
+            gps.vn_ms = cur.vel(0) + noise(0.1);
+            gps.ve_ms = cur.vel(1) + noise(0.1);
+            gps.vd_ms = cur.vel(2) + noise(0.2);
+            gps.unixtime_sec = 1.6e9 + t;
+            gps.satellites = 9;
+            gps.horiz_accuracy_m = 2.0;
+            gps.vert_accuracy_m = 4.0;
+            gps.pdop = 1.5;
+            gps.fix_type = 3;
+            gps.pack();
+            write_packet( fd, gps.id, gps.payload, gps.len );
+        }
+    }
+    gzclose( fd );
+}
+
+static float wrap_180( float a ) {
+    while ( a > 180.0 ) { a -= 360.0; }
+    while ( a < -180.0 ) { a += 360.0; }
+    return a;
+}
+
+struct Errors {
+    long rows;
+    double roll_rms, pitch_rms, yaw_rms;       // deg
+    double max_att_cov;                        // mean reported
+};
+
+// compare a csv solution against the truth during the turns
+static Errors compare( const char *file, const Truth *truth ) {
+    Errors e = { 0, 0.0, 0.0, 0.0, 0.0 };
+    FILE *fd = fopen( file, "r" );
+    if ( fd == NULL ) {
+        return e;
+    }
+    char line[1024];
+    if ( fgets(line, sizeof(line), fd) == NULL ) {
+        fclose( fd );
+        return e;
+    }
+    while ( fgets(line, sizeof(line), fd) != NULL ) {
+        double t, lat, lon, alt, vn, ve, vd, roll, pitch, yaw;
+        double pb, qb, rb, axb, ayb, azb, pos_cov, vel_cov, att_cov;
+        if ( sscanf(line, "%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf",
+                    &t, &lat, &lon, &alt, &vn, &ve, &vd, &roll, &pitch,
+                    &yaw, &pb, &qb, &rb, &axb, &ayb, &azb, &pos_cov,
+                    &vel_cov, &att_cov) != 19 ) {
+            continue;
+        }
+        int i = lround( t / dt );
+        if ( t < 60.0 || i >= steps ) {
+            continue;
+        }
+        float droll = wrap_180( roll - truth[i].phi * R2D );
+        float dpitch = pitch;
+        float dyaw = wrap_180( yaw - truth[i].psi * R2D );
+        e.roll_rms += droll * droll;
+        e.pitch_rms += dpitch * dpitch;
+        e.yaw_rms += dyaw * dyaw;
+        e.max_att_cov += att_cov;
+        e.rows++;
+    }
+    fclose( fd );
+    if ( e.rows > 0 ) {
+        e.roll_rms = sqrt( e.roll_rms / e.rows );
+        e.pitch_rms = sqrt( e.pitch_rms / e.rows );
+        e.yaw_rms = sqrt( e.yaw_rms / e.rows );
+        e.max_att_cov /= e.rows;
+    }
+    return e;
+}
+
+int main() {
+    static Truth truth[steps];
+    write_log( truth );
+
+    ReplayOptions replay_options;
+    replay_options.log_path = log_file;
+    replay_options.output_path = forward_file;
+    replay_options.format = REPLAY_CSV;
+    ReplayStats replay_stats;
+    if ( !replay_log(replay_options, &replay_stats) ) {
+        printf("FAIL: forward replay\n");
+        return 1;
+    }
+
+    bool pass = true;
+    Errors forward = compare( forward_file, truth );
+    printf("forward:   roll %.3f  pitch %.3f  yaw %.3f deg rms  att cov %.2e\n",
+           forward.roll_rms, forward.pitch_rms, forward.yaw_rms,
+           forward.max_att_cov);
+    int decimation[2] = { 1, 5 };
+    for ( int d = 0; d < 2; d++ ) {
+        SmoothOptions options;
+        options.log_path = log_file;
+        options.output_path = smooth_file;
+        options.format = REPLAY_CSV;
+        options.cov_decimation = decimation[d];
+        SmoothStats stats;
+        if ( !smooth_log(options, &stats) ) {
+            printf("FAIL: smoother\n");
+            return 1;
+        }
+        Errors smooth = compare( smooth_file, truth );
+        printf("smoothed (decimation %d): roll %.3f  pitch %.3f  yaw %.3f deg rms  att cov %.2e\n",
+               decimation[d], smooth.roll_rms, smooth.pitch_rms,
+               smooth.yaw_rms, smooth.max_att_cov);
+        printf("  steps: %ld  gps updates: %ld  scratch: %.1f MB  forward: %.3f sec  backward: %.3f sec\n",
+               stats.steps, stats.gps_updates, stats.scratch_mb,
+               stats.forward_sec, stats.backward_sec);
+        if ( smooth.rows == 0
+             || smooth.roll_rms > 0.7 * forward.roll_rms
+             || smooth.pitch_rms > 0.7 * forward.pitch_rms
+             || smooth.yaw_rms > 0.7 * forward.yaw_rms
+             || smooth.max_att_cov > forward.max_att_cov ) {
+            printf("FAIL: the smoother did not improve the attitude\n");
+            pass = false;
+        }
+    }
+
+    if ( !pass ) {
+        return 1;
+    }
+    printf("PASS\n");
+    return 0;
+}
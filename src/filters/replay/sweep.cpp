@@ -0,0 +1,216 @@
+// sweep.cpp -- parallel EKF parameter sweep bank
+//
+
+#include <math.h>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+#include "util/timing.h"
+
+#include "../nav_ekf15/EKF_15state.h"
+#include "../nav_ekf15/EKF_15state_batch.h"
+
+#include "replay.h"
+#include "sweep.h"
+
+// 95% chi-square bound for 6 and 9 degrees of freedom
+static double chi2_95( int dof ) {
+    return dof == 9 ? 16.919 : 12.592;
+}
+
+// replay_filter() sink that accumulates the innovation statistics
+class InnovationStats {
+
+public:
+
+    long count;
+    double nis_sum;
+    long in_bound;
+    double pos_sq;
+    double vel_sq;
+    double bound;
+
+    InnovationStats( double bound ):
+        count(0), nis_sum(0.0), in_bound(0), pos_sq(0.0), vel_sq(0.0),
+        bound(bound) {}
+
+    template <class Filter>
+    void output( float, Filter & ) {}
+
+    template <class Filter>
+    void gps_update( Filter &filter ) {
+        typename Filter::VectorMf y = filter.get_innovation();
+        add( filter.get_nis(), y.data() );
+    }
+
+    // y = gps position and velocity innovation
+    void add( float nis, const float *y ) {
+        count++;
+        nis_sum += nis;
+        if ( nis <= bound ) {
+            in_bound++;
+        }
+        pos_sq += y[0] * y[0] + y[1] * y[1] + y[2] * y[2];
+        vel_sq += y[3] * y[3] + y[4] * y[4] + y[5] * y[5];
+    }
+};
+
+// replay_filter() sink for EKF15Batch, statistics per config
+class BatchInnovationStats {
+
+public:
+
+    vector<InnovationStats> filters;
+
+    BatchInnovationStats( int count, double bound ):
+        filters( count, InnovationStats(bound) ) {}
+
+    void output( float, EKF15Batch & ) {}
+
+    void gps_update( EKF15Batch &filter ) {
+        float y[6];
+        for ( int i = 0; i < (int)filters.size(); i++ ) {
+            filter.get_innovation( i, y );
+            filters[i].add( filter.get_nis(i), y );
+        }
+    }
+};
+
+static void finish( const InnovationStats &stats, const NAVconfig &config,
+                    int dof, SweepResult *result )
+{
+    result->config = config;
+    result->gps_updates = stats.count;
+    result->dof = dof;
+    if ( stats.count > 0 ) {
+        result->nis_mean = stats.nis_sum / stats.count;
+        result->nis_in_bound = (double)stats.in_bound / stats.count;
+        result->pos_rms = sqrt( stats.pos_sq / stats.count );
+        result->vel_rms = sqrt( stats.vel_sq / stats.count );
+        result->score = fabs( log(result->nis_mean / dof) );
+    } else {
+        result->nis_mean = 0.0;
+        result->nis_in_bound = 0.0;
+        result->pos_rms = 0.0;
+        result->vel_rms = 0.0;
+        result->score = HUGE_VAL;
+    }
+    if ( !std::isfinite(result->score) ) {
+        // diverged
+        result->score = HUGE_VAL;
+    }
+}
+
+template <class Filter>
+static void run( const vector<LogRecord> &records, const NAVconfig &config,
+                 const SweepOptions &options, std::mutex *init_lock,
+                 SweepResult *result )
+{
+    Filter filter;
+    filter.set_config( config );
+    filter.set_sequential_update( options.sequential );
+    filter.set_gps_lag( options.gps_lag );
+    filter.set_cov_decimation( options.cov_decimation );
+
+    LogBuffer source( records );
+    InnovationStats stats( chi2_95(Filter::M) );
+    ReplayStats replay_stats = ReplayStats();
+    replay_filter( source, filter, stats, &replay_stats, init_lock );
+    finish( stats, config, Filter::M, result );
+}
+
+// configs [first, first+count) as the lanes of one batch filter
+static void run_batch( const vector<LogRecord> &records,
+                       const vector<NAVconfig> &configs, int first,
+                       int count, SweepResult *results )
+{
+    EKF15Batch filter( count );
+    for ( int i = 0; i < count; i++ ) {
+        filter.set_config( i, configs[first + i] );
+    }
+
+    LogBuffer source( records );
+    BatchInnovationStats stats( count, chi2_95(6) );
+    ReplayStats replay_stats = ReplayStats();
+    replay_filter( source, filter, stats, &replay_stats );
+    for ( int i = 0; i < count; i++ ) {
+        results[first + i].index = first + i;
+        finish( stats.filters[i], configs[first + i], 6,
+                &results[first + i] );
+    }
+}
+
+static bool better( const SweepResult &a, const SweepResult &b ) {
+    if ( a.score != b.score ) {
+        return a.score < b.score;
+    }
+    return a.pos_rms < b.pos_rms;
+}
+
+vector<SweepResult> sweep_run( const vector<LogRecord> &records,
+                               const vector<NAVconfig> &configs,
+                               const SweepOptions &options,
+                               double *wall_sec )
+{
+    vector<SweepResult> results( configs.size() );
+    int threads = options.threads;
+    if ( threads <= 0 ) {
+        threads = std::thread::hardware_concurrency();
+        if ( threads <= 0 ) {
+            threads = 1;
+        }
+    }
+    bool batch = options.batch > 0 && options.sequential && !options.mag
+        && options.gps_lag <= 0.0 && options.cov_decimation <= 1;
+    int jobs = configs.size();
+    if ( batch ) {
+        jobs = (configs.size() + options.batch - 1) / options.batch;
+    }
+    if ( threads > jobs ) {
+        threads = jobs;
+    }
+
+    // workers pull the next config index (or batch) until the list is
+    // exhausted (configs run for different lengths of time when some
+    // diverge, so this balances better than fixed slices)
+    std::atomic<int> next( 0 );
+    std::mutex init_lock;
+    auto worker = [&]() {
+        int i;
+        while ( (i = next++) < jobs ) {
+            if ( batch ) {
+                int first = i * options.batch;
+                int count = std::min( options.batch,
+                                      (int)configs.size() - first );
+                run_batch( records, configs, first, count, &results[0] );
+                continue;
+            }
+            results[i].index = i;
+            if ( options.mag ) {
+                run<EKF15_mag>( records, configs[i], options, &init_lock,
+                                &results[i] );
+            } else {
+                run<EKF15>( records, configs[i], options, &init_lock,
+                            &results[i] );
+            }
+        }
+    };
+
+    double start = get_Time();
+    vector<std::thread> pool;
+    for ( int i = 0; i < threads; i++ ) {
+        pool.push_back( std::thread(worker) );
+    }
+    for ( size_t i = 0; i < pool.size(); i++ ) {
+        pool[i].join();
+    }
+    if ( wall_sec != NULL ) {
+        *wall_sec = get_Time() - start;
+    }
+
+    std::stable_sort( results.begin(), results.end(), better );
+    return results;
+}
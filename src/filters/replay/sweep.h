@@ -0,0 +1,55 @@
+// sweep.h -- run a bank of independent EKF instances with different
+//            NAVconfig values over one decoded log, spread across a
+//            pool of threads, and rank them by gps innovation
+//            statistics
+//
+// The sensor stream is decoded once (replay_load) and shared read-only
+// by every worker; each configuration owns its filter and statistics,
+// so the workers never synchronize except to pull the next config
+// index (and around filter init, see replay_filter.)
+//
+// With options.batch the configs are instead run in lockstep groups of
+// that size, one EKF15Batch per group (the SIMD lanes carry different
+// configs over the same samples.)  The batch filter is the gps only,
+// sequential update filter without gps lag or covariance decimation,
+// so other option combinations fall back to one EKF15 per config.
+
+#pragma once
+
+#include <vector>
+using std::vector;
+
+#include "../nav_common/structs.h"
+#include "log_reader.h"
+
+struct SweepOptions {
+    bool mag;                   // EKF15_mag instead of EKF15
+    bool sequential;            // sequential scalar measurement update
+    float gps_lag;              // sec, gps latency (0 = fuse as current)
+    int cov_decimation;         // imu samples per covariance propagation
+    int threads;                // 0 = one per core
+    int batch;                  // configs per EKF15Batch (0 = one EKF15 each)
+
+    SweepOptions(): mag(false), sequential(false), gps_lag(0.0),
+                    cov_decimation(1), threads(0), batch(0) {}
+};
+
+struct SweepResult {
+    int index;                  // position in the input config list
+    NAVconfig config;
+    long gps_updates;
+    int dof;                    // measurement rows per update
+    double nis_mean;            // expect dof when consistent
+    double nis_in_bound;        // fraction inside the 95% chi-square bound
+    double pos_rms;             // [m] rms gps position innovation
+    double vel_rms;             // [m/s] rms gps velocity innovation
+    double score;               // |ln(nis_mean/dof)|, lower is better
+};
+
+// run every config over the records and return the results ranked
+// best (most consistent covariance) first.  wall_sec (optional)
+// receives the elapsed time of the bank.
+vector<SweepResult> sweep_run( const vector<LogRecord> &records,
+                               const vector<NAVconfig> &configs,
+                               const SweepOptions &options,
+                               double *wall_sec = NULL );
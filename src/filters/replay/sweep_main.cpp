@@ -0,0 +1,164 @@
+// sweep_main.cpp -- command line front end for the parallel ekf
+//                   parameter sweep
+//
+// g++ -O3 -pthread -I../.. sweep_main.cpp sweep.cpp replay.cpp
+//     nav_writer.cpp log_reader.cpp ../nav_ekf15/EKF_15state.cpp
+//     ../nav_ekf15/EKF_15state_batch.cpp ../nav_ekf15/covariance.cpp
+//     ../nav_common/nav_functions.cpp ../nav_common/coremag.c
+//     ../nav_common/magcache.cpp ../../util/timing.cpp -lz -o sweep
+//
+// sweep [--mag] [--sequential] [--gps-lag sec] [--cov-decimation n]
+//       [--threads n] [--batch n]
+//       [--top n] [--set name=value ...] [--grid name=v1,v2,... ...]
+//       flight.dat.gz
+//
+// Every --grid axis multiplies the number of configurations (the full
+// cartesian product is run.)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+using std::string;
+using std::vector;
+
+#include "replay.h"
+#include "sweep.h"
+
+static void usage( const char *prog ) {
+    printf("usage: %s [--mag] [--sequential] [--gps-lag sec] [--cov-decimation n] [--threads n] [--batch n] [--top n] [--set name=value ...] [--grid name=v1,v2,... ...] flight.dat.gz\n", prog);
+}
+
+struct GridAxis {
+    string name;
+    vector<float> values;
+};
+
+static bool parse_axis( const char *arg, GridAxis *axis ) {
+    const char *eq = strchr( arg, '=' );
+    if ( eq == NULL ) {
+        return false;
+    }
+    axis->name = string( arg, eq - arg );
+    NAVconfig test;
+    if ( !replay_set_config(&test, axis->name, 0.0) ) {
+        return false;
+    }
+    const char *p = eq + 1;
+    while ( *p ) {
+        char *end;
+        axis->values.push_back( strtof(p, &end) );
+        if ( end == p ) {
+            return false;
+        }
+        p = (*end == ',') ? end + 1 : end;
+    }
+    return axis->values.size() > 0;
+}
+
+int main( int argc, char **argv ) {
+    ReplayOptions defaults;
+    SweepOptions options;
+    vector<GridAxis> grid;
+    int top = 20;
+    int i = 1;
+    for ( ; i < argc && argv[i][0] == '-'; i++ ) {
+        if ( !strcmp(argv[i], "--mag") ) {
+            options.mag = true;
+        } else if ( !strcmp(argv[i], "--sequential") ) {
+            options.sequential = true;
+        } else if ( !strcmp(argv[i], "--gps-lag") && i + 1 < argc ) {
+            options.gps_lag = atof( argv[++i] );
+        } else if ( !strcmp(argv[i], "--cov-decimation") && i + 1 < argc ) {
+            options.cov_decimation = atoi( argv[++i] );
+        } else if ( !strcmp(argv[i], "--threads") && i + 1 < argc ) {
+            options.threads = atoi( argv[++i] );
+        } else if ( !strcmp(argv[i], "--batch") && i + 1 < argc ) {
+            options.batch = atoi( argv[++i] );
+        } else if ( !strcmp(argv[i], "--top") && i + 1 < argc ) {
+            top = atoi( argv[++i] );
+        } else if ( !strcmp(argv[i], "--set") && i + 1 < argc ) {
+            i++;
+            const char *eq = strchr( argv[i], '=' );
+            if ( eq == NULL || !replay_set_config(&defaults.config,
+                                                  string(argv[i], eq - argv[i]),
+                                                  atof(eq + 1)) ) {
+                printf("Unknown config setting: %s\n", argv[i]);
+                return 1;
+            }
+        } else if ( !strcmp(argv[i], "--grid") && i + 1 < argc ) {
+            GridAxis axis;
+            if ( !parse_axis(argv[++i], &axis) ) {
+                printf("Bad grid axis: %s\n", argv[i]);
+                return 1;
+            }
+            grid.push_back( axis );
+        } else {
+            usage( argv[0] );
+            return 1;
+        }
+    }
+    if ( i >= argc ) {
+        usage( argv[0] );
+        return 1;
+    }
+
+    // expand the grid
+    vector<NAVconfig> configs;
+    configs.push_back( defaults.config );
+    for ( size_t a = 0; a < grid.size(); a++ ) {
+        vector<NAVconfig> expanded;
+        for ( size_t c = 0; c < configs.size(); c++ ) {
+            for ( size_t v = 0; v < grid[a].values.size(); v++ ) {
+                NAVconfig config = configs[c];
+                replay_set_config( &config, grid[a].name, grid[a].values[v] );
+                expanded.push_back( config );
+            }
+        }
+        configs = expanded;
+    }
+
+    vector<LogRecord> records;
+    ReplayStats load;
+    if ( !replay_load(argv[i], &records, &load) ) {
+        return 1;
+    }
+    printf("decoded %ld records (%.1f sec of flight) in %.3f sec\n",
+           load.records, load.flight_sec, load.wall_sec);
+
+    double wall_sec;
+    vector<SweepResult> results = sweep_run( records, configs, options,
+                                             &wall_sec );
+    printf("%d configs in %.2f sec (%.1f configs/sec, %.0fx real time aggregate)\n",
+           (int)configs.size(), wall_sec, configs.size() / wall_sec,
+           load.flight_sec * configs.size() / wall_sec);
+
+    // ranked table: the grid axes plus the innovation statistics
+    printf("\nrank  index");
+    for ( size_t a = 0; a < grid.size(); a++ ) {
+        printf(" %12s", grid[a].name.c_str());
+    }
+    printf("  updates   nis/dof  in_95%%  pos_rms  vel_rms\n");
+    for ( int r = 0; r < (int)results.size() && r < top; r++ ) {
+        const SweepResult &res = results[r];
+        printf("%4d  %5d", r + 1, res.index);
+        // configs were expanded with the last axis varying fastest
+        int stride = 1;
+        vector<float> values( grid.size() );
+        for ( int a = grid.size() - 1; a >= 0; a-- ) {
+            int n = grid[a].values.size();
+            values[a] = grid[a].values[(res.index / stride) % n];
+            stride *= n;
+        }
+        for ( size_t a = 0; a < grid.size(); a++ ) {
+            printf(" %12g", values[a]);
+        }
+        printf("  %7ld  %8.3f  %6.3f  %7.3f  %7.4f\n", res.gps_updates,
+               res.nis_mean / res.dof, res.nis_in_bound, res.pos_rms,
+               res.vel_rms);
+    }
+
+    return 0;
+}
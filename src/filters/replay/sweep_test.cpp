@@ -0,0 +1,180 @@
+// sweep_test.cpp -- run a small parameter sweep over a synthetic
+//                   stream, check the ranking, the thread scaling and
+//                   the batch filter lanes.
+//
+// g++ -O3 -pthread -I../.. sweep_test.cpp sweep.cpp replay.cpp
+//     nav_writer.cpp log_reader.cpp ../nav_ekf15/EKF_15state.cpp
+//     ../nav_ekf15/EKF_15state_batch.cpp ../nav_ekf15/covariance.cpp
+//     ../nav_common/nav_functions.cpp ../nav_common/coremag.c
+//     ../nav_common/magcache.cpp ../../util/timing.cpp -lz -o sweep_test
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <thread>
+
+#include "../nav_common/constants.h"
+
+#include "replay.h"
+#include "sweep.h"
+
+static float noise(float sigma) {
+    // cheap approximately gaussian noise
+    float sum = 0.0;
+    for ( int i = 0; i < 12; i++ ) {
+        sum += drand48();
+    }
+    return (sum - 6.0) * sigma;
+}
+
+// gps noise of the synthetic stream
+static const float sig_p_ne = 2.0;
+static const float sig_p_d = 4.0;
+static const float sig_v_ne = 0.2;
+static const float sig_v_d = 0.4;
+
+// five minutes of a stationary aircraft: 100hz imu, 5hz gps
+static void make_records( vector<LogRecord> *records ) {
+    LogRecord rec;
+    for ( int i = 0; i < 30000; i++ ) {
+        float t = i * 0.01;
+        if ( i % 20 == 0 ) {
+            rec.type = LOG_GPS;
+            rec.gps.time = t;
+            rec.gps.unix_sec = 1.6e9 + t;
+            rec.gps.lat = 45.0 + noise(sig_p_ne) / 111120.0;
+            rec.gps.lon = -93.0 + noise(sig_p_ne) / (111120.0 * cos(45.0 * D2R));
+            rec.gps.alt = 300.0 + noise(sig_p_d);
+            rec.gps.vn = noise(sig_v_ne);
+            rec.gps.ve = noise(sig_v_ne);
+            rec.gps.vd = noise(sig_v_d);
+            rec.gps.sats = 9;
+            rec.gps_fix = true;
+            records->push_back( rec );
+        }
+        rec.type = LOG_IMU;
+        rec.imu.time = t;
+        rec.imu.p = noise(0.002);
+        rec.imu.q = noise(0.002);
+        rec.imu.r = noise(0.002);
+        rec.imu.ax = noise(0.05);
+        rec.imu.ay = noise(0.05);
+        rec.imu.az = -9.81 + noise(0.05);
+        rec.imu.hx = 0.3; rec.imu.hy = 0.05; rec.imu.hz = 0.5;
+        rec.imu.temp = 20.0;
+        records->push_back( rec );
+    }
+}
+
+int main() {
+    vector<LogRecord> records;
+    make_records( &records );
+
+    // scale the gps noise model around the true values
+    const float scales[] = { 0.25, 0.5, 1.0, 2.0, 4.0 };
+    ReplayOptions defaults;
+    vector<NAVconfig> configs;
+    for ( int k = 0; k < 8; k++ ) {
+        for ( int i = 0; i < 5; i++ ) {
+            NAVconfig config = defaults.config;
+            config.sig_gps_p_ne = sig_p_ne * scales[i];
+            config.sig_gps_p_d = sig_p_d * scales[i];
+            config.sig_gps_v_ne = sig_v_ne * scales[i];
+            config.sig_gps_v_d = sig_v_d * scales[i];
+            // vary the accel noise a little as well so the copies differ
+            config.sig_w_ax = config.sig_w_ay = config.sig_w_az
+                = 0.05 * (1.0 + 0.1 * k);
+            configs.push_back( config );
+        }
+    }
+
+    SweepOptions options;
+    options.threads = 1;
+    double serial_sec;
+    vector<SweepResult> serial = sweep_run( records, configs, options,
+                                            &serial_sec );
+    options.threads = 0;
+    double parallel_sec;
+    vector<SweepResult> parallel = sweep_run( records, configs, options,
+                                              &parallel_sec );
+
+    // the same sweep with the sequential update, as separate filters
+    // and as batch filter lanes
+    options.sequential = true;
+    double sequential_sec;
+    vector<SweepResult> sequential = sweep_run( records, configs, options,
+                                                &sequential_sec );
+    options.batch = 16;
+    double batch_sec;
+    vector<SweepResult> batch = sweep_run( records, configs, options,
+                                           &batch_sec );
+
+    // the batch filter only has the sequential update, so a batch sweep
+    // with the joint update runs separate filters instead
+    options.sequential = false;
+    double joint_sec;
+    vector<SweepResult> joint = sweep_run( records, configs, options,
+                                           &joint_sec );
+    options.sequential = true;
+
+    printf("rank  index  gps_scale  updates   nis/dof  in_95%%  pos_rms  vel_rms\n");
+    for ( int r = 0; r < 10; r++ ) {
+        const SweepResult &res = parallel[r];
+        printf("%4d  %5d  %9.2f  %7ld  %8.3f  %6.3f  %7.3f  %7.4f\n",
+               r + 1, res.index, res.config.sig_gps_p_ne / sig_p_ne,
+               res.gps_updates, res.nis_mean / res.dof, res.nis_in_bound,
+               res.pos_rms, res.vel_rms);
+    }
+
+    bool result = true;
+    for ( size_t i = 0; i < configs.size(); i++ ) {
+        if ( serial[i].index != parallel[i].index
+             || serial[i].nis_mean != parallel[i].nis_mean ) {
+            printf("FAIL: thread count changed the results\n");
+            result = false;
+            break;
+        }
+    }
+    for ( size_t i = 0; i < configs.size(); i++ ) {
+        if ( joint[i].index != parallel[i].index
+             || joint[i].nis_mean != parallel[i].nis_mean ) {
+            printf("FAIL: batch option ignored the joint update\n");
+            result = false;
+            break;
+        }
+    }
+    vector<double> nis( configs.size() );
+    for ( size_t i = 0; i < configs.size(); i++ ) {
+        nis[sequential[i].index] = sequential[i].nis_mean;
+    }
+    for ( size_t i = 0; i < configs.size(); i++ ) {
+        double n = nis[batch[i].index];
+        if ( fabs(batch[i].nis_mean - n) > 0.01 * n ) {
+            printf("FAIL: batch lane %d nis %.4f, separate filter %.4f\n",
+                   batch[i].index, batch[i].nis_mean, n);
+            result = false;
+            break;
+        }
+    }
+    float best_scale = parallel[0].config.sig_gps_p_ne / sig_p_ne;
+    if ( best_scale < 0.5 || best_scale > 2.0 ) {
+        printf("FAIL: best gps noise scale = %.2f\n", best_scale);
+        result = false;
+    }
+
+    int cores = std::thread::hardware_concurrency();
+    printf("%d configs: 1 thread %.2f sec, %d threads %.2f sec (%.1fx)\n",
+           (int)configs.size(), serial_sec, cores, parallel_sec,
+           serial_sec / parallel_sec);
+    printf("sequential update: separate filters %.2f sec, batch of %d %.2f sec (%.1fx)\n",
+           sequential_sec, options.batch, batch_sec,
+           sequential_sec / batch_sec);
+
+    if ( !result ) {
+        printf("FAIL\n");
+        return 1;
+    }
+    printf("PASS\n");
+    return 0;
+}
@@ -17,7 +17,7 @@ import props_json
 
 # C++ modules
 from rcUAS import actuator_mgr, control_mgr, driver_mgr, filter_mgr
-from rcUAS import airdata_helper, gps_helper
+from rcUAS import airdata_helper, frame_snapshot, gps_helper
 
 # Pure python modules
 from comms import display, logging, remote_link, telnet
@@ -25,7 +25,7 @@ from control import navigation
 from drivers import pilot_helper
 from health import health
 from mission import mission_mgr
-from util import myprof, timer
+from util import myprof, propprof, timer
 
 parser = argparse.ArgumentParser(description="Rice Creak UAS flight code")
 parser.add_argument("--config", required=True, help="path to config tree")
@@ -71,6 +71,9 @@ if config_node.hasChild("gps_timeout_sec"):
 
 # module initialization
 def init():
+    # opt-in property access profiler
+    propprof.init()
+
     # communication modules
     logging.init()
     remote_link.init()
@@ -106,6 +109,12 @@ def init():
     # save the master config tree with the flight data
     logging.write_configs()
 
+    # per frame snapshot of the tree for readers outside the main loop
+    frame_snapshot.init()
+    for path in [ "/sensors", "/filters", "/autopilot", "/actuators",
+                  "/status" ]:
+        frame_snapshot.add(path)
+
     print("Initialization complete.");
 
 display_timer = timer.get_pytime()
@@ -195,6 +204,10 @@ def update():
         myprof.datalog_prof.stats()
         myprof.main_prof.stats()
 
+    # publish a consistent copy of this frame
+    frame_snapshot.commit()
+    propprof.frame()
+
     myprof.main_prof.stop()
 
 # Here is the top level main program.  In arduino style, we call the
@@ -173,7 +173,7 @@ class Land(Task):
                     self.nav_node.setString("mode", "route")
         else:
             # on final approach
-            if control.route.dist_valid:
+            if control.route.dist_valid():
                 self.dist_rem_m = self.route_node.getFloat("dist_remaining_m")
 
         # compute glideslope/target elevation
@@ -2,6 +2,7 @@
 from __future__ import division
 
 import math
+import numpy as np
 
 from rcUAS import wgs84
 
@@ -63,31 +64,26 @@ class Area():
 # convert list of Point coordinates from geodetic (lon/lat) to cartesian
 def geod2cart(ref, geod_points):
     print('geod2cart()')
-    result = []
-    for p in geod_points:
-        # expects points as [lat, lon]
-        #heading, dist = gc.course_and_dist( [ref.y, ref.x], [p.y, p.x] )
-        (heading, reverse, dist) = \
-            wgs84.geo_inverse( ref.y, ref.x, p.y, p.x )
-        angle = (90 - heading) * d2r
-        x = math.cos(angle) * dist
-        y = math.sin(angle) * dist
-        print(p.pretty(), 'hdg:', heading, 'dist:', dist, 'cart:', x, y)
-        result.append( point.Point(x, y) )
-    return result
+    lon = np.array([p.x for p in geod_points])
+    lat = np.array([p.y for p in geod_points])
+    (heading, reverse, dist) = \
+        wgs84.geo_inverse_array( ref.y, ref.x, lat, lon )
+    angle = (90 - heading) * d2r
+    x = np.cos(angle) * dist
+    y = np.sin(angle) * dist
+    print('converted %d points' % len(geod_points))
+    return [ point.Point(x[i], y[i]) for i in range(len(geod_points)) ]
         
 # convert list of Point coordinates from cartesian to geodetic (lon/lat)
 def cart2geod(ref, cart_points):
     print('cart2geod()')
-    result = []
-    for p in cart_points:
-        heading = 90 - math.atan2(p.y, p.x) * r2d
-        dist = math.sqrt(p.x*p.x + p.y*p.y)
-        #lat, lon = gc.project_course_distance( [ref.y, ref.x], heading, dist )
-        lat, lon, az2 = wgs84.geo_direct( ref.y, ref.x, heading, dist )
-        print(p.pretty(), 'hdg:', heading, 'dist:', dist, 'geod:', lon, lat)
-        result.append( point.Point(lon, lat) )
-    return result
+    x = np.array([p.x for p in cart_points])
+    y = np.array([p.y for p in cart_points])
+    heading = 90 - np.arctan2(y, x) * r2d
+    dist = np.sqrt(x*x + y*y)
+    lat, lon, az2 = wgs84.geo_direct_array( ref.y, ref.x, heading, dist )
+    print('converted %d points' % len(cart_points))
+    return [ point.Point(lon[i], lat[i]) for i in range(len(cart_points)) ]
     
     
 # slice an Area() with a cut line perpendicular to the given dir
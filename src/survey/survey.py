@@ -81,13 +81,14 @@ def do_survey( request ):
     geod_route = area.cart2geod( ref, cart_route )
 
     # assemble the route
-    control.route.standby_route = []
+    wps = []
     for p in geod_route:
         wp = control.waypoint.Waypoint()
         wp.mode = 'absolute'
         wp.lon_deg = p.x
         wp.lat_deg = p.y
-        control.route.standby_route.append(wp)
+        wps.append(wp)
+    control.route.set_standby(wps)
 
     # make active
     control.route.swap()
@@ -0,0 +1,294 @@
+#ifdef HAVE_PYBIND11
+  #include <pybind11/pybind11.h>
+  namespace py = pybind11;
+#endif
+
+#include <pyprops.h>
+
+#include <stdio.h>
+
+#include "timing.h"
+#include "frame_snapshot.h"
+
+// guards against reference loops in the tree
+static const int max_depth = 16;
+
+int FrameData::find( const string &path ) {
+    for ( unsigned int i = 0; i < values.size(); i++ ) {
+        if ( values[i].path == path ) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+FrameSnapshot::FrameSnapshot():
+    latest(-1),
+    seq(0),
+    dropped(0)
+{
+    for ( int i = 0; i < 3; i++ ) {
+        readers[i] = 0;
+    }
+}
+
+FrameSnapshot::~FrameSnapshot() {
+    // (the python nodes are left alone, the interpreter may already be
+    // gone when a static snapshot is destroyed)
+}
+
+bool FrameSnapshot::add( string path ) {
+    pyPropertyNode node = pyGetNode( path, true );
+    if ( node.isNull() ) {
+        printf("WARNING: frame snapshot can't find %s\n", path.c_str());
+        return false;
+    }
+    if ( path.length() > 1 && path[path.length()-1] == '/' ) {
+        path = path.substr(0, path.length()-1);
+    }
+    Subtree s;
+    s.path = (path == "/") ? "" : path;
+    s.node = node.pObj;
+    Py_INCREF(s.node);
+    subtrees.push_back( s );
+    return true;
+}
+
+// copy one leaf value into the next slot of the frame (reusing the
+// slot's string storage from earlier frames)
+void FrameSnapshot::store( PyObject *val, const string &path,
+                           FrameData *frame, unsigned int *count )
+{
+    char type;
+    double value = 0.0;
+    const char *text = NULL;
+    if ( PyFloat_CheckExact(val) ) {
+        type = 'd';
+        value = PyFloat_AS_DOUBLE(val);
+    } else if ( PyBool_Check(val) ) {
+        type = 'b';
+        value = (val == Py_True) ? 1.0 : 0.0;
+    } else if ( PyLong_Check(val) ) {
+        type = 'l';
+        value = PyLong_AsDouble(val);
+    } else if ( PyFloat_Check(val) ) {
+        type = 'd';
+        value = PyFloat_AsDouble(val);
+    } else if ( PyUnicode_Check(val) ) {
+        type = 's';
+        text = PyUnicode_AsUTF8(val);
+    } else {
+        return;                 // not a property value
+    }
+    if ( PyErr_Occurred() ) {
+        PyErr_Clear();
+    }
+    if ( *count >= frame->values.size() ) {
+        frame->values.resize( *count + 1 );
+    }
+    FrameValue &v = frame->values[*count];
+    v.path = path;
+    v.type = type;
+    v.value = value;
+    if ( text != NULL ) {
+        v.text = text;
+    } else {
+        v.text.clear();
+    }
+    (*count)++;
+}
+
+// copy every value below a python PropertyNode.  Child nodes are
+// attributes with their own __dict__, enumerated children and value
+// arrays are python lists.
+void FrameSnapshot::walk( PyObject *obj, const string &path, int depth,
+                          FrameData *frame, unsigned int *count )
+{
+    if ( depth > max_depth || Py_TYPE(obj)->tp_dictoffset == 0 ) {
+        return;
+    }
+    PyObject *dict = PyObject_GenericGetDict( obj, NULL );
+    if ( dict == NULL || !PyDict_Check(dict) ) {
+        Py_XDECREF(dict);
+        PyErr_Clear();
+        return;
+    }
+    PyObject *key;
+    PyObject *val;
+    Py_ssize_t pos = 0;
+    string child;
+    while ( PyDict_Next(dict, &pos, &key, &val) ) {
+        const char *name = PyUnicode_Check(key) ? PyUnicode_AsUTF8(key) : NULL;
+        if ( name == NULL || name[0] == '_' ) {
+            PyErr_Clear();
+            continue;
+        }
+        child = path + "/" + name;
+        if ( PyList_Check(val) ) {
+            Py_ssize_t len = PyList_Size(val);
+            for ( Py_ssize_t i = 0; i < len; i++ ) {
+                PyObject *item = PyList_GetItem(val, i);
+                string elem = child + "[" + std::to_string(i) + "]";
+                if ( Py_TYPE(item)->tp_dictoffset != 0
+                     && !PyType_Check(item) && !PyModule_Check(item) ) {
+                    walk( item, elem, depth + 1, frame, count );
+                } else {
+                    store( item, elem, frame, count );
+                }
+            }
+        } else if ( Py_TYPE(val)->tp_dictoffset != 0
+                    && !PyType_Check(val) && !PyModule_Check(val) ) {
+            walk( val, child, depth + 1, frame, count );
+        } else {
+            store( val, child, frame, count );
+        }
+    }
+    Py_DECREF(dict);
+
+    // aliased values live in the target node (see util/propalias.py)
+    PyObject *cls_dict = Py_TYPE(obj)->tp_dict;
+    PyObject *aliases = NULL;
+    if ( cls_dict != NULL ) {
+        aliases = PyDict_GetItemString( cls_dict, "_aliases" );
+    }
+    if ( aliases == NULL || !PyDict_Check(aliases) ) {
+        return;
+    }
+    pos = 0;
+    while ( PyDict_Next(aliases, &pos, &key, &val) ) {
+        if ( !PyUnicode_Check(key) || !PyList_Check(val)
+             || PyList_GET_SIZE(val) < 2 ) {
+            continue;
+        }
+        PyObject *value = PyDict_GetItem( PyList_GET_ITEM(val, 0),
+                                          PyList_GET_ITEM(val, 1) );
+        if ( value != NULL ) {
+            store( value, path + "/" + PyUnicode_AsUTF8(key), frame, count );
+        }
+    }
+}
+
+void FrameSnapshot::commit() {
+    // pick a buffer that is neither the latest nor being read
+    int slot = -1;
+    {
+        std::lock_guard<std::mutex> guard( lock );
+        for ( int i = 0; i < 3; i++ ) {
+            if ( i != latest && readers[i] == 0 ) {
+                slot = i;
+                break;
+            }
+        }
+        if ( slot < 0 ) {
+            dropped++;
+            return;
+        }
+    }
+
+    // fill it (readers never touch an unpublished buffer)
+    FrameData *frame = &buffers[slot];
+    unsigned int count = 0;
+    for ( unsigned int i = 0; i < subtrees.size(); i++ ) {
+        walk( subtrees[i].node, subtrees[i].path, 0, frame, &count );
+    }
+    frame->values.resize( count );
+    frame->timestamp = get_Time();
+
+    // publish
+    std::lock_guard<std::mutex> guard( lock );
+    frame->seq = ++seq;
+    latest = slot;
+}
+
+bool FrameSnapshot::read( FrameData *frame ) {
+    int slot;
+    {
+        std::lock_guard<std::mutex> guard( lock );
+        if ( latest < 0 ) {
+            return false;
+        }
+        slot = latest;
+        readers[slot]++;
+    }
+    *frame = buffers[slot];
+    std::lock_guard<std::mutex> guard( lock );
+    readers[slot]--;
+    return true;
+}
+
+uint64_t FrameSnapshot::get_seq() {
+    std::lock_guard<std::mutex> guard( lock );
+    return seq;
+}
+
+long FrameSnapshot::get_dropped() {
+    std::lock_guard<std::mutex> guard( lock );
+    return dropped;
+}
+
+
+#ifdef HAVE_PYBIND11
+
+// the flight code publishes one snapshot per frame
+static FrameSnapshot snapshot;
+
+static void py_init() {
+    pyPropsInit();
+}
+
+static bool py_add( string path ) {
+    return snapshot.add( path );
+}
+
+static void py_commit() {
+    snapshot.commit();
+}
+
+// latest frame as (seq, timestamp, { path: value }) or None.  The copy
+// is made with the GIL released so reader threads don't stall the main
+// loop.
+static py::object py_read() {
+    FrameData frame;
+    bool result;
+    {
+        py::gil_scoped_release release;
+        result = snapshot.read( &frame );
+    }
+    if ( !result ) {
+        return py::none();
+    }
+    py::dict values;
+    for ( unsigned int i = 0; i < frame.values.size(); i++ ) {
+        FrameValue &v = frame.values[i];
+        py::str key( v.path );
+        if ( v.type == 'd' ) {
+            values[key] = py::float_( v.value );
+        } else if ( v.type == 'l' ) {
+            values[key] = py::int_( (long)v.value );
+        } else if ( v.type == 'b' ) {
+            values[key] = py::bool_( v.value != 0.0 );
+        } else {
+            values[key] = py::str( v.text );
+        }
+    }
+    return py::make_tuple( frame.seq, frame.timestamp, values );
+}
+
+static uint64_t py_seq() {
+    return snapshot.get_seq();
+}
+
+static long py_dropped() {
+    return snapshot.get_dropped();
+}
+
+PYBIND11_MODULE(frame_snapshot, m) {
+    m.doc() = "per frame property tree snapshot for off loop readers";
+    m.def("init", &py_init);
+    m.def("add", &py_add);
+    m.def("commit", &py_commit);
+    m.def("read", &py_read);
+    m.def("seq", &py_seq);
+    m.def("dropped", &py_dropped);
+  }
+#endif // HAVE_PYBIND11
@@ -0,0 +1,91 @@
+// frame_snapshot.h -- consistent per frame copies of property subtrees
+//                     for readers outside the main loop
+//
+// The property tree lives in python and may only be touched while
+// holding the GIL, so everything that looks at it (logging, telemetry,
+// telnet, http) has to run inside the main loop.  At the end of each
+// frame commit() walks the registered subtrees (on the main thread,
+// holding the GIL) and copies every value into a flat FrameData
+// buffer.  Three buffers rotate: commit() fills one that no reader is
+// holding and then publishes it as the latest.  read() pins the latest
+// buffer just long enough to copy it out, so a reader on any thread
+// sees one whole frame (never a mix of two) and never needs the GIL.
+//
+// If slow readers are holding both spare buffers a commit is dropped
+// (and counted) rather than waiting on them.
+
+#pragma once
+
+#include <pyprops.h>
+
+#include <stdint.h>
+
+#include <mutex>
+#include <string>
+#include <vector>
+using std::string;
+using std::vector;
+
+struct FrameValue {
+    string path;                // full path, i.e. "/sensors/imu[0]/hx"
+    char type;                  // 'd' double, 'l' long, 'b' bool, 's' string
+    double value;               // numeric value (bools are 0 / 1)
+    string text;                // string value
+};
+
+struct FrameData {
+    uint64_t seq;               // commit number (0 = nothing committed)
+    double timestamp;           // host time of the commit
+    vector<FrameValue> values;
+
+    FrameData(): seq(0), timestamp(0.0) {}
+
+    // index of a value by path (or -1)
+    int find( const string &path );
+};
+
+class FrameSnapshot {
+
+public:
+
+    FrameSnapshot();
+    ~FrameSnapshot();
+
+    // register a subtree ("/sensors", "/filters/filter[0]", ...)
+    bool add( string path );
+
+    // copy the registered subtrees into the next buffer and publish
+    // it (main loop only, requires the GIL)
+    void commit();
+
+    // copy out the latest frame (any thread, does not need the GIL.)
+    // Returns false if nothing has been committed yet.
+    bool read( FrameData *frame );
+
+    uint64_t get_seq();
+    long get_dropped();
+
+private:
+
+    struct Subtree {
+        string path;
+        PyObject *node;         // the python PropertyNode
+    };
+    vector<Subtree> subtrees;
+
+    FrameData buffers[3];
+    int readers[3];             // readers copying out of each buffer
+    int latest;                 // most recently published buffer (or -1)
+    uint64_t seq;
+    long dropped;
+    std::mutex lock;
+
+    void walk( PyObject *obj, const string &path, int depth,
+               FrameData *frame, unsigned int *count );
+    void store( PyObject *val, const string &path, FrameData *frame,
+                unsigned int *count );
+
+    // not copyable
+    FrameSnapshot( const FrameSnapshot & );
+    FrameSnapshot & operator= ( const FrameSnapshot & );
+};
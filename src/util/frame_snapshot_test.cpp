@@ -0,0 +1,167 @@
+// frame_snapshot_test.cpp -- commit frames of property values on the
+//                            main thread while reader threads copy
+//                            them out, check that no reader ever sees
+//                            a torn frame and time the commit.
+//
+// g++ -O3 -I.. $(python3-config --includes) frame_snapshot_test.cpp
+//     frame_snapshot.cpp prop_handle.cpp timing.cpp -lpyprops
+//     $(python3-config --ldflags --embed) -lpthread -o frame_snapshot_test
+
+#include <stdio.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include <pyprops.h>
+
+#include "timing.h"
+#include "frame_snapshot.h"
+#include "prop_handle.h"
+
+static const char *imu_names[] = {
+    "timestamp", "p_rad_sec", "q_rad_sec", "r_rad_sec", "ax_mps_sec",
+    "ay_mps_sec", "az_mps_sec", "hx", "hy", "hz", "temp_C"
+};
+static const char *filter_names[] = {
+    "timestamp", "roll_deg", "pitch_deg", "heading_deg", "latitude_deg",
+    "longitude_deg", "altitude_m", "vn_ms", "ve_ms", "vd_ms", "p_bias",
+    "q_bias", "r_bias", "ax_bias", "ay_bias", "az_bias", "groundtrack_deg",
+    "groundspeed_ms", "vertical_speed_fps"
+};
+static const int imu_count = sizeof(imu_names) / sizeof(char *);
+static const int filter_count = sizeof(filter_names) / sizeof(char *);
+
+static FrameSnapshot snapshot;
+static std::atomic<bool> done( false );
+static std::atomic<long> frames_read( 0 );
+static std::atomic<long> torn( 0 );
+static uint64_t first_seq = 0;  // frames before this are not checked
+
+// every value of frame n is n (or "n"), so a mix of two frames shows
+static void reader() {
+    FrameData frame;
+    uint64_t last = 0;
+    while ( !done ) {
+        if ( !snapshot.read( &frame ) || frame.seq < first_seq ) {
+            continue;
+        }
+        if ( frame.seq < last ) {
+            torn++;
+        }
+        last = frame.seq;
+        double n = (double)frame.seq;
+        for ( unsigned int i = 0; i < frame.values.size(); i++ ) {
+            FrameValue &v = frame.values[i];
+            if ( v.type == 's' ) {
+                if ( v.text != std::to_string(frame.seq) ) {
+                    torn++;
+                }
+            } else if ( v.value != n && v.type != 'b' ) {
+                torn++;
+            }
+        }
+        frames_read++;
+    }
+}
+
+int main() {
+    Py_Initialize();
+    pyPropsInit();
+    bool pass = true;
+
+    pyPropertyNode imu_node = pyGetNode( "/sensors/imu[0]", true );
+    pyPropertyNode filter_node = pyGetNode( "/filters/filter[0]", true );
+    pyPropertyNode status_node = pyGetNode( "/status", true );
+    PropBatch imu( imu_node, imu_names, imu_count );
+    PropBatch filter( filter_node, filter_names, filter_count );
+    double imu_vals[imu_count];
+    double filter_vals[filter_count];
+
+    snapshot.add( "/sensors" );
+    snapshot.add( "/filters" );
+    snapshot.add( "/status" );
+
+    FrameData frame;
+    if ( snapshot.read( &frame ) ) {
+        printf("FAIL: read before the first commit\n");
+        pass = false;
+    }
+
+    // uncontended commit time
+    for ( int i = 0; i < imu_count; i++ ) {
+        imu_vals[i] = 0.0;
+    }
+    for ( int i = 0; i < filter_count; i++ ) {
+        filter_vals[i] = 0.0;
+    }
+    imu.set( imu_vals );
+    filter.set( filter_vals );
+    status_node.setLong( "frame", 0 );
+    status_node.setString( "navigation", "0" );
+    const int quiet = 2000;
+    double start = get_Time();
+    for ( int n = 1; n <= quiet; n++ ) {
+        snapshot.commit();
+    }
+    double quiet_sec = get_Time() - start;
+    int base = snapshot.get_seq();
+    first_seq = base + 1;
+
+    // the python side is only touched from this thread (the GIL
+    // stays with it), the readers only see the snapshot
+    std::thread readers[3];
+    for ( int i = 0; i < 3; i++ ) {
+        readers[i] = std::thread( reader );
+    }
+    const int frames = 20000;
+    double commit_sec = 0.0;
+    for ( int n = base + 1; n <= base + frames; n++ ) {
+        for ( int i = 0; i < imu_count; i++ ) {
+            imu_vals[i] = n;
+        }
+        for ( int i = 0; i < filter_count; i++ ) {
+            filter_vals[i] = n;
+        }
+        imu.set( imu_vals );
+        filter.set( filter_vals );
+        status_node.setLong( "frame", n );
+        status_node.setString( "navigation", std::to_string(n).c_str() );
+        start = get_Time();
+        snapshot.commit();
+        commit_sec += get_Time() - start;
+        if ( snapshot.get_seq() != (uint64_t)n ) {
+            // a dropped commit: make the values match the next seq
+            n--;
+        }
+    }
+    done = true;
+    for ( int i = 0; i < 3; i++ ) {
+        readers[i].join();
+    }
+
+    snapshot.read( &frame );
+    int roll = frame.find( "/filters/filter[0]/roll_deg" );
+    int nav = frame.find( "/status/navigation" );
+    if ( roll < 0 || frame.values[roll].value != base + frames
+         || nav < 0 || frame.values[nav].text != std::to_string(base + frames) ) {
+        printf("FAIL: last frame content\n");
+        pass = false;
+    }
+    printf("%d values per frame\n", (int)frame.values.size());
+    printf("commit: %.2f us (no readers), %.2f us (3 spinning readers)\n",
+           quiet_sec * 1e6 / quiet,
+           commit_sec * 1e6 / (snapshot.get_seq() - base));
+    printf("%ld frames read, %ld commits dropped\n",
+           (long)frames_read, snapshot.get_dropped());
+    if ( torn > 0 ) {
+        printf("FAIL: %ld torn or out of order frames\n", (long)torn);
+        pass = false;
+    }
+
+    if ( !pass ) {
+        return 1;
+    }
+    printf("PASS\n");
+    return 0;
+}
@@ -0,0 +1,403 @@
+#include <pyprops.h>
+
+#include "prop_handle.h"
+
+// the attribute dictionary of a node (new reference) or NULL if the
+// node doesn't keep its attributes in one
+static PyObject *node_dict( pyPropertyNode &node ) {
+    PyObject *dict = NULL;
+    if ( Py_TYPE(node.pObj)->tp_dictoffset != 0 ) {
+        dict = PyObject_GenericGetDict( node.pObj, NULL );
+        if ( dict != NULL && !PyDict_Check(dict) ) {
+            Py_DECREF(dict);
+            dict = NULL;
+        }
+    }
+    if ( PyErr_Occurred() ) {
+        PyErr_Clear();
+    }
+    return dict;
+}
+
+// the alias cell of node.name (new reference) or NULL if it isn't an
+// alias.  Aliased nodes have a class of their own that holds a
+// { name: [ target dict, target name, target node ] } dictionary.
+static PyObject *node_alias( pyPropertyNode &node, PyObject *key ) {
+    PyObject *cls_dict = Py_TYPE(node.pObj)->tp_dict;
+    if ( cls_dict == NULL || key == NULL ) {
+        return NULL;
+    }
+    PyObject *aliases = PyDict_GetItemString( cls_dict, "_aliases" );
+    if ( aliases == NULL || !PyDict_Check(aliases) ) {
+        return NULL;
+    }
+    PyObject *cell = PyDict_GetItem( aliases, key );
+    if ( cell == NULL || !PyList_Check(cell) || PyList_GET_SIZE(cell) < 2 ) {
+        return NULL;
+    }
+    Py_INCREF(cell);
+    return cell;
+}
+
+// current storage of a value (follows re-pointed aliases)
+static inline void resolve( PyObject *alias, PyObject **dict,
+                            PyObject **key )
+{
+    if ( alias != NULL ) {
+        *dict = PyList_GET_ITEM(alias, 0);
+        *key = PyList_GET_ITEM(alias, 1);
+    }
+}
+
+bool prop_alias( pyPropertyNode &node, const char *name,
+                 pyPropertyNode &target, const char *target_name )
+{
+    static PyObject *module = NULL;
+    if ( node.isNull() || target.isNull() ) {
+        return false;
+    }
+    if ( module == NULL ) {
+        module = PyImport_ImportModule( "util.propalias" );
+        if ( module == NULL ) {
+            PyErr_Print();
+            return false;
+        }
+    }
+    PyObject *result = PyObject_CallMethod( module, "alias", "OsOs",
+                                            node.pObj, name,
+                                            target.pObj, target_name );
+    if ( result == NULL ) {
+        PyErr_Print();
+        return false;
+    }
+    bool ok = PyObject_IsTrue( result );
+    Py_DECREF(result);
+    return ok;
+}
+
+// convert a (borrowed) attribute value, missing values read as zero
+static double value_to_double( PyObject *val, const char *name ) {
+    if ( val == NULL ) {
+        return 0.0;
+    } else if ( PyFloat_CheckExact(val) ) {
+        return PyFloat_AS_DOUBLE(val);
+    } else if ( PyLong_CheckExact(val) ) {
+        return PyLong_AsDouble(val);
+    }
+    // slow path for strings, bools and anything else float() accepts
+    double result = 0.0;
+    PyObject *pFloat = PyNumber_Float( val );
+    if ( pFloat != NULL ) {
+        result = PyFloat_AS_DOUBLE(pFloat);
+        Py_DECREF(pFloat);
+    } else {
+        PyErr_Clear();
+        printf("WARNING: %s is not a number\n", name);
+    }
+    return result;
+}
+
+static long value_to_long( PyObject *val, const char *name ) {
+    if ( val != NULL && PyLong_CheckExact(val) ) {
+        return PyLong_AsLong(val);
+    }
+    return (long)value_to_double( val, name );
+}
+
+static void dict_set_double( PyObject *dict, PyObject *key, double val ) {
+    PyObject *pFloat = PyFloat_FromDouble( val );
+    PyDict_SetItem( dict, key, pFloat );
+    Py_DECREF(pFloat);
+}
+
+static void dict_set_long( PyObject *dict, PyObject *key, long val ) {
+    PyObject *pLong = PyLong_FromLong( val );
+    PyDict_SetItem( dict, key, pLong );
+    Py_DECREF(pLong);
+}
+
+PropHandle::PropHandle():
+    dict(NULL),
+    key(NULL),
+    alias(NULL)
+{
+}
+
+PropHandle::PropHandle( pyPropertyNode &node, const char *name ):
+    dict(NULL),
+    key(NULL),
+    alias(NULL)
+{
+    init( node, name );
+}
+
+PropHandle::PropHandle( string prop, bool create ):
+    dict(NULL),
+    key(NULL),
+    alias(NULL)
+{
+    init( prop, create );
+}
+
+PropHandle::PropHandle( const PropHandle &h ):
+    dict(NULL),
+    key(NULL),
+    alias(NULL)
+{
+    *this = h;
+}
+
+PropHandle::~PropHandle() {
+    release();
+}
+
+PropHandle & PropHandle::operator= ( const PropHandle &h ) {
+    if ( this != &h ) {
+        Py_XINCREF(h.dict);
+        Py_XINCREF(h.key);
+        Py_XINCREF(h.alias);
+        release();
+        // (a null pyPropertyNode can't be copied)
+        if ( h.node.pObj != NULL ) {
+            node = h.node;
+        }
+        name = h.name;
+        dict = h.dict;
+        key = h.key;
+        alias = h.alias;
+    }
+    return *this;
+}
+
+void PropHandle::release() {
+    Py_XDECREF(dict);
+    Py_XDECREF(key);
+    Py_XDECREF(alias);
+    dict = NULL;
+    key = NULL;
+    alias = NULL;
+}
+
+bool PropHandle::init( pyPropertyNode &node, const char *name ) {
+    release();
+    this->name = name;
+    if ( node.isNull() ) {
+        return false;
+    }
+    this->node = node;
+    key = PyUnicode_InternFromString( name );
+    dict = node_dict( node );
+    alias = node_alias( node, key );
+    return true;
+}
+
+bool PropHandle::init( string prop, bool create ) {
+    size_t pos = prop.rfind("/");
+    if ( pos == string::npos ) {
+        printf("WARNING: requested bad property path: %s\n", prop.c_str());
+        release();
+        name = "";
+        return false;
+    }
+    string path = prop.substr(0, pos);
+    string attr = prop.substr(pos+1);
+    pyPropertyNode prop_node = pyGetNode( path, create );
+    return init( prop_node, attr.c_str() );
+}
+
+double PropHandle::getDouble() {
+    if ( dict == NULL ) {
+        return node.getDouble( name.c_str() );
+    }
+    PyObject *d = dict, *k = key;
+    resolve( alias, &d, &k );
+    return value_to_double( PyDict_GetItem(d, k), name.c_str() );
+}
+
+long PropHandle::getLong() {
+    if ( dict == NULL ) {
+        return node.getLong( name.c_str() );
+    }
+    PyObject *d = dict, *k = key;
+    resolve( alias, &d, &k );
+    return value_to_long( PyDict_GetItem(d, k), name.c_str() );
+}
+
+bool PropHandle::getBool() {
+    if ( dict == NULL ) {
+        return node.getBool( name.c_str() );
+    }
+    PyObject *d = dict, *k = key;
+    resolve( alias, &d, &k );
+    PyObject *val = PyDict_GetItem( d, k );
+    if ( val == NULL ) {
+        return false;
+    }
+    return PyObject_IsTrue(val);
+}
+
+void PropHandle::setDouble( double val ) {
+    if ( dict == NULL ) {
+        node.setDouble( name.c_str(), val );
+        return;
+    }
+    PyObject *d = dict, *k = key;
+    resolve( alias, &d, &k );
+    dict_set_double( d, k, val );
+}
+
+void PropHandle::setLong( long val ) {
+    if ( dict == NULL ) {
+        node.setLong( name.c_str(), val );
+        return;
+    }
+    PyObject *d = dict, *k = key;
+    resolve( alias, &d, &k );
+    dict_set_long( d, k, val );
+}
+
+void PropHandle::setBool( bool val ) {
+    if ( dict == NULL ) {
+        node.setBool( name.c_str(), val );
+        return;
+    }
+    PyObject *d = dict, *k = key;
+    resolve( alias, &d, &k );
+    PyDict_SetItem( d, k, val ? Py_True : Py_False );
+}
+
+
+PropBatch::PropBatch():
+    dict(NULL)
+{
+}
+
+PropBatch::PropBatch( pyPropertyNode &node, const char **names, int count ):
+    dict(NULL)
+{
+    init( node, names, count );
+}
+
+PropBatch::~PropBatch() {
+    release();
+}
+
+void PropBatch::release() {
+    Py_XDECREF(dict);
+    dict = NULL;
+    for ( unsigned int i = 0; i < keys.size(); i++ ) {
+        Py_XDECREF(keys[i]);
+        Py_XDECREF(aliases[i]);
+    }
+    keys.clear();
+    aliases.clear();
+    names.clear();
+}
+
+bool PropBatch::init( pyPropertyNode &node, const char **names, int count ) {
+    release();
+    if ( node.isNull() ) {
+        return false;
+    }
+    this->node = node;
+    for ( int i = 0; i < count; i++ ) {
+        this->names.push_back( names[i] );
+        keys.push_back( PyUnicode_InternFromString(names[i]) );
+        aliases.push_back( node_alias(node, keys[i]) );
+    }
+    dict = node_dict( node );
+    return true;
+}
+
+void PropBatch::get( double *values ) {
+    if ( dict == NULL ) {
+        for ( unsigned int i = 0; i < keys.size(); i++ ) {
+            values[i] = node.getDouble( names[i].c_str() );
+        }
+        return;
+    }
+    for ( unsigned int i = 0; i < keys.size(); i++ ) {
+        PyObject *d = dict, *k = keys[i];
+        resolve( aliases[i], &d, &k );
+        values[i] = value_to_double( PyDict_GetItem(d, k), names[i].c_str() );
+    }
+}
+
+void PropBatch::set( const double *values ) {
+    if ( dict == NULL ) {
+        for ( unsigned int i = 0; i < keys.size(); i++ ) {
+            node.setDouble( names[i].c_str(), values[i] );
+        }
+        return;
+    }
+    for ( unsigned int i = 0; i < keys.size(); i++ ) {
+        PyObject *d = dict, *k = keys[i];
+        resolve( aliases[i], &d, &k );
+        dict_set_double( d, k, values[i] );
+    }
+}
+
+void PropBatch::set( const long *values ) {
+    if ( dict == NULL ) {
+        for ( unsigned int i = 0; i < keys.size(); i++ ) {
+            node.setLong( names[i].c_str(), values[i] );
+        }
+        return;
+    }
+    for ( unsigned int i = 0; i < keys.size(); i++ ) {
+        PyObject *d = dict, *k = keys[i];
+        resolve( aliases[i], &d, &k );
+        dict_set_long( d, k, values[i] );
+    }
+}
+
+
+PropWatch::PropWatch():
+    cell(NULL),
+    seen(-1)
+{
+}
+
+PropWatch::~PropWatch() {
+    Py_XDECREF(cell);
+}
+
+bool PropWatch::init( pyPropertyNode &node ) {
+    static PyObject *module = NULL;
+    Py_XDECREF(cell);
+    cell = NULL;
+    seen = -1;
+    if ( node.isNull() ) {
+        return false;
+    }
+    if ( module == NULL ) {
+        module = PyImport_ImportModule( "util.propwatch" );
+        if ( module == NULL ) {
+            PyErr_Print();
+            return false;
+        }
+    }
+    PyObject *result = PyObject_CallMethod( module, "watch", "O", node.pObj );
+    if ( result == NULL ) {
+        PyErr_Print();
+        return false;
+    }
+    if ( !PyList_Check(result) || PyList_GET_SIZE(result) < 1 ) {
+        Py_DECREF(result);
+        return false;
+    }
+    cell = result;
+    return true;
+}
+
+bool PropWatch::changed() {
+    if ( cell == NULL ) {
+        return true;
+    }
+    long version = PyLong_AsLong( PyList_GET_ITEM(cell, 0) );
+    if ( version == seen ) {
+        return false;
+    }
+    seen = version;
+    return true;
+}
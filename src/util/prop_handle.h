@@ -0,0 +1,139 @@
+#pragma once
+
+// pre-resolved handles to property tree values (single values and blocks)
+//
+// pyPropertyNode::getDouble("name") (and friends) converts the name to a
+// python string, hashes it and runs the full python attribute lookup on
+// every call, and every setDouble() boxes a new python float.  A
+// PropHandle resolves a (node, attribute) pair once at init: it keeps the
+// node's attribute dictionary and an interned copy of the name, so a
+// read or write is a single dictionary probe with no string work (a
+// write still boxes a new python float.)
+//
+// The value still lives in the python PropertyNode, so python getNode()
+// access sees exactly what C++ wrote (and vice versa.)  Nodes without an
+// attribute dictionary fall back to the pyPropertyNode calls.  Like
+// pyPropertyNode, handles may only be used while holding the GIL.
+//
+// A handle to an aliased attribute (see util/propalias.py) keeps the
+// alias cell and follows it to the target's storage, so re-pointing an
+// alias re-points the handles too.
+//
+// A PropWatch tells a reader that caches values (i.e. configuration)
+// when anything in a subtree was written (see util/propwatch.py.)
+
+#include <pyprops.h>
+
+#include <string>
+#include <vector>
+using std::string;
+using std::vector;
+
+// make node.name an alias of target.target_name (util/propalias.py)
+bool prop_alias( pyPropertyNode &node, const char *name,
+                 pyPropertyNode &target, const char *target_name );
+
+class PropHandle {
+
+public:
+
+    PropHandle();
+    PropHandle( pyPropertyNode &node, const char *name );
+    PropHandle( string prop, bool create=true ); // "/path/to/node/attr"
+    PropHandle( const PropHandle &h );
+    ~PropHandle();
+
+    PropHandle & operator= ( const PropHandle &h );
+
+    bool init( pyPropertyNode &node, const char *name );
+    bool init( string prop, bool create=true );
+
+    bool isNull() { return node.isNull(); }
+    string get_name() { return name; }
+
+    // value getters (missing values read as zero / false)
+    double getDouble();
+    long getLong();
+    bool getBool();
+
+    // value setters
+    void setDouble( double val );
+    void setLong( long val );
+    void setBool( bool val );
+
+private:
+
+    pyPropertyNode node;
+    string name;
+    PyObject *dict;             // node attribute dictionary (or NULL)
+    PyObject *key;              // interned attribute name
+    PyObject *alias;            // alias cell (or NULL)
+
+    void release();
+};
+
+// A fixed list of attributes of one node that is read or written as a
+// block: one call moves a whole publisher's worth of values between a
+// C array and the property tree (in the order of the names.)
+
+class PropBatch {
+
+public:
+
+    PropBatch();
+    PropBatch( pyPropertyNode &node, const char **names, int count );
+    ~PropBatch();
+
+    bool init( pyPropertyNode &node, const char **names, int count );
+    int size() { return keys.size(); }
+
+    // read every value (missing values read as zero)
+    void get( double *values );
+
+    // write every value
+    void set( const double *values );
+    void set( const long *values );
+
+private:
+
+    pyPropertyNode node;
+    vector<string> names;
+    PyObject *dict;             // node attribute dictionary (or NULL)
+    vector<PyObject *> keys;    // interned attribute names
+    vector<PyObject *> aliases; // alias cells (or NULL)
+
+    void release();
+
+    // not copyable
+    PropBatch( const PropBatch & );
+    PropBatch & operator= ( const PropBatch & );
+};
+
+// Change counter of a watched subtree: changed() compares the shared
+// version cell with the last value seen (no python calls, no string
+// work), so a reader can keep native copies of the values and refresh
+// them only after a write.  If the watch can't be set up changed()
+// always returns true (the reader falls back to reading every time.)
+
+class PropWatch {
+
+public:
+
+    PropWatch();
+    ~PropWatch();
+
+    bool init( pyPropertyNode &node );
+
+    // true on the first call and after any write below the node since
+    // the previous call
+    bool changed();
+
+private:
+
+    PyObject *cell;             // shared [ version ] list (or NULL)
+    long seen;
+
+    // not copyable
+    PropWatch( const PropWatch & );
+    PropWatch & operator= ( const PropWatch & );
+};
@@ -0,0 +1,293 @@
+// prop_handle_test.cpp -- per frame property traffic through named
+//                         pyPropertyNode calls vs. pre-resolved
+//                         PropHandles vs. PropBatch blocks, and check
+//                         that python sees the handle writes and that
+//                         aliases forward and watches see config
+//                         writes.  (Run from src/util with PYTHONPATH=..
+//                         so util.propalias / util.propwatch import.)
+//
+// g++ -O3 -I.. $(python3-config --includes) prop_handle_test.cpp
+//     prop_handle.cpp timing.cpp -lpyprops
+//     $(python3-config --ldflags --embed) -o prop_handle_test
+
+#include <math.h>
+#include <stdio.h>
+
+#include <pyprops.h>
+
+#include "timing.h"
+#include "prop_handle.h"
+
+// one frame of filter traffic (the same fields as the ekf
+// props2umn() / umn2props() and filter_mgr publish_values())
+static const char *imu_names[] = {
+    "timestamp", "p_rad_sec", "q_rad_sec", "r_rad_sec", "ax_mps_sec",
+    "ay_mps_sec", "az_mps_sec", "hx", "hy", "hz"
+};
+static const char *gps_names[] = {
+    "timestamp", "latitude_deg", "longitude_deg", "altitude_m", "vn_ms",
+    "ve_ms", "vd_ms"
+};
+static const char *filter_names[] = {
+    "timestamp", "roll_deg", "pitch_deg", "heading_deg", "latitude_deg",
+    "longitude_deg", "altitude_m", "vn_ms", "ve_ms", "vd_ms", "p_bias",
+    "q_bias", "r_bias", "ax_bias", "ay_bias", "az_bias", "groundtrack_deg",
+    "groundspeed_ms", "vertical_speed_fps"
+};
+static const int imu_count = sizeof(imu_names) / sizeof(char *);
+static const int gps_count = sizeof(gps_names) / sizeof(char *);
+static const int filter_count = sizeof(filter_names) / sizeof(char *);
+static const int accesses = imu_count + gps_count + filter_count * 2;
+
+static double named_frame( pyPropertyNode &imu, pyPropertyNode &gps,
+                           pyPropertyNode &filter, int frame )
+{
+    double sum = 0.0;
+    for ( int i = 0; i < imu_count; i++ ) {
+        sum += imu.getDouble( imu_names[i] );
+    }
+    for ( int i = 0; i < gps_count; i++ ) {
+        sum += gps.getDouble( gps_names[i] );
+    }
+    for ( int i = 0; i < filter_count; i++ ) {
+        filter.setDouble( filter_names[i], sum + frame + i );
+    }
+    for ( int i = 0; i < filter_count; i++ ) {
+        sum += filter.getDouble( filter_names[i] );
+    }
+    return sum;
+}
+
+static double handle_frame( PropHandle *imu, PropHandle *gps,
+                            PropHandle *filter, int frame )
+{
+    double sum = 0.0;
+    for ( int i = 0; i < imu_count; i++ ) {
+        sum += imu[i].getDouble();
+    }
+    for ( int i = 0; i < gps_count; i++ ) {
+        sum += gps[i].getDouble();
+    }
+    for ( int i = 0; i < filter_count; i++ ) {
+        filter[i].setDouble( sum + frame + i );
+    }
+    for ( int i = 0; i < filter_count; i++ ) {
+        sum += filter[i].getDouble();
+    }
+    return sum;
+}
+
+static double batch_frame( PropBatch &imu, PropBatch &gps,
+                           PropBatch &filter, int frame )
+{
+    double imu_vals[imu_count];
+    double gps_vals[gps_count];
+    double filter_vals[filter_count];
+    double sum = 0.0;
+    imu.get( imu_vals );
+    gps.get( gps_vals );
+    for ( int i = 0; i < imu_count; i++ ) {
+        sum += imu_vals[i];
+    }
+    for ( int i = 0; i < gps_count; i++ ) {
+        sum += gps_vals[i];
+    }
+    for ( int i = 0; i < filter_count; i++ ) {
+        filter_vals[i] = sum + frame + i;
+    }
+    filter.set( filter_vals );
+    filter.get( filter_vals );
+    for ( int i = 0; i < filter_count; i++ ) {
+        sum += filter_vals[i];
+    }
+    return sum;
+}
+
+// evaluate a python expression and return it as a double
+static double py_eval( const char *expr ) {
+    PyObject *main = PyImport_AddModule( "__main__" );
+    PyObject *globals = PyModule_GetDict( main );
+    PyObject *val = PyRun_String( expr, Py_eval_input, globals, globals );
+    if ( val == NULL ) {
+        PyErr_Print();
+        return NAN;
+    }
+    double result = PyFloat_AsDouble( val );
+    Py_DECREF(val);
+    return result;
+}
+
+int main() {
+    Py_Initialize();
+    pyPropsInit();
+    bool pass = true;
+
+    pyPropertyNode imu_node = pyGetNode( "/sensors/imu[0]", true );
+    pyPropertyNode gps_node = pyGetNode( "/sensors/gps[0]", true );
+    pyPropertyNode filter_node = pyGetNode( "/filters/filter[0]", true );
+    for ( int i = 0; i < imu_count; i++ ) {
+        imu_node.setDouble( imu_names[i], 0.01 * i );
+    }
+    for ( int i = 0; i < gps_count; i++ ) {
+        gps_node.setDouble( gps_names[i], 10.0 * i );
+    }
+
+    PropHandle imu[imu_count];
+    PropHandle gps[gps_count];
+    PropHandle filter[filter_count];
+    for ( int i = 0; i < imu_count; i++ ) {
+        imu[i].init( imu_node, imu_names[i] );
+    }
+    for ( int i = 0; i < gps_count; i++ ) {
+        gps[i].init( gps_node, gps_names[i] );
+    }
+    for ( int i = 0; i < filter_count; i++ ) {
+        filter[i].init( filter_node, filter_names[i] );
+    }
+
+    PropBatch imu_batch( imu_node, imu_names, imu_count );
+    PropBatch gps_batch( gps_node, gps_names, gps_count );
+    PropBatch filter_batch( filter_node, filter_names, filter_count );
+
+    // all paths must produce the same values
+    double a = named_frame( imu_node, gps_node, filter_node, 1 );
+    double b = handle_frame( imu, gps, filter, 1 );
+    double c = batch_frame( imu_batch, gps_batch, filter_batch, 1 );
+    if ( a != b || a != c ) {
+        printf("FAIL: handle frame %.6f batch frame %.6f != named frame %.6f\n",
+               b, c, a);
+        pass = false;
+    }
+
+    // python sees handle writes, and a value python is holding on to
+    // is not changed underneath it
+    PyRun_SimpleString( "import props\n"
+                        "f = props.getNode('/filters/filter[0]')\n"
+                        "held = f.roll_deg\n" );
+    double held = py_eval( "held" );
+    filter[1].setDouble( 12.5 );
+    if ( py_eval("f.roll_deg") != 12.5 || py_eval("held") != held ) {
+        printf("FAIL: python view of a handle write\n");
+        pass = false;
+    }
+    PyRun_SimpleString( "del held" );
+    filter[1].setDouble( -3.25 );
+    if ( py_eval("f.roll_deg") != -3.25 ) {
+        printf("FAIL: python view of an in place write\n");
+        pass = false;
+    }
+    PyRun_SimpleString( "f.roll_deg = 7\n"
+                        "f.status = '2'\n" );
+    PropHandle status( filter_node, "status" );
+    PropHandle missing( "/filters/filter[0]/no_such_value" );
+    if ( filter[1].getDouble() != 7.0 || filter[1].getLong() != 7
+         || status.getDouble() != 2.0 || missing.getDouble() != 0.0 ) {
+        printf("FAIL: handle view of python writes\n");
+        pass = false;
+    }
+    PropHandle flag( "/filters/filter[0]/enable" );
+    flag.setBool( true );
+    if ( py_eval("1.0 if f.enable is True else 0.0") != 1.0 ) {
+        printf("FAIL: bool write\n");
+        pass = false;
+    }
+
+    // aliases read and write the target storage, and handles follow a
+    // re-pointed alias
+    pyPropertyNode orient_node = pyGetNode( "/orientation", true );
+    pyPropertyNode filter1_node = pyGetNode( "/filters/filter[1]", true );
+    orient_node.setDouble( "roll_deg", 99.0 );
+    filter1_node.setDouble( "roll_deg", 45.0 );
+    if ( !prop_alias( orient_node, "roll_deg", filter_node, "roll_deg" ) ) {
+        printf("FAIL: prop_alias()\n");
+        pass = false;
+    }
+    PropHandle orient_roll( orient_node, "roll_deg" );
+    const char *orient_names[] = { "roll_deg" };
+    PropBatch orient_batch( orient_node, orient_names, 1 );
+    double roll;
+    filter[1].setDouble( 10.0 );
+    orient_batch.get( &roll );
+    if ( orient_node.getDouble("roll_deg") != 10.0
+         || orient_roll.getDouble() != 10.0 || roll != 10.0
+         || py_eval("props.getNode('/orientation').roll_deg") != 10.0 ) {
+        printf("FAIL: alias read\n");
+        pass = false;
+    }
+    orient_roll.setDouble( 20.0 );
+    if ( filter[1].getDouble() != 20.0 ) {
+        printf("FAIL: alias write\n");
+        pass = false;
+    }
+    prop_alias( orient_node, "roll_deg", filter1_node, "roll_deg" );
+    orient_batch.get( &roll );
+    if ( orient_roll.getDouble() != 45.0 || roll != 45.0
+         || orient_node.getDouble("roll_deg") != 45.0 ) {
+        printf("FAIL: re-pointed alias\n");
+        pass = false;
+    }
+
+    // a watch sees writes below the node (including new children) and
+    // is quiet otherwise
+    pyPropertyNode config_node = pyGetNode( "/config/autopilot/component[0]",
+                                            true );
+    config_node.setDouble( "Kp", 0.5 );
+    PropWatch watch;
+    if ( !watch.init( config_node ) || !watch.changed() || watch.changed() ) {
+        printf("FAIL: watch init\n");
+        pass = false;
+    }
+    config_node.getDouble( "Kp" );
+    filter[1].setDouble( 5.0 );
+    if ( watch.changed() ) {
+        printf("FAIL: watch saw a read\n");
+        pass = false;
+    }
+    config_node.setDouble( "Kp", 0.6 );
+    bool c_write = watch.changed();
+    py_eval( "setattr(props.getNode('/config/autopilot/component[0]/config',"
+             " True), 'Ti', 2.0) or 0.0" );
+    bool c_child = watch.changed();
+    if ( !c_write || !c_child || watch.changed() ) {
+        printf("FAIL: watch missed a write\n");
+        pass = false;
+    }
+
+    // per frame timing
+    const int frames = 20000;
+    double sum = 0.0;
+    double start = get_Time();
+    for ( int i = 0; i < frames; i++ ) {
+        sum += named_frame( imu_node, gps_node, filter_node, i );
+    }
+    double named_sec = get_Time() - start;
+    start = get_Time();
+    for ( int i = 0; i < frames; i++ ) {
+        sum -= handle_frame( imu, gps, filter, i );
+    }
+    double handle_sec = get_Time() - start;
+    start = get_Time();
+    for ( int i = 0; i < frames; i++ ) {
+        sum += batch_frame( imu_batch, gps_batch, filter_batch, i );
+    }
+    double batch_sec = get_Time() - start;
+    printf("%d property accesses per frame\n", accesses);
+    printf("named:   %.2f us per frame (%.3f us per access)\n",
+           named_sec * 1e6 / frames, named_sec * 1e6 / (frames * accesses));
+    printf("handles: %.2f us per frame (%.3f us per access)  %.1fx  [%.1e]\n",
+           handle_sec * 1e6 / frames, handle_sec * 1e6 / (frames * accesses),
+           named_sec / handle_sec, sum);
+    printf("batches: %.2f us per frame (%.3f us per access)  %.1fx\n",
+           batch_sec * 1e6 / frames, batch_sec * 1e6 / (frames * accesses),
+           named_sec / batch_sec);
+    if ( handle_sec > named_sec || batch_sec > named_sec ) {
+        printf("FAIL: resolved access is slower than named access\n");
+        pass = false;
+    }
+
+    if ( !pass ) {
+        return 1;
+    }
+    printf("PASS\n");
+    return 0;
+}
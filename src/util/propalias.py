@@ -0,0 +1,110 @@
+# Property tree aliases
+#
+# alias(node, name, target, target_name) makes node.name a view of
+# target.target_name: reads and writes (from python or through the C++
+# pyPropertyNode / PropHandle / PropBatch calls) go straight to the
+# target node's storage, nothing is copied per frame.  Calling alias()
+# again for the same node.name re-points it (i.e. to switch the
+# primary filter) and every reader follows immediately.
+#
+# Each alias is a shared cell [ target __dict__, target name, target
+# node ] hung off a per node subclass of PropertyNode (so other nodes
+# are untouched.)  The subclass exposes the alias as a data descriptor
+# (for attribute access) and forwards the name based accessor methods
+# (getFloat(), setFloat(), ...) to the target.  Alias chains are
+# resolved once when the alias is made.  C++ handles resolve the cell
+# at init, so handles bound before an alias is made keep pointing at
+# the old value.
+
+import sys
+
+import props
+
+PropertyNode = props.PropertyNode
+
+# accessor methods that take the attribute name as the first argument
+_forward_methods = [ 'getFloat', 'getInt', 'getBool', 'getString',
+                     'setFloat', 'setInt', 'setBool', 'setString',
+                     'getFloatEnum', 'getIntEnum', 'getStringEnum',
+                     'setFloatEnum', 'setIntEnum', 'setStringEnum',
+                     'hasChild', 'isLeaf', 'isEnum', 'getLen', 'setLen' ]
+
+class _AliasValue():
+    def __init__(self, cell):
+        self.cell = cell
+
+    def __get__(self, obj, objtype=None):
+        if obj is None:
+            return self
+        try:
+            return self.cell[0][self.cell[1]]
+        except KeyError:
+            raise AttributeError(self.cell[1])
+
+    def __set__(self, obj, value):
+        self.cell[0][self.cell[1]] = value
+
+    def __delete__(self, obj):
+        raise AttributeError('can not delete an alias')
+
+def _make_forward(method):
+    base = getattr(PropertyNode, method)
+    def forward(self, name, *args):
+        cell = type(self)._aliases.get(name)
+        if cell is None:
+            return base(self, name, *args)
+        return getattr(cell[2], method)(cell[1], *args)
+    return forward
+
+def _getChildren(self, *args, **kwargs):
+    result = PropertyNode.getChildren(self, *args, **kwargs)
+    for name in type(self)._aliases:
+        if name not in result:
+            result.append(name)
+    return result
+
+# give the node its own subclass to hang aliases on
+def _alias_class(node):
+    cls = type(node)
+    if '_aliases' in cls.__dict__:
+        return cls
+    members = { '_aliases': {} }
+    for method in _forward_methods:
+        if hasattr(PropertyNode, method):
+            members[method] = _make_forward(method)
+    if hasattr(PropertyNode, 'getChildren'):
+        members['getChildren'] = _getChildren
+    cls = type('AliasedPropertyNode', (cls,), members)
+    node.__class__ = cls
+    return cls
+
+# the alias cell of node.name (or None)
+def lookup(node, name):
+    aliases = type(node).__dict__.get('_aliases')
+    if aliases is None:
+        return None
+    return aliases.get(name)
+
+def alias(node, name, target, target_name):
+    # resolve chains once
+    cell = lookup(target, target_name)
+    if cell is not None:
+        target = cell[2]
+        target_name = cell[1]
+    if target is node and target_name == name:
+        print('WARNING: alias of %s to itself ignored' % name)
+        return False
+    target_name = sys.intern(target_name)
+    cls = _alias_class(node)
+    cell = cls._aliases.get(name)
+    if cell is None:
+        cell = [ target.__dict__, target_name, target ]
+        cls._aliases[name] = cell
+        node.__dict__.pop(name, None)
+        setattr(cls, name, _AliasValue(cell))
+    else:
+        # re-point in place so everything holding the cell follows
+        cell[0] = target.__dict__
+        cell[1] = target_name
+        cell[2] = target
+    return True
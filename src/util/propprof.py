@@ -0,0 +1,158 @@
+# Per path property access profiler
+#
+# Counts the reads and writes of every (node path, attribute) in the
+# property tree and the time spent in them, and reports them per frame.
+# The time is the whole hooked attribute call (the lookup or store plus
+# the profiler's own bookkeeping), so it overstates the unprofiled cost
+# by a roughly fixed amount per call.  The 'new num' column counts the
+# writes that stored a different int or float object than the one they
+# replaced: an estimate of the writes that boxed a new python number
+# (cached small ints and reused objects count too.)
+#
+# All named access ends up in the python PropertyNode attribute
+# protocol (C++ pyPropertyNode get/set calls and python code alike), so
+# the profiler hooks __getattribute__ / __setattr__ of the node class
+# while it is enabled and unhooks it when disabled (zero cost when off.)
+# Pre-resolved C++ PropHandle / PropBatch access goes straight to the
+# node dictionaries and does not show up, which is the point: what is
+# left in the report is what still pays for named lookups.
+#
+# Enable with /config/profile_props = true or the telnet 'propprof on'
+# command.
+
+import atexit
+import time
+
+import props
+from props import root
+
+PropertyNode = props.PropertyNode
+
+# original attribute protocol of the node class
+_get = object.__getattribute__
+_orig_getattr = PropertyNode.__dict__.get('__getattribute__')
+_orig_setattr = PropertyNode.__dict__.get('__setattr__')
+_base_setattr = PropertyNode.__setattr__
+
+enabled = False
+frames = 0
+start_frames = 0
+stats = {}                      # (id(node), attr) -> [reads, writes, sec, new_num]
+nodes = {}                      # id(node) -> node (keeps ids valid)
+
+def _prof_getattr(self, name):
+    t0 = time.perf_counter()
+    result = _get(self, name)
+    # only count values (methods and other class attributes are not
+    # property accesses)
+    if name in _get(self, '__dict__'):
+        key = (id(self), name)
+        s = stats.get(key)
+        if s is None:
+            s = stats[key] = [0, 0, 0.0, 0]
+            nodes[id(self)] = self
+        s[0] += 1
+        s[2] += time.perf_counter() - t0
+    return result
+
+def _prof_setattr(self, name, value):
+    t0 = time.perf_counter()
+    old = _get(self, '__dict__').get(name)
+    _base_setattr(self, name, value)
+    key = (id(self), name)
+    s = stats.get(key)
+    if s is None:
+        s = stats[key] = [0, 0, 0.0, 0]
+        nodes[id(self)] = self
+    s[1] += 1
+    # a different number object than the one replaced (likely boxed)
+    if old is not value and type(value) in (float, int):
+        s[3] += 1
+    s[2] += time.perf_counter() - t0
+
+def enable():
+    global enabled
+    if not enabled:
+        PropertyNode.__getattribute__ = _prof_getattr
+        PropertyNode.__setattr__ = _prof_setattr
+        enabled = True
+
+def disable():
+    global enabled
+    if enabled:
+        if _orig_getattr is None:
+            del PropertyNode.__getattribute__
+        else:
+            PropertyNode.__getattribute__ = _orig_getattr
+        if _orig_setattr is None:
+            del PropertyNode.__setattr__
+        else:
+            PropertyNode.__setattr__ = _orig_setattr
+        enabled = False
+
+def reset():
+    global start_frames
+    stats.clear()
+    nodes.clear()
+    start_frames = frames
+
+# call once per main loop frame
+def frame():
+    global frames
+    frames += 1
+
+# map node ids back to their paths in the tree
+def _node_paths():
+    paths = {}
+    pending = [ ('', root) ]
+    while len(pending):
+        path, node = pending.pop()
+        paths[id(node)] = path
+        for name, child in _get(node, '__dict__').items():
+            if isinstance(child, PropertyNode):
+                pending.append( (path + '/' + name, child) )
+            elif type(child) is list:
+                for i, item in enumerate(child):
+                    if isinstance(item, PropertyNode):
+                        pending.append( ('%s/%s[%d]' % (path, name, i), item) )
+    return paths
+
+# report lines sorted by time per frame (worst first)
+def report(count=25):
+    was_enabled = enabled
+    disable()                   # don't profile the report
+    n = frames - start_frames
+    if n < 1:
+        n = 1
+    paths = _node_paths()
+    rows = []
+    total_calls = 0
+    total_sec = 0.0
+    total_new = 0
+    for key, s in stats.items():
+        path = paths.get(key[0], '?') + '/' + key[1]
+        rows.append( (s[2], path, s[0], s[1], s[3]) )
+        total_calls += s[0] + s[1]
+        total_sec += s[2]
+        total_new += s[3]
+    rows.sort(reverse=True)
+    lines = []
+    lines.append('property access over %d frames: %.1f calls %.1f us (hooked call time, profiler included) %.1f new numbers written per frame'
+                 % (n, total_calls / n, 1e6 * total_sec / n, total_new / n))
+    lines.append('%10s %10s %10s %10s  %s' % ('call us', 'reads', 'writes', 'new num', 'path'))
+    for sec, path, reads, writes, new_num in rows[:count]:
+        lines.append('%10.2f %10.1f %10.1f %10.1f  %s'
+                     % (1e6 * sec / n, reads / n, writes / n, new_num / n, path))
+    if was_enabled:
+        enable()
+    return '\n'.join(lines) + '\n'
+
+def _shutdown():
+    if len(stats):
+        print(report())
+
+def init():
+    config_node = props.getNode('/config', True)
+    if config_node.getBool('profile_props'):
+        enable()
+    atexit.register(_shutdown)
@@ -0,0 +1,110 @@
+# Property tree change notification
+#
+# watch(node) returns a version cell [ count ] that is bumped by every
+# write to a value anywhere in the subtree below node: python attribute
+# writes, the set*() accessors and the C++ pyPropertyNode setters (which
+# go through the python attribute protocol.)  A reader that caches
+# configuration values (i.e. the autopilot components, see PropWatch in
+# util/prop_handle.h) compares the count once per update and only
+# re-reads the tree when it moved, so values tuned from the ground
+# station, auratuner or telnet still take effect on the next frame.
+#
+# Watched nodes are switched to a subclass of their PropertyNode class
+# that bumps the cells of every watch they belong to.  Nodes added
+# later (by assignment or getChild(create=True)) join the watches of
+# their parent.  Writes that bypass the node (C++ setDouble(name,
+# index) into a value list, PropHandle / PropBatch writes straight into
+# the node dictionary) are not seen: those are meant for per frame
+# data, not configuration.
+
+import props
+
+PropertyNode = props.PropertyNode
+
+# accessor methods that change a value
+_set_methods = [ 'setFloat', 'setInt', 'setBool', 'setString',
+                 'setFloatEnum', 'setIntEnum', 'setBoolEnum',
+                 'setStringEnum', 'setLen' ]
+
+# version cells of each watched node (by id)
+_cells = {}
+
+# watched subclass of each node class
+_classes = {}
+
+def _bump(cells):
+    for cell in cells:
+        cell[0] += 1
+
+def _adopt(value, cells):
+    if isinstance(value, PropertyNode):
+        _join(value, cells)
+    elif isinstance(value, list):
+        for item in value:
+            if isinstance(item, PropertyNode):
+                _join(item, cells)
+
+def _make_setter(base):
+    def __setattr__(self, name, value):
+        base.__setattr__(self, name, value)
+        cells = _cells.get(id(self))
+        if cells:
+            _adopt(value, cells)
+            _bump(cells)
+    return __setattr__
+
+def _make_set_method(base, method):
+    func = getattr(base, method)
+    def set_method(self, *args, **kwargs):
+        result = func(self, *args, **kwargs)
+        cells = _cells.get(id(self))
+        if cells:
+            _bump(cells)
+        return result
+    return set_method
+
+def _make_getChild(base):
+    func = base.getChild
+    def getChild(self, *args, **kwargs):
+        child = func(self, *args, **kwargs)
+        cells = _cells.get(id(self))
+        if cells and isinstance(child, PropertyNode):
+            _join(child, cells)
+        return child
+    return getChild
+
+def _watched_class(cls):
+    if cls.__dict__.get('_watched'):
+        return cls
+    watched = _classes.get(cls)
+    if watched is None:
+        members = { '_watched': True,
+                    '__setattr__': _make_setter(cls) }
+        for method in _set_methods:
+            if hasattr(cls, method):
+                members[method] = _make_set_method(cls, method)
+        if hasattr(cls, 'getChild'):
+            members['getChild'] = _make_getChild(cls)
+        watched = type('Watched' + cls.__name__, (cls,), members)
+        _classes[cls] = watched
+    return watched
+
+# add node and every node below it to the watches in cells
+def _join(node, cells):
+    mine = _cells.setdefault(id(node), [])
+    added = False
+    for cell in cells:
+        if not any(c is cell for c in mine):
+            mine.append(cell)
+            added = True
+    if not added:
+        return
+    node.__class__ = _watched_class(type(node))
+    for name, value in list(node.__dict__.items()):
+        if not name.startswith('_'):
+            _adopt(value, cells)
+
+def watch(node):
+    cell = [ 0 ]
+    _join(node, [ cell ])
+    return cell
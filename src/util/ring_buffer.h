@@ -0,0 +1,49 @@
+/**
+ * \file: ring_buffer.h
+ *
+ * Fixed capacity ring buffer.  Storage is a plain member array so
+ * pushing never allocates; once full, each push overwrites the oldest
+ * entry.  Entries are addressed oldest (0) to newest (size()-1).
+ *
+ */
+
+#pragma once
+
+template <class T, int N>
+class AuraRingBuffer {
+
+private:
+
+    T _buf[N];
+    int _head;                  // slot of the oldest entry
+    int _count;
+
+public:
+
+    AuraRingBuffer(): _head(0), _count(0) {}
+    ~AuraRingBuffer() {}
+
+    static int capacity() { return N; }
+    int size() const { return _count; }
+    bool empty() const { return _count == 0; }
+    void clear() { _head = 0; _count = 0; }
+
+    // claim the next slot (dropping the oldest entry when full) and
+    // return it to be filled in place
+    T& push() {
+        int slot;
+        if ( _count < N ) {
+            slot = (_head + _count) % N;
+            _count++;
+        } else {
+            slot = _head;
+            _head = (_head + 1) % N;
+        }
+        return _buf[slot];
+    }
+
+    T& operator[]( int i ) { return _buf[(_head + i) % N]; }
+    const T& operator[]( int i ) const { return _buf[(_head + i) % N]; }
+
+    T& newest() { return (*this)[_count - 1]; }
+};
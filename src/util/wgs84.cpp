@@ -3,8 +3,13 @@
   namespace py = pybind11;
 #endif
 
+#include <algorithm>
 #include <limits>
 #include <math.h>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+using std::vector;
 
 #include "wgs84.h"
 
@@ -248,6 +253,175 @@ static int _geo_inverse_wgs_84( double lat1, double lon1, double lat2,
     }
 }
 
+int geo_direct_wgs84( double lat1, double lon1, double az1, double s,
+                      double *lat2, double *lon2, double *az2 )
+{
+    return _geo_direct_wgs_84( lat1, lon1, az1, s, lat2, lon2, az2 );
+}
+
+int geo_inverse_wgs84( double lat1, double lon1, double lat2, double lon2,
+                       double *az1, double *az2, double *s )
+{
+    return _geo_inverse_wgs_84( lat1, lon1, lat2, lon2, az1, az2, s );
+}
+
+
+// WGS84 meridional (M) and prime vertical (N) radii of curvature at
+// latitude phi (radians)
+static inline void local_radii( double phi, double *M, double *N ) {
+    double f = 1.0 / iFLATTENING;
+    double e2 = f*(2.0-f);
+    double sinphi = sin(phi);
+    double w2 = 1.0 - e2*sinphi*sinphi;
+    double w = sqrt(w2);
+    *N = EQURAD / w;
+    *M = EQURAD*(1.0-e2) / (w2*w);
+}
+
+// flat earth (equirectangular) direct solution at the mid latitude,
+// see wgs84.h for the error bound
+static void _geo_direct_approx( double lat1, double lon1, double az1,
+                                double s, double *lat2, double *lon2,
+                                double *az2 )
+{
+    if ( fabs(s) < 0.01 ) {
+	*lat2 = lat1;
+	*lon2 = lon1;
+	*az2 = 180.0 + az1;
+	if( *az2 > 360.0 ) *az2 -= 360.0;
+        return;
+    }
+    double phi1 = lat1*d2r;
+    // step along the mean azimuth (the start azimuth turned by half
+    // the meridian convergence) at the mid latitude, both found by
+    // two fixed point passes
+    double phim = phi1;
+    double azm = az1*d2r;
+    double dphi = 0.0, dlam = 0.0;
+    for ( int i = 0; i < 2; i++ ) {
+        double M, N;
+        local_radii( phim, &M, &N );
+        dphi = s*cos(azm) / M;
+        phim = phi1 + 0.5*dphi;
+        dlam = s*sin(azm) / (N*cos(phim));
+        azm = az1*d2r + 0.5*dlam*sin(phim);
+    }
+    *lat2 = lat1 + dphi*r2d;
+    *lon2 = lon1 + dlam*r2d;
+    if (*lon2 > 180.0  ) *lon2 -= 360.0;
+    if (*lon2 < -180.0 ) *lon2 += 360.0;
+    // (meridian convergence)
+    *az2 = az1 + dlam*sin(phim)*r2d + 180.0;
+    if ( *az2 >= 360.0 ) *az2 -= 360.0;
+    if ( *az2 < 0.0 ) *az2 += 360.0;
+}
+
+// flat earth (equirectangular) inverse solution at the mid latitude
+static void _geo_inverse_approx( double lat1, double lon1, double lat2,
+                                 double lon2, double *az1, double *az2,
+                                 double *s )
+{
+    double testv = 1.0E-10;
+    if ( fabs(lat1-lat2) < testv && fabs(lon1-lon2) < testv ) {
+	*az1 = 0.0; *az2 = 0.0; *s = 0.0;
+        return;
+    }
+    double dlon = lon2 - lon1;
+    if ( dlon > 180.0 ) dlon -= 360.0;
+    if ( dlon < -180.0 ) dlon += 360.0;
+    double phim = 0.5*(lat1 + lat2)*d2r;
+    double M, N;
+    local_radii( phim, &M, &N );
+    double dlam = dlon*d2r;
+    double dn = (lat2 - lat1)*d2r*M;
+    double de = dlam*N*cos(phim);
+    *s = sqrt(dn*dn + de*de);
+    *az1 = atan2(de, dn)*r2d;
+    if ( *az1 < 0.0 ) *az1 += 360.0;
+    // (mean azimuth above, rotate by half the meridian convergence to
+    // the end points)
+    double conv = 0.5*dlam*sin(phim)*r2d;
+    *az2 = *az1 + conv + 180.0;
+    *az1 -= conv;
+    if ( *az1 >= 360.0 ) *az1 -= 360.0;
+    if ( *az1 < 0.0 ) *az1 += 360.0;
+    if ( *az2 >= 360.0 ) *az2 -= 360.0;
+    if ( *az2 < 0.0 ) *az2 += 360.0;
+}
+
+// run fn(first, last) over [0, n) split into contiguous slices, one
+// per thread (the calling thread takes the first slice.)  Thread
+// start up costs about as much as a thousand Vincenty solutions, so
+// small batches stay on the calling thread.
+template <class F>
+static void parallel_range( int n, int threads, F fn ) {
+    const int min_slice = 4096;
+    if ( threads <= 0 ) {
+        threads = std::thread::hardware_concurrency();
+        if ( threads <= 0 ) {
+            threads = 1;
+        }
+    }
+    threads = std::min( threads, n / min_slice );
+    if ( threads <= 1 ) {
+        fn( 0, n );
+        return;
+    }
+    int slice = (n + threads - 1) / threads;
+    vector<std::thread> pool;
+    for ( int i = 1; i < threads; i++ ) {
+        int first = i * slice;
+        int last = std::min( n, first + slice );
+        pool.push_back( std::thread(fn, first, last) );
+    }
+    fn( 0, slice );
+    for ( size_t i = 0; i < pool.size(); i++ ) {
+        pool[i].join();
+    }
+}
+
+void geo_direct_wgs84_batch( int n, const double *lat1, const double *lon1,
+                             const double *az1, const double *s,
+                             double *lat2, double *lon2, double *az2,
+                             bool approx, int threads )
+{
+    parallel_range( n, threads, [=]( int first, int last ) {
+        if ( approx ) {
+            for ( int i = first; i < last; i++ ) {
+                _geo_direct_approx( lat1[i], lon1[i], az1[i], s[i],
+                                    &lat2[i], &lon2[i], &az2[i] );
+            }
+        } else {
+            for ( int i = first; i < last; i++ ) {
+                _geo_direct_wgs_84( lat1[i], lon1[i], az1[i], s[i],
+                                    &lat2[i], &lon2[i], &az2[i] );
+            }
+        }
+    } );
+}
+
+void geo_inverse_wgs84_batch( int n, const double *lat1, const double *lon1,
+                              const double *lat2, const double *lon2,
+                              double *az1, double *az2, double *s,
+                              bool approx, int threads )
+{
+    parallel_range( n, threads, [=]( int first, int last ) {
+        if ( approx ) {
+            for ( int i = first; i < last; i++ ) {
+                _geo_inverse_approx( lat1[i], lon1[i], lat2[i], lon2[i],
+                                     &az1[i], &az2[i], &s[i] );
+            }
+        } else {
+            for ( int i = first; i < last; i++ ) {
+                _geo_inverse_wgs_84( lat1[i], lon1[i], lat2[i], lon2[i],
+                                     &az1[i], &az2[i], &s[i] );
+            }
+        }
+    } );
+}
+
+
+#ifdef HAVE_PYBIND11
 py::tuple py_geo_direct_wgs84(double lat1, double lon1, double az1, double s) {
     double lat2, lon2, az2;
     _geo_direct_wgs_84( lat1, lon1, az1, s, &lat2, &lon2, &az2 );
@@ -260,11 +434,79 @@ py::tuple py_geo_inverse_wgs84(double lat1, double lon1, double lat2, double lon
     return py::make_tuple(az1, az2, s);
 }
 
+// the common length of the arguments (each either that long or a
+// single value), and the arguments expanded to it
+static int broadcast( py_darray *args[4], vector<double> cols[4],
+                      const double *ptrs[4] )
+{
+    py::ssize_t n = 1;
+    for ( int i = 0; i < 4; i++ ) {
+        py::ssize_t size = args[i]->size();
+        if ( size != 1 && n != 1 && size != n ) {
+            throw std::invalid_argument( "wgs84: array lengths differ" );
+        }
+        if ( size != 1 ) {
+            n = size;
+        }
+    }
+    for ( int i = 0; i < 4; i++ ) {
+        if ( args[i]->size() == n ) {
+            ptrs[i] = args[i]->data();
+        } else {
+            cols[i].assign( n, *args[i]->data() );
+            ptrs[i] = cols[i].data();
+        }
+    }
+    return n;
+}
+
+py::tuple py_geo_direct_wgs84_array( py_darray lat1, py_darray lon1,
+                                     py_darray az1, py_darray s,
+                                     bool approx, int threads )
+{
+    py_darray *args[4] = { &lat1, &lon1, &az1, &s };
+    vector<double> cols[4];
+    const double *in[4];
+    int n = broadcast( args, cols, in );
+    py_darray lat2( n ), lon2( n ), az2( n );
+    double *out[3] = { lat2.mutable_data(), lon2.mutable_data(),
+                       az2.mutable_data() };
+    {
+        py::gil_scoped_release release;
+        geo_direct_wgs84_batch( n, in[0], in[1], in[2], in[3],
+                                out[0], out[1], out[2], approx, threads );
+    }
+    return py::make_tuple(lat2, lon2, az2);
+}
+
+py::tuple py_geo_inverse_wgs84_array( py_darray lat1, py_darray lon1,
+                                      py_darray lat2, py_darray lon2,
+                                      bool approx, int threads )
+{
+    py_darray *args[4] = { &lat1, &lon1, &lat2, &lon2 };
+    vector<double> cols[4];
+    const double *in[4];
+    int n = broadcast( args, cols, in );
+    py_darray az1( n ), az2( n ), s( n );
+    double *out[3] = { az1.mutable_data(), az2.mutable_data(),
+                       s.mutable_data() };
+    {
+        py::gil_scoped_release release;
+        geo_inverse_wgs84_batch( n, in[0], in[1], in[2], in[3],
+                                 out[0], out[1], out[2], approx, threads );
+    }
+    return py::make_tuple(az1, az2, s);
+}
 
-#ifdef HAVE_PYBIND11
 PYBIND11_MODULE(wgs84, m) {
     m.doc() = "wgs84 routines for python";
     m.def("geo_direct", &py_geo_direct_wgs84);
     m.def("geo_inverse", &py_geo_inverse_wgs84);
+    m.def("geo_direct_array", &py_geo_direct_wgs84_array,
+          py::arg("lat1"), py::arg("lon1"), py::arg("az1"), py::arg("s"),
+          py::arg("approx") = false, py::arg("threads") = 0);
+    m.def("geo_inverse_array", &py_geo_inverse_wgs84_array,
+          py::arg("lat1"), py::arg("lon1"), py::arg("lat2"), py::arg("lon2"),
+          py::arg("approx") = false, py::arg("threads") = 0);
   }
 #endif // HAVE_PYBIND11
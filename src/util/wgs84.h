@@ -1,6 +1,41 @@
 #pragma once
 
+// given lat1, lon1, az1 and distance (s), calculate lat2, lon2 and
+// az2 (starting return heading.)  Lat, lon, and azimuth are in
+// degrees, distance in meters.
+int geo_direct_wgs84( double lat1, double lon1, double az1, double s,
+                      double *lat2, double *lon2, double *az2 );
+
+// given lat1, lon1, lat2, lon2, calculate starting and ending az1,
+// az2 and distance (s).  Lat, lon, and azimuth are in degrees,
+// distance in meters.
+int geo_inverse_wgs84( double lat1, double lon1, double lat2, double lon2,
+                       double *az1, double *az2, double *s );
+
+// Batched versions: n independent problems from parallel arrays (the
+// same units as above), split across threads (threads <= 0 uses all
+// the cores; small batches run on the calling thread.)
+//
+// approx = true replaces the Vincenty iteration with a local flat
+// earth (equirectangular) projection using the WGS84 meridional and
+// prime vertical radii at the mid latitude.  Below 70 degrees of
+// latitude and for distances under 10 km this stays within 0.001% of
+// the distance (10 cm at 10 km) and 0.001 degree of azimuth; the
+// error grows quickly with distance, so use it for survey grids and
+// local patterns, not long legs.
+void geo_direct_wgs84_batch( int n, const double *lat1, const double *lon1,
+                             const double *az1, const double *s,
+                             double *lat2, double *lon2, double *az2,
+                             bool approx=false, int threads=0 );
+void geo_inverse_wgs84_batch( int n, const double *lat1, const double *lon1,
+                              const double *lat2, const double *lon2,
+                              double *az1, double *az2, double *s,
+                              bool approx=false, int threads=0 );
+
+#ifdef HAVE_PYBIND11
+
 #include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
 namespace py = pybind11;
 
 // given, lla, az1 and distance (s), return (lat2, lon2) and modify
@@ -12,3 +47,15 @@ py::tuple py_geo_direct_wgs84 ( double lat1, double lon1, double az1, double s )
 // az1, az2 and distance (s).  Lat, lon, and azimuth are in degrees.
 // distance in meters
 py::tuple py_geo_inverse_wgs84( double lat1, double lon1, double lat2, double lon2 );
+
+// numpy versions of the above: array (or scalar) arguments broadcast
+// to a common length, returning a tuple of three arrays
+typedef py::array_t<double, py::array::c_style | py::array::forcecast> py_darray;
+py::tuple py_geo_direct_wgs84_array( py_darray lat1, py_darray lon1,
+                                     py_darray az1, py_darray s,
+                                     bool approx, int threads );
+py::tuple py_geo_inverse_wgs84_array( py_darray lat1, py_darray lon1,
+                                      py_darray lat2, py_darray lon2,
+                                      bool approx, int threads );
+
+#endif // HAVE_PYBIND11
@@ -0,0 +1,135 @@
+// wgs84_test.cpp -- check the batched geodesic solutions match the
+//                   single point ones, measure the flat earth
+//                   approximation error against Vincenty over random
+//                   latitudes, azimuths and distances, and time the
+//                   batch paths.
+//
+// g++ -O3 -pthread -I.. wgs84_test.cpp wgs84.cpp timing.cpp -o wgs84_test
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <vector>
+using std::vector;
+
+#include "timing.h"
+#include "wgs84.h"
+
+int main() {
+    bool pass = true;
+
+    // a survey sized set of points: a reference lat/lon, and courses
+    // and distances out to 10 km
+    const int n = 200000;
+    vector<double> lat1(n), lon1(n), az1(n), s(n);
+    srand( 1 );
+    for ( int i = 0; i < n; i++ ) {
+        lat1[i] = -70.0 + 140.0 * rand() / (double)RAND_MAX;
+        lon1[i] = -180.0 + 360.0 * rand() / (double)RAND_MAX;
+        az1[i] = 360.0 * rand() / (double)RAND_MAX;
+        s[i] = 10000.0 * rand() / (double)RAND_MAX;
+    }
+
+    // one at a time (as the python loops call it)
+    vector<double> lat2(n), lon2(n), az2(n);
+    double start = get_Time();
+    for ( int i = 0; i < n; i++ ) {
+        geo_direct_wgs84( lat1[i], lon1[i], az1[i], s[i],
+                          &lat2[i], &lon2[i], &az2[i] );
+    }
+    double single_sec = get_Time() - start;
+
+    // batched, exact: identical results
+    vector<double> blat2(n), blon2(n), baz2(n);
+    start = get_Time();
+    geo_direct_wgs84_batch( n, &lat1[0], &lon1[0], &az1[0], &s[0],
+                            &blat2[0], &blon2[0], &baz2[0] );
+    double batch_sec = get_Time() - start;
+    for ( int i = 0; i < n; i++ ) {
+        if ( blat2[i] != lat2[i] || blon2[i] != lon2[i]
+             || baz2[i] != az2[i] ) {
+            printf("FAIL: batch direct %d\n", i);
+            pass = false;
+            break;
+        }
+    }
+
+    // inverse back to the start
+    vector<double> iaz1(n), iaz2(n), is(n);
+    start = get_Time();
+    geo_inverse_wgs84_batch( n, &lat1[0], &lon1[0], &lat2[0], &lon2[0],
+                             &iaz1[0], &iaz2[0], &is[0], false, 1 );
+    double inverse_sec = get_Time() - start;
+    for ( int i = 0; i < n; i++ ) {
+        double a, b, c;
+        geo_inverse_wgs84( lat1[i], lon1[i], lat2[i], lon2[i], &a, &b, &c );
+        if ( iaz1[i] != a || iaz2[i] != b || is[i] != c
+             || fabs(is[i] - s[i]) > 0.001 ) {
+            printf("FAIL: batch inverse %d\n", i);
+            pass = false;
+            break;
+        }
+    }
+
+    // approximations vs. Vincenty (judged above 100 m, below that
+    // Vincenty's own convergence tolerance dominates the difference)
+    vector<double> alat2(n), alon2(n), aaz2(n);
+    start = get_Time();
+    geo_direct_wgs84_batch( n, &lat1[0], &lon1[0], &az1[0], &s[0],
+                            &alat2[0], &alon2[0], &aaz2[0], true, 1 );
+    double approx_sec = get_Time() - start;
+    vector<double> aiaz1(n), aiaz2(n), ais(n);
+    geo_inverse_wgs84_batch( n, &lat1[0], &lon1[0], &lat2[0], &lon2[0],
+                             &aiaz1[0], &aiaz2[0], &ais[0], true, 1 );
+    double max_pos = 0.0, max_dist = 0.0, max_az = 0.0;
+    for ( int i = 0; i < n; i++ ) {
+        double a, b, miss;
+        geo_inverse_wgs84( lat2[i], lon2[i], alat2[i], alon2[i],
+                           &a, &b, &miss );
+        if ( s[i] > 100.0 ) {
+            max_pos = std::max( max_pos, miss / s[i] );
+            max_dist = std::max( max_dist, fabs(ais[i] - s[i]) / s[i] );
+            double azs[3][2] = { { aaz2[i], az2[i] }, { aiaz1[i], iaz1[i] },
+                                 { aiaz2[i], iaz2[i] } };
+            for ( int j = 0; j < 3; j++ ) {
+                double d = fabs( azs[j][0] - azs[j][1] );
+                if ( d > 180.0 ) { d = 360.0 - d; }
+                max_az = std::max( max_az, d );
+            }
+        }
+    }
+    printf("approx (lat < 70, s < 10 km): direct %.4f%%  inverse %.4f%% "
+           "of distance, azimuth %.4f deg\n", max_pos * 100.0,
+           max_dist * 100.0, max_az);
+    if ( max_pos > 0.00001 || max_dist > 0.00001 || max_az > 0.001 ) {
+        printf("FAIL: approximation error bound\n");
+        pass = false;
+    }
+
+    // threaded batches match the single thread
+    vector<double> tlat2(n), tlon2(n), taz2(n);
+    start = get_Time();
+    geo_direct_wgs84_batch( n, &lat1[0], &lon1[0], &az1[0], &s[0],
+                            &tlat2[0], &tlon2[0], &taz2[0], false, 4 );
+    double thread_sec = get_Time() - start;
+    for ( int i = 0; i < n; i++ ) {
+        if ( tlat2[i] != lat2[i] || tlon2[i] != lon2[i] ) {
+            printf("FAIL: threaded direct %d\n", i);
+            pass = false;
+            break;
+        }
+    }
+
+    printf("direct: single %.3f  batch %.3f  4 threads %.3f  approx %.3f "
+           "us per point\n", single_sec * 1e6 / n, batch_sec * 1e6 / n,
+           thread_sec * 1e6 / n, approx_sec * 1e6 / n);
+    printf("inverse: batch %.3f us per point\n", inverse_sec * 1e6 / n);
+
+    if ( !pass ) {
+        return 1;
+    }
+    printf("PASS\n");
+    return 0;
+}
@@ -12,8 +12,8 @@ static const double m2pi = pi * 2.0;
 // fly to achieve the desired course in the given wind.  Also compute the
 // estimated ground speed.
 
-py::tuple wind_course( double ws_kt, double tas_kt, double wd_deg,
-                       double crs_deg )
+void wind_course( double ws_kt, double tas_kt, double wd_deg, double crs_deg,
+                  double *hd_deg_out, double *gs_kt_out )
 {
     // from williams.best.vwh.net/avform.htm (aviation formulas)
     double wd = wd_deg * d2r;
@@ -44,13 +44,22 @@ py::tuple wind_course( double ws_kt, double tas_kt, double wd_deg,
     // if ( display_on ) {
     //   printf("af: hd=%.1f gs=%.1f\n", hd * SGD_RADIANS_TO_DEGREES, gs);
     // }
-    return py::make_tuple(hd_deg, gs_kt);
+    *hd_deg_out = hd_deg;
+    *gs_kt_out = gs_kt;
 }
 
 
 #ifdef HAVE_PYBIND11
+py::tuple py_wind_course( double ws_kt, double tas_kt, double wd_deg,
+                          double crs_deg )
+{
+    double hd_deg, gs_kt;
+    wind_course( ws_kt, tas_kt, wd_deg, crs_deg, &hd_deg, &gs_kt );
+    return py::make_tuple(hd_deg, gs_kt);
+}
+
 PYBIND11_MODULE(windtri, m) {
     m.doc() = "wind triangle calcs for python";
-    m.def("wind_course", &wind_course);
+    m.def("wind_course", &py_wind_course);
 }
 #endif // HAVE_PYBIND11
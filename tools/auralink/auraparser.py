@@ -97,6 +97,8 @@ def parse_msg(id, buf):
         index = packer.unpack_ap_status_v6(buf)
     elif id == aura_messages.ap_status_v7_id:
         index = packer.unpack_ap_status_v7(buf)
+    elif id == aura_messages.ap_stats_v1_id:
+        index = packer.unpack_ap_stats_v1(buf)
     elif id == aura_messages.system_health_v4_id:
         index = packer.unpack_system_health_v4(buf)
     elif id == aura_messages.system_health_v5_id:
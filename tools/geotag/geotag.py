@@ -5,6 +5,7 @@ import csv
 import datetime
 import fnmatch
 import fractions
+import json
 import math
 from matplotlib import pyplot as plt 
 import numpy as np
@@ -28,6 +29,7 @@ parser.add_argument('--align-first', action='store_true', help='align first in-f
 parser.add_argument('--no-plot', dest='plot', action='store_false', help='do not show correlation plots')
 parser.add_argument('--write', action='store_true', help='update geotags on source images')
 parser.add_argument('--force-ap-flag-on', action='store_true', help='force ap flag on')
+parser.add_argument('--smooth', action='store_true', help='geotag with the smoothed (forward + backward) nav solution')
 parser.set_defaults(plot=True)
 args = parser.parse_args()
 
@@ -37,6 +39,67 @@ data, flight_format = flight_loader.load(args.flight)
 interp = flight_interp.FlightInterpolate()
 interp.build(data)
 
+if args.smooth:
+    # rerun the ekf over the raw log and smooth it (native code, the
+    # intermediate states are kept in a scratch file, not in memory)
+    from scipy import interpolate
+    from rcUAS import replay
+    log_file = os.path.join(args.flight, 'flight.dat.gz')
+    smooth_file = os.path.join(args.flight, 'filter-smooth.csv')
+
+    # rerun the filter the flight flew with: the primary (else first)
+    # enabled ekf section of the /config saved in the log directory
+    section = {}
+    config_file = os.path.join(args.flight, 'master-config.json')
+    if os.path.exists(config_file):
+        with open(config_file, 'r') as f:
+            filters = json.load(f).get('filters', {})
+        sections = []
+        for value in filters.values():
+            if isinstance(value, list):
+                sections += [ s for s in value if isinstance(s, dict) ]
+            elif isinstance(value, dict):
+                sections.append(value)
+        def is_true(value):
+            return str(value).lower() in ('true', '1')
+        sections = [ s for s in sections
+                     if is_true(s.get('enable', False))
+                     and str(s.get('module', '')).startswith('nav-ekf15') ]
+        primary = [ s for s in sections if is_true(s.get('primary', False)) ]
+        if len(primary):
+            section = primary[0]
+        elif len(sections):
+            section = sections[0]
+    else:
+        print('No saved config (%s), smoothing with the defaults' %
+              config_file)
+    mag = section.get('module', 'nav-ekf15') == 'nav-ekf15-mag'
+    sequential = section.get('update_mode', '') == 'sequential'
+    cov_decimation = max(int(section.get('cov_decimation', 1)), 1)
+    if float(section.get('gps_lag_sec', 0.0)) > 0.0:
+        print('  note: the smoother does not model gps lag (%s sec)' %
+              section['gps_lag_sec'])
+    print('Smoothing:', log_file, 'module:',
+          section.get('module', 'nav-ekf15'),
+          'sequential:', sequential, 'cov_decimation:', cov_decimation)
+    stats = replay.smooth(log_file, smooth_file, mag=mag,
+                          sequential=sequential,
+                          cov_decimation=cov_decimation)
+    print('  %d steps, forward %.1f sec, backward %.1f sec' %
+          (stats['steps'], stats['forward_sec'], stats['backward_sec']))
+    smooth = np.genfromtxt(smooth_file, delimiter=',', names=True)
+    def smooth_interp(values):
+        return interpolate.interp1d(smooth['timestamp'], values,
+                                    bounds_error=False, fill_value=0.0)
+    psi = smooth['heading_deg'] * d2r
+    interp.filter_lat = smooth_interp(smooth['latitude_deg'] * d2r)
+    interp.filter_lon = smooth_interp(smooth['longitude_deg'] * d2r)
+    interp.filter_alt = smooth_interp(smooth['altitude_m'])
+    interp.filter_phi = smooth_interp(smooth['roll_deg'] * d2r)
+    interp.filter_the = smooth_interp(smooth['pitch_deg'] * d2r)
+    interp.filter_psix = smooth_interp(np.cos(psi))
+    interp.filter_psiy = smooth_interp(np.sin(psi))
+
 # load camera triggers (from the events file)
 triggers = []
 airborne = False